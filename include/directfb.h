@@ -3443,8 +3443,10 @@ typedef enum {
                                                                     SetMatrix(). */
      DSRO_ANTIALIAS                        = 0x00000008,         /* Enable anti-aliasing for edges (alpha blending must
                                                                     be enabled). */
+     DSRO_SMOOTH_BICUBIC                   = 0x00000010,         /* Use bicubic instead of bilinear interpolation for
+                                                                    smooth StretchBlit(). */
 
-     DSRO_ALL                              = 0x0000000F          /* All of these. */
+     DSRO_ALL                              = 0x0000001F          /* All of these. */
 } DFBSurfaceRenderOptions;
 
 /*
@@ -6308,6 +6310,14 @@ typedef DFBEnumerationResult (*DFBTextEncodingCallback) (
      void                                   *callbackdata
 );
 
+/*
+ * Called when the glyphs requested via IDirectFBFont::PrewarmGlyphs() are cached.
+ */
+typedef void (*DFBFontPrewarmCallback) (
+     DFBResult                               result,
+     void                                   *callbackdata
+);
+
 /*
  * IDirectFBFont is the font interface.
  */
@@ -6561,6 +6571,26 @@ D_DEFINE_INTERFACE( IDirectFBFont,
           IDirectFBFont                     *thiz,
           DFBFontDescription                *ret_desc
      );
+
+
+   /** Glyph cache **/
+
+     /*
+      * Load and render the glyphs of a string into the glyph cache in the background.
+      *
+      * The string is decoded with the current encoding, the glyphs are cached by a separate thread so that
+      * drawing the string later on does not need to render them. Requests are processed in order.
+      *
+      * The optional callback is called from that thread when all glyphs are cached, or with DFB_DESTROYED if
+      * the font is released before. The callback must not release the font.
+      */
+     DFBResult (*PrewarmGlyphs) (
+          IDirectFBFont                     *thiz,
+          const char                        *text,
+          int                                bytes,
+          DFBFontPrewarmCallback             callback,
+          void                              *callbackdata
+     );
 )
 
 /**************************
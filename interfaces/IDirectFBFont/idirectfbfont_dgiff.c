@@ -16,13 +16,16 @@
    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
 */
 
+#include <core/CoreDFB.h>
 #include <core/fonts.h>
 #include <core/surface.h>
+#include <core/surface_pool.h>
 #include <dgiff.h>
 #include <direct/filesystem.h>
 #include <direct/hash.h>
 #include <directfb_util.h>
 #include <media/idirectfbfont.h>
+#include <misc/conf.h>
 
 D_DEBUG_DOMAIN( Font_DGIFF, "Font/DGIFF", "DGIFF Font Provider" );
 
@@ -40,6 +43,8 @@ DIRECT_INTERFACE_IMPLEMENTATION( IDirectFBFont, DGIFF )
 /**********************************************************************************************************************/
 
 typedef struct {
+     DirectLink    link;
+
      void         *map;      /* memory map of the font file */
      int           size;     /* size of the memory map */
 
@@ -47,6 +52,113 @@ typedef struct {
      int           num_rows;
 } DGIFFImplData;
 
+/* Destroyed fonts whose memory map is still used by row surfaces referenced elsewhere, e.g. by a state. */
+static DirectLink  *orphans;
+static DirectMutex  orphans_lock = DIRECT_MUTEX_INITIALIZER();
+
+/**********************************************************************************************************************/
+
+/*
+ * Create a surface using the pixels of a glyph row in the memory map, without copying them.
+ */
+static DFBResult
+create_mapped_row( CoreDFB               *core,
+                   DGIFFGlyphRow         *row,
+                   DFBSurfacePixelFormat  format,
+                   CoreSurface          **ret_surface )
+{
+     DFBResult             ret;
+     DFBSurfaceDescription desc;
+     CoreSurfaceConfig     config;
+
+     if (row->pitch < DFB_BYTES_PER_LINE( format, row->width ))
+          return DFB_UNSUPPORTED;
+
+     desc.flags                = DSDESC_PREALLOCATED;
+     desc.preallocated[0].data  = row + 1;
+     desc.preallocated[0].pitch = row->pitch;
+
+     config.flags      = CSCONF_SIZE | CSCONF_FORMAT | CSCONF_COLORSPACE | CSCONF_CAPS | CSCONF_PREALLOCATED;
+     config.size.w     = row->width;
+     config.size.h     = row->height;
+     config.format     = format;
+     config.colorspace = DFB_COLORSPACE_DEFAULT( format );
+     config.caps       = DSCAPS_NONE;
+
+     ret = dfb_surface_pools_prealloc( &desc, &config );
+     if (ret)
+          return ret;
+
+     return CoreDFB_CreateSurface( core, &config, CSTF_PREALLOCATED, 0, NULL, ret_surface );
+}
+
+/*
+ * Release the row surfaces, keeping those using the memory map while someone else holds a reference.
+ *
+ * Returns true if all of them are released and the memory map can be removed.
+ */
+static bool
+release_rows( DGIFFImplData *data )
+{
+     int  i;
+     int  refs;
+     bool released = true;
+
+     for (i = 0; i < data->num_rows; i++) {
+          CoreSurface *surface = data->rows[i];
+
+          if (!surface)
+               continue;
+
+          if ((surface->type & CSTF_PREALLOCATED) &&
+              fusion_ref_stat( &surface->object.ref, &refs ) == DR_OK && refs > 1) {
+               released = false;
+               continue;
+          }
+
+          dfb_surface_unref( surface );
+
+          data->rows[i] = NULL;
+     }
+
+     return released;
+}
+
+static void
+destroy_data( DGIFFImplData *data )
+{
+     if (data->rows)
+          D_FREE( data->rows );
+
+     if (data->map)
+          direct_file_unmap( data->map, data->size );
+
+     D_FREE( data );
+}
+
+/*
+ * Remove the memory maps of destroyed fonts that are no longer used.
+ */
+static void
+release_orphans( void )
+{
+     DGIFFImplData *data, *next;
+
+     direct_mutex_lock( &orphans_lock );
+
+     direct_list_foreach_safe (data, next, orphans) {
+          if (release_rows( data )) {
+               D_DEBUG_AT( Font_DGIFF, "  -> unmapping %p\n", data->map );
+
+               direct_list_remove( &orphans, &data->link );
+
+               destroy_data( data );
+          }
+     }
+
+     direct_mutex_unlock( &orphans_lock );
+}
+
 /**********************************************************************************************************************/
 
 static void
@@ -56,22 +168,23 @@ IDirectFBFont_DGIFF_Destruct( IDirectFBFont *thiz )
 
      D_DEBUG_AT( Font_DGIFF, "%s( %p )\n", __FUNCTION__, thiz );
 
-     if (data->rows) {
-          int i;
+     /* Destroy the font and its glyphs first. */
+     IDirectFBFont_Destruct( thiz );
 
-          for (i = 0; i < data->num_rows; i++) {
-               if (data->rows[i])
-                    dfb_surface_unref( data->rows[i] );
-          }
+     release_orphans();
 
-          D_FREE( data->rows );
+     if (release_rows( data )) {
+          destroy_data( data );
      }
+     else {
+          D_DEBUG_AT( Font_DGIFF, "  -> keeping map %p for row surfaces in use\n", data->map );
 
-     direct_file_unmap( data->map, data->size );
+          direct_mutex_lock( &orphans_lock );
 
-     D_FREE( data );
+          direct_list_append( &orphans, &data->link );
 
-     IDirectFBFont_Destruct( thiz );
+          direct_mutex_unlock( &orphans_lock );
+     }
 }
 
 static DirectResult
@@ -131,6 +244,8 @@ Construct( IDirectFBFont              *thiz,
 
      D_DEBUG_AT( Font_DGIFF, "  -> file '%s' at pixel height %d\n", ctx->filename, desc->height );
 
+     release_orphans();
+
      /* Open the file. */
      ret = direct_file_open( &fd, ctx->filename, O_RDONLY, 0 );
      if (ret) {
@@ -205,6 +320,8 @@ Construct( IDirectFBFont              *thiz,
      data->map  = ptr;
      data->size = info.size;
 
+     ptr = NULL;
+
      data->num_rows = faceheader->num_rows;
 
      /* Allocate array for glyph cache rows. */
@@ -214,23 +331,34 @@ Construct( IDirectFBFont              *thiz,
           goto error;
      }
 
-     /* Build glyph cache rows. */
+     /* Build glyph cache rows, using the pixels in the memory map if possible. */
      for (i = 0; i < data->num_rows; i++) {
-          ret = dfb_surface_create_simple( core, row->width, row->height, faceheader->pixelformat,
-                                           DFB_COLORSPACE_DEFAULT( faceheader->pixelformat ), DSCAPS_NONE, CSTF_NONE, 0,
-                                           NULL, &data->rows[i] );
-          if (ret) {
-               D_DERROR( ret, "DGIFF/Font: Could not create %s %dx%d glyph row surface!\n",
-                         dfb_pixelformat_name( faceheader->pixelformat ), row->width, row->height );
-               goto error;
-          }
+          if (create_mapped_row( core, row, faceheader->pixelformat, &data->rows[i] )) {
+               ret = dfb_surface_create_simple( core, row->width, row->height, faceheader->pixelformat,
+                                                DFB_COLORSPACE_DEFAULT( faceheader->pixelformat ), DSCAPS_NONE,
+                                                CSTF_NONE, 0, NULL, &data->rows[i] );
+               if (ret) {
+                    D_DERROR( ret, "DGIFF/Font: Could not create %s %dx%d glyph row surface!\n",
+                              dfb_pixelformat_name( faceheader->pixelformat ), row->width, row->height );
+                    goto error;
+               }
 
-          dfb_surface_write_buffer( data->rows[i], DSBR_BACK, row + 1, row->pitch, NULL );
+               dfb_surface_write_buffer( data->rows[i], DSBR_BACK, row + 1, row->pitch, NULL );
+          }
 
           /* Jump to next row. */
           row = (void*) (row + 1) + row->pitch * row->height;
      }
 
+     /* Read ahead or lock the rows of the face. */
+     if (dfb_config->font_preload || dfb_config->font_mlock) {
+          ret = direct_file_map_advise( (void*) faceheader, (void*) row - (void*) faceheader,
+                                        (dfb_config->font_preload ? DFMA_WILLNEED : DFMA_NONE) |
+                                        (dfb_config->font_mlock   ? DFMA_LOCK     : DFMA_NONE) );
+          if (ret)
+               D_DERROR( ret, "Font/DGIFF: Could not preload face of '%s'!\n", ctx->filename );
+     }
+
      /* Build glyph info. */
      for (i = 0; i < faceheader->num_glyphs; i++) {
           CoreGlyphData  *glyph_data;
@@ -253,10 +381,7 @@ Construct( IDirectFBFont              *thiz,
 
           D_MAGIC_SET( glyph_data, CoreGlyphData );
 
-          direct_hash_insert( font->layers[0].glyph_hash, glyph->unicode, glyph_data );
-
-          if (glyph->unicode < 128)
-               font->layers[0].glyph_data[glyph->unicode] = glyph_data;
+          dfb_font_insert_glyph_data( font, glyph->unicode, 0, glyph_data );
      }
 
      font->impl_data = data;
@@ -270,16 +395,8 @@ Construct( IDirectFBFont              *thiz,
 error:
      if (font) {
           if (data) {
-               if (data->rows) {
-                    for (i = 0; i < data->num_rows; i++) {
-                         if (data->rows[i])
-                              dfb_surface_unref( data->rows[i] );
-                    }
-
-                    D_FREE( data->rows );
-               }
-
-               D_FREE( data );
+               release_rows( data );
+               destroy_data( data );
           }
 
           dfb_font_destroy( font );
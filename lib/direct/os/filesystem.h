@@ -36,6 +36,15 @@ typedef enum {
      DFP_ALL   = 0x00000003
 } DirectFilePermission;
 
+typedef enum {
+     DFMA_NONE     = 0x00000000,
+
+     DFMA_WILLNEED = 0x00000001, /* read ahead the mapped pages */
+     DFMA_LOCK     = 0x00000002, /* lock the mapped pages in memory */
+
+     DFMA_ALL      = 0x00000003
+} DirectFileMapAdvice;
+
 typedef enum {
      DFIF_NONE = 0x00000000,
 
@@ -109,6 +118,10 @@ DirectResult DIRECT_API direct_file_map       ( DirectFile            *file,
 DirectResult DIRECT_API direct_file_unmap     ( void                  *addr,
                                                 size_t                 bytes );
 
+DirectResult DIRECT_API direct_file_map_advise( void                  *addr,
+                                                size_t                 bytes,
+                                                DirectFileMapAdvice    advice );
+
 DirectResult DIRECT_API direct_file_get_info  ( DirectFile            *file,
                                                 DirectFileInfo        *ret_info );
 
@@ -18,6 +18,7 @@
 
 #include <direct/debug.h>
 #include <direct/os/filesystem.h>
+#include <direct/os/system.h>
 #include <direct/messages.h>
 #include <direct/util.h>
 
@@ -286,6 +287,28 @@ direct_file_unmap( void   *addr,
      return DR_OK;
 }
 
+DirectResult
+direct_file_map_advise( void                *addr,
+                        size_t               bytes,
+                        DirectFileMapAdvice  advice )
+{
+     unsigned long offset = (unsigned long) addr & (direct_pagesize() - 1);
+
+     D_ASSERT( addr != NULL );
+
+     /* Start at the page boundary. */
+     addr   = (u8*) addr - offset;
+     bytes += offset;
+
+     if ((advice & DFMA_WILLNEED) && madvise( addr, bytes, MADV_WILLNEED ) < 0)
+          return errno2result( errno );
+
+     if ((advice & DFMA_LOCK) && mlock( addr, bytes ) < 0)
+          return errno2result( errno );
+
+     return DR_OK;
+}
+
 DirectResult
 direct_file_get_info( DirectFile     *file,
                       DirectFileInfo *ret_info )
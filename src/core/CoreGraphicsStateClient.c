@@ -21,6 +21,7 @@
 #include <core/CoreGraphicsStateClient.h>
 #include <core/core.h>
 #include <core/graphics_state.h>
+#include <direct/memcpy.h>
 #include <fusion/conf.h>
 
 D_DEBUG_DOMAIN(
@@ -30,6 +31,11 @@ D_DEBUG_DOMAIN(
 
 /**********************************************************************************************************************/
 
+/* Capacity of the recorded commands, executed by one call. */
+#define COMMANDS_SIZE 8192
+
+/**********************************************************************************************************************/
+
 typedef struct clients_s {
      CoreGraphicsStateClient *client;
      struct clients_s *next;
@@ -119,6 +125,9 @@ CoreGraphicsStateClient_Init( CoreGraphicsStateClient *client,
      client->core      = state->core;
      client->state     = state;
      client->gfx_state = NULL;
+     client->commands  = NULL;
+     client->length    = 0;
+     client->Execute   = CoreGraphicsState_Execute;
 
      ret = CoreDFB_CreateState( state->core, &client->gfx_state );
      if (ret)
@@ -149,6 +158,9 @@ CoreGraphicsStateClient_Deinit( CoreGraphicsStateClient *client )
 
      CoreGraphicsStateClient_Flush( client );
 
+     if (client->commands)
+          D_FREE( client->commands );
+
      dfb_graphics_state_unref( client->gfx_state );
 
      RemoveClient( client );
@@ -156,6 +168,144 @@ CoreGraphicsStateClient_Deinit( CoreGraphicsStateClient *client )
      D_MAGIC_CLEAR( client );
 }
 
+/*
+ * Execute the recorded commands with one call.
+ */
+static DFBResult
+CoreGraphicsStateClient_Submit( CoreGraphicsStateClient *client )
+{
+     DFBResult ret;
+
+     if (!client->length)
+          return DFB_OK;
+
+     D_DEBUG_AT( Core_GraphicsStateClient_Flush, "%s( %p ) <- length %u\n", __FUNCTION__, client, client->length );
+
+     ret = client->Execute( client->gfx_state, client->commands, client->length );
+
+     client->length = 0;
+
+     return ret;
+}
+
+/*
+ * Append a command, submitting the recorded ones first if there is not enough room left.
+ */
+static DFBResult
+CoreGraphicsStateClient_Record( CoreGraphicsStateClient       *client,
+                                CoreGraphicsStateCommandType   type,
+                                u32                            num,
+                                s32                            param,
+                                u32                            length,
+                                void                         **ret_args )
+{
+     DFBResult                 ret;
+     CoreGraphicsStateCommand *command;
+
+     D_ASSERT( !(length & 3) );
+     D_ASSERT( sizeof(CoreGraphicsStateCommand) + length <= COMMANDS_SIZE );
+
+     if (!client->commands) {
+          client->commands = D_MALLOC( COMMANDS_SIZE );
+          if (!client->commands)
+               return D_OOM();
+     }
+
+     if (client->length + sizeof(CoreGraphicsStateCommand) + length > COMMANDS_SIZE) {
+          ret = CoreGraphicsStateClient_Submit( client );
+          if (ret)
+               return ret;
+     }
+
+     command = (CoreGraphicsStateCommand*) (client->commands + client->length);
+
+     command->type   = type;
+     command->num    = num;
+     command->param  = param;
+     command->length = length;
+
+     client->length += sizeof(CoreGraphicsStateCommand) + length;
+
+     if (ret_args)
+          *ret_args = command + 1;
+
+     return DFB_OK;
+}
+
+static DFBResult
+CoreGraphicsStateClient_RecordValue( CoreGraphicsStateClient      *client,
+                                     CoreGraphicsStateCommandType  type,
+                                     const void                   *value,
+                                     u32                           size,
+                                     s32                           param )
+{
+     DFBResult  ret;
+     void      *args;
+
+     ret = CoreGraphicsStateClient_Record( client, type, 0, param, size, &args );
+     if (ret)
+          return ret;
+
+     direct_memcpy( args, value, size );
+
+     return DFB_OK;
+}
+
+/*
+ * Append an operation on up to three arrays with 'num' elements each, split into several commands if needed.
+ */
+static DFBResult
+CoreGraphicsStateClient_RecordArrays( CoreGraphicsStateClient      *client,
+                                      CoreGraphicsStateCommandType  type,
+                                      s32                           param,
+                                      unsigned int                  num,
+                                      const void                   *array1,
+                                      u32                           size1,
+                                      const void                   *array2,
+                                      u32                           size2,
+                                      const void                   *array3,
+                                      u32                           size3 )
+{
+     DFBResult    ret;
+     unsigned int done = 0;
+     u32          size = size1 + size2 + size3;
+
+     while (done < num) {
+          unsigned int  n;
+          unsigned int  space;
+          u8           *args;
+
+          /* Fill up the remaining room, or all of it after submitting the recorded commands. */
+          if (client->length + sizeof(CoreGraphicsStateCommand) + size > COMMANDS_SIZE)
+               space = COMMANDS_SIZE - sizeof(CoreGraphicsStateCommand);
+          else
+               space = COMMANDS_SIZE - sizeof(CoreGraphicsStateCommand) - client->length;
+
+          n = MIN( num - done, space / size );
+
+          /* Spans are on consecutive lines, each command starts at the line of its first span. */
+          ret = CoreGraphicsStateClient_Record( client, type, n, type == CGSC_FILL_SPANS ? param + (s32) done : param,
+                                                n * size, (void**) &args );
+          if (ret)
+               return ret;
+
+          direct_memcpy( args, (const u8*) array1 + done * size1, n * size1 );
+          args += n * size1;
+
+          if (size2) {
+               direct_memcpy( args, (const u8*) array2 + done * size2, n * size2 );
+               args += n * size2;
+          }
+
+          if (size3)
+               direct_memcpy( args, (const u8*) array3 + done * size3, n * size3 );
+
+          done += n;
+     }
+
+     return DFB_OK;
+}
+
 void
 CoreGraphicsStateClient_Flush( CoreGraphicsStateClient *client )
 {
@@ -167,6 +317,8 @@ CoreGraphicsStateClient_Flush( CoreGraphicsStateClient *client )
            dfb_gfxcard_flush();
       }
       else {
+           CoreGraphicsStateClient_Submit( client );
+
            CoreGraphicsState_Flush( client->gfx_state );
       }
 }
@@ -178,7 +330,10 @@ CoreGraphicsStateClient_ReleaseSource( CoreGraphicsStateClient *client )
 
      D_MAGIC_ASSERT( client, CoreGraphicsStateClient );
 
-     CoreGraphicsState_ReleaseSource( client->gfx_state );
+     if (!dfb_config->call_nodirect && (dfb_core_is_master( client->core ) || !fusion_config->secure_fusion))
+          CoreGraphicsState_ReleaseSource( client->gfx_state );
+     else
+          return CoreGraphicsStateClient_Record( client, CGSC_RELEASE_SOURCE, 0, 0, 0, NULL );
 
      return DFB_OK;
 }
@@ -192,7 +347,10 @@ CoreGraphicsStateClient_SetColorAndIndex( CoreGraphicsStateClient *client,
 
      D_MAGIC_ASSERT( client, CoreGraphicsStateClient );
 
-     CoreGraphicsState_SetColorAndIndex( client->gfx_state, color, index );
+     if (!dfb_config->call_nodirect && (dfb_core_is_master( client->core ) || !fusion_config->secure_fusion))
+          CoreGraphicsState_SetColorAndIndex( client->gfx_state, color, index );
+     else
+          return CoreGraphicsStateClient_RecordValue( client, CGSC_COLOR_AND_INDEX, color, sizeof(DFBColor), index );
 
      return DFB_OK;
 }
@@ -209,50 +367,63 @@ CoreGraphicsStateClient_SetState( CoreGraphicsStateClient *client,
      D_MAGIC_ASSERT( client, CoreGraphicsStateClient );
      D_MAGIC_ASSERT( state, CardState );
 
+     /* Surfaces and the index translation are set by separate calls, which must not overtake recorded commands. */
+     if (flags & (SMF_DESTINATION | SMF_SOURCE | SMF_SOURCE_MASK | SMF_SOURCE2 | SMF_INDEX_TRANSLATION)) {
+          ret = CoreGraphicsStateClient_Submit( client );
+          if (ret)
+               return ret;
+     }
+
      if (flags & SMF_DRAWING_FLAGS) {
-          ret = CoreGraphicsState_SetDrawingFlags( client->gfx_state, state->drawingflags );
+          ret = CoreGraphicsStateClient_RecordValue( client, CGSC_DRAWING_FLAGS, &state->drawingflags,
+                                                     sizeof(state->drawingflags), 0 );
           if (ret)
                return ret;
      }
 
      if (flags & SMF_BLITTING_FLAGS) {
-          ret = CoreGraphicsState_SetBlittingFlags( client->gfx_state, state->blittingflags );
+          ret = CoreGraphicsStateClient_RecordValue( client, CGSC_BLITTING_FLAGS, &state->blittingflags,
+                                                     sizeof(state->blittingflags), 0 );
           if (ret)
                return ret;
      }
 
      if (flags & SMF_CLIP) {
-          ret = CoreGraphicsState_SetClip( client->gfx_state, &state->clip );
+          ret = CoreGraphicsStateClient_RecordValue( client, CGSC_CLIP, &state->clip, sizeof(state->clip), 0 );
           if (ret)
                return ret;
      }
 
      if (flags & SMF_COLOR) {
-          ret = CoreGraphicsState_SetColor( client->gfx_state, &state->color );
+          ret = CoreGraphicsStateClient_RecordValue( client, CGSC_COLOR, &state->color, sizeof(state->color), 0 );
           if (ret)
                return ret;
      }
 
      if (flags & SMF_SRC_BLEND) {
-          ret = CoreGraphicsState_SetSrcBlend( client->gfx_state, state->src_blend );
+          ret = CoreGraphicsStateClient_RecordValue( client, CGSC_SRC_BLEND, &state->src_blend,
+                                                     sizeof(state->src_blend), 0 );
           if (ret)
                return ret;
      }
 
      if (flags & SMF_DST_BLEND) {
-          ret = CoreGraphicsState_SetDstBlend( client->gfx_state, state->dst_blend );
+          ret = CoreGraphicsStateClient_RecordValue( client, CGSC_DST_BLEND, &state->dst_blend,
+                                                     sizeof(state->dst_blend), 0 );
           if (ret)
                return ret;
      }
 
      if (flags & SMF_SRC_COLORKEY) {
-          ret = CoreGraphicsState_SetSrcColorKey( client->gfx_state, state->src_colorkey );
+          ret = CoreGraphicsStateClient_RecordValue( client, CGSC_SRC_COLORKEY, &state->src_colorkey,
+                                                     sizeof(state->src_colorkey), 0 );
           if (ret)
                return ret;
      }
 
      if (flags & SMF_DST_COLORKEY) {
-          ret = CoreGraphicsState_SetDstColorKey( client->gfx_state, state->dst_colorkey );
+          ret = CoreGraphicsStateClient_RecordValue( client, CGSC_DST_COLORKEY, &state->dst_colorkey,
+                                                     sizeof(state->dst_colorkey), 0 );
           if (ret)
                return ret;
      }
@@ -279,8 +450,8 @@ CoreGraphicsStateClient_SetState( CoreGraphicsStateClient *client,
      }
 
      if (flags & SMF_SOURCE_MASK_VALS) {
-          ret = CoreGraphicsState_SetSourceMaskVals( client->gfx_state, &state->src_mask_offset,
-                                                     state->src_mask_flags );
+          ret = CoreGraphicsStateClient_RecordValue( client, CGSC_SOURCE_MASK_VALS, &state->src_mask_offset,
+                                                     sizeof(state->src_mask_offset), state->src_mask_flags );
           if (ret)
                return ret;
      }
@@ -293,19 +464,21 @@ CoreGraphicsStateClient_SetState( CoreGraphicsStateClient *client,
      }
 
      if (flags & SMF_COLORKEY) {
-          ret = CoreGraphicsState_SetColorKey( client->gfx_state, &state->colorkey );
+          ret = CoreGraphicsStateClient_RecordValue( client, CGSC_COLORKEY, &state->colorkey,
+                                                     sizeof(state->colorkey), 0 );
           if (ret)
                return ret;
      }
 
      if (flags & SMF_RENDER_OPTIONS) {
-          ret = CoreGraphicsState_SetRenderOptions( client->gfx_state, state->render_options );
+          ret = CoreGraphicsStateClient_RecordValue( client, CGSC_RENDER_OPTIONS, &state->render_options,
+                                                     sizeof(state->render_options), 0 );
           if (ret)
                return ret;
      }
 
      if (flags & SMF_MATRIX) {
-          ret = CoreGraphicsState_SetMatrix( client->gfx_state, state->matrix );
+          ret = CoreGraphicsStateClient_RecordValue( client, CGSC_MATRIX, state->matrix, sizeof(state->matrix), 0 );
           if (ret)
                return ret;
      }
@@ -317,19 +490,28 @@ CoreGraphicsStateClient_SetState( CoreGraphicsStateClient *client,
      }
 
      if (flags & SMF_FROM) {
-          ret = CoreGraphicsState_SetFrom( client->gfx_state, state->from, state->from_eye );
+          ret = CoreGraphicsStateClient_RecordValue( client, CGSC_FROM, &state->from,
+                                                     sizeof(state->from), state->from_eye );
           if (ret)
                return ret;
      }
 
      if (flags & SMF_TO) {
-          ret = CoreGraphicsState_SetTo( client->gfx_state, state->to, state->to_eye );
+          ret = CoreGraphicsStateClient_RecordValue( client, CGSC_TO, &state->to, sizeof(state->to), state->to_eye );
           if (ret)
                return ret;
      }
 
      if (flags & SMF_SRC_CONVOLUTION) {
-          ret = CoreGraphicsState_SetSrcConvolution( client->gfx_state, &state->src_convolution );
+          ret = CoreGraphicsStateClient_RecordValue( client, CGSC_SRC_CONVOLUTION, &state->src_convolution,
+                                                     sizeof(state->src_convolution), 0 );
+          if (ret)
+               return ret;
+     }
+
+     if (flags & SMF_SRC_COLORMATRIX) {
+          ret = CoreGraphicsStateClient_RecordValue( client, CGSC_SRC_COLORMATRIX, state->src_colormatrix,
+                                                     sizeof(state->src_colormatrix), 0 );
           if (ret)
                return ret;
      }
@@ -392,6 +574,9 @@ CoreGraphicsStateClient_Update( CoreGraphicsStateClient *client,
 
           if (state->blittingflags & DSBLIT_SRC_CONVOLUTION)
                flags |= SMF_SRC_CONVOLUTION;
+
+          if (state->blittingflags & DSBLIT_SRC_COLORMATRIX)
+               flags |= SMF_SRC_COLORMATRIX;
      }
 
      ret = CoreGraphicsStateClient_SetState( client, state, state->modified & flags );
@@ -422,6 +607,10 @@ CoreGraphicsStateClient_GetAccelerationMask( CoreGraphicsStateClient *client,
                                           (client->state->source2 ? DFXL_BLIT2 : DFXL_BLIT) : DFXL_FILLRECTANGLE,
                                           client->state );
 
+          ret = CoreGraphicsStateClient_Submit( client );
+          if (ret)
+               return ret;
+
           ret = CoreGraphicsState_GetAccelerationMask( client->gfx_state, ret_accel );
           if (ret)
                return ret;
@@ -448,7 +637,8 @@ CoreGraphicsStateClient_FillRectangles( CoreGraphicsStateClient *client,
 
           CoreGraphicsStateClient_Update( client, DFXL_FILLRECTANGLE, client->state );
 
-          ret = CoreGraphicsState_FillRectangles( client->gfx_state, rects, num );
+          ret = CoreGraphicsStateClient_RecordArrays( client, CGSC_FILL_RECTANGLES, 0, num, rects, sizeof(DFBRectangle),
+                                                      NULL, 0, NULL, 0 );
           if (ret)
                return ret;
      }
@@ -477,7 +667,8 @@ CoreGraphicsStateClient_DrawRectangles( CoreGraphicsStateClient *client,
 
           CoreGraphicsStateClient_Update( client, DFXL_DRAWRECTANGLE, client->state );
 
-          ret = CoreGraphicsState_DrawRectangles( client->gfx_state, rects, num );
+          ret = CoreGraphicsStateClient_RecordArrays( client, CGSC_DRAW_RECTANGLES, 0, num, rects, sizeof(DFBRectangle),
+                                                      NULL, 0, NULL, 0 );
           if (ret)
                return ret;
      }
@@ -503,7 +694,8 @@ CoreGraphicsStateClient_DrawLines( CoreGraphicsStateClient *client,
 
           CoreGraphicsStateClient_Update( client, DFXL_DRAWLINE, client->state );
 
-          ret = CoreGraphicsState_DrawLines( client->gfx_state, lines, num );
+          ret = CoreGraphicsStateClient_RecordArrays( client, CGSC_DRAW_LINES, 0, num, lines, sizeof(DFBRegion),
+                                                      NULL, 0, NULL, 0 );
           if (ret)
                return ret;
      }
@@ -529,7 +721,8 @@ CoreGraphicsStateClient_FillTriangles( CoreGraphicsStateClient *client,
 
           CoreGraphicsStateClient_Update( client, DFXL_FILLTRIANGLE, client->state );
 
-          ret = CoreGraphicsState_FillTriangles( client->gfx_state, triangles, num );
+          ret = CoreGraphicsStateClient_RecordArrays( client, CGSC_FILL_TRIANGLES, 0, num, triangles,
+                                                      sizeof(DFBTriangle), NULL, 0, NULL, 0 );
           if (ret)
                return ret;
      }
@@ -555,7 +748,8 @@ CoreGraphicsStateClient_FillTrapezoids( CoreGraphicsStateClient *client,
 
           CoreGraphicsStateClient_Update( client, DFXL_FILLTRAPEZOID, client->state );
 
-          ret = CoreGraphicsState_FillTrapezoids( client->gfx_state, trapezoids, num );
+          ret = CoreGraphicsStateClient_RecordArrays( client, CGSC_FILL_TRAPEZOIDS, 0, num, trapezoids,
+                                                      sizeof(DFBTrapezoid), NULL, 0, NULL, 0 );
           if (ret)
                return ret;
      }
@@ -581,7 +775,8 @@ CoreGraphicsStateClient_FillQuadrangles( CoreGraphicsStateClient *client,
 
           CoreGraphicsStateClient_Update( client, DFXL_FILLQUADRANGLE, client->state );
 
-          ret = CoreGraphicsState_FillQuadrangles( client->gfx_state, points, num );
+          ret = CoreGraphicsStateClient_RecordArrays( client, CGSC_FILL_QUADRANGLES, 0, num, points,
+                                                      4 * sizeof(DFBPoint), NULL, 0, NULL, 0 );
           if (ret)
                return ret;
      }
@@ -608,7 +803,8 @@ CoreGraphicsStateClient_FillSpans( CoreGraphicsStateClient *client,
 
           CoreGraphicsStateClient_Update( client, DFXL_FILLRECTANGLE, client->state );
 
-          ret = CoreGraphicsState_FillSpans( client->gfx_state, y, spans, num );
+          ret = CoreGraphicsStateClient_RecordArrays( client, CGSC_FILL_SPANS, y, num, spans, sizeof(DFBSpan),
+                                                      NULL, 0, NULL, 0 );
           if (ret)
                return ret;
      }
@@ -632,16 +828,14 @@ CoreGraphicsStateClient_Blit( CoreGraphicsStateClient *client,
           dfb_gfxcard_batchblit( (DFBRectangle*) rects, (DFBPoint*) points, num, client->state );
      }
      else {
-          DFBResult    ret;
-          unsigned int i;
+          DFBResult ret;
 
           CoreGraphicsStateClient_Update( client, DFXL_BLIT, client->state );
 
-          for (i = 0; i < num; i += 200) {
-               ret = CoreGraphicsState_Blit( client->gfx_state, &rects[i], &points[i], MIN( 200, num - i ) );
-               if (ret)
-                    return ret;
-          }
+          ret = CoreGraphicsStateClient_RecordArrays( client, CGSC_BLIT, 0, num, rects, sizeof(DFBRectangle),
+                                                      points, sizeof(DFBPoint), NULL, 0 );
+          if (ret)
+               return ret;
      }
 
      return DFB_OK;
@@ -669,7 +863,8 @@ CoreGraphicsStateClient_Blit2( CoreGraphicsStateClient *client,
 
           CoreGraphicsStateClient_Update( client, DFXL_BLIT2, client->state );
 
-          ret = CoreGraphicsState_Blit2( client->gfx_state, rects, points1, points2, num );
+          ret = CoreGraphicsStateClient_RecordArrays( client, CGSC_BLIT2, 0, num, rects, sizeof(DFBRectangle),
+                                                      points1, sizeof(DFBPoint), points2, sizeof(DFBPoint) );
           if (ret)
                return ret;
      }
@@ -713,14 +908,17 @@ CoreGraphicsStateClient_StretchBlit( CoreGraphicsStateClient *client,
                CoreGraphicsStateClient_Update( client, DFXL_BLIT, client->state );
 
                DFBPoint point = { drects[0].x, drects[0].y };
-               ret = CoreGraphicsState_Blit( client->gfx_state, srects, &point, 1 );
+               ret = CoreGraphicsStateClient_RecordArrays( client, CGSC_BLIT, 0, 1, srects, sizeof(DFBRectangle),
+                                                           &point, sizeof(DFBPoint), NULL, 0 );
                if (ret)
                     return ret;
           }
           else {
                CoreGraphicsStateClient_Update( client, DFXL_STRETCHBLIT, client->state );
 
-               ret = CoreGraphicsState_StretchBlit( client->gfx_state, srects, drects, num );
+               ret = CoreGraphicsStateClient_RecordArrays( client, CGSC_STRETCH_BLIT, 0, num,
+                                                           srects, sizeof(DFBRectangle),
+                                                           drects, sizeof(DFBRectangle), NULL, 0 );
                if (ret)
                     return ret;
           }
@@ -755,7 +953,8 @@ CoreGraphicsStateClient_TileBlit( CoreGraphicsStateClient *client,
 
           CoreGraphicsStateClient_Update( client, DFXL_BLIT, client->state );
 
-          ret = CoreGraphicsState_TileBlit( client->gfx_state, rects, points1, points2, num );
+          ret = CoreGraphicsStateClient_RecordArrays( client, CGSC_TILE_BLIT, 0, num, rects, sizeof(DFBRectangle),
+                                                      points1, sizeof(DFBPoint), points2, sizeof(DFBPoint) );
           if (ret)
                return ret;
      }
@@ -782,9 +981,22 @@ CoreGraphicsStateClient_TextureTriangles( CoreGraphicsStateClient *client,
 
           CoreGraphicsStateClient_Update( client, DFXL_TEXTRIANGLES, client->state );
 
-          ret = CoreGraphicsState_TextureTriangles( client->gfx_state, vertices, num, formation );
-          if (ret)
-               return ret;
+          /* The triangles can not be split, a large number of them is rendered by a separate call. */
+          if (sizeof(CoreGraphicsStateCommand) + num * sizeof(DFBVertex) <= COMMANDS_SIZE) {
+               ret = CoreGraphicsStateClient_RecordArrays( client, CGSC_TEXTURE_TRIANGLES, formation, num,
+                                                           vertices, sizeof(DFBVertex), NULL, 0, NULL, 0 );
+               if (ret)
+                    return ret;
+          }
+          else {
+               ret = CoreGraphicsStateClient_Submit( client );
+               if (ret)
+                    return ret;
+
+               ret = CoreGraphicsState_TextureTriangles( client->gfx_state, vertices, num, formation );
+               if (ret)
+                    return ret;
+          }
      }
 
      return DFB_OK;
@@ -32,6 +32,14 @@ struct __DFB_CoreGraphicsStateClient {
      CardState         *state;     /* Local state structure. */
 
      CoreGraphicsState *gfx_state; /* Remote object for rendering, syncing values from local state as needed. */
+
+     u8                *commands;  /* State changes and operations recorded for the remote object. */
+     unsigned int       length;    /* Length of the recorded commands, executed by CoreGraphicsStateClient_Flush(). */
+
+     /* Executes the recorded commands, CoreGraphicsState_Execute() unless replaced, e.g. by a test. */
+     DFBResult        (*Execute)( CoreGraphicsState *obj,
+                                  const u8          *commands,
+                                  u32                length );
 };
 
 /**********************************************************************************************************************/
@@ -498,6 +498,219 @@ IGraphicsState_Real__TextureTriangles( CoreGraphicsState    *obj,
      return DFB_OK;
 }
 
+static DFBResult
+execute_command( CoreGraphicsState              *obj,
+                 const CoreGraphicsStateCommand *command )
+{
+     const u8 *args = (const u8*) (command + 1);
+     u32       num  = command->num;
+
+/* Check the length of the value or arrays of the command. */
+#define CHECK_LENGTH(size)                                 \
+     do {                                                  \
+          if (command->length != (u64) num * (size))       \
+               return DFB_INVARG;                          \
+     } while (0)
+
+     switch (command->type) {
+          case CGSC_DRAWING_FLAGS:
+               num = 1;
+               CHECK_LENGTH( sizeof(DFBSurfaceDrawingFlags) );
+               return IGraphicsState_Real__SetDrawingFlags( obj, *(const DFBSurfaceDrawingFlags*) args );
+
+          case CGSC_BLITTING_FLAGS:
+               num = 1;
+               CHECK_LENGTH( sizeof(DFBSurfaceBlittingFlags) );
+               return IGraphicsState_Real__SetBlittingFlags( obj, *(const DFBSurfaceBlittingFlags*) args );
+
+          case CGSC_CLIP:
+               num = 1;
+               CHECK_LENGTH( sizeof(DFBRegion) );
+               return IGraphicsState_Real__SetClip( obj, (const DFBRegion*) args );
+
+          case CGSC_COLOR:
+               num = 1;
+               CHECK_LENGTH( sizeof(DFBColor) );
+               return IGraphicsState_Real__SetColor( obj, (const DFBColor*) args );
+
+          case CGSC_COLOR_AND_INDEX:
+               num = 1;
+               CHECK_LENGTH( sizeof(DFBColor) );
+               return IGraphicsState_Real__SetColorAndIndex( obj, (const DFBColor*) args, command->param );
+
+          case CGSC_SRC_BLEND:
+               num = 1;
+               CHECK_LENGTH( sizeof(DFBSurfaceBlendFunction) );
+               return IGraphicsState_Real__SetSrcBlend( obj, *(const DFBSurfaceBlendFunction*) args );
+
+          case CGSC_DST_BLEND:
+               num = 1;
+               CHECK_LENGTH( sizeof(DFBSurfaceBlendFunction) );
+               return IGraphicsState_Real__SetDstBlend( obj, *(const DFBSurfaceBlendFunction*) args );
+
+          case CGSC_SRC_COLORKEY:
+               num = 1;
+               CHECK_LENGTH( sizeof(u32) );
+               return IGraphicsState_Real__SetSrcColorKey( obj, *(const u32*) args );
+
+          case CGSC_DST_COLORKEY:
+               num = 1;
+               CHECK_LENGTH( sizeof(u32) );
+               return IGraphicsState_Real__SetDstColorKey( obj, *(const u32*) args );
+
+          case CGSC_SOURCE_MASK_VALS:
+               num = 1;
+               CHECK_LENGTH( sizeof(DFBPoint) );
+               return IGraphicsState_Real__SetSourceMaskVals( obj, (const DFBPoint*) args, command->param );
+
+          case CGSC_COLORKEY:
+               num = 1;
+               CHECK_LENGTH( sizeof(DFBColorKey) );
+               return IGraphicsState_Real__SetColorKey( obj, (const DFBColorKey*) args );
+
+          case CGSC_RENDER_OPTIONS:
+               num = 1;
+               CHECK_LENGTH( sizeof(DFBSurfaceRenderOptions) );
+               return IGraphicsState_Real__SetRenderOptions( obj, *(const DFBSurfaceRenderOptions*) args );
+
+          case CGSC_MATRIX:
+               num = 9;
+               CHECK_LENGTH( sizeof(s32) );
+               return IGraphicsState_Real__SetMatrix( obj, (const s32*) args );
+
+          case CGSC_FROM:
+               num = 1;
+               CHECK_LENGTH( sizeof(DFBSurfaceBufferRole) );
+               return IGraphicsState_Real__SetFrom( obj, *(const DFBSurfaceBufferRole*) args, command->param );
+
+          case CGSC_TO:
+               num = 1;
+               CHECK_LENGTH( sizeof(DFBSurfaceBufferRole) );
+               return IGraphicsState_Real__SetTo( obj, *(const DFBSurfaceBufferRole*) args, command->param );
+
+          case CGSC_SRC_CONVOLUTION:
+               num = 1;
+               CHECK_LENGTH( sizeof(DFBConvolutionFilter) );
+               return IGraphicsState_Real__SetSrcConvolution( obj, (const DFBConvolutionFilter*) args );
+
+          case CGSC_SRC_COLORMATRIX:
+               num = 12;
+               CHECK_LENGTH( sizeof(s32) );
+               return IGraphicsState_Real__SetSrcColorMatrix( obj, (const s32*) args );
+
+          case CGSC_RELEASE_SOURCE:
+               CHECK_LENGTH( 0 );
+               return IGraphicsState_Real__ReleaseSource( obj );
+
+          case CGSC_FILL_RECTANGLES:
+               CHECK_LENGTH( sizeof(DFBRectangle) );
+               return IGraphicsState_Real__FillRectangles( obj, (const DFBRectangle*) args, num );
+
+          case CGSC_DRAW_RECTANGLES:
+               CHECK_LENGTH( sizeof(DFBRectangle) );
+               return IGraphicsState_Real__DrawRectangles( obj, (const DFBRectangle*) args, num );
+
+          case CGSC_DRAW_LINES:
+               CHECK_LENGTH( sizeof(DFBRegion) );
+               return IGraphicsState_Real__DrawLines( obj, (const DFBRegion*) args, num );
+
+          case CGSC_FILL_TRIANGLES:
+               CHECK_LENGTH( sizeof(DFBTriangle) );
+               return IGraphicsState_Real__FillTriangles( obj, (const DFBTriangle*) args, num );
+
+          case CGSC_FILL_TRAPEZOIDS:
+               CHECK_LENGTH( sizeof(DFBTrapezoid) );
+               return IGraphicsState_Real__FillTrapezoids( obj, (const DFBTrapezoid*) args, num );
+
+          case CGSC_FILL_QUADRANGLES:
+               CHECK_LENGTH( 4 * sizeof(DFBPoint) );
+               return IGraphicsState_Real__FillQuadrangles( obj, (const DFBPoint*) args, num );
+
+          case CGSC_FILL_SPANS:
+               CHECK_LENGTH( sizeof(DFBSpan) );
+               return IGraphicsState_Real__FillSpans( obj, command->param, (const DFBSpan*) args, num );
+
+          case CGSC_BLIT:
+               CHECK_LENGTH( sizeof(DFBRectangle) + sizeof(DFBPoint) );
+               return IGraphicsState_Real__Blit( obj, (const DFBRectangle*) args,
+                                                 (const DFBPoint*) (args + num * sizeof(DFBRectangle)), num );
+
+          case CGSC_BLIT2:
+               CHECK_LENGTH( sizeof(DFBRectangle) + 2 * sizeof(DFBPoint) );
+               return IGraphicsState_Real__Blit2( obj, (const DFBRectangle*) args,
+                                                  (const DFBPoint*) (args + num * sizeof(DFBRectangle)),
+                                                  (const DFBPoint*) (args + num * (sizeof(DFBRectangle) +
+                                                                                   sizeof(DFBPoint))), num );
+
+          case CGSC_STRETCH_BLIT:
+               CHECK_LENGTH( 2 * sizeof(DFBRectangle) );
+               return IGraphicsState_Real__StretchBlit( obj, (const DFBRectangle*) args,
+                                                        (const DFBRectangle*) (args + num * sizeof(DFBRectangle)),
+                                                        num );
+
+          case CGSC_TILE_BLIT:
+               CHECK_LENGTH( sizeof(DFBRectangle) + 2 * sizeof(DFBPoint) );
+               return IGraphicsState_Real__TileBlit( obj, (const DFBRectangle*) args,
+                                                     (const DFBPoint*) (args + num * sizeof(DFBRectangle)),
+                                                     (const DFBPoint*) (args + num * (sizeof(DFBRectangle) +
+                                                                                      sizeof(DFBPoint))), num );
+
+          case CGSC_TEXTURE_TRIANGLES:
+               CHECK_LENGTH( sizeof(DFBVertex) );
+
+               if (num < 3)
+                    return DFB_INVARG;
+
+               return IGraphicsState_Real__TextureTriangles( obj, (const DFBVertex*) args, num, command->param );
+
+          default:
+               break;
+     }
+
+#undef CHECK_LENGTH
+
+     return DFB_INVARG;
+}
+
+DFBResult
+IGraphicsState_Real__Execute( CoreGraphicsState *obj,
+                              const u8          *commands,
+                              u32                length )
+{
+     DFBResult ret;
+     DFBResult result = DFB_OK;
+     u32       offset = 0;
+
+     D_DEBUG_AT( DirectFB_CoreGraphicsState, "%s( %p, %u )\n", __FUNCTION__, obj, length );
+
+     D_ASSERT( commands != NULL );
+
+     while (offset < length) {
+          const CoreGraphicsStateCommand *command = (const CoreGraphicsStateCommand*) (commands + offset);
+
+          if (length - offset < sizeof(CoreGraphicsStateCommand) ||
+              command->length > length - offset - sizeof(CoreGraphicsStateCommand) || command->length & 3) {
+               D_DEBUG_AT( DirectFB_CoreGraphicsState, "  -> invalid command at offset %u\n", offset );
+               return DFB_INVARG;
+          }
+
+          D_DEBUG_AT( DirectFB_CoreGraphicsState, "  -> type %u, num %u, length %u\n",
+                      command->type, command->num, command->length );
+
+          /* Like separate calls, a failing command does not prevent the following ones. */
+          ret = execute_command( obj, command );
+          if (ret == DFB_INVARG)
+               return ret;
+
+          if (ret && !result)
+               result = ret;
+
+          offset += sizeof(CoreGraphicsStateCommand) + command->length;
+     }
+
+     return result;
+}
+
 DFBResult
 IGraphicsState_Real__Flush( CoreGraphicsState *obj )
 {
@@ -533,6 +746,19 @@ IGraphicsState_Real__SetSrcConvolution( CoreGraphicsState          *obj,
      return DFB_OK;
 }
 
+DFBResult
+IGraphicsState_Real__SetSrcColorMatrix( CoreGraphicsState *obj,
+                                        const s32         *matrix )
+{
+     D_DEBUG_AT( DirectFB_CoreGraphicsState, "%s( %p )\n", __FUNCTION__, obj );
+
+     D_ASSERT( matrix != NULL );
+
+     dfb_state_set_src_colormatrix( &obj->state, matrix );
+
+     return DFB_OK;
+}
+
 DFBResult
 IGraphicsState_Real__GetAccelerationMask( CoreGraphicsState   *obj,
                                           DFBAccelerationMask *ret_accel )
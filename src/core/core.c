@@ -21,6 +21,7 @@
 #include <core/core.h>
 #include <core/core_parts.h>
 #include <core/fonts.h>
+#include <core/gfxcard.h>
 #include <core/graphics_state.h>
 #include <core/layer_context.h>
 #include <core/palette.h>
@@ -1665,6 +1666,9 @@ dfb_core_shutdown( CoreDFB *core,
 
      dfb_core_enum_layer_regions( core, region_callback, core );
 
+     /* Finish pending rendering, queued operations hold references to the surfaces. */
+     dfb_gfxcard_sync();
+
      fusion_stop_dispatcher( core->world, false );
 
      while (loops--) {
@@ -33,6 +33,8 @@ typedef struct __DFB_CoreFont                CoreFont;
 typedef struct __DFB_CoreFontCache           CoreFontCache;
 typedef struct __DFB_CoreFontCacheRow        CoreFontCacheRow;
 typedef struct __DFB_CoreFontManager         CoreFontManager;
+typedef struct __DFB_CoreFontSharedFace      CoreFontSharedFace;
+typedef struct __DFB_CoreFontSharedPage      CoreFontSharedPage;
 typedef struct __DFB_CoreGlyphData           CoreGlyphData;
 typedef struct __DFB_CoreInputDevice         CoreInputDevice;
 typedef struct __DFB_CoreLayer               CoreLayer;
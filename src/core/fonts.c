@@ -16,20 +16,34 @@
    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
 */
 
+#include <config.h>
 #include <core/core.h>
 #include <core/fonts.h>
 #include <core/gfxcard.h>
 #include <core/surface.h>
+#include <core/surface_buffer.h>
 #include <direct/hash.h>
 #include <direct/map.h>
+#include <direct/memcpy.h>
 #include <direct/utf8.h>
 #include <directfb_util.h>
+#include <fusion/conf.h>
+#include <fusion/hash.h>
+#include <fusion/ref.h>
+#include <fusion/shmalloc.h>
+#include <stddef.h>
+
+#ifdef USE_SSE2
+#include <emmintrin.h>
+#endif
 
 D_DEBUG_DOMAIN( Core_Font,         "Core/Font",          "DirectFB Core Font" );
 D_DEBUG_DOMAIN( Font_Cache,        "Core/Font/Cache",    "DirectFB Core Font Cache" );
 D_DEBUG_DOMAIN( Font_CacheRow,     "Core/Font/CacheRow", "DirectFB Core Font Cache Row" );
 D_DEBUG_DOMAIN( Core_FontSurfaces, "Core/Font/Surf",     "DirectFB Core Font Surfaces" );
 D_DEBUG_DOMAIN( Font_Manager,      "Core/Font/Manager",  "DirectFB Core Font Manager" );
+D_DEBUG_DOMAIN( Font_TextRun,      "Core/Font/TextRun",  "DirectFB Core Font Text Run" );
+D_DEBUG_DOMAIN( Font_Shared,       "Core/Font/Shared",   "DirectFB Core Font Shared Cache" );
 
 /**********************************************************************************************************************/
 
@@ -40,26 +54,114 @@ struct __DFB_CoreFontCache {
 
      CoreFontCacheType  type;
 
-     unsigned int       row_width;
+     int                page_size;
+     int                align;         /* horizontal alignment of glyphs minus one */
+
+     DirectLink        *pages;         /* freshest is first */
 
-     DirectLink        *rows;
+     CoreSurface       *staging;       /* for glyphs rendered below the top of a page */
 };
 
+typedef struct {
+     DirectLink         link;
+
+     int                magic;
+
+     CoreFontCache     *cache;
+
+     CoreSurface       *surface;
+     int                width;
+     int                height;
+
+     int                next_y;        /* top of the free space at the bottom */
+
+     DirectLink        *rows;          /* sorted by y, without adjacent empty rows nor an empty last row */
+} CoreFontCachePage;
+
 struct __DFB_CoreFontCacheRow {
-     DirectLink           link;
+     DirectLink          link;
+
+     int                 magic;
+
+     CoreFontCachePage  *page;
+
+     int                 y;
+     int                 height;
 
+     DirectLink         *glyphs;       /* sorted by start */
+};
+
+/*
+ * Glyph cache shared by all processes in multi application mode, glyphs are placed in rows of shared surfaces.
+ *
+ * When the cache is full, the least recently used page of the format is cleared and reused as a whole, which is noticed
+ * by the processes using its glyphs from the changed serial. Pages are referenced by each process while it blits their
+ * glyphs, i.e. until the font manager is unlocked, and are not reused meanwhile. Their surfaces stay valid until the
+ * cache is destroyed.
+ */
+typedef struct {
      int                  magic;
 
-     CoreFontCache       *cache;
+     FusionSHMPoolShared *shmpool;
+     FusionSkirmish       lock;
+
+     FusionHash          *faces;       /* CoreFontSharedFace by font identity */
+
+     DirectLink          *pages;
+     unsigned int         max_pages;
+     unsigned int         num_pages;
+     int                  page_size;
+
+     u64                  stamp;
+} CoreFontShared;
 
-     unsigned long long   stamp;
+struct __DFB_CoreFontSharedFace {
+     int                  magic;
+
+     FusionHash          *glyphs;      /* CoreFontSharedGlyph by index and layer */
+};
+
+struct __DFB_CoreFontSharedPage {
+     DirectLink           link;
+
+     int                  magic;
 
      CoreSurface         *surface;
-     unsigned int         next_x;
+     CoreFontCacheType    type;
+     int                  width;
+     int                  height;
+     int                  align;       /* horizontal alignment of glyphs minus one */
+
+     int                  row_y;       /* top of the current row */
+     int                  row_height;
+     int                  row_x;       /* left of the free space in the current row */
 
      DirectLink          *glyphs;
+
+     FusionRef            ref;         /* processes blitting glyphs of the page */
+     unsigned int         serial;      /* incremented each time the page is reused */
+     u64                  stamp;       /* last use, for eviction */
 };
 
+typedef struct {
+     DirectLink           link;
+
+     int                  magic;
+
+     CoreFontSharedFace  *face;
+     unsigned long        key;
+
+     CoreFontSharedPage  *page;        /* NULL if the glyph has no bitmap */
+     int                  start;
+     int                  start_y;
+     int                  width;
+     int                  height;
+     int                  left;
+     int                  top;
+     int                  xadvance;
+     int                  yadvance;
+} CoreFontSharedGlyph;
+
 struct __DFB_CoreFontManager {
      int                 magic;
 
@@ -69,11 +171,29 @@ struct __DFB_CoreFontManager {
 
      DirectMap          *caches;
 
-     unsigned int        max_rows;
-     unsigned int        num_rows;
-     unsigned long long  row_stamp;
+     unsigned int        max_pages;
+     unsigned int        num_pages;
+     DirectLink         *glyphs_lru;       /* glyphs placed in pages, most recently used is first */
+     int                 pinned;           /* most recently used glyphs that must not be evicted */
+
+     DirectMap          *runs;
+     DirectLink         *runs_lru;         /* most recently used is first */
+     CoreTextRunStats    run_stats;
+
+     CoreFontShared     *shared;           /* NULL if glyphs are not shared with other processes */
+     CoreFontSharedPage **shared_refs;     /* shared pages referenced until the lock is released */
+     unsigned int        num_shared_refs;
+
+     int                 locked;           /* recursion depth of the lock */
 };
 
+typedef struct {
+     const CoreFont     *font;
+     unsigned int        layer;
+     const unsigned int *indices;
+     int                 num;
+} TextRunKey;
+
 /**********************************************************************************************************************/
 
 DFBResult
@@ -109,8 +229,6 @@ dfb_font_manager_destroy( CoreFontManager *manager )
      D_DEBUG_AT( Font_Manager, "%s()\n", __FUNCTION__ );
 
      D_MAGIC_ASSERT( manager, CoreFontManager );
-     D_ASSERT( manager->max_rows > 0 );
-     D_ASSERT( manager->num_rows <= manager->max_rows );
 
      dfb_font_manager_deinit( manager );
 
@@ -138,9 +256,67 @@ font_cache_map_hash( DirectMap  *map,
 {
      const CoreFontCacheType *type = key;
 
-     return (type->height * 131 + type->pixel_format) * 131 + type->surface_caps;
+     return type->pixel_format * 131 + type->surface_caps;
+}
+
+static bool
+text_run_map_compare( DirectMap  *map,
+                      const void *key,
+                      void       *object,
+                      void       *ctx )
+{
+     const TextRunKey *run_key = key;
+     CoreTextRun      *run     = object;
+
+     return run->font == run_key->font && run->layer == run_key->layer && run->num == run_key->num &&
+            memcmp( run->indices, run_key->indices, run_key->num * sizeof(unsigned int) ) == 0;
+}
+
+static unsigned int
+text_run_map_hash( DirectMap  *map,
+                   const void *key,
+                   void       *ctx )
+{
+     const TextRunKey *run_key = key;
+     unsigned int      hash    = (unsigned long) run_key->font * 131 + run_key->layer;
+     int               i;
+
+     for (i = 0; i < run_key->num; i++)
+          hash = hash * 131 + run_key->indices[i];
+
+     return hash;
+}
+
+static void
+text_run_remove( CoreFontManager *manager,
+                 CoreTextRun     *run )
+{
+     TextRunKey key = { run->font, run->layer, run->indices, run->num };
+
+     D_DEBUG_AT( Font_TextRun, "%s( %p )\n", __FUNCTION__, run );
+
+     D_MAGIC_ASSERT( run, CoreTextRun );
+     D_ASSERT( manager->run_stats.num_runs > 0 );
+     D_ASSERT( manager->run_stats.size >= run->size );
+
+     direct_map_remove( manager->runs, &key );
+     direct_list_remove( &manager->runs_lru, &run->link );
+
+     manager->run_stats.num_runs--;
+     manager->run_stats.size -= run->size;
+
+     if (run->surface)
+          dfb_surface_unref( run->surface );
+
+     D_MAGIC_CLEAR( run );
+
+     D_FREE( run );
 }
 
+static void font_shared_create ( CoreFontManager *manager );
+
+static void font_shared_release( CoreFontManager *manager );
+
 DFBResult
 dfb_font_manager_init( CoreFontManager *manager,
                        CoreDFB         *core )
@@ -153,16 +329,41 @@ dfb_font_manager_init( CoreFontManager *manager,
      D_ASSERT( manager != NULL );
 
      manager->core      = core;
-     manager->max_rows  = dfb_config->max_font_rows;
+     manager->max_pages = dfb_config->max_font_pages;
 
      ret = direct_map_create( 11, font_cache_map_compare, font_cache_map_hash, NULL, &manager->caches );
      if (ret)
           return ret;
 
+     ret = direct_map_create( 47, text_run_map_compare, text_run_map_hash, NULL, &manager->runs );
+     if (ret) {
+          direct_map_destroy( manager->caches );
+          return ret;
+     }
+
+     manager->run_stats.budget = MAX( dfb_config->font_run_cache, 0 );
+
      direct_recursive_mutex_init( &manager->lock );
 
      D_MAGIC_SET( manager, CoreFontManager );
 
+     /* The master sets up the shared glyph cache, other processes use it if available. */
+     if (dfb_core_is_master( core )) {
+          if (FUSION_BUILD_MULTI && dfb_config->font_shared_pages > 0 && !fusion_config->secure_fusion)
+               font_shared_create( manager );
+     }
+     else
+          core_arena_get_shared_field( core, "Core/Font/Shared", (void**) &manager->shared );
+
+     /* Each page is referenced at most once at a time. */
+     if (manager->shared) {
+          manager->shared_refs = D_CALLOC( manager->shared->max_pages, sizeof(CoreFontSharedPage*) );
+          if (!manager->shared_refs) {
+               D_OOM();
+               manager->shared = NULL;
+          }
+     }
+
      return DFB_OK;
 }
 
@@ -188,12 +389,21 @@ dfb_font_manager_deinit( CoreFontManager *manager )
      D_DEBUG_AT( Font_Manager, "%s()\n", __FUNCTION__ );
 
      D_MAGIC_ASSERT( manager, CoreFontManager );
-     D_ASSERT( manager->max_rows > 0 );
-     D_ASSERT( manager->num_rows <= manager->max_rows );
+
+     D_DEBUG_AT( Font_TextRun, "  -> %llu hits, %llu misses, %llu evictions\n",
+                 manager->run_stats.hits, manager->run_stats.misses, manager->run_stats.evictions );
+
+     while (manager->runs_lru)
+          text_run_remove( manager, (CoreTextRun*) manager->runs_lru );
+
+     direct_map_destroy( manager->runs );
 
      direct_map_iterate( manager->caches, destroy_caches, NULL );
      direct_map_destroy( manager->caches );
 
+     if (manager->shared_refs)
+          D_FREE( manager->shared_refs );
+
      direct_mutex_deinit( &manager->lock );
 
      D_MAGIC_CLEAR( manager );
@@ -207,11 +417,11 @@ dfb_font_manager_lock( CoreFontManager *manager )
      D_DEBUG_AT( Font_Manager, "%s()\n", __FUNCTION__ );
 
      D_MAGIC_ASSERT( manager, CoreFontManager );
-     D_ASSERT( manager->max_rows > 0 );
-     D_ASSERT( manager->num_rows <= manager->max_rows );
 
      direct_mutex_lock( &manager->lock );
 
+     manager->locked++;
+
      return DFB_OK;
 }
 
@@ -221,8 +431,11 @@ dfb_font_manager_unlock( CoreFontManager *manager )
      D_DEBUG_AT( Font_Manager, "%s()\n", __FUNCTION__ );
 
      D_MAGIC_ASSERT( manager, CoreFontManager );
-     D_ASSERT( manager->max_rows > 0 );
-     D_ASSERT( manager->num_rows <= manager->max_rows );
+     D_ASSERT( manager->locked > 0 );
+
+     /* The blits of the glyphs looked up under the lock have been issued. */
+     if (!--manager->locked && manager->num_shared_refs)
+          font_shared_release( manager );
 
      direct_mutex_unlock( &manager->lock );
 
@@ -237,29 +450,22 @@ dfb_font_manager_get_cache( CoreFontManager          *manager,
      D_DEBUG_AT( Font_Manager, "%s()\n", __FUNCTION__ );
 
      D_MAGIC_ASSERT( manager, CoreFontManager );
-     D_ASSERT( manager->max_rows > 0 );
-     D_ASSERT( manager->num_rows <= manager->max_rows );
      D_ASSERT( type != NULL );
      D_ASSERT( ret_cache != NULL );
 
-     D_DEBUG_AT( Font_Manager, "  -> height %u, format 0x%x, caps 0x%x\n",
-                 type->height, (unsigned int) type->pixel_format, (unsigned int) type->surface_caps );
+     D_DEBUG_AT( Font_Manager, "  -> format 0x%x, caps 0x%x\n",
+                 (unsigned int) type->pixel_format, (unsigned int) type->surface_caps );
 
      DFBResult      ret;
      CoreFontCache *cache;
 
-     CoreFontCacheType _type = *type;
-
-     if (_type.height < 8)
-          _type.height = 8;
-
-     cache = direct_map_lookup( manager->caches, &_type );
+     cache = direct_map_lookup( manager->caches, type );
      if (!cache) {
-          ret = dfb_font_cache_create( manager, &_type, &cache );
+          ret = dfb_font_cache_create( manager, type, &cache );
           if (ret)
                return ret;
 
-          ret = direct_map_insert( manager->caches, &_type, cache );
+          ret = direct_map_insert( manager->caches, type, cache );
           if (ret) {
                dfb_font_cache_destroy( cache );
                return ret;
@@ -271,70 +477,168 @@ dfb_font_manager_get_cache( CoreFontManager          *manager,
      return DFB_OK;
 }
 
-typedef struct {
-     unsigned int      lru_stamp;
-     CoreFontCacheRow *lru_row;
-} FindLruRowContext;
+static __inline__ CoreGlyphData *
+font_glyph_of_lru( DirectLink *link )
+{
+     return (CoreGlyphData*) ((u8*) link - offsetof( CoreGlyphData, lru ));
+}
 
-static DirectEnumerationResult
-find_lru_row( DirectMap *map,
-              void      *object,
-              void      *ctx )
+/*
+ * Mark a glyph as used, the stamp of a shared page is set without locking as it's only a hint for eviction.
+ */
+static __inline__ void
+font_glyph_touch( CoreFontManager *manager,
+                  CoreGlyphData   *data )
 {
-     FindLruRowContext *context = ctx;
-     CoreFontCache     *cache   = object;
-     CoreFontCacheRow  *row;
+     if (data->row)
+          direct_list_move_to_front( &manager->glyphs_lru, &data->lru );
+     else if (data->shared_page)
+          data->shared_page->stamp = ++manager->shared->stamp;
+}
 
-     D_DEBUG_AT( Font_Manager, "%s( %p )\n", __FUNCTION__, cache );
+static bool
+font_shared_page_referenced( CoreFontManager    *manager,
+                             CoreFontSharedPage *page )
+{
+     unsigned int i;
 
-     D_MAGIC_ASSERT( cache, CoreFontCache );
+     for (i = 0; i < manager->num_shared_refs; i++) {
+          if (manager->shared_refs[i] == page)
+               return true;
+     }
 
-     direct_list_foreach (row, cache->rows) {
-          D_DEBUG_AT( Font_Manager, "  -> stamp %llu\n", row->stamp );
+     return false;
+}
 
-          if (!context->lru_row || context->lru_stamp > row->stamp) {
-               context->lru_row   = row;
-               context->lru_stamp = row->stamp;
-          }
+/*
+ * Reference a shared page until the font manager is unlocked, the shared cache must be locked.
+ */
+static DFBResult
+font_shared_page_ref( CoreFontManager    *manager,
+                      CoreFontSharedPage *page )
+{
+     DFBResult ret;
+
+     if (font_shared_page_referenced( manager, page ))
+          return DFB_OK;
+
+     D_ASSERT( manager->num_shared_refs < manager->shared->max_pages );
+
+     ret = fusion_ref_up( &page->ref, false );
+     if (ret)
+          return ret;
+
+     manager->shared_refs[manager->num_shared_refs++] = page;
+
+     return DFB_OK;
+}
+
+/*
+ * Check if a glyph is usable, it needs to be loaded again if that failed before or if its shared page has been reused.
+ * Otherwise its shared page is referenced.
+ */
+static bool
+font_glyph_acquire( CoreFontManager *manager,
+                    CoreGlyphData   *data )
+{
+     bool valid;
+
+     if (data->retry)
+          return false;
+
+     if (!data->shared_page)
+          return true;
+
+     /* A page referenced by this process is not reused. */
+     if (font_shared_page_referenced( manager, data->shared_page ))
+          return data->shared_page->serial == data->shared_serial;
+
+     if (fusion_skirmish_prevail( &manager->shared->lock ))
+          return false;
+
+     valid = data->shared_page->serial == data->shared_serial &&
+             font_shared_page_ref( manager, data->shared_page ) == DFB_OK;
+
+     fusion_skirmish_dismiss( &manager->shared->lock );
+
+     return valid;
+}
+
+static void
+font_glyph_forget( CoreGlyphData *glyph )
+{
+     CoreFont *font = glyph->font;
+
+     D_MAGIC_ASSERT( glyph, CoreGlyphData );
+     D_ASSERT( glyph->layer < D_ARRAY_SIZE(font->layers) );
+
+     direct_hash_remove( font->layers[glyph->layer].glyph_hash, glyph->index );
+
+     if (glyph->index < DFB_FONT_GLYPH_PAGES * DFB_FONT_GLYPH_PAGE_SIZE) {
+          CoreGlyphData **page = font->layers[glyph->layer].glyph_pages[glyph->index >> DFB_FONT_GLYPH_PAGE_BITS];
+
+          if (page)
+               page[glyph->index & (DFB_FONT_GLYPH_PAGE_SIZE - 1)] = NULL;
      }
 
-     return DENUM_OK;
+     D_MAGIC_CLEAR( glyph );
+     D_FREE( glyph );
 }
 
 DFBResult
-dfb_font_manager_remove_lru_row( CoreFontManager *manager )
+dfb_font_manager_evict_glyph( CoreFontManager *manager )
 {
-     FindLruRowContext  context;
-     CoreFontCache     *cache;
+     DirectLink    *link;
+     CoreGlyphData *glyph;
 
      D_DEBUG_AT( Font_Manager, "%s()\n", __FUNCTION__ );
 
      D_MAGIC_ASSERT( manager, CoreFontManager );
-     D_ASSERT( manager->max_rows > 0 );
-     D_ASSERT( manager->num_rows <= manager->max_rows );
 
-     context.lru_stamp = 0;
-     context.lru_row   = NULL;
+     link = direct_list_get_last( manager->glyphs_lru );
+     if (!link) {
+          D_ERROR( "Core/Font: Could not find any LRU glyph!\n" );
+          return DFB_ITEMNOTFOUND;
+     }
 
-     direct_map_iterate( manager->caches, find_lru_row, &context );
+     /* Glyphs looked up by dfb_font_get_glyph_data_array() are still to be used, they are at the front. */
+     if (manager->pinned) {
+          DirectLink *pinned = manager->glyphs_lru;
+          int         i;
 
-     if (!context.lru_row) {
-          D_ERROR( "Core/Font: Could not find any LRU row!\n" );
-          return DFB_ITEMNOTFOUND;
+          for (i = 0; i < manager->pinned && pinned; i++, pinned = pinned->next) {
+               if (pinned == link) {
+                    D_DEBUG_AT( Font_Manager, "  -> all %d glyphs are pinned\n", i + 1 );
+                    return DFB_LIMITEXCEEDED;
+               }
+          }
      }
 
-     D_DEBUG_AT( Font_Manager, "  -> row %p (stamp %llu)\n", context.lru_row, context.lru_row->stamp );
+     glyph = font_glyph_of_lru( link );
 
-     cache = context.lru_row->cache;
+     D_DEBUG_AT( Font_Manager, "  -> glyph %p (index %u)\n", glyph, glyph->index );
 
-     D_MAGIC_ASSERT( cache, CoreFontCache );
+     dfb_font_cache_free_glyph( glyph );
+
+     font_glyph_forget( glyph );
+
+     return DFB_OK;
+}
+
+DFBResult
+dfb_font_manager_get_run_stats( CoreFontManager  *manager,
+                                CoreTextRunStats *ret_stats )
+{
+     D_DEBUG_AT( Font_Manager, "%s()\n", __FUNCTION__ );
+
+     D_MAGIC_ASSERT( manager, CoreFontManager );
+     D_ASSERT( ret_stats != NULL );
 
-     direct_list_remove( &cache->rows, &context.lru_row->link );
+     direct_mutex_lock( &manager->lock );
 
-     dfb_font_cache_row_destroy( context.lru_row );
+     *ret_stats = manager->run_stats;
 
-     /* Decrease row counter. */
-     manager->num_rows--;
+     direct_mutex_unlock( &manager->lock );
 
      return DFB_OK;
 }
@@ -350,8 +654,6 @@ dfb_font_cache_create( CoreFontManager          *manager,
      CoreFontCache *cache;
 
      D_MAGIC_ASSERT( manager, CoreFontManager );
-     D_ASSERT( manager->max_rows > 0 );
-     D_ASSERT( manager->num_rows <= manager->max_rows );
      D_ASSERT( type != NULL );
      D_ASSERT( ret_cache != NULL );
 
@@ -389,217 +691,1174 @@ dfb_font_cache_init( CoreFontCache           *cache,
 {
      D_ASSERT( cache != NULL );
      D_MAGIC_ASSERT( manager, CoreFontManager );
-     D_ASSERT( manager->max_rows > 0 );
-     D_ASSERT( manager->num_rows <= manager->max_rows );
      D_ASSERT( type != NULL );
 
      cache->manager = manager;
      cache->type    = *type;
 
-     cache->row_width = 2048 * type->height / 64;
-
-     if (cache->row_width > dfb_config->max_font_row_width)
-          cache->row_width = dfb_config->max_font_row_width;
-
-     if (cache->row_width < type->height)
-          cache->row_width = type->height;
-
-     cache->row_width = (cache->row_width + 7) & ~7;
+     cache->page_size = (MAX( dfb_config->font_page_size, 64 ) + 7) & ~7;
 
+     cache->align = (8 / (DFB_BYTES_PER_PIXEL( type->pixel_format ) ?: 1)) *
+                    (DFB_PIXELFORMAT_ALIGNMENT( type->pixel_format ) + 1) - 1;
 
      D_MAGIC_SET( cache, CoreFontCache );
 
      return DFB_OK;
 }
 
+static void font_cache_page_destroy( CoreFontCachePage *page );
+
 DFBResult
 dfb_font_cache_deinit( CoreFontCache *cache )
 {
-     CoreFontCacheRow *row, *next;
-
      D_MAGIC_ASSERT( cache, CoreFontCache );
 
-     direct_list_foreach_safe (row, next, cache->rows) {
-          dfb_font_cache_row_destroy( row );
-     }
+     while (cache->pages)
+          font_cache_page_destroy( (CoreFontCachePage*) cache->pages );
 
-     cache->rows = NULL;
+     if (cache->staging)
+          dfb_surface_unref( cache->staging );
 
      D_MAGIC_CLEAR( cache );
 
      return DFB_OK;
 }
 
-DFBResult
-dfb_font_cache_get_row( CoreFontCache     *cache,
-                        unsigned int       width,
-                        CoreFontCacheRow **ret_row )
+static DFBResult
+font_cache_page_create( CoreFontCache      *cache,
+                        int                 width,
+                        int                 height,
+                        CoreFontCachePage **ret_page )
 {
-     DFBResult         ret;
-     CoreFontManager  *manager;
-     CoreFontCacheRow *row;
-     CoreFontCacheRow *best_row = NULL;
-     unsigned int      best_val = 0;
+     DFBResult          ret;
+     CoreFontManager   *manager;
+     CoreFontCachePage *page;
 
      D_MAGIC_ASSERT( cache, CoreFontCache );
-     D_ASSERT( ret_row != NULL );
 
      manager = cache->manager;
 
      D_MAGIC_ASSERT( manager, CoreFontManager );
-     D_ASSERT( manager->max_rows > 0 );
-     D_ASSERT( manager->num_rows <= manager->max_rows );
 
-     /* Try freshest row first. */
-     row = (CoreFontCacheRow*) cache->rows;
-     if (row && row->next_x + width <= cache->row_width) {
-          *ret_row = row;
-
-          return DFB_OK;
-     }
-
-     /* Check for trailing space in each row. */
-     direct_list_foreach (row, cache->rows) {
-          D_MAGIC_ASSERT( row, CoreFontCacheRow );
-
-          /* If glyph fits... */
-          if (row->next_x + width <= cache->row_width) {
-               /* ...and no row yet or this row fits better... */
-               if (!best_row || best_val < row->next_x) {
-                    /* ...remember row. */
-                    best_row = row;
-                    best_val = row->next_x;
-               }
-          }
-     }
+     page = D_CALLOC( 1, sizeof(CoreFontCachePage) );
+     if (!page)
+          return D_OOM();
 
-     if (best_row) {
-          *ret_row = best_row;
+     page->cache  = cache;
+     page->width  = width;
+     page->height = height;
 
-          return DFB_OK;
+     /* Create a new font surface. */
+     ret = dfb_surface_create_simple( manager->core, width, height, cache->type.pixel_format,
+                                      DFB_COLORSPACE_DEFAULT( cache->type.pixel_format ), cache->type.surface_caps,
+                                      CSTF_FONT, dfb_config->font_resource_id, NULL, &page->surface );
+     if (ret) {
+          D_DERROR( ret, "Core/Font: Could not create font surface!\n" );
+          D_FREE( page );
+          return ret;
      }
 
-     /* Maximum number of rows reached. */
-     if (manager->num_rows == manager->max_rows) {
-          /* Remove the least recently used row. */
-          ret = dfb_font_manager_remove_lru_row( manager );
-          if (ret)
-               return ret;
-     }
+     D_DEBUG_AT( Core_FontSurfaces, "  -> new page %u - %dx%d %s\n",
+                 manager->num_pages, width, height, dfb_pixelformat_name( cache->type.pixel_format ) );
 
-     /* Create another row. */
-     ret = dfb_font_cache_row_create( cache, &row );
-     if (ret)
-          return ret;
+     D_MAGIC_SET( page, CoreFontCachePage );
 
      /* Prepend to list (freshest is first). */
-     direct_list_prepend( &cache->rows, &row->link );
+     direct_list_prepend( &cache->pages, &page->link );
 
-     /* Increase row counter in manager. */
-     manager->num_rows++;
+     /* Increase page counter in manager. */
+     manager->num_pages++;
 
-     *ret_row = row;
+     *ret_page = page;
 
      return DFB_OK;
 }
 
-DFBResult
-dfb_font_cache_row_create( CoreFontCache     *cache,
-                           CoreFontCacheRow **ret_row )
+static void
+font_cache_page_destroy( CoreFontCachePage *page )
 {
-     DFBResult         ret;
-     CoreFontCacheRow *row;
+     CoreFontCache    *cache;
+     CoreFontManager  *manager;
+     CoreFontCacheRow *row, *next_row;
+     CoreGlyphData    *glyph, *next;
 
-     row = D_CALLOC( 1, sizeof(CoreFontCacheRow) );
-     if (!row)
-          return D_OOM();
+     D_MAGIC_ASSERT( page, CoreFontCachePage );
 
-     ret = dfb_font_cache_row_init( row, cache );
-     if (ret) {
-          D_FREE( row );
-          return ret;
-     }
+     cache = page->cache;
 
-     *ret_row = row;
+     D_MAGIC_ASSERT( cache, CoreFontCache );
 
-     return DFB_OK;
-}
+     manager = cache->manager;
 
-DFBResult
-dfb_font_cache_row_destroy( CoreFontCacheRow *row )
-{
-     D_MAGIC_ASSERT( row, CoreFontCacheRow );
+     D_MAGIC_ASSERT( manager, CoreFontManager );
+     D_ASSERT( manager->num_pages > 0 );
 
-     dfb_font_cache_row_deinit( row );
+     D_DEBUG_AT( Core_FontSurfaces, "  -> remove page %p\n", page );
 
-     D_FREE( row );
+     /* Kick out all glyphs. */
+     direct_list_foreach_safe (row, next_row, page->rows) {
+          D_MAGIC_ASSERT( row, CoreFontCacheRow );
 
-     return DFB_OK;
-}
+          direct_list_foreach_safe (glyph, next, row->glyphs) {
+               direct_list_remove( &manager->glyphs_lru, &glyph->lru );
 
-DFBResult
-dfb_font_cache_row_init( CoreFontCacheRow *row,
-                         CoreFontCache    *cache )
-{
-     DFBResult        ret;
-     CoreFontManager *manager;
+               font_glyph_forget( glyph );
+          }
 
-     D_MAGIC_ASSERT( cache, CoreFontCache );
+          D_MAGIC_CLEAR( row );
+          D_FREE( row );
+     }
 
-     manager = cache->manager;
+     direct_list_remove( &cache->pages, &page->link );
 
-     D_MAGIC_ASSERT( manager, CoreFontManager );
-     D_ASSERT( manager->max_rows > 0 );
-     D_ASSERT( manager->num_rows <= manager->max_rows );
+     /* Decrease page counter in manager. */
+     manager->num_pages--;
 
-     row->cache = cache;
+     dfb_surface_unref( page->surface );
 
-     /* Create a new font surface. */
-     ret = dfb_surface_create_simple( manager->core, cache->row_width, cache->type.height, cache->type.pixel_format,
-                                      DFB_COLORSPACE_DEFAULT( cache->type.pixel_format ), cache->type.surface_caps,
-                                      CSTF_FONT, dfb_config->font_resource_id, NULL, &row->surface );
-     if (ret) {
-          D_DERROR( ret, "Core/Font: Could not create font surface!\n" );
-          return ret;
-     }
+     D_MAGIC_CLEAR( page );
+     D_FREE( page );
+}
+
+static DFBResult
+font_cache_row_create( CoreFontCachePage  *page,
+                       int                 y,
+                       int                 height,
+                       CoreFontCacheRow   *before,
+                       CoreFontCacheRow  **ret_row )
+{
+     CoreFontCacheRow *row;
+
+     D_MAGIC_ASSERT( page, CoreFontCachePage );
+
+     row = D_CALLOC( 1, sizeof(CoreFontCacheRow) );
+     if (!row)
+          return D_OOM();
 
-     D_DEBUG_AT( Core_FontSurfaces, "  -> new row %u - %dx%d %s\n",
-                 manager->num_rows, row->surface->config.size.w, row->surface->config.size.h,
-                 dfb_pixelformat_name( row->surface->config.format ) );
+     row->page   = page;
+     row->y      = y;
+     row->height = height;
 
      D_MAGIC_SET( row, CoreFontCacheRow );
 
+     direct_list_insert( &page->rows, &row->link, before ? &before->link : NULL );
+
+     *ret_row = row;
+
      return DFB_OK;
 }
 
-DFBResult
-dfb_font_cache_row_deinit( CoreFontCacheRow *row )
+static void
+font_cache_row_destroy( CoreFontCacheRow *row )
 {
-     CoreGlyphData *glyph, *next;
+     CoreFontCachePage *page;
 
      D_MAGIC_ASSERT( row, CoreFontCacheRow );
+     D_ASSERT( row->glyphs == NULL );
 
-     /* Kick out all glyphs. */
-     direct_list_foreach_safe (glyph, next, row->glyphs) {
-          CoreFont *font = glyph->font;
+     page = row->page;
 
-          D_MAGIC_ASSERT( glyph, CoreGlyphData );
-          D_ASSERT( glyph->layer < D_ARRAY_SIZE(font->layers) );
+     D_MAGIC_ASSERT( page, CoreFontCachePage );
 
-          direct_hash_remove( font->layers[glyph->layer].glyph_hash, glyph->index );
+     direct_list_remove( &page->rows, &row->link );
 
-          if (glyph->index < 128)
-               font->layers[glyph->layer].glyph_data[glyph->index] = NULL;
+     D_MAGIC_CLEAR( row );
+     D_FREE( row );
+}
+
+/*
+ * Open a row of the given height in an empty row or in the free space at the bottom of the page.
+ */
+static DFBResult
+font_cache_page_open_row( CoreFontCachePage  *page,
+                          int                 height,
+                          CoreFontCacheRow  **ret_row )
+{
+     DFBResult         ret;
+     CoreFontCacheRow *row;
+     CoreFontCacheRow *rest;
+
+     D_MAGIC_ASSERT( page, CoreFontCachePage );
+
+     direct_list_foreach (row, page->rows) {
+          D_MAGIC_ASSERT( row, CoreFontCacheRow );
+
+          if (row->glyphs || row->height < height)
+               continue;
+
+          /* Keep the remaining space as an empty row. */
+          if (row->height > height) {
+               ret = font_cache_row_create( page, row->y + height, row->height - height,
+                                            (CoreFontCacheRow*) row->link.next, &rest );
+               if (ret)
+                    return ret;
+
+               row->height = height;
+          }
+
+          *ret_row = row;
+
+          return DFB_OK;
+     }
+
+     if (page->height - page->next_y < height)
+          return DFB_LIMITEXCEEDED;
+
+     ret = font_cache_row_create( page, page->next_y, height, NULL, &row );
+     if (ret)
+          return ret;
+
+     page->next_y += height;
+
+     *ret_row = row;
+
+     return DFB_OK;
+}
+
+/*
+ * Find the first gap for the (aligned) width in a row.
+ */
+static bool
+font_cache_row_fit( CoreFontCacheRow  *row,
+                    int                width,
+                    int               *ret_x,
+                    CoreGlyphData    **ret_before )
+{
+     CoreFontCache *cache = row->page->cache;
+     CoreGlyphData *glyph;
+     int            x     = 0;
+
+     direct_list_foreach (glyph, row->glyphs) {
+          if (glyph->start - x >= width) {
+               *ret_x      = x;
+               *ret_before = glyph;
+
+               return true;
+          }
+
+          x = glyph->start + ((glyph->width + cache->align) & ~cache->align);
+     }
+
+     if (row->page->width - x >= width) {
+          *ret_x      = x;
+          *ret_before = NULL;
+
+          return true;
+     }
+
+     return false;
+}
+
+static void
+font_cache_row_insert( CoreFontCacheRow *row,
+                       CoreGlyphData    *data,
+                       int               x,
+                       CoreGlyphData    *before )
+{
+     D_MAGIC_ASSERT( row, CoreFontCacheRow );
+
+     data->row     = row;
+     data->surface = row->page->surface;
+     data->start   = x;
+     data->start_y = row->y;
+
+     direct_list_insert( &row->glyphs, &data->link, before ? &before->link : NULL );
+
+     direct_list_prepend( &row->page->cache->manager->glyphs_lru, &data->lru );
+}
+
+DFBResult
+dfb_font_cache_alloc_glyph( CoreFontCache *cache,
+                            CoreGlyphData *data )
+{
+     DFBResult          ret;
+     CoreFontManager   *manager;
+     CoreFontCachePage *page;
+     CoreFontCacheRow  *row;
+     int                width;
+     int                height;
+
+     D_MAGIC_ASSERT( cache, CoreFontCache );
+     D_MAGIC_ASSERT( data, CoreGlyphData );
+     D_ASSERT( data->row == NULL );
+     D_ASSERT( data->width > 0 );
+     D_ASSERT( data->height > 0 );
+
+     manager = cache->manager;
+
+     D_MAGIC_ASSERT( manager, CoreFontManager );
+
+     width  = (data->width + cache->align) & ~cache->align;
+     height = (data->height + 3) & ~3;
+
+     while (true) {
+          CoreFontCacheRow *best_row    = NULL;
+          CoreGlyphData    *best_before = NULL;
+          int               best_x      = 0;
+
+          /* Look for a gap in the lowest row of a similar height. */
+          direct_list_foreach (page, cache->pages) {
+               D_MAGIC_ASSERT( page, CoreFontCachePage );
+
+               direct_list_foreach (row, page->rows) {
+                    int            x;
+                    CoreGlyphData *before;
+
+                    if (!row->glyphs || row->height < data->height || row->height - data->height > row->height / 4 + 2)
+                         continue;
+
+                    if (best_row && best_row->height <= row->height)
+                         continue;
+
+                    if (font_cache_row_fit( row, width, &x, &before )) {
+                         best_row    = row;
+                         best_before = before;
+                         best_x      = x;
+                    }
+               }
+          }
+
+          if (best_row) {
+               font_cache_row_insert( best_row, data, best_x, best_before );
+
+               return DFB_OK;
+          }
+
+          /* Open a new row in a page. */
+          direct_list_foreach (page, cache->pages) {
+               if (page->width < width)
+                    continue;
+
+               ret = font_cache_page_open_row( page, height, &row );
+               if (ret == DFB_OK) {
+                    font_cache_row_insert( row, data, 0, NULL );
+
+                    return DFB_OK;
+               }
+
+               if (ret != DFB_LIMITEXCEEDED)
+                    return ret;
+          }
+
+          /* Remove the least recently used glyph, exceeding the maximum number of pages if all of them are pinned. */
+          if (manager->num_pages >= manager->max_pages && manager->num_pages) {
+               ret = dfb_font_manager_evict_glyph( manager );
+               if (ret == DFB_OK)
+                    continue;
+
+               if (ret != DFB_LIMITEXCEEDED)
+                    return ret;
+          }
+
+          /* Create another page, glyphs larger than the page size get a page of their own. */
+          ret = font_cache_page_create( cache, MAX( cache->page_size, width ), MAX( cache->page_size, height ), &page );
+          if (ret)
+               return ret;
+
+          ret = font_cache_page_open_row( page, height, &row );
+          if (ret) {
+               font_cache_page_destroy( page );
+               return ret;
+          }
+
+          font_cache_row_insert( row, data, 0, NULL );
+
+          return DFB_OK;
+     }
+}
+
+/*
+ * Return a row without glyphs to the free space of its page, destroying the page if it got empty.
+ */
+static void
+font_cache_row_release( CoreFontCacheRow *row )
+{
+     CoreFontCachePage *page;
+     CoreFontCacheRow  *next;
+     CoreFontCacheRow  *prev;
+
+     D_MAGIC_ASSERT( row, CoreFontCacheRow );
+     D_ASSERT( row->glyphs == NULL );
+
+     page = row->page;
+
+     D_MAGIC_ASSERT( page, CoreFontCachePage );
+
+     /* Merge the empty row with empty neighbours. */
+     next = (CoreFontCacheRow*) row->link.next;
+     prev = (row != (CoreFontCacheRow*) page->rows) ? (CoreFontCacheRow*) row->link.prev : NULL;
+
+     if (next && !next->glyphs) {
+          row->height += next->height;
+
+          font_cache_row_destroy( next );
+     }
+
+     if (prev && !prev->glyphs) {
+          prev->height += row->height;
+
+          font_cache_row_destroy( row );
+
+          row = prev;
+     }
+
+     /* Return an empty last row to the free space at the bottom. */
+     if (!row->link.next) {
+          page->next_y = row->y;
+
+          font_cache_row_destroy( row );
+     }
+
+     /* If the page got empty, destroy it. */
+     if (!page->rows)
+          font_cache_page_destroy( page );
+}
+
+DFBResult
+dfb_font_cache_free_glyph( CoreGlyphData *data )
+{
+     CoreFontCacheRow *row;
+
+     D_MAGIC_ASSERT( data, CoreGlyphData );
+
+     row = data->row;
+
+     D_MAGIC_ASSERT( row, CoreFontCacheRow );
+
+     /* Remove glyph from cache row. */
+     direct_list_remove( &row->glyphs, &data->link );
+     direct_list_remove( &row->page->cache->manager->glyphs_lru, &data->lru );
+
+     data->row     = NULL;
+     data->surface = NULL;
+
+     if (!row->glyphs)
+          font_cache_row_release( row );
+
+     return DFB_OK;
+}
+
+/**********************************************************************************************************************/
+
+DFBResult
+dfb_font_manager_remove_lru_row( CoreFontManager *manager )
+{
+     DirectLink       *link;
+     CoreFontCacheRow *row;
+     CoreGlyphData    *glyph, *next;
+
+     D_DEBUG_AT( Font_Manager, "%s()\n", __FUNCTION__ );
+
+     D_MAGIC_ASSERT( manager, CoreFontManager );
+
+     link = direct_list_get_last( manager->glyphs_lru );
+     if (!link) {
+          D_ERROR( "Core/Font: Could not find any LRU row!\n" );
+          return DFB_ITEMNOTFOUND;
+     }
+
+     row = font_glyph_of_lru( link )->row;
+
+     D_MAGIC_ASSERT( row, CoreFontCacheRow );
+
+     D_DEBUG_AT( Font_Manager, "  -> row %p\n", row );
+
+     /* Freeing the last glyph releases the row. */
+     direct_list_foreach_safe (glyph, next, row->glyphs) {
+          dfb_font_cache_free_glyph( glyph );
+
+          font_glyph_forget( glyph );
+     }
+
+     return DFB_OK;
+}
+
+DFBResult
+dfb_font_cache_get_row( CoreFontCache     *cache,
+                        unsigned int       width,
+                        CoreFontCacheRow **ret_row )
+{
+     CoreFontCachePage *page;
+     CoreFontCacheRow  *row;
+     CoreGlyphData     *before;
+     int                x;
+
+     D_MAGIC_ASSERT( cache, CoreFontCache );
+     D_ASSERT( ret_row != NULL );
+
+     width = (width + cache->align) & ~cache->align;
+
+     /* Look for a gap in a row of any page. */
+     direct_list_foreach (page, cache->pages) {
+          direct_list_foreach (row, page->rows) {
+               if (row->glyphs && font_cache_row_fit( row, width, &x, &before )) {
+                    *ret_row = row;
+
+                    return DFB_OK;
+               }
+          }
+     }
+
+     return dfb_font_cache_row_create( cache, ret_row );
+}
+
+DFBResult
+dfb_font_cache_row_create( CoreFontCache     *cache,
+                           CoreFontCacheRow **ret_row )
+{
+     DFBResult         ret;
+     CoreFontCacheRow *row;
+
+     D_MAGIC_ASSERT( cache, CoreFontCache );
+     D_ASSERT( ret_row != NULL );
+
+     row = D_CALLOC( 1, sizeof(CoreFontCacheRow) );
+     if (!row)
+          return D_OOM();
+
+     ret = dfb_font_cache_row_init( row, cache );
+     if (ret) {
+          D_FREE( row );
+          return ret;
+     }
+
+     *ret_row = row;
+
+     return DFB_OK;
+}
+
+DFBResult
+dfb_font_cache_row_destroy( CoreFontCacheRow *row )
+{
+     D_MAGIC_ASSERT( row, CoreFontCacheRow );
+
+     /* The page owns the row. */
+     return dfb_font_cache_row_deinit( row );
+}
+
+DFBResult
+dfb_font_cache_row_init( CoreFontCacheRow *row,
+                         CoreFontCache    *cache )
+{
+     DFBResult          ret;
+     CoreFontManager   *manager;
+     CoreFontCachePage *page;
+
+     D_ASSERT( row != NULL );
+     D_MAGIC_ASSERT( cache, CoreFontCache );
+
+     manager = cache->manager;
+
+     D_MAGIC_ASSERT( manager, CoreFontManager );
+
+     /* Maximum number of pages reached. */
+     while (manager->num_pages && manager->num_pages >= manager->max_pages) {
+          ret = dfb_font_manager_remove_lru_row( manager );
+          if (ret)
+               return ret;
+     }
+
+     ret = font_cache_page_create( cache, cache->page_size, cache->page_size, &page );
+     if (ret)
+          return ret;
+
+     row->page   = page;
+     row->y      = 0;
+     row->height = page->height;
+
+     D_MAGIC_SET( row, CoreFontCacheRow );
+
+     direct_list_append( &page->rows, &row->link );
+
+     page->next_y = page->height;
+
+     return DFB_OK;
+}
+
+DFBResult
+dfb_font_cache_row_deinit( CoreFontCacheRow *row )
+{
+     CoreFontManager *manager;
+     CoreGlyphData   *glyph, *next;
+
+     D_MAGIC_ASSERT( row, CoreFontCacheRow );
+
+     manager = row->page->cache->manager;
+
+     /* Kick out all glyphs. */
+     direct_list_foreach_safe (glyph, next, row->glyphs) {
+          direct_list_remove( &manager->glyphs_lru, &glyph->lru );
+
+          font_glyph_forget( glyph );
+     }
+
+     row->glyphs = NULL;
+
+     font_cache_row_release( row );
+
+     return DFB_OK;
+}
+
+/**********************************************************************************************************************/
+
+/*
+ * Remove all glyphs of a page and make its whole space available again.
+ */
+static void
+font_shared_page_clear( CoreFontShared     *shared,
+                        CoreFontSharedPage *page )
+{
+     CoreFontSharedGlyph *glyph, *next;
+
+     D_DEBUG_AT( Font_Shared, "%s( %p )\n", __FUNCTION__, page );
+
+     D_MAGIC_ASSERT( page, CoreFontSharedPage );
+
+     /* The face hashes free the glyphs. */
+     direct_list_foreach_safe (glyph, next, page->glyphs) {
+          D_MAGIC_ASSERT( glyph, CoreFontSharedGlyph );
+          D_MAGIC_ASSERT( glyph->face, CoreFontSharedFace );
 
           D_MAGIC_CLEAR( glyph );
-          D_FREE( glyph );
+
+          fusion_hash_remove( glyph->face->glyphs, (void*) glyph->key, NULL, NULL );
      }
 
-     dfb_surface_unref( row->surface );
+     page->glyphs     = NULL;
+     page->row_y      = 0;
+     page->row_height = 0;
+     page->row_x      = 0;
+}
+
+static void
+font_shared_page_destroy( CoreFontShared     *shared,
+                          CoreFontSharedPage *page )
+{
+     D_DEBUG_AT( Font_Shared, "%s( %p )\n", __FUNCTION__, page );
+
+     D_MAGIC_ASSERT( page, CoreFontSharedPage );
+     D_ASSERT( shared->num_pages > 0 );
 
-     D_MAGIC_CLEAR( row );
+     font_shared_page_clear( shared, page );
+
+     direct_list_remove( &shared->pages, &page->link );
+
+     shared->num_pages--;
+
+     dfb_surface_unlink( &page->surface );
+
+     fusion_ref_destroy( &page->ref );
+
+     D_MAGIC_CLEAR( page );
+
+     SHFREE( shared->shmpool, page );
+}
+
+static void
+font_shared_cleanup( void *data,
+                     int   emergency )
+{
+     CoreFontShared      *shared = data;
+     CoreFontSharedFace  *face;
+     FusionHashIterator   iterator;
+
+     D_DEBUG_AT( Font_Shared, "%s( %p )\n", __FUNCTION__, shared );
+
+     D_MAGIC_ASSERT( shared, CoreFontShared );
+
+     while (shared->pages)
+          font_shared_page_destroy( shared, (CoreFontSharedPage*) shared->pages );
+
+     fusion_hash_foreach (face, iterator, shared->faces) {
+          D_MAGIC_ASSERT( face, CoreFontSharedFace );
+
+          fusion_hash_destroy( face->glyphs );
+
+          D_MAGIC_CLEAR( face );
+     }
+
+     fusion_hash_destroy( shared->faces );
+
+     fusion_skirmish_destroy( &shared->lock );
+
+     D_MAGIC_CLEAR( shared );
+
+     SHFREE( shared->shmpool, shared );
+}
+
+static void
+font_shared_create( CoreFontManager *manager )
+{
+     DFBResult            ret;
+     CoreDFB             *core    = manager->core;
+     FusionSHMPoolShared *shmpool = dfb_core_shmpool( core );
+     CoreFontShared      *shared;
+
+     D_DEBUG_AT( Font_Shared, "%s()\n", __FUNCTION__ );
+
+     shared = SHCALLOC( shmpool, 1, sizeof(CoreFontShared) );
+     if (!shared) {
+          D_OOSHM();
+          return;
+     }
+
+     shared->shmpool   = shmpool;
+     shared->max_pages = dfb_config->font_shared_pages;
+     shared->page_size = (MAX( dfb_config->font_page_size, 64 ) + 7) & ~7;
+
+     ret = fusion_hash_create( shmpool, HASH_STRING, HASH_PTR, 17, &shared->faces );
+     if (ret) {
+          D_DERROR( ret, "Core/Font: Could not create shared face hash!\n" );
+          SHFREE( shmpool, shared );
+          return;
+     }
+
+     fusion_hash_set_autofree( shared->faces, true, true );
+
+     fusion_skirmish_init2( &shared->lock, "Font Cache", dfb_core_world( core ), fusion_config->secure_fusion );
+
+     D_MAGIC_SET( shared, CoreFontShared );
+
+     ret = core_arena_add_shared_field( core, "Core/Font/Shared", shared );
+     if (ret) {
+          D_DERROR( ret, "Core/Font: Could not publish shared glyph cache!\n" );
+          font_shared_cleanup( shared, false );
+          return;
+     }
+
+     /* Destroy it after all other processes have left. */
+     dfb_core_cleanup_add( core, font_shared_cleanup, shared, false );
+
+     manager->shared = shared;
+}
+
+/*
+ * Look up the shared glyphs of a font, fonts are identified by their file, description and glyph format.
+ */
+static CoreFontSharedFace *
+font_shared_get_face( CoreFontShared *shared,
+                      CoreFont       *font )
+{
+     DFBResult                 ret;
+     const DFBFontDescription *desc = &font->description;
+     CoreFontSharedFace       *face;
+     char                     *shkey;
+     char                      key[1024];
+
+     if (font->shared_face)
+          return font->shared_face;
+
+     if (!font->url)
+          return NULL;
+
+     if (snprintf( key, sizeof(key), "%s|%x|%x|%x|%x|%d|%d|%u|%d|%d|%d|%d|%d|%d", font->url,
+                   (unsigned int) font->pixel_format, (unsigned int) font->surface_caps,
+                   (unsigned int) font->attributes, (unsigned int) desc->flags,
+                   (desc->flags & DFDESC_HEIGHT)          ? desc->height          : 0,
+                   (desc->flags & DFDESC_WIDTH)           ? desc->width           : 0,
+                   (desc->flags & DFDESC_INDEX)           ? desc->index           : 0,
+                   (desc->flags & DFDESC_FIXEDADVANCE)    ? desc->fixed_advance   : 0,
+                   (desc->flags & DFDESC_FRACT_HEIGHT)    ? desc->fract_height    : 0,
+                   (desc->flags & DFDESC_FRACT_WIDTH)     ? desc->fract_width     : 0,
+                   (desc->flags & DFDESC_OUTLINE_WIDTH)   ? desc->outline_width   : 0,
+                   (desc->flags & DFDESC_OUTLINE_OPACITY) ? desc->outline_opacity : 0,
+                   (desc->flags & DFDESC_ROTATION)        ? desc->rotation        : 0 ) >= sizeof(key))
+          return NULL;
+
+     face = fusion_hash_lookup( shared->faces, key );
+     if (!face) {
+          D_DEBUG_AT( Font_Shared, "  -> new face '%s'\n", key );
+
+          face = SHCALLOC( shared->shmpool, 1, sizeof(CoreFontSharedFace) );
+          if (!face) {
+               D_OOSHM();
+               return NULL;
+          }
+
+          shkey = SHSTRDUP( shared->shmpool, key );
+          if (!shkey) {
+               D_OOSHM();
+               SHFREE( shared->shmpool, face );
+               return NULL;
+          }
+
+          ret = fusion_hash_create( shared->shmpool, HASH_INT, HASH_PTR, 61, &face->glyphs );
+          if (ret) {
+               SHFREE( shared->shmpool, shkey );
+               SHFREE( shared->shmpool, face );
+               return NULL;
+          }
+
+          fusion_hash_set_autofree( face->glyphs, false, true );
+
+          D_MAGIC_SET( face, CoreFontSharedFace );
+
+          ret = fusion_hash_insert( shared->faces, shkey, face );
+          if (ret) {
+               fusion_hash_destroy( face->glyphs );
+               D_MAGIC_CLEAR( face );
+               SHFREE( shared->shmpool, shkey );
+               SHFREE( shared->shmpool, face );
+               return NULL;
+          }
+     }
+
+     D_MAGIC_ASSERT( face, CoreFontSharedFace );
+
+     font->shared_face = face;
+
+     return face;
+}
+
+static DFBResult
+font_shared_page_create( CoreFontShared           *shared,
+                         CoreDFB                  *core,
+                         const CoreFontCacheType  *type,
+                         int                       width,
+                         int                       height,
+                         CoreFontSharedPage      **ret_page )
+{
+     DFBResult           ret;
+     CoreFontSharedPage *page;
+
+     page = SHCALLOC( shared->shmpool, 1, sizeof(CoreFontSharedPage) );
+     if (!page)
+          return D_OOSHM();
+
+     page->type   = *type;
+     page->width  = MAX( shared->page_size, width );
+     page->height = MAX( shared->page_size, height );
+     page->align  = (8 / (DFB_BYTES_PER_PIXEL( type->pixel_format ) ?: 1)) *
+                    (DFB_PIXELFORMAT_ALIGNMENT( type->pixel_format ) + 1) - 1;
+
+     ret = dfb_surface_create_simple( core, page->width, page->height, type->pixel_format,
+                                      DFB_COLORSPACE_DEFAULT( type->pixel_format ), type->surface_caps,
+                                      CSTF_SHARED | CSTF_FONT, dfb_config->font_resource_id, NULL, &page->surface );
+     if (ret) {
+          D_DERROR( ret, "Core/Font: Could not create shared font surface!\n" );
+          SHFREE( shared->shmpool, page );
+          return ret;
+     }
+
+     /* Keep the surface beyond the lifetime of this process. */
+     dfb_surface_globalize( page->surface );
+
+     fusion_ref_init( &page->ref, "Font Shared Page", dfb_core_world( core ) );
+
+     D_DEBUG_AT( Font_Shared, "  -> new page %u - %dx%d %s\n",
+                 shared->num_pages, page->width, page->height, dfb_pixelformat_name( type->pixel_format ) );
+
+     D_MAGIC_SET( page, CoreFontSharedPage );
+
+     direct_list_append( &shared->pages, &page->link );
+
+     shared->num_pages++;
+
+     *ret_page = page;
+
+     return DFB_OK;
+}
+
+/*
+ * Place a glyph in the current row of a page, or open a new row below it.
+ */
+static bool
+font_shared_page_fit( CoreFontSharedPage *page,
+                      int                 width,
+                      int                 height,
+                      int                *ret_x,
+                      int                *ret_y )
+{
+     width = (width + page->align) & ~page->align;
+
+     if (page->row_height >= height && page->row_height - height <= page->row_height / 4 + 2 &&
+         page->width - page->row_x >= width) {
+          *ret_x = page->row_x;
+          *ret_y = page->row_y;
+
+          page->row_x += width;
+
+          return true;
+     }
+
+     height = (height + 3) & ~3;
+
+     if (page->height - (page->row_y + page->row_height) >= height && page->width >= width) {
+          page->row_y      += page->row_height;
+          page->row_height  = height;
+          page->row_x       = width;
+
+          *ret_x = 0;
+          *ret_y = page->row_y;
+
+          return true;
+     }
+
+     return false;
+}
+
+static DFBResult
+font_shared_alloc( CoreFontShared           *shared,
+                   CoreDFB                  *core,
+                   const CoreFontCacheType  *type,
+                   int                       width,
+                   int                       height,
+                   CoreFontSharedPage      **ret_page,
+                   int                      *ret_x,
+                   int                      *ret_y )
+{
+     DFBResult           ret;
+     CoreFontSharedPage *page;
+     CoreFontSharedPage *lru;
+
+     while (true) {
+          direct_list_foreach (page, shared->pages) {
+               D_MAGIC_ASSERT( page, CoreFontSharedPage );
+
+               if (memcmp( &page->type, type, sizeof(*type) ))
+                    continue;
+
+               if (font_shared_page_fit( page, width, height, ret_x, ret_y )) {
+                    *ret_page = page;
+
+                    return DFB_OK;
+               }
+          }
+
+          if (shared->num_pages < shared->max_pages) {
+               ret = font_shared_page_create( shared, core, type, width, height, &page );
+               if (ret)
+                    return ret;
+
+               font_shared_page_fit( page, width, height, ret_x, ret_y );
+
+               *ret_page = page;
+
+               return DFB_OK;
+          }
+
+          /* Reuse the least recently used page of the format that is large enough and not referenced by any process,
+             Fusion drops the references of processes that died. */
+          lru = NULL;
+
+          direct_list_foreach (page, shared->pages) {
+               int refs;
+
+               if (memcmp( &page->type, type, sizeof(*type) ) || page->width < width || page->height < height)
+                    continue;
+
+               if (fusion_ref_stat( &page->ref, &refs ) || refs)
+                    continue;
+
+               if (!lru || lru->stamp > page->stamp)
+                    lru = page;
+          }
+
+          if (!lru)
+               return DFB_LIMITEXCEEDED;
+
+          D_DEBUG_AT( Font_Shared, "  -> reuse page %p (serial %u)\n", lru, lru->serial );
+
+          font_shared_page_clear( shared, lru );
+
+          lru->serial++;
+     }
+}
+
+static void
+font_shared_bind( CoreFontShared      *shared,
+                  CoreFontSharedGlyph *glyph,
+                  CoreGlyphData       *data )
+{
+     D_MAGIC_ASSERT( glyph, CoreFontSharedGlyph );
+
+     data->width    = glyph->width;
+     data->height   = glyph->height;
+     data->left     = glyph->left;
+     data->top      = glyph->top;
+     data->xadvance = glyph->xadvance;
+     data->yadvance = glyph->yadvance;
+
+     if (glyph->page) {
+          D_MAGIC_ASSERT( glyph->page, CoreFontSharedPage );
+
+          data->surface       = glyph->page->surface;
+          data->start         = glyph->start;
+          data->start_y       = glyph->start_y;
+          data->shared_page   = glyph->page;
+          data->shared_serial = glyph->page->serial;
+
+          glyph->page->stamp = ++shared->stamp;
+     }
+}
+
+static DFBResult font_cache_render_glyph( CoreFontCache *cache,
+                                          CoreFont      *font,
+                                          unsigned int   index,
+                                          CoreGlyphData *data );
+
+/*
+ * Load a glyph and render it into a shared page.
+ */
+static DFBResult
+font_shared_add_glyph( CoreFontShared       *shared,
+                       CoreFontSharedFace   *face,
+                       CoreFont             *font,
+                       unsigned long         key,
+                       CoreGlyphData        *data,
+                       CoreFontSharedGlyph **ret_glyph )
+{
+     DFBResult            ret;
+     CoreFontSharedGlyph *glyph;
+     CoreFontSharedPage  *page = NULL;
+     CoreFontCache       *cache;
+     CoreFontCacheType    type;
+
+     ret = font->GetGlyphData( font, data->index, data );
+     if (ret)
+          return ret;
+
+     if (!(font->flags & CFF_SUBPIXEL_ADVANCE)) {
+          data->xadvance <<= 8;
+          data->yadvance <<= 8;
+     }
+
+     glyph = SHCALLOC( shared->shmpool, 1, sizeof(CoreFontSharedGlyph) );
+     if (!glyph)
+          return D_OOSHM();
+
+     if (data->width > 0 && data->height > 0) {
+          type.pixel_format = font->pixel_format;
+          type.surface_caps = font->surface_caps;
+
+          /* The local cache of the format provides the staging surface. */
+          ret = dfb_font_manager_get_cache( font->manager, &type, &cache );
+          if (ret)
+               goto error;
+
+          ret = font_shared_alloc( shared, font->core, &type, data->width, data->height,
+                                   &page, &data->start, &data->start_y );
+          if (ret)
+               goto error;
+
+          data->surface = page->surface;
+
+          D_DEBUG_AT( Font_Shared, "  -> render %u - %2dx%2d at %4d,%4d\n",
+                      data->index, data->width, data->height, data->start, data->start_y );
+
+          /* The space stays allocated until the page is evicted. */
+          ret = font_cache_render_glyph( cache, font, data->index, data );
+          if (ret)
+               goto error;
+
+          dfb_gfxcard_flush_texture_cache();
+
+          glyph->page    = page;
+          glyph->start   = data->start;
+          glyph->start_y = data->start_y;
+     }
+     else {
+          data->width  = 0;
+          data->height = 0;
+     }
+
+     glyph->face     = face;
+     glyph->key      = key;
+     glyph->width    = data->width;
+     glyph->height   = data->height;
+     glyph->left     = data->left;
+     glyph->top      = data->top;
+     glyph->xadvance = data->xadvance;
+     glyph->yadvance = data->yadvance;
+
+     D_MAGIC_SET( glyph, CoreFontSharedGlyph );
+
+     ret = fusion_hash_insert( face->glyphs, (void*) key, glyph );
+     if (ret) {
+          D_MAGIC_CLEAR( glyph );
+          goto error;
+     }
+
+     if (page)
+          direct_list_append( &page->glyphs, &glyph->link );
+
+     *ret_glyph = glyph;
 
      return DFB_OK;
+
+error:
+     SHFREE( shared->shmpool, glyph );
+
+     data->surface = NULL;
+     data->start   = data->start_y = 0;
+
+     return ret;
+}
+
+/*
+ * Get a glyph from the shared cache, loading and rendering it there on a miss.
+ */
+static DFBResult
+font_shared_get_glyph( CoreFontShared *shared,
+                       CoreFont       *font,
+                       CoreGlyphData  *data )
+{
+     DFBResult            ret = DFB_OK;
+     unsigned long        key = (unsigned long) data->index * DFB_FONT_MAX_LAYERS + data->layer;
+     CoreFontSharedFace  *face;
+     CoreFontSharedGlyph *glyph;
+
+     D_DEBUG_AT( Font_Shared, "%s( index %u, layer %u )\n", __FUNCTION__, data->index, data->layer );
+
+     D_MAGIC_ASSERT( shared, CoreFontShared );
+
+     if (fusion_skirmish_prevail( &shared->lock ))
+          return DFB_FUSION;
+
+     face = font_shared_get_face( shared, font );
+     if (!face) {
+          ret = DFB_UNSUPPORTED;
+          goto out;
+     }
+
+     glyph = fusion_hash_lookup( face->glyphs, (void*) key );
+     if (glyph)
+          D_DEBUG_AT( Font_Shared, "  -> rendered by another font (%p)\n", glyph );
+     else
+          ret = font_shared_add_glyph( shared, face, font, key, data, &glyph );
+
+     if (ret == DFB_OK) {
+          font_shared_bind( shared, glyph, data );
+
+          if (data->shared_page) {
+               ret = font_shared_page_ref( font->manager, data->shared_page );
+               if (ret) {
+                    data->shared_page = NULL;
+                    data->surface     = NULL;
+               }
+          }
+     }
+
+out:
+     fusion_skirmish_dismiss( &shared->lock );
+
+     return ret;
+}
+
+/*
+ * Release the shared pages referenced while the font manager was locked.
+ */
+static void
+font_shared_release( CoreFontManager *manager )
+{
+     unsigned int i;
+
+     D_DEBUG_AT( Font_Shared, "%s( %u pages )\n", __FUNCTION__, manager->num_shared_refs );
+
+     for (i = 0; i < manager->num_shared_refs; i++)
+          fusion_ref_down( &manager->shared_refs[i]->ref, false );
+
+     manager->num_shared_refs = 0;
 }
 
 /**********************************************************************************************************************/
@@ -704,8 +1963,7 @@ free_glyphs( DirectHash    *hash,
              void          *value,
              void          *ctx )
 {
-     CoreGlyphData    *data = value;
-     CoreFontCacheRow *row;
+     CoreGlyphData *data = value;
 
      D_DEBUG_AT( Core_Font, "%s( %lu )\n", __FUNCTION__, key );
 
@@ -716,64 +1974,162 @@ free_glyphs( DirectHash    *hash,
      /* Remove glyph from font. */
      direct_hash_remove( hash, key );
 
-     row = data->row;
-     if (row) {
-          D_MAGIC_ASSERT( row, CoreFontCacheRow );
+     /* Release the space of the glyph in the cache, glyphs in the shared cache stay until their page is reused. */
+     if (data->row)
+          dfb_font_cache_free_glyph( data );
+
+     D_MAGIC_CLEAR( data );
+
+     D_FREE( data );
+
+     return true;
+}
+
+DFBResult
+dfb_font_dispose( CoreFont *font )
+{
+     int              i, n;
+     CoreFontManager *manager;
+     CoreTextRun     *run, *next;
+
+     D_DEBUG_AT( Core_Font, "%s()\n", __FUNCTION__ );
+
+     D_MAGIC_ASSERT( font, CoreFont );
+
+     manager = font->manager;
+
+     dfb_font_manager_lock( manager );
+
+     /* Remove text runs of the font. */
+     direct_list_foreach_safe (run, next, manager->runs_lru) {
+          if (run->font == font)
+               text_run_remove( manager, run );
+     }
+
+     for (i = 0; i < DFB_FONT_MAX_LAYERS; i++) {
+          direct_hash_iterate( font->layers[i].glyph_hash, free_glyphs, NULL );
+
+          for (n = 0; n < DFB_FONT_GLYPH_PAGES; n++) {
+               if (font->layers[i].glyph_pages[n]) {
+                    D_FREE( font->layers[i].glyph_pages[n] );
+
+                    font->layers[i].glyph_pages[n] = NULL;
+               }
+          }
+     }
+
+     dfb_font_manager_unlock( manager );
+
+     return DFB_OK;
+}
+
+DFBResult
+dfb_font_insert_glyph_data( CoreFont      *font,
+                            unsigned int   index,
+                            unsigned int   layer,
+                            CoreGlyphData *data )
+{
+     DFBResult       ret;
+     CoreGlyphData **page;
+
+     D_DEBUG_AT( Core_Font, "%s( index %u, layer %u )\n", __FUNCTION__, index, layer );
+
+     D_MAGIC_ASSERT( font, CoreFont );
+     D_ASSERT( layer < D_ARRAY_SIZE(font->layers) );
+     D_MAGIC_ASSERT( data, CoreGlyphData );
+
+     ret = direct_hash_insert( font->layers[layer].glyph_hash, index, data );
+     if (ret)
+          return ret;
+
+     /* Indices beyond the page table are found in the hash only. */
+     if (index >= DFB_FONT_GLYPH_PAGES * DFB_FONT_GLYPH_PAGE_SIZE)
+          return DFB_OK;
+
+     page = font->layers[layer].glyph_pages[index >> DFB_FONT_GLYPH_PAGE_BITS];
+     if (!page) {
+          page = D_CALLOC( DFB_FONT_GLYPH_PAGE_SIZE, sizeof(CoreGlyphData*) );
+          if (!page)
+               return DFB_OK;
+
+          font->layers[layer].glyph_pages[index >> DFB_FONT_GLYPH_PAGE_BITS] = page;
+     }
 
-          /* Remove glyph from cache row. */
-          direct_list_remove( &row->glyphs, &data->link );
+     page[index & (DFB_FONT_GLYPH_PAGE_SIZE - 1)] = data;
 
-          /* If cache row got empty, destroy it. */
-          if (!row->glyphs) {
-               CoreFontManager *manager;
-               CoreFontCache   *cache = row->cache;
+     return DFB_OK;
+}
 
-               D_MAGIC_ASSERT( cache, CoreFontCache );
+/*
+ * Font implementations render glyphs at the top of the surface, glyphs placed below are rendered into a staging surface
+ * and written into the page straight from its locked buffer.
+ */
+static DFBResult
+font_cache_render_glyph( CoreFontCache *cache,
+                         CoreFont      *font,
+                         unsigned int   index,
+                         CoreGlyphData *data )
+{
+     DFBResult              ret;
+     CoreSurface           *surface = data->surface;
+     int                    start   = data->start;
+     int                    start_y = data->start_y;
+     CoreSurfaceBufferLock  lock;
+     DFBRectangle           rect;
 
-               manager = cache->manager;
+     D_MAGIC_ASSERT( cache, CoreFontCache );
 
-               D_MAGIC_ASSERT( manager, CoreFontManager );
-               D_ASSERT( manager->max_rows > 0 );
-               D_ASSERT( manager->num_rows <= manager->max_rows );
+     if (!start_y)
+          return font->RenderGlyph( font, index, data );
 
-               /* Remove row from cache. */
-               direct_list_remove( &cache->rows, &row->link );
+     if (!cache->staging ||
+         cache->staging->config.size.w < data->width || cache->staging->config.size.h < data->height) {
+          int width  = data->width;
+          int height = data->height;
 
-               /* Destroy row. */
-               dfb_font_cache_row_destroy( row );
+          if (cache->staging) {
+               width  = MAX( width, cache->staging->config.size.w );
+               height = MAX( height, cache->staging->config.size.h );
 
-               /* Decrease row counter in manager. */
-               manager->num_rows--;
+               dfb_surface_unref( cache->staging );
+               cache->staging = NULL;
           }
-     }
-
-     D_MAGIC_CLEAR( data );
 
-     D_FREE( data );
+          ret = dfb_surface_create_simple( cache->manager->core, width, height, cache->type.pixel_format,
+                                           DFB_COLORSPACE_DEFAULT( cache->type.pixel_format ), cache->type.surface_caps,
+                                           CSTF_NONE, 0, NULL, &cache->staging );
+          if (ret) {
+               D_DERROR( ret, "Core/Font: Could not create staging surface!\n" );
+               return ret;
+          }
+     }
 
-     return true;
-}
+     data->surface = cache->staging;
+     data->start   = 0;
+     data->start_y = 0;
 
-DFBResult
-dfb_font_dispose( CoreFont *font )
-{
-     int i;
+     ret = font->RenderGlyph( font, index, data );
 
-     D_DEBUG_AT( Core_Font, "%s()\n", __FUNCTION__ );
+     data->surface = surface;
+     data->start   = start;
+     data->start_y = start_y;
 
-     D_MAGIC_ASSERT( font, CoreFont );
+     if (ret)
+          return ret;
 
-     dfb_font_manager_lock( font->manager );
+     ret = dfb_surface_lock_buffer( cache->staging, DSBR_BACK, CSAID_CPU, CSAF_READ, &lock );
+     if (ret) {
+          D_DERROR( ret, "Core/Font: Could not lock staging surface!\n" );
+          return ret;
+     }
 
-     for (i = 0; i < DFB_FONT_MAX_LAYERS; i++) {
-          direct_hash_iterate( font->layers[i].glyph_hash, free_glyphs, NULL );
+     rect = (DFBRectangle) { start, start_y, data->width, data->height };
 
-          memset( font->layers[i].glyph_data, 0, sizeof(font->layers[i].glyph_data) );
-     }
+     ret = dfb_surface_write_buffer( surface, DSBR_BACK, lock.addr, lock.pitch, &rect );
 
-     dfb_font_manager_unlock( font->manager );
+     dfb_surface_unlock_buffer( cache->staging, &lock );
 
-     return DFB_OK;
+     return ret;
 }
 
 DFBResult
@@ -782,12 +2138,10 @@ dfb_font_get_glyph_data( CoreFont       *font,
                          unsigned int    layer,
                          CoreGlyphData **ret_data )
 {
-     DFBResult         ret;
-     CoreGlyphData    *data;
-     int               align;
-     CoreFontManager  *manager;
-     CoreFontCache    *cache;
-     CoreFontCacheRow *row = NULL;
+     DFBResult        ret;
+     CoreGlyphData   *data;
+     CoreFontManager *manager;
+     CoreFontCache   *cache;
 
      D_DEBUG_AT( Core_Font, "%s( index %u, layer %u )\n", __FUNCTION__, index, layer );
 
@@ -798,36 +2152,35 @@ dfb_font_get_glyph_data( CoreFont       *font,
      manager = font->manager;
 
      D_MAGIC_ASSERT( manager, CoreFontManager );
-     D_ASSERT( (manager)->max_rows > 0 );
-     D_ASSERT( (manager)->num_rows <= (manager)->max_rows );
 
-     /* Quick Lookup in array. */
-     if (index < 128 && font->layers[layer].glyph_data[index]) {
-          data = font->layers[layer].glyph_data[index];
-          if (data->retry)
-               goto retry;
+     /* Quick lookup in page table. */
+     if (index < DFB_FONT_GLYPH_PAGES * DFB_FONT_GLYPH_PAGE_SIZE) {
+          CoreGlyphData **page = font->layers[layer].glyph_pages[index >> DFB_FONT_GLYPH_PAGE_BITS];
 
-          *ret_data = font->layers[layer].glyph_data[index];
-          return DFB_OK;
+          if (page && page[index & (DFB_FONT_GLYPH_PAGE_SIZE - 1)]) {
+               data = page[index & (DFB_FONT_GLYPH_PAGE_SIZE - 1)];
+               if (!font_glyph_acquire( manager, data ))
+                    goto retry;
+
+               font_glyph_touch( manager, data );
+
+               *ret_data = data;
+               return DFB_OK;
+          }
      }
 
-     /* Standard lookup in hash. */
+     /* Fallback lookup in hash. */
      data = direct_hash_lookup( font->layers[layer].glyph_hash, index );
      if (data) {
           D_MAGIC_ASSERT( data, CoreGlyphData );
 
           D_DEBUG_AT( Core_Font, "  -> already in cache (%p)\n", data );
 
-          row = data->row;
-          if (row) {
-               D_MAGIC_ASSERT( row, CoreFontCacheRow );
-
-               row->stamp = manager->row_stamp++;
-          }
-
-          if (data->retry)
+          if (!font_glyph_acquire( manager, data ))
                goto retry;
 
+          font_glyph_touch( manager, data );
+
           *ret_data = data;
           return DFB_OK;
      }
@@ -849,7 +2202,14 @@ dfb_font_get_glyph_data( CoreFont       *font,
      data->layer = layer;
 
 retry:
-     data->retry = false;
+     D_ASSERT( data->row == NULL );
+
+     data->retry       = false;
+     data->shared_page = NULL;
+
+     /* Use the glyph cache shared with other processes, falling back to the local one if it's full. */
+     if (manager->shared && font_shared_get_glyph( manager->shared, font, data ) == DFB_OK)
+          goto out;
 
      /* Get glyph data from font implementation. */
      ret = font->GetGlyphData( font, index, data );
@@ -875,51 +2235,35 @@ retry:
           goto out;
      }
 
-     /* Get the proper cache based on size. */
+     /* Get the proper cache based on the format, glyphs of all sizes share its pages. */
 
      CoreFontCacheType type;
 
-     type.height       = MAX( data->height, data->width );
      type.pixel_format = font->pixel_format;
      type.surface_caps = font->surface_caps;
 
-     /* Avoid too many surface switches during one string rendering. */
-     type.height       = MAX( font->height, type.height );
-
      ret = dfb_font_manager_get_cache( font->manager, &type, &cache );
      if (ret) {
           D_DEBUG_AT( Core_Font, "  -> could not get cache from manager!\n" );
           goto error;
      }
 
-     /* Check for a cache row (surface) to use. */
-     ret = dfb_font_cache_get_row( cache, data->width, &row );
+     /* Place the glyph in a cache page. */
+     ret = dfb_font_cache_alloc_glyph( cache, data );
      if (ret) {
-          D_DEBUG_AT( Core_Font, "  -> could not get row from cache!\n" );
+          D_DEBUG_AT( Core_Font, "  -> could not allocate glyph in cache!\n" );
           goto error;
      }
 
-     /* Add the glyph to the cache row. */
-
-     D_DEBUG_AT( Core_FontSurfaces, "  -> render %u - %2dx%2d at %03u\n",
-                 index, data->width, data->height, row->next_x );
-
-     data->row     = row;
-     data->start   = row->next_x;
-     data->surface = row->surface;
-
-     align = (8 / (DFB_BYTES_PER_PIXEL( font->pixel_format ) ?: 1)) *
-             (DFB_PIXELFORMAT_ALIGNMENT( font->pixel_format ) + 1) - 1;
-
-     row->next_x  += (data->width + align) & ~align;
-
-     row->stamp = manager->row_stamp++;
+     D_DEBUG_AT( Core_FontSurfaces, "  -> render %u - %2dx%2d at %4d,%4d\n",
+                 index, data->width, data->height, data->start, data->start_y );
 
      /* Render the glyph data into the surface. */
-     ret = font->RenderGlyph( font, index, data );
+     ret = font_cache_render_glyph( cache, font, index, data );
      if (ret) {
           D_DEBUG_AT( Core_Font, "  -> rendering glyph failed!\n" );
-          data->start = data->width = data->height = 0;
+          dfb_font_cache_free_glyph( data );
+          data->start = data->start_y = data->width = data->height = 0;
 
           /* If the font module returned BUFFEREMPTY we will retry loading next time. */
           if (ret == DFB_BUFFEREMPTY)
@@ -934,13 +2278,7 @@ retry:
 
 out:
      if (!data->inserted) {
-          if (row)
-               direct_list_append( &row->glyphs, &data->link );
-
-          direct_hash_insert( font->layers[layer].glyph_hash, index, data );
-
-          if (index < 128)
-               font->layers[layer].glyph_data[index] = data;
+          dfb_font_insert_glyph_data( font, index, layer, data );
 
           data->inserted = true;
      }
@@ -956,6 +2294,386 @@ error:
      return ret;
 }
 
+DFBResult
+dfb_font_get_glyph_data_array( CoreFont            *font,
+                               unsigned int         prev,
+                               const unsigned int  *indices,
+                               int                  num,
+                               unsigned int         layer,
+                               CoreGlyphData      **ret_glyphs,
+                               DFBPoint            *ret_advances )
+{
+     int              i;
+     CoreFontManager *manager;
+
+     D_DEBUG_AT( Core_Font, "%s( prev %u, %d indices, layer %u )\n", __FUNCTION__, prev, num, layer );
+
+     D_MAGIC_ASSERT( font, CoreFont );
+     D_ASSERT( indices != NULL || num == 0 );
+     D_ASSERT( layer < D_ARRAY_SIZE(font->layers) );
+     D_ASSERT( ret_glyphs != NULL || ret_advances != NULL );
+
+     manager = font->manager;
+
+     D_MAGIC_ASSERT( manager, CoreFontManager );
+
+     for (i = 0; i < num; i++) {
+          unsigned int   current = indices[i];
+          CoreGlyphData *data    = NULL;
+          int            kx, ky;
+
+          /* Quick lookup in page table, glyphs of a run mostly share the same page. */
+          if (current < DFB_FONT_GLYPH_PAGES * DFB_FONT_GLYPH_PAGE_SIZE) {
+               CoreGlyphData **page = font->layers[layer].glyph_pages[current >> DFB_FONT_GLYPH_PAGE_BITS];
+
+               if (page)
+                    data = page[current & (DFB_FONT_GLYPH_PAGE_SIZE - 1)];
+          }
+
+          if (data && font_glyph_acquire( manager, data ))
+               font_glyph_touch( manager, data );
+          else if (dfb_font_get_glyph_data( font, current, layer, &data ))
+               data = NULL;
+
+          if (ret_glyphs) {
+               ret_glyphs[i] = data;
+
+               /* Keep the returned glyphs from being evicted by loading the following ones. */
+               if (data && data->row)
+                    manager->pinned++;
+          }
+
+          if (ret_advances) {
+               if (data) {
+                    ret_advances[i].x = data->xadvance;
+                    ret_advances[i].y = data->yadvance;
+
+                    if (prev && font->GetKerning && font->GetKerning( font, prev, current, &kx, &ky ) == DFB_OK) {
+                         ret_advances[i].x += kx << 8;
+                         ret_advances[i].y += ky << 8;
+                    }
+               }
+               else
+                    ret_advances[i].x = ret_advances[i].y = 0;
+          }
+
+          prev = current;
+     }
+
+     manager->pinned = 0;
+
+     return DFB_OK;
+}
+
+static void
+text_run_blend( u8                    *dst,
+                int                    dst_pitch,
+                const u8              *src,
+                int                    src_pitch,
+                int                    width,
+                int                    height,
+                DFBSurfacePixelFormat  format )
+{
+     int x, y;
+
+     /* Porter/Duff SRC_OVER composition of premultiplied glyphs. */
+     for (y = 0; y < height; y++) {
+          if (format == DSPF_A8) {
+               for (x = 0; x < width; x++)
+                    dst[x] = src[x] + (dst[x] * (255 - src[x]) + 127) / 255;
+          }
+          else {
+               u32       *d = (u32*) dst;
+               const u32 *s = (const u32*) src;
+
+               for (x = 0; x < width; x++) {
+                    u32          spixel = s[x];
+                    u32          dpixel = d[x];
+                    unsigned int inv    = 255 - (spixel >> 24);
+                    int          shift;
+
+                    d[x] = 0;
+
+                    for (shift = 0; shift < 32; shift += 8) {
+                         unsigned int c = ((spixel >> shift) & 0xff) + (((dpixel >> shift) & 0xff) * inv + 127) / 255;
+
+                         d[x] |= MIN( c, 0xff ) << shift;
+                    }
+               }
+          }
+
+          dst += dst_pitch;
+          src += src_pitch;
+     }
+}
+
+static DFBResult
+text_run_render( CoreFont          *font,
+                 const TextRunKey  *key,
+                 CoreTextRun      **ret_run )
+{
+     DFBResult      ret;
+     int            i;
+     int            kern_x;
+     int            kern_y;
+     CoreTextRun   *run;
+     CoreGlyphData *glyph;
+     unsigned int   prev   = 0;
+     int            x      = 0;
+     int            y      = 0;
+     int            pitch  = 0;
+     int            max    = 0;
+     u8            *pixels = NULL;
+     u8            *buffer = NULL;
+     DFBRegion      bounds = { 0, 0, -1, -1 };
+     DFBPoint      *points;
+
+     D_DEBUG_AT( Font_TextRun, "%s( %p, %d, layer %u )\n", __FUNCTION__, font, key->num, key->layer );
+
+     points = D_MALLOC( MAX( key->num, 1 ) * sizeof(DFBPoint) );
+     if (!points)
+          return D_OOM();
+
+     /* Place the glyphs like dfb_gfxcard_drawstring(), loading them only to get the size of the run. */
+     for (i = 0; i < key->num; i++) {
+          unsigned int current = key->indices[i];
+
+          ret = dfb_font_get_glyph_data( font, current, key->layer, &glyph );
+          if (ret) {
+               prev = current;
+               continue;
+          }
+
+          if (glyph->retry) {
+               D_FREE( points );
+               return DFB_BUFFEREMPTY;
+          }
+
+          if (prev && font->GetKerning && font->GetKerning( font, prev, current, &kern_x, &kern_y ) == DFB_OK) {
+               x += kern_x << 8;
+               y += kern_y << 8;
+          }
+
+          if (glyph->width) {
+               DFBRegion region = { (x >> 8) + glyph->left, (y >> 8) + glyph->top,
+                                    (x >> 8) + glyph->left + glyph->width - 1,
+                                    (y >> 8) + glyph->top + glyph->height - 1 };
+
+               if (bounds.x2 < bounds.x1)
+                    bounds = region;
+               else
+                    dfb_region_region_union( &bounds, &region );
+
+               points[i].x = region.x1;
+               points[i].y = region.y1;
+
+               max = MAX( max, glyph->width * glyph->height );
+          }
+
+          x   += glyph->xadvance;
+          y   += glyph->yadvance;
+          prev = current;
+     }
+
+     run = D_CALLOC( 1, sizeof(CoreTextRun) + key->num * sizeof(unsigned int) );
+     if (!run) {
+          D_FREE( points );
+          return D_OOM();
+     }
+
+     run->font    = font;
+     run->layer   = key->layer;
+     run->indices = (unsigned int*) (run + 1);
+     run->num     = key->num;
+     run->size    = sizeof(CoreTextRun) + key->num * sizeof(unsigned int);
+
+     direct_memcpy( run->indices, key->indices, key->num * sizeof(unsigned int) );
+
+     D_MAGIC_SET( run, CoreTextRun );
+
+     if (bounds.x2 < bounds.x1) {
+          D_FREE( points );
+          goto out;
+     }
+
+     run->left   = bounds.x1;
+     run->top    = bounds.y1;
+     run->width  = bounds.x2 - bounds.x1 + 1;
+     run->height = bounds.y2 - bounds.y1 + 1;
+
+     pitch = DFB_BYTES_PER_LINE( font->pixel_format, run->width );
+
+     run->size += pitch * run->height;
+
+     if (run->size > font->manager->run_stats.budget) {
+          ret = DFB_LIMITEXCEEDED;
+          goto error;
+     }
+
+     pixels = D_CALLOC( run->height, pitch );
+     buffer = D_MALLOC( max * DFB_BYTES_PER_PIXEL( font->pixel_format ) );
+     if (!pixels || !buffer) {
+          ret = D_OOM();
+          goto error;
+     }
+
+     /* Composite each glyph right after loading it again, as loading another one may evict its row. */
+     for (i = 0; i < key->num; i++) {
+          DFBRectangle rect;
+          int          glyph_pitch;
+
+          ret = dfb_font_get_glyph_data( font, key->indices[i], key->layer, &glyph );
+          if (ret)
+               continue;
+
+          if (glyph->retry) {
+               ret = DFB_BUFFEREMPTY;
+               goto error;
+          }
+
+          if (!glyph->width)
+               continue;
+
+          rect        = (DFBRectangle) { glyph->start, glyph->start_y, glyph->width, glyph->height };
+          glyph_pitch = DFB_BYTES_PER_LINE( font->pixel_format, glyph->width );
+
+          ret = dfb_surface_read_buffer( glyph->surface, DSBR_BACK, buffer, glyph_pitch, &rect );
+          if (ret)
+               goto error;
+
+          text_run_blend( pixels + (points[i].y - run->top) * pitch +
+                          DFB_BYTES_PER_LINE( font->pixel_format, points[i].x - run->left ), pitch,
+                          buffer, glyph_pitch, glyph->width, glyph->height, font->pixel_format );
+     }
+
+     ret = dfb_surface_create_simple( font->core, run->width, run->height, font->pixel_format,
+                                      DFB_COLORSPACE_DEFAULT( font->pixel_format ), font->surface_caps,
+                                      CSTF_FONT, dfb_config->font_resource_id, NULL, &run->surface );
+     if (ret) {
+          D_DERROR( ret, "Core/Font: Could not create text run surface!\n" );
+          goto error;
+     }
+
+     ret = dfb_surface_write_buffer( run->surface, DSBR_BACK, pixels, pitch, NULL );
+     if (ret)
+          goto error;
+
+     D_FREE( buffer );
+     D_FREE( pixels );
+     D_FREE( points );
+
+     D_DEBUG_AT( Core_FontSurfaces, "  -> new run %dx%d %s\n",
+                 run->width, run->height, dfb_pixelformat_name( font->pixel_format ) );
+
+out:
+     *ret_run = run;
+
+     return DFB_OK;
+
+error:
+     if (run->surface)
+          dfb_surface_unref( run->surface );
+
+     if (buffer)
+          D_FREE( buffer );
+
+     if (pixels)
+          D_FREE( pixels );
+
+     D_FREE( points );
+
+     D_MAGIC_CLEAR( run );
+     D_FREE( run );
+
+     return ret;
+}
+
+DFBResult
+dfb_font_get_text_run( CoreFont            *font,
+                       const unsigned int  *indices,
+                       int                  num,
+                       unsigned int         layer,
+                       CoreTextRun        **ret_run )
+{
+     DFBResult        ret;
+     CoreFontManager *manager;
+     CoreTextRun     *run;
+     TextRunKey       key = { font, layer, indices, num };
+
+     D_DEBUG_AT( Font_TextRun, "%s( %p, %d, layer %u )\n", __FUNCTION__, font, num, layer );
+
+     D_MAGIC_ASSERT( font, CoreFont );
+     D_ASSERT( indices != NULL || num == 0 );
+     D_ASSERT( layer < D_ARRAY_SIZE(font->layers) );
+     D_ASSERT( ret_run != NULL );
+
+     manager = font->manager;
+
+     D_MAGIC_ASSERT( manager, CoreFontManager );
+
+     if (!manager->run_stats.budget)
+          return DFB_UNSUPPORTED;
+
+     /* Only premultiplied glyphs blended by their alpha channel can be composited into a run which blends like the
+        single glyphs. */
+     if (font->pixel_format != DSPF_A8 &&
+         (font->pixel_format != DSPF_ARGB || !(font->surface_caps & DSCAPS_PREMULTIPLIED)))
+          return DFB_UNSUPPORTED;
+
+     if ((font->blittingflags & ~DSBLIT_COLORIZE) != DSBLIT_BLEND_ALPHACHANNEL)
+          return DFB_UNSUPPORTED;
+
+     run = direct_map_lookup( manager->runs, &key );
+     if (run) {
+          D_MAGIC_ASSERT( run, CoreTextRun );
+
+          D_DEBUG_AT( Font_TextRun, "  -> hit (%p)\n", run );
+
+          manager->run_stats.hits++;
+
+          direct_list_move_to_front( &manager->runs_lru, &run->link );
+
+          *ret_run = run;
+
+          return DFB_OK;
+     }
+
+     manager->run_stats.misses++;
+
+     ret = text_run_render( font, &key, &run );
+     if (ret)
+          return ret;
+
+     /* Remove least recently used runs until the new one fits into the budget. */
+     while (manager->run_stats.size + run->size > manager->run_stats.budget) {
+          D_ASSERT( manager->runs_lru != NULL );
+
+          text_run_remove( manager, (CoreTextRun*) direct_list_get_last( manager->runs_lru ) );
+
+          manager->run_stats.evictions++;
+     }
+
+     ret = direct_map_insert( manager->runs, &key, run );
+     if (ret) {
+          if (run->surface)
+               dfb_surface_unref( run->surface );
+
+          D_MAGIC_CLEAR( run );
+          D_FREE( run );
+
+          return ret;
+     }
+
+     direct_list_prepend( &manager->runs_lru, &run->link );
+
+     manager->run_stats.num_runs++;
+     manager->run_stats.size += run->size;
+
+     *ret_run = run;
+
+     return DFB_OK;
+}
+
 /**********************************************************************************************************************/
 
 DFBResult
@@ -1022,6 +2740,81 @@ dfb_font_register_encoding( CoreFont                    *font,
      return DFB_OK;
 }
 
+/*
+ * Widen the leading 7 bit characters of a string to indices, returning the number of bytes consumed.
+ */
+#ifdef USE_SSE2
+
+#define SSE2_FUNC __attribute__((target("sse2")))
+
+static int SSE2_FUNC
+decode_ascii( const u8     *bytes,
+              int           length,
+              unsigned int *ret_indices )
+{
+     int           pos  = 0;
+     const __m128i zero = _mm_setzero_si128();
+
+     while (pos + 16 <= length) {
+          __m128i chars = _mm_loadu_si128( (const __m128i*) (bytes + pos) );
+          __m128i lo, hi;
+
+          if (_mm_movemask_epi8( chars ))
+               break;
+
+          lo = _mm_unpacklo_epi8( chars, zero );
+          hi = _mm_unpackhi_epi8( chars, zero );
+
+          _mm_storeu_si128( (__m128i*) (ret_indices + pos +  0), _mm_unpacklo_epi16( lo, zero ) );
+          _mm_storeu_si128( (__m128i*) (ret_indices + pos +  4), _mm_unpackhi_epi16( lo, zero ) );
+          _mm_storeu_si128( (__m128i*) (ret_indices + pos +  8), _mm_unpacklo_epi16( hi, zero ) );
+          _mm_storeu_si128( (__m128i*) (ret_indices + pos + 12), _mm_unpackhi_epi16( hi, zero ) );
+
+          pos += 16;
+     }
+
+     while (pos < length && bytes[pos] < 128) {
+          ret_indices[pos] = bytes[pos];
+          pos++;
+     }
+
+     return pos;
+}
+
+#else
+
+static int
+decode_ascii( const u8     *bytes,
+              int           length,
+              unsigned int *ret_indices )
+{
+     int pos = 0;
+
+     while (pos + 8 <= length) {
+          u64 chars;
+          int i;
+
+          direct_memcpy( &chars, bytes + pos, 8 );
+
+          if (chars & 0x8080808080808080ULL)
+               break;
+
+          for (i = 0; i < 8; i++)
+               ret_indices[pos + i] = bytes[pos + i];
+
+          pos += 8;
+     }
+
+     while (pos < length && bytes[pos] < 128) {
+          ret_indices[pos] = bytes[pos];
+          pos++;
+     }
+
+     return pos;
+}
+
+#endif
+
 DFBResult
 dfb_font_decode_text( CoreFont          *font,
                       DFBTextEncodingID  encoding,
@@ -1066,21 +2859,35 @@ dfb_font_decode_text( CoreFont          *font,
           while (pos < length) {
                unsigned int c;
 
-               if (bytes[pos] < 128)
-                    c = bytes[pos++];
-               else {
-                    c = DIRECT_UTF8_GET_CHAR( &bytes[pos] );
-                    pos += DIRECT_UTF8_SKIP( bytes[pos] );
+               if (bytes[pos] < 128) {
+                    /* Widen the run of 7 bit characters in place, indices never overtake characters. */
+                    unsigned int *chars = ret_indices + num;
+                    int           i, run = decode_ascii( bytes + pos, length - pos, chars );
+
+                    for (i = 0; i < run; i++) {
+                         if (funcs->GetCharacterIndex( font, chars[i], &ret_indices[num] ) == DFB_OK)
+                              num++;
+                    }
+
+                    pos += run;
+                    continue;
                }
 
+               c = DIRECT_UTF8_GET_CHAR( &bytes[pos] );
+               pos += DIRECT_UTF8_SKIP( bytes[pos] );
+
                if (funcs->GetCharacterIndex( font, c, &ret_indices[num] ) == DFB_OK)
                     num++;
           }
      }
      else {
           while (pos < length) {
-               if (bytes[pos] < 128)
-                    ret_indices[num++] = bytes[pos++];
+               if (bytes[pos] < 128) {
+                    int run = decode_ascii( bytes + pos, length - pos, ret_indices + num );
+
+                    pos += run;
+                    num += run;
+               }
                else {
                     ret_indices[num++] = DIRECT_UTF8_GET_CHAR( &bytes[pos] );
                     pos += DIRECT_UTF8_SKIP( bytes[pos] );
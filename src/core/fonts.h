@@ -24,7 +24,11 @@
 
 /**********************************************************************************************************************/
 
-#define DFB_FONT_MAX_LAYERS 2
+#define DFB_FONT_MAX_LAYERS      2
+
+#define DFB_FONT_GLYPH_PAGE_BITS 8
+#define DFB_FONT_GLYPH_PAGE_SIZE (1 << DFB_FONT_GLYPH_PAGE_BITS)
+#define DFB_FONT_GLYPH_PAGES     (0x20000 >> DFB_FONT_GLYPH_PAGE_BITS)   /* indices of the first two unicode planes */
 
 typedef struct {
      DFBResult (*GetCharacterIndex)( CoreFont     *thiz,
@@ -71,10 +75,12 @@ struct __DFB_CoreFont {
      DFBFontAttributes             attributes;
 
      struct {
-          DirectHash              *glyph_hash;
-          CoreGlyphData           *glyph_data[128];
+          DirectHash              *glyph_hash;                         /* all glyphs */
+          CoreGlyphData          **glyph_pages[DFB_FONT_GLYPH_PAGES];  /* direct lookup, pages allocated on first use */
      } layers[DFB_FONT_MAX_LAYERS];
 
+     CoreFontSharedFace           *shared_face;     /* glyphs shared with other processes, NULL until looked up */
+
      int                           height;          /* font height */
 
      int                           ascender;        /* a positive value, the distance from the baseline to the top */
@@ -129,6 +135,7 @@ struct __DFB_CoreGlyphData {
 
      CoreSurface      *surface;  /* contains bitmap of glyph */
      int               start;    /* x offset of glyph in surface */
+     int               start_y;  /* y offset of glyph in surface */
      int               width;    /* width of the glyphs bitmap */
      int               height;   /* height of the glyphs bitmap */
      int               left;     /* x offset of the glyph */
@@ -139,6 +146,10 @@ struct __DFB_CoreGlyphData {
      int               magic;
 
      CoreFontCacheRow *row;
+     DirectLink        lru;      /* in the LRU list of the manager */
+
+     CoreFontSharedPage *shared_page;   /* page of the shared cache holding the bitmap */
+     unsigned int        shared_serial; /* serial of the page when the bitmap was looked up */
 
      bool              inserted;
      bool              retry;
@@ -151,6 +162,7 @@ struct __DFB_CoreGlyphData {
           D_DEBUG_AT( Domain, "  -> row      %p\n", (data)->row );      \
           D_DEBUG_AT( Domain, "  -> surface  %p\n", (data)->surface );  \
           D_DEBUG_AT( Domain, "  -> start    %d\n", (data)->start );    \
+          D_DEBUG_AT( Domain, "  -> start_y  %d\n", (data)->start_y );  \
           D_DEBUG_AT( Domain, "  -> width    %d\n", (data)->width );    \
           D_DEBUG_AT( Domain, "  -> height   %d\n", (data)->height );   \
           D_DEBUG_AT( Domain, "  -> left     %d\n", (data)->left );     \
@@ -159,10 +171,40 @@ struct __DFB_CoreGlyphData {
           D_DEBUG_AT( Domain, "  -> yadvance %d\n", (data)->yadvance ); \
      } while (0)
 
+/*
+ * Glyphs of a decoded string in one layer, composited into a single surface.
+ */
+typedef struct {
+     DirectLink        link;
+
+     int               magic;
+
+     CoreFont         *font;
+     unsigned int      layer;
+     unsigned int     *indices;
+     int               num;
+
+     CoreSurface      *surface;  /* contains bitmap of all glyphs, NULL if nothing is visible */
+     int               left;     /* x offset of the run from the string origin */
+     int               top;      /* y offset of the run from the string origin */
+     int               width;    /* width of the runs bitmap */
+     int               height;   /* height of the runs bitmap */
+
+     unsigned int      size;     /* bytes accounted in the cache budget */
+} CoreTextRun;
+
+typedef struct {
+     unsigned int           num_runs;
+     unsigned int           size;      /* bytes used by cached runs */
+     unsigned int           budget;    /* maximum size, 0 if the cache is disabled */
+     unsigned long long     hits;
+     unsigned long long     misses;
+     unsigned long long     evictions;
+} CoreTextRunStats;
+
 /**********************************************************************************************************************/
 
 typedef struct {
-     unsigned int           height;
      DFBSurfacePixelFormat  pixel_format;
      DFBSurfaceCapabilities surface_caps;
 } CoreFontCacheType;
@@ -187,8 +229,19 @@ DFBResult dfb_font_manager_get_cache     ( CoreFontManager              *manager
                                            const CoreFontCacheType      *type,
                                            CoreFontCache               **ret_cache );
 
+DFBResult dfb_font_manager_evict_glyph   ( CoreFontManager              *manager );
+
+/*
+ * Deprecated, evicts all glyphs of the row holding the least recently used glyph.
+ */
 DFBResult dfb_font_manager_remove_lru_row( CoreFontManager              *manager );
 
+/*
+ * Get usage and hit rate of the text run cache.
+ */
+DFBResult dfb_font_manager_get_run_stats ( CoreFontManager              *manager,
+                                           CoreTextRunStats             *ret_stats );
+
 /**********************************************************************************************************************/
 
 DFBResult dfb_font_cache_create          ( CoreFontManager              *manager,
@@ -203,6 +256,22 @@ DFBResult dfb_font_cache_init            ( CoreFontCache                *cache,
 
 DFBResult dfb_font_cache_deinit          ( CoreFontCache                *cache );
 
+/*
+ * Place a glyph of the given size in a page of the cache, evicting least recently used glyphs if needed.
+ */
+DFBResult dfb_font_cache_alloc_glyph     ( CoreFontCache                *cache,
+                                           CoreGlyphData                *data );
+
+/*
+ * Release the space of a glyph in the cache.
+ */
+DFBResult dfb_font_cache_free_glyph      ( CoreGlyphData                *data );
+
+/*
+ * Deprecated row interface, glyphs are placed in rows of pages by dfb_font_cache_alloc_glyph().
+ *
+ * A created row spans a page of its own, deinitializing or destroying a row returns it to its page.
+ */
 DFBResult dfb_font_cache_get_row         ( CoreFontCache                *cache,
                                            unsigned int                  width,
                                            CoreFontCacheRow            **ret_row );
@@ -245,6 +314,43 @@ DFBResult dfb_font_get_glyph_data        ( CoreFont                     *font,
                                            unsigned int                  layer,
                                            CoreGlyphData               **glyph_data );
 
+/*
+ * Load glyph data for a run of indices in a layer, the font must be locked.
+ *
+ * Glyphs that can't be loaded are returned as NULL. Advances are in 1/256 pixels and include the kerning with the
+ * preceding index, which is 'prev' for the first one (0 for none), so that their sum is the pen movement of the run.
+ *
+ * Returned glyphs are not evicted while loading the following ones, the cache may exceed its maximum number of pages
+ * to hold a run longer than expected. They are valid until another glyph is loaded.
+ */
+DFBResult dfb_font_get_glyph_data_array  ( CoreFont                     *font,
+                                           unsigned int                  prev,
+                                           const unsigned int           *indices,
+                                           int                           num,
+                                           unsigned int                  layer,
+                                           CoreGlyphData               **ret_glyphs,
+                                           DFBPoint                     *ret_advances );
+
+/*
+ * Insert glyph data into the lookup tables of the font.
+ */
+DFBResult dfb_font_insert_glyph_data     ( CoreFont                     *font,
+                                           unsigned int                  index,
+                                           unsigned int                  layer,
+                                           CoreGlyphData                *data );
+
+/*
+ * Get the cached text run of decoded characters in a layer, rendering it on a miss.
+ *
+ * Returns DFB_UNSUPPORTED if the cache is disabled or the glyph format can't be composited, DFB_LIMITEXCEEDED if the
+ * run doesn't fit into the budget and DFB_BUFFEREMPTY if a glyph is not available yet.
+ */
+DFBResult dfb_font_get_text_run          ( CoreFont                     *font,
+                                           const unsigned int           *indices,
+                                           int                           num,
+                                           unsigned int                  layer,
+                                           CoreTextRun                 **ret_run );
+
 /*
  * Register encoding implementations.
  *
@@ -31,6 +31,9 @@
 #include <gfx/generic/generic_blit.h>
 #include <gfx/generic/generic_draw_line.h>
 #include <gfx/generic/generic_fill_rectangle.h>
+#include <gfx/generic/generic_glyphs.h>
+#include <gfx/generic/generic_queue.h>
+#include <gfx/generic/generic_scale.h>
 #include <gfx/generic/generic_stretch_blit.h>
 #include <gfx/generic/generic_texture_triangles.h>
 #include <gfx/util.h>
@@ -269,6 +272,16 @@ dfb_graphics_core_initialize( CoreDFB               *core,
 
      fusion_skirmish_init2( &shared->lock, "GfxCard", dfb_core_world( core ), fusion_config->secure_fusion );
 
+     if (dfb_config->software_only && dfb_config->software_queue > 0) {
+#if FUSION_BUILD_MULTI
+          D_INFO( "DirectFB/Graphics: Software render queue not supported in multi application mode\n" );
+#else
+          ret = Genefx_Queue_Start( dfb_config->software_queue );
+          if (ret)
+               D_DERROR( ret, "DirectFB/Graphics: Could not start software render queue!\n" );
+#endif
+     }
+
      D_MAGIC_SET( data, DFBGraphicsCore );
      D_MAGIC_SET( shared, DFBGraphicsCoreShared );
 
@@ -394,6 +407,10 @@ dfb_graphics_core_shutdown( DFBGraphicsCore *data,
 
      pool = dfb_core_shmpool( data->core );
 
+     Genefx_Queue_Stop();
+
+     gShutdown();
+
      dfb_gfxcard_lock( GDLF_SYNC );
 
      if (data->driver_funcs) {
@@ -430,6 +447,8 @@ dfb_graphics_core_leave( DFBGraphicsCore *data,
      D_MAGIC_ASSERT( data, DFBGraphicsCore );
      D_MAGIC_ASSERT( data->shared, DFBGraphicsCoreShared );
 
+     gShutdown();
+
      if (data->driver_funcs) {
           data->driver_funcs->CloseDriver( data->driver_data );
 
@@ -617,6 +636,41 @@ dfb_gfxcard_stop_drawing( CardState *state )
           card->funcs.StopDrawing( card->driver_data, card->device_data, state );
 }
 
+/*
+ * Returns true if the result of a previous check of the function is still valid, i.e. no value of the state has been
+ * modified, as CheckState() of a driver may read any of them, and none of the surfaces has been reconfigured or flipped
+ * since.
+ */
+static __inline__ bool
+dfb_gfxcard_state_checked( const CardState     *state,
+                           DFBAccelerationMask  accel )
+{
+     if (!(state->checked & accel) || state->modified)
+          return false;
+
+     if (!D_FLAGS_IS_SET( state->flags, CSF_DESTINATION ) || !state->destination->num_buffers ||
+         !direct_serial_check( &state->dst_serial, &state->destination->serial ))
+          return false;
+
+     if (DFB_BLITTING_FUNCTION( accel )) {
+          if (!D_FLAGS_IS_SET( state->flags, CSF_SOURCE ) ||
+              !direct_serial_check( &state->src_serial, &state->source->serial ))
+               return false;
+
+          if (state->blittingflags & (DSBLIT_SRC_MASK_ALPHA | DSBLIT_SRC_MASK_COLOR) &&
+              (!D_FLAGS_IS_SET( state->flags, CSF_SOURCE_MASK ) ||
+               !direct_serial_check( &state->src_mask_serial, &state->source_mask->serial )))
+               return false;
+
+          if (accel == DFXL_BLIT2 &&
+              (!D_FLAGS_IS_SET( state->flags, CSF_SOURCE2 ) ||
+               !direct_serial_check( &state->src2_serial, &state->source2->serial )))
+               return false;
+     }
+
+     return true;
+}
+
 bool
 dfb_gfxcard_state_check( CardState           *state,
                          DFBAccelerationMask  accel )
@@ -693,16 +747,6 @@ dfb_gfxcard_state_check( CardState           *state,
           }
      }
 
-     ret = dfb_surface_lock( state->destination );
-     if (ret)
-          return false;
-
-     dst_buffer = dfb_surface_get_buffer( state->destination, state->to );
-
-     D_MAGIC_ASSERT( dst_buffer, CoreSurfaceBuffer );
-
-     dfb_surface_unlock( state->destination );
-
      D_ASSUME( state->clip.x2 < state->destination->config.size.w );
      D_ASSUME( state->clip.y2 < state->destination->config.size.h );
 
@@ -727,6 +771,10 @@ dfb_gfxcard_state_check( CardState           *state,
           state->modified |= SMF_CLIP;
      }
 
+     /* Operations of the render queue are executed in software, their buffers have been locked in advance. */
+     if (state->flags & CSF_BUFFERS_LOCKED)
+          return false;
+
      /* If there's no CheckState() function, there's no acceleration at all.  */
      if (!card->funcs.CheckState) {
           D_DEBUG_AT( Core_GfxState, "  -> no acceleration available\n" );
@@ -741,6 +789,17 @@ dfb_gfxcard_state_check( CardState           *state,
           return false;
      }
 
+     /* Nothing else to do if the function has been checked already, the clip has been clamped above. */
+     if (dfb_gfxcard_state_checked( state, accel )) {
+          D_DEBUG_AT( Core_GfxState, "  -> unchanged, accel 0x%08x\n", state->accel );
+
+          /* Move modification flags to the set for drivers. */
+          state->mod_hw   |= state->modified;
+          state->modified  = SMF_NONE;
+
+          return state->accel & accel;
+     }
+
      /* If destination or blend functions have been changed... */
      if (state->modified & (SMF_DESTINATION | SMF_SRC_BLEND | SMF_DST_BLEND | SMF_RENDER_OPTIONS)) {
           /* ...force rechecking for all functions. */
@@ -785,6 +844,16 @@ dfb_gfxcard_state_check( CardState           *state,
      D_DEBUG_AT( Core_GfxState, "  -> checked 0x%08x, accel 0x%08x, modified 0x%08x, mod_hw 0x%08x\n",
                  state->checked, state->accel, state->modified, state->mod_hw );
 
+     ret = dfb_surface_lock( state->destination );
+     if (ret)
+          return false;
+
+     dst_buffer = dfb_surface_get_buffer( state->destination, state->to );
+
+     D_MAGIC_ASSERT( dst_buffer, CoreSurfaceBuffer );
+
+     dfb_surface_unlock( state->destination );
+
      /* Move modification flags to the set for drivers. */
      state->mod_hw   |= state->modified;
      state->modified  = SMF_NONE;
@@ -1142,6 +1211,11 @@ dfb_gfxcard_state_check_acquire( CardState           *state,
           state->modified |= SMF_CLIP;
      }
 
+     /* Operations of the render queue are executed in software without taking the surface locks, the callers queueing
+        them may hold these while waiting for the render thread. */
+     if (state->flags & CSF_BUFFERS_LOCKED)
+          return false;
+
      /* If there's no CheckState() function, there's no acceleration at all. */
      if (!card->funcs.CheckState)
           return false;
@@ -1153,11 +1227,33 @@ dfb_gfxcard_state_check_acquire( CardState           *state,
      if (core_dfb->shutdown_running)
           return false;
 
+     /* Fall back without taking the surface locks if the function has been checked to be not accelerated already. */
+     if (!(state->accel & accel) && dfb_gfxcard_state_checked( state, accel )) {
+          D_DEBUG_AT( Core_GfxState, "  -> unchanged, not accelerated\n" );
+
+          state->mod_hw   |= state->modified;
+          state->modified  = SMF_NONE;
+
+          return false;
+     }
+
      if (fusion_skirmish_prevail_multi( locks, num_locks ))
           return false;
 
      dfb_state_update_destination( state );
 
+     if (DFB_BLITTING_FUNCTION( accel )) {
+          dfb_state_update_sources( state, CSF_SOURCE );
+
+          /* If using a mask. */
+          if (state->blittingflags & (DSBLIT_SRC_MASK_ALPHA | DSBLIT_SRC_MASK_COLOR))
+               dfb_state_update_sources( state, CSF_SOURCE_MASK );
+
+          /* If using source2. */
+          if (accel == DFXL_BLIT2)
+               dfb_state_update_sources( state, CSF_SOURCE2 );
+     }
+
      /* If destination or blend functions have been changed... */
      if (state->modified & (SMF_DESTINATION | SMF_SRC_BLEND | SMF_DST_BLEND | SMF_RENDER_OPTIONS)) {
           /* ...force rechecking for all functions. */
@@ -1202,18 +1298,6 @@ dfb_gfxcard_state_check_acquire( CardState           *state,
      D_DEBUG_AT( Core_GfxState, "  -> checked 0x%08x, accel 0x%08x, modified 0x%08x, mod_hw 0x%08x\n",
                  state->checked, state->accel, state->modified, state->mod_hw );
 
-     if (DFB_BLITTING_FUNCTION(accel)) {
-          dfb_state_update_sources( state, CSF_SOURCE );
-
-          /* If using a mask. */
-          if (state->blittingflags & (DSBLIT_SRC_MASK_ALPHA | DSBLIT_SRC_MASK_COLOR))
-               dfb_state_update_sources( state, CSF_SOURCE_MASK );
-
-          /* If using source2. */
-          if (accel == DFXL_BLIT2)
-               dfb_state_update_sources( state, CSF_SOURCE2 );
-     }
-
      /* If the function needs to be checked. */
      if (!(state->checked & accel)) {
           /* Unset unchecked functions. */
@@ -1508,6 +1592,11 @@ dfb_gfxcard_state_destroy ( CardState *state )
           if (gfxs->ABstart)
                D_FREE( gfxs->ABstart );
 
+          if (gfxs->Kstart)
+               D_FREE( gfxs->Kstart );
+
+          Genefx_Scale_Flush( gfxs );
+
           D_FREE( gfxs );
      }
 
@@ -1654,6 +1743,8 @@ dfb_gfxcard_fillrectangles( DFBRectangle *rects,
                             int           num,
                             CardState    *state )
 {
+     GenefxQueueOperation operation = { 0 };
+
      D_ASSERT( card != NULL );
      D_ASSERT( card->shared != NULL );
 
@@ -1663,6 +1754,14 @@ dfb_gfxcard_fillrectangles( DFBRectangle *rects,
 
      D_DEBUG_AT( Core_GraphicsOps, "%s( %p [%d], %p )\n", __FUNCTION__, rects, num, state );
 
+     operation.op   = GQO_FILLRECTANGLES;
+     operation.data = rects;
+     operation.num  = num;
+
+     /* Defer to the render thread. */
+     if (Genefx_Queue_Put( state, &operation ))
+          return;
+
      /* The state is locked during graphics operations. */
      dfb_state_lock( state );
 
@@ -1822,6 +1921,8 @@ dfb_gfxcard_drawrectangle( DFBRectangle *rect,
      bool         hw = false;
      int          i = 0, num = 0;
 
+     GenefxQueueOperation operation = { 0 };
+
      D_ASSERT( card != NULL );
      D_ASSERT( card->shared != NULL );
 
@@ -1830,6 +1931,13 @@ dfb_gfxcard_drawrectangle( DFBRectangle *rect,
 
      D_DEBUG_AT( Core_GraphicsOps, "%s( %4d,%4d-%4dx%4d, %p )\n", __FUNCTION__, DFB_RECTANGLE_VALS( rect ), state );
 
+     operation.op   = GQO_DRAWRECTANGLE;
+     operation.data = rect;
+
+     /* Defer to the render thread. */
+     if (Genefx_Queue_Put( state, &operation ))
+          return;
+
      /* The state is locked during graphics operations. */
      dfb_state_lock( state );
 
@@ -1927,6 +2035,8 @@ dfb_gfxcard_drawlines( DFBRegion *lines,
 {
      int i = 0;
 
+     GenefxQueueOperation operation = { 0 };
+
      D_ASSERT( card != NULL );
      D_ASSERT( card->shared != NULL );
 
@@ -1936,6 +2046,14 @@ dfb_gfxcard_drawlines( DFBRegion *lines,
 
      D_DEBUG_AT( Core_GraphicsOps, "%s( %p [%d], %p )\n", __FUNCTION__, lines, num, state );
 
+     operation.op   = GQO_DRAWLINES;
+     operation.data = lines;
+     operation.num  = num;
+
+     /* Defer to the render thread. */
+     if (Genefx_Queue_Put( state, &operation ))
+          return;
+
      /* The state is locked during graphics operations. */
      dfb_state_lock( state );
 
@@ -1983,6 +2101,8 @@ dfb_gfxcard_filltriangles( DFBTriangle *tris,
      bool hw = false;
      int  i  = 0;
 
+     GenefxQueueOperation operation = { 0 };
+
      D_ASSERT( card != NULL );
      D_ASSERT( card->shared != NULL );
 
@@ -1992,6 +2112,14 @@ dfb_gfxcard_filltriangles( DFBTriangle *tris,
 
      D_DEBUG_AT( Core_GraphicsOps, "%s( %p [%d], %p )\n", __FUNCTION__, tris, num, state );
 
+     operation.op   = GQO_FILLTRIANGLES;
+     operation.data = tris;
+     operation.num  = num;
+
+     /* Defer to the render thread. */
+     if (Genefx_Queue_Put( state, &operation ))
+          return;
+
      /* The state is locked during graphics operations. */
      dfb_state_lock( state );
 
@@ -2150,6 +2278,8 @@ dfb_gfxcard_filltrapezoids( DFBTrapezoid *traps,
      bool hw = false;
      int  i  = 0;
 
+     GenefxQueueOperation operation = { 0 };
+
      D_ASSERT( card != NULL );
      D_ASSERT( card->shared != NULL );
 
@@ -2159,6 +2289,14 @@ dfb_gfxcard_filltrapezoids( DFBTrapezoid *traps,
 
      D_DEBUG_AT( Core_GraphicsOps, "%s( %p [%d], %p )\n", __FUNCTION__, traps, num, state );
 
+     operation.op   = GQO_FILLTRAPEZOIDS;
+     operation.data = traps;
+     operation.num  = num;
+
+     /* Defer to the render thread. */
+     if (Genefx_Queue_Put( state, &operation ))
+          return;
+
      /* The state is locked during graphics operations. */
      dfb_state_lock( state );
 
@@ -2301,6 +2439,8 @@ dfb_gfxcard_fillquadrangles( DFBPoint  *points,
 {
      bool hw = false;
 
+     GenefxQueueOperation operation = { 0 };
+
      D_ASSERT( card != NULL );
      D_ASSERT( card->shared != NULL );
 
@@ -2309,6 +2449,14 @@ dfb_gfxcard_fillquadrangles( DFBPoint  *points,
 
      D_DEBUG_AT( Core_GraphicsOps, "%s( %p [%d], %p )\n", __FUNCTION__, points, num, state );
 
+     operation.op   = GQO_FILLQUADRANGLES;
+     operation.data = points;
+     operation.num  = num;
+
+     /* Defer to the render thread. */
+     if (Genefx_Queue_Put( state, &operation ))
+          return;
+
      /* The state is locked during graphics operations. */
      dfb_state_lock( state );
 
@@ -2372,6 +2520,8 @@ dfb_gfxcard_fillspans( int        y,
 {
      int i = 0;
 
+     GenefxQueueOperation operation = { 0 };
+
      D_ASSERT( card != NULL );
      D_ASSERT( card->shared != NULL );
 
@@ -2381,6 +2531,15 @@ dfb_gfxcard_fillspans( int        y,
 
      D_DEBUG_AT( Core_GraphicsOps, "%s( %d, %p [%d], %p )\n", __FUNCTION__, y, spans, num, state );
 
+     operation.op   = GQO_FILLSPANS;
+     operation.data = spans;
+     operation.num  = num;
+     operation.y    = y;
+
+     /* Defer to the render thread. */
+     if (Genefx_Queue_Put( state, &operation ))
+          return;
+
      /* The state is locked during graphics operations. */
      dfb_state_lock( state );
 
@@ -2744,6 +2903,17 @@ dfb_gfxcard_blit( DFBRectangle *rect,
                   int           dy,
                   CardState    *state )
 {
+     GenefxQueueOperation operation = { 0 };
+
+     operation.op   = GQO_BLIT;
+     operation.data = rect;
+     operation.x    = dx;
+     operation.y    = dy;
+
+     /* Defer to the render thread. */
+     if (Genefx_Queue_Put( state, &operation ))
+          return;
+
      /* The state is locked during graphics operations. */
      dfb_state_lock( state );
      dfb_gfxcard_blit_locked( rect, dx, dy, state );
@@ -2801,6 +2971,7 @@ dfb_gfxcard_batchblit( DFBRectangle *rects,
      unsigned int i = 0;
 
      DFBSurfaceBlittingFlags blittingflags;
+     GenefxQueueOperation    operation = { 0 };
 
      D_ASSERT( card != NULL );
      D_ASSERT( card->shared != NULL );
@@ -2812,6 +2983,15 @@ dfb_gfxcard_batchblit( DFBRectangle *rects,
 
      D_DEBUG_AT( Core_GraphicsOps, "%s( %p, %p [%d], %p )\n", __FUNCTION__, rects, points, num, state );
 
+     operation.op    = GQO_BATCHBLIT;
+     operation.data  = rects;
+     operation.data2 = points;
+     operation.num   = num;
+
+     /* Defer to the render thread. */
+     if (Genefx_Queue_Put( state, &operation ))
+          return;
+
      blittingflags = state->blittingflags;
      dfb_simplify_blittingflags( &blittingflags );
 
@@ -2962,6 +3142,10 @@ dfb_gfxcard_batchblit( DFBRectangle *rects,
           }
           else {
                if (gAcquire( state, DFXL_BLIT )) {
+                    /* Glyphs of a string are composited line by line. */
+                    if (num - i > 1 && Genefx_BlitGlyphs( state, rects + i, points + i, num - i ))
+                         i = num;
+
                     for (; i < num; i++) {
                          DFBRectangle drect = { points[i].x, points[i].y, rects[i].w, rects[i].h };
 
@@ -3004,6 +3188,9 @@ dfb_gfxcard_batchblit2( DFBRectangle *rects,
 
      D_DEBUG_AT( Core_GraphicsOps, "%s( %p, %p, %p [%d], %p )\n", __FUNCTION__, rects, points, points2, num, state );
 
+     /* Not deferred to the render thread: it only runs with software_only, where Blit2 is never accelerated and Genefx
+        has no fallback, so nothing is drawn that could overtake pending operations. */
+
      /* The state is locked during graphics operations. */
      dfb_state_lock( state );
 
@@ -3074,6 +3261,7 @@ dfb_gfxcard_batchstretchblit( DFBRectangle *srects,
      bool need_clip, acquired = false;
 
      DFBSurfaceBlittingFlags blittingflags;
+     GenefxQueueOperation    operation = { 0 };
 
      D_ASSERT( card != NULL );
      D_ASSERT( card->shared != NULL );
@@ -3089,6 +3277,15 @@ dfb_gfxcard_batchstretchblit( DFBRectangle *srects,
           D_DEBUG_AT( Core_GraphicsOps, "  -> %4d,%4d-%4dx%4d -> %4d,%4d-%4dx%4d\n",
                       DFB_RECTANGLE_VALS( &srects[i] ), DFB_RECTANGLE_VALS( &drects[i] ) );
 
+     operation.op    = GQO_BATCHSTRETCHBLIT;
+     operation.data  = srects;
+     operation.data2 = drects;
+     operation.num   = num;
+
+     /* Defer to the render thread. */
+     if (Genefx_Queue_Put( state, &operation ))
+          return;
+
      blittingflags = state->blittingflags;
      dfb_simplify_blittingflags( &blittingflags );
 
@@ -3224,6 +3421,8 @@ dfb_gfxcard_tileblit( DFBRectangle *rect,
      DFBRectangle  srect;
      DFBRegion    *clip;
 
+     GenefxQueueOperation operation = { 0 };
+
      D_ASSERT( card != NULL );
      D_ASSERT( card->shared != NULL );
 
@@ -3234,6 +3433,17 @@ dfb_gfxcard_tileblit( DFBRectangle *rect,
 
      D_DEBUG_AT( Core_GraphicsOps, "%s( %4d,%4d-%4d,%4d, %p )\n", __FUNCTION__, dx1, dy1, dx2, dy2, state );
 
+     operation.op   = GQO_TILEBLIT;
+     operation.data = rect;
+     operation.x    = dx1;
+     operation.y    = dy1;
+     operation.x2   = dx2;
+     operation.y2   = dy2;
+
+     /* Defer to the render thread. */
+     if (Genefx_Queue_Put( state, &operation ))
+          return;
+
      /* The state is locked during graphics operations. */
      dfb_state_lock( state );
 
@@ -3373,6 +3583,10 @@ dfb_gfxcard_tileblit( DFBRectangle *rect,
           }
           else {
                if (gAcquire( state, DFXL_BLIT )) {
+                    /* Copy already blitted tiles within the destination if possible. */
+                    if (gTileBlit( state, rect, odx, dy1, dx2, dy2 ))
+                         dy1 = dy2;
+
                     for (; dy1 < dy2; dy1 += rect->h) {
                          for (; dx1 < dx2; dx1 += rect->w) {
                               if (!dfb_clip_blit_precheck( clip, rect->w, rect->h, dx1, dy1 ))
@@ -3406,6 +3620,8 @@ dfb_gfxcard_texture_triangles( DFBVertex            *vertices,
 {
      bool hw = false;
 
+     GenefxQueueOperation operation = { 0 };
+
      D_ASSERT( card != NULL );
      D_ASSERT( card->shared != NULL );
 
@@ -3418,6 +3634,15 @@ dfb_gfxcard_texture_triangles( DFBVertex            *vertices,
                  (formation == DTTF_STRIP) ? "STRIP" :
                  (formation == DTTF_FAN)   ? "FAN"   : "unknown formation", state );
 
+     operation.op        = GQO_TEXTURE_TRIANGLES;
+     operation.data      = vertices;
+     operation.num       = num;
+     operation.formation = formation;
+
+     /* Defer to the render thread. */
+     if (Genefx_Queue_Put( state, &operation ))
+          return;
+
      /* The state is locked during graphics operations. */
      dfb_state_lock( state );
 
@@ -3531,20 +3756,20 @@ dfb_gfxcard_drawstring( const u8                *text,
                         CoreGraphicsStateClient *client,
                         DFBSurfaceTextFlags      flags )
 {
-     DFBResult     ret;
-     unsigned int  prev = 0;
-     unsigned int  indices[bytes];
-     int           i, l, num;
-     int           kern_x;
-     int           kern_y;
-     CoreSurface  *surface;
-     CardState     state_backup;
-     DFBPoint      points[50];
-     DFBRectangle  rects[50];
-     int           num_blits = 0;
-     int           ox = x;
-     int           oy = y;
-     CardState    *state;
+     DFBResult      ret;
+     unsigned int   indices[bytes];
+     int            c, i, l, num;
+     CoreSurface   *surface;
+     CardState      state_backup;
+     DFBPoint       points[50];
+     DFBRectangle   rects[50];
+     CoreGlyphData *glyphs[D_ARRAY_SIZE(rects)];
+     DFBPoint       advances[D_ARRAY_SIZE(rects)];
+     int            num_blits = 0;
+     int            ox = x;
+     int            oy = y;
+     bool           runs;
+     CardState     *state;
 
      D_ASSERT( card != NULL );
      D_ASSERT( card->shared != NULL );
@@ -3582,60 +3807,83 @@ dfb_gfxcard_drawstring( const u8                *text,
      if (ret)
           return;
 
+     /* Not deferred to the render thread as a whole: glyphs are loaded and evicted here, each batch of blits goes
+        through dfb_gfxcard_batchblit() and is queued with the font cache surface locked and tagged, so that CPU writes
+        to it wait for the blits. */
+
+     /* Transparent pixels of a text run must leave the destination untouched. */
+     runs = !(flags & DSTF_BLEND_FUNCS) && !(state->drawingflags & DSDRAW_XOR);
+
      font_state_prepare( state, &state_backup, font, surface, !(flags & DSTF_BLEND_FUNCS) );
 
      dfb_font_lock( font );
 
      for (l = layers - 1; l >= 0; l--) {
+          CoreTextRun *run;
+
           x = ox << 8;
           y = oy << 8;
 
           if (layers > 1)
                dfb_state_set_color( state, &state->colors[l] );
 
-          /* Blit glyphs. */
-          for (i = 0; i < num; i++) {
-               DFBResult      ret;
-               CoreGlyphData *glyph;
-               unsigned int   current = indices[i];
+          /* Blit the whole string at once from the text run cache. */
+          if (runs && dfb_font_get_text_run( font, indices, num, l, &run ) == DFB_OK) {
+               if (run->surface) {
+                    DFBRectangle rect  = { 0, 0, run->width, run->height };
+                    DFBPoint     point = { ox + run->left, oy + run->top };
 
-               ret = dfb_font_get_glyph_data( font, current, l, &glyph );
-               if (ret) {
-                    D_DEBUG_AT( Core_GraphicsOps, "  -> glyph data loading from font failed!\n" );
-                    prev = current;
-                    continue;
-               }
+                    dfb_state_set_source( state, run->surface );
 
-               if (prev && font->GetKerning && font->GetKerning( font, prev, current, &kern_x, &kern_y) == DFB_OK) {
-                    x += kern_x << 8;
-                    y += kern_y << 8;
+                    CoreGraphicsStateClient_Blit( client, &rect, &point, 1 );
                }
 
-               if (glyph->width) {
-                    if (glyph->surface != state->source || num_blits == D_ARRAY_SIZE(rects)) {
-                         if (num_blits) {
-                              CoreGraphicsStateClient_Blit( client, rects, points, num_blits );
-                              num_blits = 0;
-                         }
+               continue;
+          }
 
-                         if (glyph->surface != state->source)
-                              dfb_state_set_source( state, glyph->surface );
+          /* Blit glyphs, loading no more of them at once than blits are queued, as loading may evict glyphs. */
+          for (c = 0; c < num; c += D_ARRAY_SIZE(rects)) {
+               int n = MIN( num - c, D_ARRAY_SIZE(rects) );
+
+               dfb_font_get_glyph_data_array( font, c ? indices[c - 1] : 0, indices + c, n, l, glyphs, advances );
+
+               for (i = 0; i < n; i++) {
+                    CoreGlyphData *glyph = glyphs[i];
+
+                    if (!glyph) {
+                         D_DEBUG_AT( Core_GraphicsOps, "  -> glyph data loading from font failed!\n" );
+                         continue;
                     }
 
-                    points[num_blits] = (DFBPoint) { (x >> 8) + glyph->left, (y >> 8) + glyph->top };
-                    rects[num_blits]  = (DFBRectangle) { glyph->start, 0, glyph->width, glyph->height };
+                    /* The advance includes the kerning with the previous glyph. */
+                    x += advances[i].x - glyph->xadvance;
+                    y += advances[i].y - glyph->yadvance;
 
-                    num_blits++;
-               }
+                    if (glyph->width) {
+                         if (glyph->surface != state->source) {
+                              if (num_blits) {
+                                   CoreGraphicsStateClient_Blit( client, rects, points, num_blits );
+                                   num_blits = 0;
+                              }
 
-               x   += glyph->xadvance;
-               y   += glyph->yadvance;
-               prev = current;
-          }
+                              dfb_state_set_source( state, glyph->surface );
+                         }
+
+                         points[num_blits] = (DFBPoint) { (x >> 8) + glyph->left, (y >> 8) + glyph->top };
+                         rects[num_blits]  = (DFBRectangle) { glyph->start, glyph->start_y,
+                                                              glyph->width, glyph->height };
+
+                         num_blits++;
+                    }
 
-          if (num_blits) {
-               CoreGraphicsStateClient_Blit( client, rects, points, num_blits );
-               num_blits = 0;
+                    x += glyph->xadvance;
+                    y += glyph->yadvance;
+               }
+
+               if (num_blits) {
+                    CoreGraphicsStateClient_Blit( client, rects, points, num_blits );
+                    num_blits = 0;
+               }
           }
      }
 
@@ -3673,6 +3921,8 @@ dfb_gfxcard_drawglyph( CoreGlyphData           **glyph,
 
      surface = state->destination;
 
+     /* Not deferred to the render thread as a whole, like dfb_gfxcard_drawstring() each blit is queued on its own. */
+
      font_state_prepare( state, &state_backup, font, surface, !(flags & DSTF_BLEND_FUNCS) );
 
      for (l = layers - 1; l >= 0; l--) {
@@ -3681,7 +3931,7 @@ dfb_gfxcard_drawglyph( CoreGlyphData           **glyph,
 
           /* Blit glyph. */
           if (glyph[l]->width) {
-               DFBRectangle rect  = { glyph[l]->start, 0, glyph[l]->width, glyph[l]->height };
+               DFBRectangle rect  = { glyph[l]->start, glyph[l]->start_y, glyph[l]->width, glyph[l]->height };
                DFBPoint     point = { x + glyph[l]->left, y + glyph[l]->top };
 
                dfb_state_set_source( state, glyph[l]->surface );
@@ -3754,6 +4004,8 @@ dfb_gfxcard_sync()
      if (!card)
           return DFB_OK;
 
+     Genefx_Queue_Sync();
+
      ret = dfb_gfxcard_lock( GDLF_SYNC );
      if (ret)
           return ret;
@@ -3771,9 +4023,14 @@ dfb_gfxcard_wait_serial( const CoreGraphicsSerial *serial )
 
      D_ASSERT( serial != NULL );
 
-     if (!card || dfb_config->software_only)
+     if (!card)
           return DFB_OK;
 
+     if (dfb_config->software_only) {
+          Genefx_Queue_Wait( serial );
+          return DFB_OK;
+     }
+
      D_ASSERT( card->shared != NULL );
 
      shared = card->shared;
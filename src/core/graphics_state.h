@@ -44,6 +44,52 @@ typedef struct {
 
 /**********************************************************************************************************************/
 
+/*
+ * Commands recorded by a state client for the remote object, executed at once by CoreGraphicsState_Execute().
+ */
+typedef enum {
+     CGSC_DRAWING_FLAGS,      /* DFBSurfaceDrawingFlags */
+     CGSC_BLITTING_FLAGS,     /* DFBSurfaceBlittingFlags */
+     CGSC_CLIP,               /* DFBRegion */
+     CGSC_COLOR,              /* DFBColor */
+     CGSC_COLOR_AND_INDEX,    /* DFBColor, index in 'param' */
+     CGSC_SRC_BLEND,          /* DFBSurfaceBlendFunction */
+     CGSC_DST_BLEND,          /* DFBSurfaceBlendFunction */
+     CGSC_SRC_COLORKEY,       /* u32 */
+     CGSC_DST_COLORKEY,       /* u32 */
+     CGSC_SOURCE_MASK_VALS,   /* DFBPoint, DFBSurfaceMaskFlags in 'param' */
+     CGSC_COLORKEY,           /* DFBColorKey */
+     CGSC_RENDER_OPTIONS,     /* DFBSurfaceRenderOptions */
+     CGSC_MATRIX,             /* s32[9] */
+     CGSC_FROM,               /* DFBSurfaceBufferRole, DFBSurfaceStereoEye in 'param' */
+     CGSC_TO,                 /* DFBSurfaceBufferRole, DFBSurfaceStereoEye in 'param' */
+     CGSC_SRC_CONVOLUTION,    /* DFBConvolutionFilter */
+     CGSC_SRC_COLORMATRIX,    /* s32[12] */
+     CGSC_RELEASE_SOURCE,     /* no arguments */
+
+     CGSC_FILL_RECTANGLES,    /* DFBRectangle[num] */
+     CGSC_DRAW_RECTANGLES,    /* DFBRectangle[num] */
+     CGSC_DRAW_LINES,         /* DFBRegion[num] */
+     CGSC_FILL_TRIANGLES,     /* DFBTriangle[num] */
+     CGSC_FILL_TRAPEZOIDS,    /* DFBTrapezoid[num] */
+     CGSC_FILL_QUADRANGLES,   /* DFBPoint[num * 4] */
+     CGSC_FILL_SPANS,         /* DFBSpan[num], y in 'param' */
+     CGSC_BLIT,               /* DFBRectangle[num], DFBPoint[num] */
+     CGSC_BLIT2,              /* DFBRectangle[num], DFBPoint[num], DFBPoint[num] */
+     CGSC_STRETCH_BLIT,       /* DFBRectangle[num], DFBRectangle[num] */
+     CGSC_TILE_BLIT,          /* DFBRectangle[num], DFBPoint[num], DFBPoint[num] */
+     CGSC_TEXTURE_TRIANGLES   /* DFBVertex[num], DFBTriangleFormation in 'param' */
+} CoreGraphicsStateCommandType;
+
+typedef struct {
+     u32 type;   /* CoreGraphicsStateCommandType */
+     u32 num;    /* number of primitives */
+     s32 param;  /* additional value */
+     u32 length; /* length of the arguments following, a multiple of four */
+} CoreGraphicsStateCommand;
+
+/**********************************************************************************************************************/
+
 /*
  * Creates a pool of graphics state objects.
  */
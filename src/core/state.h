@@ -40,6 +40,7 @@ typedef enum {
 
      CSF_SOURCE_LOCKED      = 0x00000010, /* source surface is locked */
      CSF_SOURCE_MASK_LOCKED = 0x00000020, /* source mask surface is locked */
+     CSF_BUFFERS_LOCKED     = 0x00000040, /* buffers are locked in advance by the render queue */
 
      CSF_SOURCE2            = 0x00000100, /* source2 is set using dfb_state_set_source2() */
      CSF_SOURCE2_LOCKED     = 0x00000200, /* source2 surface is locked */
@@ -47,7 +48,7 @@ typedef enum {
      CSF_DRAWING            = 0x00010000, /* something has been rendered with this state, this is cleared by flushing
                                              the state, e.g. upon flip */
 
-     CSF_ALL                = 0x0001033B  /* all of these */
+     CSF_ALL                = 0x0001037B  /* all of these */
 } CardStateFlags;
 
 typedef enum {
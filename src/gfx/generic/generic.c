@@ -24,8 +24,12 @@
 #include <gfx/convert.h>
 #include <gfx/generic/duffs_device.h>
 #include <gfx/generic/generic.h>
+#include <gfx/generic/generic_bands.h>
+#include <gfx/generic/generic_util.h>
 #include <gfx/util.h>
 
+D_DEBUG_DOMAIN( Genefx_Path, "Genefx/Path", "Genefx Pipeline Selection" );
+
 /**********************************************************************************************************************/
 
 /* lookup tables for 2/3bit to 8bit color conversion */
@@ -6705,12 +6709,42 @@ Bop_argb_blend_alphachannel_src_invsrc_Aop_argb8565( GenefxState *gfxs )
      }
 }
 
+static void
+Bop_argb_blend_alphachannel_src_invsrc_Aop_argb( GenefxState *gfxs )
+{
+     int  w     = gfxs->length + 1;
+     u32 *S     = gfxs->Bop[0];
+     u32 *D     = gfxs->Aop[0];
+     int  Sstep = gfxs->Bstep;
+     int  Dstep = gfxs->Astep;
+
+     while (--w) {
+          u32 s  = *S;
+          u32 sa = s >> 24;
+
+          /* Same rounding as blending the accumulators, each product is truncated separately. */
+          if (sa == 0xff)
+               *D = s;
+          else if (sa) {
+               u32 d      = *D;
+               u32 src    = sa + 1;
+               u32 invsrc = 0x100 - sa;
+
+               *D = ((((s & 0x00ff00ff) * src) >> 8) & 0x00ff00ff) + ((((d & 0x00ff00ff) * invsrc) >> 8) & 0x00ff00ff) +
+                    ((((s >> 8) & 0x00ff00ff) * src) & 0xff00ff00) + ((((d >> 8) & 0x00ff00ff) * invsrc) & 0xff00ff00);
+          }
+
+          S += Sstep;
+          D += Dstep;
+     }
+}
+
 static GenefxFunc Bop_argb_blend_alphachannel_src_invsrc_Aop_PFI[DFB_NUM_PIXELFORMATS] = {
      [DFB_PIXELFORMAT_INDEX(DSPF_ARGB1555)]   = NULL,
      [DFB_PIXELFORMAT_INDEX(DSPF_RGB16)]      = Bop_argb_blend_alphachannel_src_invsrc_Aop_rgb16,
      [DFB_PIXELFORMAT_INDEX(DSPF_RGB24)]      = NULL,
      [DFB_PIXELFORMAT_INDEX(DSPF_RGB32)]      = Bop_argb_blend_alphachannel_src_invsrc_Aop_rgb32,
-     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]       = Bop_argb_blend_alphachannel_src_invsrc_Aop_argb,
      [DFB_PIXELFORMAT_INDEX(DSPF_A8)]         = NULL,
      [DFB_PIXELFORMAT_INDEX(DSPF_YUY2)]       = NULL,
      [DFB_PIXELFORMAT_INDEX(DSPF_RGB332)]     = NULL,
@@ -6932,6 +6966,125 @@ static GenefxFunc Bop_argb_blend_alphachannel_one_invsrc_premultiply_Aop_PFI[DFB
      [DFB_PIXELFORMAT_INDEX(DSPF_BGR24)]      = NULL,
 };
 
+/**********************************************************************************************************************
+ ********************************* Bop_PFI_packed_Aop_32 **************************************************************
+ **********************************************************************************************************************/
+
+/*
+ * Modulate an ARGB or RGB32 source pixel, with each product truncated like in the accumulators.
+ */
+static inline u32
+packed_source( const GenefxPacked *P,
+               u32                 s )
+{
+     u32 a, r, g, b;
+
+     s |= P->src_or;
+
+     a = s >> 24;
+     r = (((s >> 16) & 0xff) * P->premultcolor) >> 8;
+     g = (((s >>  8) & 0xff) * P->premultcolor) >> 8;
+     b = (( s        & 0xff) * P->premultcolor) >> 8;
+
+     a = (a * P->modulate[3]) >> 8;
+     r = (r * P->modulate[2]) >> 8;
+     g = (g * P->modulate[1]) >> 8;
+     b = (b * P->modulate[0]) >> 8;
+
+     if (P->premultiply) {
+          r = (r * (a + 1)) >> 8;
+          g = (g * (a + 1)) >> 8;
+          b = (b * (a + 1)) >> 8;
+     }
+
+     return PIXEL_ARGB( a, r, g, b );
+}
+
+/*
+ * Blend a modulated source pixel over the destination pixel, saturating the sum like writing the accumulator.
+ */
+static inline u32
+packed_over( const GenefxPacked *P,
+             u32                 s,
+             u32                 d )
+{
+     u32 sa     = s >> 24;
+     u32 invsrc = 0x100 - sa;
+     u32 rb, ag;
+
+     if (P->src_blend == DSBF_SRCALPHA)
+          s = ((((s & 0x00ff00ff) * (sa + 1)) >> 8) & 0x00ff00ff) | ((((s >> 8) & 0x00ff00ff) * (sa + 1)) & 0xff00ff00);
+
+     rb = ( s       & 0x00ff00ff) + ((((d & 0x00ff00ff)      * invsrc) >> 8) & 0x00ff00ff);
+     ag = ((s >> 8) & 0x00ff00ff) + (((((d >> 8) & 0x00ff00ff) * invsrc) >> 8) & 0x00ff00ff);
+
+     rb |= ((rb >> 8) & 0x00010001) * 0xff;
+     ag |= ((ag >> 8) & 0x00010001) * 0xff;
+
+     return (rb & 0x00ff00ff) | ((ag & 0x00ff00ff) << 8);
+}
+
+static void
+Bop_32_packed_Aop_32_C( GenefxState *gfxs )
+{
+     int                 w     = gfxs->length + 1;
+     u32                *S     = gfxs->Bop[0];
+     u32                *D     = gfxs->Aop[0];
+     int                 Sstep = gfxs->Bstep;
+     int                 Dstep = gfxs->Astep;
+     const GenefxPacked *P     = &gfxs->Packed;
+
+     if (P->src_blend) {
+          while (--w) {
+               *D = packed_over( P, packed_source( P, *S ), *D ) | P->dst_or;
+
+               S += Sstep;
+               D += Dstep;
+          }
+     }
+     else {
+          while (--w) {
+               *D = packed_source( P, *S ) | P->dst_or;
+
+               S += Sstep;
+               D += Dstep;
+          }
+     }
+}
+
+static GenefxFunc Bop_32_packed_Aop_32 = Bop_32_packed_Aop_32_C;
+
+static void
+Bop_a8_packed_Aop_32_C( GenefxState *gfxs )
+{
+     int                 w     = gfxs->length + 1;
+     u8                 *S     = gfxs->Bop[0];
+     u32                *D     = gfxs->Aop[0];
+     int                 Sstep = gfxs->Bstep;
+     int                 Dstep = gfxs->Astep;
+     const GenefxPacked *P     = &gfxs->Packed;
+
+     /* The source is white with the alpha of the A8 pixel. */
+     if (P->src_blend) {
+          while (--w) {
+               *D = packed_over( P, packed_source( P, (*S << 24) | 0x00ffffff ), *D ) | P->dst_or;
+
+               S += Sstep;
+               D += Dstep;
+          }
+     }
+     else {
+          while (--w) {
+               *D = packed_source( P, (*S << 24) | 0x00ffffff ) | P->dst_or;
+
+               S += Sstep;
+               D += Dstep;
+          }
+     }
+}
+
+static GenefxFunc Bop_a8_packed_Aop_32 = Bop_a8_packed_Aop_32_C;
+
 /**********************************************************************************************************************
  ********************************* Bop_a8_set_alphapixel_Aop_PFI ******************************************************
  **********************************************************************************************************************/
@@ -9433,6 +9586,277 @@ static GenefxFunc Sacc_add_to_Dacc = Sacc_add_to_Dacc_C;
 
 /**********************************************************************************************************************/
 
+/*
+ * Mark source pixels with colors in the range of the extended source color key, or outside for DCKP_OTHER.
+ */
+static void
+Dacc_Skey_extended_C( GenefxState *gfxs )
+{
+     int                w     = gfxs->length + 1;
+     GenefxAccumulator *D     = gfxs->Dacc;
+     DFBColor           lower = gfxs->SkeyExtended.lower;
+     DFBColor           upper = gfxs->SkeyExtended.upper;
+     bool               other = gfxs->SkeyExtended.polarity == DCKP_OTHER;
+
+     while (--w) {
+          if (!(D->RGB.a & 0xf000)) {
+               bool in_range = D->RGB.r >= lower.r && D->RGB.r <= upper.r &&
+                               D->RGB.g >= lower.g && D->RGB.g <= upper.g &&
+                               D->RGB.b >= lower.b && D->RGB.b <= upper.b;
+
+               if (in_range != other)
+                    D->RGB.a = 0xf000;
+          }
+
+          ++D;
+     }
+}
+
+static GenefxFunc Dacc_Skey_extended = Dacc_Skey_extended_C;
+
+/**********************************************************************************************************************/
+
+/*
+ * Convert a 16.16 coefficient to the 20.12 fixed point of the filters, limited to keep the sums within 32 bit.
+ */
+static inline s32
+filter_coefficient( s64 value,
+                    s32 limit )
+{
+     value = (value + 8) >> 4;
+
+     return CLAMP( value, -limit, limit );
+}
+
+/* 20.12 fixed point sum to a color channel */
+static inline u16
+filter_channel( s32 sum )
+{
+     sum = (sum + 0x800) >> 12;
+
+     return CLAMP( sum, 0, 0xff );
+}
+
+/*
+ * Prepare the coefficients of the color matrix, returns true if they fit in 16 bit for the SIMD functions.
+ */
+static bool
+src_colormatrix_prepare( GenefxState *gfxs,
+                         const s32   *matrix )
+{
+     int  i;
+     bool fit = true;
+
+     for (i = 0; i < 12; i++) {
+          /* Offsets (every fourth value) are not multiplied. */
+          gfxs->SrcMatrix[i] = filter_coefficient( matrix[i], (i & 3) == 3 ? 0x400000 : 0x80000 );
+
+          if ((i & 3) != 3 && (gfxs->SrcMatrix[i] < -0x8000 || gfxs->SrcMatrix[i] > 0x7fff))
+               fit = false;
+     }
+
+     return fit;
+}
+
+/*
+ * Transform the colors with the source color matrix.
+ */
+static void
+Dacc_src_colormatrix_C( GenefxState *gfxs )
+{
+     int                w = gfxs->length + 1;
+     GenefxAccumulator *D = gfxs->Dacc;
+     const s32         *m = gfxs->SrcMatrix;
+
+     while (--w) {
+          if (!(D->RGB.a & 0xf000)) {
+               s32 r = D->RGB.r;
+               s32 g = D->RGB.g;
+               s32 b = D->RGB.b;
+
+               D->RGB.r = filter_channel( r * m[0] + g * m[1] + b * m[2]  + m[3]  );
+               D->RGB.g = filter_channel( r * m[4] + g * m[5] + b * m[6]  + m[7]  );
+               D->RGB.b = filter_channel( r * m[8] + g * m[9] + b * m[10] + m[11] );
+          }
+
+          ++D;
+     }
+}
+
+static GenefxFunc Dacc_src_colormatrix = Dacc_src_colormatrix_C;
+
+/*
+ * Prepare the convolution kernel with the scale applied, returns true if it fits in 16 bit for the SIMD functions.
+ */
+static bool
+src_convolution_prepare( GenefxState                *gfxs,
+                         const DFBConvolutionFilter *filter )
+{
+     int  i;
+     bool fit = true;
+
+     for (i = 0; i < 9; i++) {
+          gfxs->SrcKernel[i] = filter_coefficient( ((s64) filter->kernel[i] * filter->scale) >> 16, 0x80000 );
+
+          if (gfxs->SrcKernel[i] < -0x8000 || gfxs->SrcKernel[i] > 0x7fff)
+               fit = false;
+     }
+
+     gfxs->SrcBias = filter_coefficient( filter->bias, 0x400000 );
+
+     return fit;
+}
+
+/*
+ * Return the line y of the source, clamped to the surface, starting one pixel left of the span and ending one pixel
+ * right of it. Lines are read by the Kfuncs into the Kacc, replicating the edges of the surface, and kept while they
+ * are within the lines around 'center'.
+ */
+static const GenefxAccumulator *
+Kacc_line( GenefxState *gfxs,
+           int          y,
+           int          center )
+{
+     int                i;
+     int                x     = gfxs->BopX;
+     int                w     = gfxs->length;
+     int                x0    = MAX( x - 1, 0 ) & ~1;
+     int                x1    = MIN( x + w, gfxs->src_width - 1 );
+     int                n     = x1 - x0 + 1;
+     int                slot  = 0;
+     int                dist  = -1;
+     GenefxAccumulator *K;
+     void              *Bop[3];
+     int                BopY, Bop_field;
+     void             **Sop;
+     GenefxAccumulator *Dacc;
+     int                Ostep;
+
+     y = CLAMP( y, 0, gfxs->src_height - 1 );
+
+     /* Pairs of pixels are read as a whole, as chroma may be shared by them. */
+     if ((n & 1) && x0 + n < gfxs->src_width)
+          n++;
+
+     for (i = 0; i < 3; i++) {
+          int d = (gfxs->KaccY[i] < 0) ? gfxs->src_height : ABS( gfxs->KaccY[i] - center );
+
+          if (gfxs->KaccY[i] == y)
+               return gfxs->Kacc + i * gfxs->Ksize + x - x0;
+
+          if (d > dist) {
+               dist = d;
+               slot = i;
+          }
+     }
+
+     K = gfxs->Kacc + slot * gfxs->Ksize;
+
+     direct_memcpy( Bop, gfxs->Bop, sizeof(Bop) );
+
+     BopY      = gfxs->BopY;
+     Bop_field = gfxs->Bop_field;
+     Sop       = gfxs->Sop;
+     Dacc      = gfxs->Dacc;
+     Ostep     = gfxs->Ostep;
+
+     Genefx_Bop_xy( gfxs, x0, y );
+
+     gfxs->Sop    = gfxs->Bop;
+     gfxs->Ostep  = 1;
+     gfxs->Dacc   = K + 1;
+     gfxs->length = n;
+
+     for (i = 0; gfxs->Kfuncs[i]; i++)
+          gfxs->Kfuncs[i]( gfxs );
+
+     direct_memcpy( gfxs->Bop, Bop, sizeof(Bop) );
+
+     gfxs->BopX      = x;
+     gfxs->BopY      = BopY;
+     gfxs->Bop_field = Bop_field;
+     gfxs->Sop       = Sop;
+     gfxs->Dacc      = Dacc;
+     gfxs->Ostep     = Ostep;
+     gfxs->length    = w;
+
+     gfxs->KaccY[slot] = y;
+
+     /* Replicate the edges. */
+     if (x == 0)
+          K[0] = K[1];
+
+     if (x + w > x1)
+          K[x - x0 + w + 1] = K[x - x0 + w];
+
+     return K + x - x0;
+}
+
+/* convolution of the pixel at L[1][i + 1], L being the three lines of the source */
+static inline void
+convolve_pixel( const GenefxAccumulator **L,
+                int                       i,
+                const s32                *k,
+                s32                       bias,
+                GenefxAccumulator        *D )
+{
+     int j;
+     s32 b = bias, g = bias, r = bias, a = bias;
+
+     for (j = 0; j < 9; j++) {
+          const GenefxAccumulator *S = &L[j / 3][i + j % 3];
+
+          b += S->RGB.b * k[j];
+          g += S->RGB.g * k[j];
+          r += S->RGB.r * k[j];
+          a += S->RGB.a * k[j];
+     }
+
+     D->RGB.b = filter_channel( b );
+     D->RGB.g = filter_channel( g );
+     D->RGB.r = filter_channel( r );
+     D->RGB.a = filter_channel( a );
+}
+
+/*
+ * Filter the source with the convolution kernel. Pixels already marked by a source color key are left alone when
+ * keyed, otherwise the accumulators are written without being read.
+ */
+static inline void
+Dacc_convolve( GenefxState *gfxs,
+               bool         keyed )
+{
+     int                      i;
+     int                      w = gfxs->length;
+     GenefxAccumulator       *D = gfxs->Dacc;
+     const GenefxAccumulator *L[3];
+
+     for (i = 0; i < 3; i++)
+          L[i] = Kacc_line( gfxs, gfxs->BopY - 1 + i, gfxs->BopY );
+
+     for (i = 0; i < w; i++) {
+          if (!keyed || !(D[i].RGB.a & 0xf000))
+               convolve_pixel( L, i, gfxs->SrcKernel, gfxs->SrcBias, &D[i] );
+     }
+}
+
+static void
+Dacc_convolve_C( GenefxState *gfxs )
+{
+     Dacc_convolve( gfxs, false );
+}
+
+static void
+Dacc_convolve_keyed_C( GenefxState *gfxs )
+{
+     Dacc_convolve( gfxs, true );
+}
+
+static GenefxFunc Dacc_src_convolve       = Dacc_convolve_C;
+static GenefxFunc Dacc_src_convolve_keyed = Dacc_convolve_keyed_C;
+
+/**********************************************************************************************************************/
+
 /* change the last value to adjust the size of the device (1-4) */
 #define SET_PIXEL_DUFFS_DEVICE(D,S,w) \
      SET_PIXEL_DUFFS_DEVICE_N( D, S, w, 3 )
@@ -9714,70 +10138,1166 @@ Bop_rgb32_to_Aop_rgb16_LE( GenefxState *gfxs )
 
 /**********************************************************************************************************************/
 
-static int use_mmx = 0;
-
-#ifdef USE_MMX
-
-#include "generic_mmx.h"
-
 /*
- * patches function pointers to MMX functions
+ * Opaque RGB32 to ARGB conversion and vice versa.
  */
 static void
-gInit_MMX()
+Bop_rgb32_to_Aop_argb( GenefxState *gfxs )
 {
-     use_mmx = 1;
+     int  w = gfxs->length + 1;
+     u32 *S = gfxs->Bop[0];
+     u32 *D = gfxs->Aop[0];
 
-/********************************* Xacc_blend *********************************/
-     Xacc_blend[DSBF_SRCALPHA-1]    = Xacc_blend_srcalpha_MMX;
-     Xacc_blend[DSBF_INVSRCALPHA-1] = Xacc_blend_invsrcalpha_MMX;
-/********************************* Dacc_modulation ****************************/
-     Dacc_modulation[DSBLIT_BLEND_ALPHACHANNEL | DSBLIT_BLEND_COLORALPHA | DSBLIT_COLORIZE] = Dacc_modulate_argb_MMX;
-/********************************* Misc accumulator operations ****************/
-     SCacc_add_to_Dacc = SCacc_add_to_Dacc_MMX;
-     Sacc_add_to_Dacc  = Sacc_add_to_Dacc_MMX;
+     while (--w)
+          *D++ = *S++ | 0xff000000;
 }
 
-#endif
-
-#if SIZEOF_LONG == 8
-
-#include "generic_64.h"
-
 /*
- * patches function pointers to 64 bits functions
+ * RGB16 to ARGB / RGB32 conversion.
  */
 static void
-gInit_64bit()
+Bop_rgb16_to_Aop_argb( GenefxState *gfxs )
 {
-/********************************* Cop_to_Aop_PFI ********************************/
-     Cop_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Cop_to_Aop_32_64;
-     Cop_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Cop_to_Aop_32_64;
-     Cop_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_AiRGB)] = Cop_to_Aop_32_64;
-/********************************* Bop_PFI_toK_Aop_PFI ***************************/
-     Bop_PFI_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Bop_rgb32_toK_Aop_64;
-     Bop_PFI_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Bop_rgb32_toK_Aop_64;
-     Bop_PFI_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_AiRGB)] = Bop_rgb32_toK_Aop_64;
-/********************************* Bop_PFI_Kto_Aop_PFI ***************************/
-     Bop_PFI_Kto_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Bop_rgb32_Kto_Aop_64;
-     Bop_PFI_Kto_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Bop_rgb32_Kto_Aop_64;
-     Bop_PFI_Kto_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_AiRGB)] = Bop_rgb32_Kto_Aop_64;
-/********************************* Bop_PFI_Sto_Aop_PFI ***************************/
-     Bop_PFI_Sto_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Bop_32_Sto_Aop_64;
-     Bop_PFI_Sto_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Bop_32_Sto_Aop_64;
-     Bop_PFI_Sto_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_AiRGB)] = Bop_32_Sto_Aop_64;
-/********************************* Misc accumulator operations *******************/
-     Dacc_xor = Dacc_xor_64;
-}
+     int  w = gfxs->length + 1;
+     u16 *S = gfxs->Bop[0];
+     u32 *D = gfxs->Aop[0];
 
-#endif
+     while (--w) {
+          u16 s = *S++;
 
-#ifdef WORDS_BIGENDIAN
+          *D++ = PIXEL_ARGB( 0xff,
+                             EXPAND_5to8( (s & 0xf800) >> 11 ),
+                             EXPAND_6to8( (s & 0x07e0) >>  5 ),
+                             EXPAND_5to8(  s & 0x001f        ) );
+     }
+}
 
-/*
- * patches function pointers to big endian functions
- */
-static void
+static GenefxFunc Bop_rgb16_to_Aop_PFI[DFB_NUM_PIXELFORMATS] = {
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB1555)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB16)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB24)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB32)]      = Bop_rgb16_to_Aop_argb,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]       = Bop_rgb16_to_Aop_argb,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A8)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YUY2)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB332)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_UYVY)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_I420)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV12)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT8)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ALUT44)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AiRGB)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A1)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV12)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV16)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB2554)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB4444)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBA4444)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV21)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AYUV)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A4)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB1666)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB6666)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB18)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT2)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB444)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB555)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_BGR555)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBA5551)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_Y444)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB8565)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AVYU)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_VYU)]        = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A1_LSB)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV16)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ABGR)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBAF88871)] = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT1)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV61)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_Y42B)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV24)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV24)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV42)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_BGR24)]      = NULL,
+};
+
+static GenefxFunc Bop_rgb24_to_Aop_PFI[DFB_NUM_PIXELFORMATS] = {
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB1555)]   = NULL,
+#ifndef WORDS_BIGENDIAN
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB16)]      = Bop_rgb24_to_Aop_rgb16_LE,
+#else
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB16)]      = NULL,
+#endif
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB24)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB32)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A8)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YUY2)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB332)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_UYVY)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_I420)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV12)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT8)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ALUT44)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AiRGB)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A1)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV12)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV16)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB2554)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB4444)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBA4444)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV21)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AYUV)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A4)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB1666)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB6666)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB18)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT2)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB444)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB555)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_BGR555)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBA5551)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_Y444)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB8565)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AVYU)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_VYU)]        = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A1_LSB)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV16)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ABGR)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBAF88871)] = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT1)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV61)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_Y42B)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV24)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV24)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV42)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_BGR24)]      = NULL,
+};
+
+static GenefxFunc Bop_rgb32_to_Aop_PFI[DFB_NUM_PIXELFORMATS] = {
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB1555)]   = NULL,
+#ifndef WORDS_BIGENDIAN
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB16)]      = Bop_rgb32_to_Aop_rgb16_LE,
+#else
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB16)]      = NULL,
+#endif
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB24)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB32)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]       = Bop_rgb32_to_Aop_argb,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A8)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YUY2)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB332)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_UYVY)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_I420)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV12)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT8)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ALUT44)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AiRGB)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A1)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV12)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV16)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB2554)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB4444)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBA4444)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV21)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AYUV)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A4)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB1666)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB6666)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB18)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT2)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB444)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB555)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_BGR555)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBA5551)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_Y444)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB8565)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AVYU)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_VYU)]        = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A1_LSB)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV16)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ABGR)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBAF88871)] = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT1)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV61)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_Y42B)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV24)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV24)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV42)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_BGR24)]      = NULL,
+};
+
+static GenefxFunc Bop_argb_to_Aop_PFI[DFB_NUM_PIXELFORMATS] = {
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB1555)]   = NULL,
+#ifndef WORDS_BIGENDIAN
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB16)]      = Bop_rgb32_to_Aop_rgb16_LE,
+#else
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB16)]      = NULL,
+#endif
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB24)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB32)]      = Bop_rgb32_to_Aop_argb,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A8)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YUY2)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB332)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_UYVY)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_I420)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV12)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT8)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ALUT44)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AiRGB)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A1)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV12)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV16)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB2554)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB4444)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBA4444)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV21)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AYUV)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A4)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB1666)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB6666)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB18)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT2)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB444)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB555)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_BGR555)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBA5551)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_Y444)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB8565)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AVYU)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_VYU)]        = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A1_LSB)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV16)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ABGR)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBAF88871)] = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT1)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV61)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_Y42B)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV24)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV24)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV42)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_BGR24)]      = NULL,
+};
+
+/**********************************************************************************************************************/
+
+/*
+ * YCbCr to RGB conversion of video formats, see YCBCR_TO_RGB_BT601() and friends.
+ */
+
+static const GenefxYCbCrToRGB ycbcr_to_rgb_bt601  = { 409, -100, -208, 516 };
+static const GenefxYCbCrToRGB ycbcr_to_rgb_bt709  = { 459,  -55, -136, 541 };
+static const GenefxYCbCrToRGB ycbcr_to_rgb_bt2020 = { 430,  -48, -167, 548 };
+
+static const GenefxYCbCrToRGB *
+ycbcr_to_rgb( DFBSurfaceColorSpace colorspace )
+{
+     switch (colorspace) {
+          case DSCS_BT601:
+               return &ycbcr_to_rgb_bt601;
+          case DSCS_BT709:
+               return &ycbcr_to_rgb_bt709;
+          case DSCS_BT2020:
+               return &ycbcr_to_rgb_bt2020;
+          default:
+               return NULL;
+     }
+}
+
+#define YCBCR_TO_RGB(m,y,cb,cr,r,g,b)                                    \
+do {                                                                     \
+     int _y  = (y)  -  16;                                               \
+     int _cb = (cb) - 128;                                               \
+     int _cr = (cr) - 128;                                               \
+                                                                         \
+     int _r = (298 * _y                   + (m)->cr_r * _cr + 128) >> 8; \
+     int _g = (298 * _y + (m)->cb_g * _cb + (m)->cr_g * _cr + 128) >> 8; \
+     int _b = (298 * _y + (m)->cb_b * _cb                   + 128) >> 8; \
+                                                                         \
+     (r) = CLAMP( _r, 0, 255 );                                          \
+     (g) = CLAMP( _g, 0, 255 );                                          \
+     (b) = CLAMP( _b, 0, 255 );                                          \
+} while (0)
+
+/*
+ * The span functions convert planar Y, Cb and Cr samples. Each chroma sample is used for two pixels if subsampled,
+ * otherwise there's one per pixel.
+ */
+typedef void (*GenefxYCbCrSpanFunc)( const u8 *Y, const u8 *U, const u8 *V, bool subsampled,
+                                     void *D, int w, const GenefxYCbCrToRGB *m );
+
+static void
+YCbCr_span_to_argb_C( const u8               *Y,
+                      const u8               *U,
+                      const u8               *V,
+                      bool                    subsampled,
+                      void                   *D,
+                      int                     w,
+                      const GenefxYCbCrToRGB *m )
+{
+     int  i;
+     u32 *D32   = D;
+     int  shift = subsampled ? 1 : 0;
+
+     for (i = 0; i < w; i++) {
+          int r, g, b;
+
+          YCBCR_TO_RGB( m, Y[i], U[i>>shift], V[i>>shift], r, g, b );
+
+          D32[i] = PIXEL_ARGB( 0xff, r, g, b );
+     }
+}
+
+static void
+YCbCr_span_to_rgb16_C( const u8               *Y,
+                       const u8               *U,
+                       const u8               *V,
+                       bool                    subsampled,
+                       void                   *D,
+                       int                     w,
+                       const GenefxYCbCrToRGB *m )
+{
+     int  i;
+     u16 *D16   = D;
+     int  shift = subsampled ? 1 : 0;
+
+     for (i = 0; i < w; i++) {
+          int r, g, b;
+
+          YCBCR_TO_RGB( m, Y[i], U[i>>shift], V[i>>shift], r, g, b );
+
+          D16[i] = PIXEL_RGB16( r, g, b );
+     }
+}
+
+static GenefxYCbCrSpanFunc YCbCr_span_to_argb  = YCbCr_span_to_argb_C;
+static GenefxYCbCrSpanFunc YCbCr_span_to_rgb16 = YCbCr_span_to_rgb16_C;
+
+/* number of pixels deinterleaved or sampled at once, must be even */
+#define YCBCR_CHUNK 256
+
+/*
+ * Unscaled I420 / YV12, NV12 and YUY2 to ARGB / RGB32 / RGB16 conversion.
+ */
+static inline void
+Bop_ycbcr_to_Aop( GenefxState           *gfxs,
+                  DFBSurfacePixelFormat  format,
+                  GenefxYCbCrSpanFunc    span,
+                  int                    dst_bpp )
+{
+     int                     w = gfxs->length;
+     u8                     *D = gfxs->Aop[0];
+     const GenefxYCbCrToRGB *m = gfxs->YCbCr;
+
+     switch (format) {
+          case DSPF_I420:
+               span( gfxs->Bop[0], gfxs->Bop[1], gfxs->Bop[2], true, D, w, m );
+               break;
+
+          case DSPF_NV12: {
+               u8 *Sy  = gfxs->Bop[0];
+               u8 *Suv = gfxs->Bop[1];
+               u8  U[YCBCR_CHUNK/2];
+               u8  V[YCBCR_CHUNK/2];
+
+               while (w) {
+                    int i, n = MIN( w, YCBCR_CHUNK );
+
+                    for (i = 0; i < (n + 1) / 2; i++) {
+                         U[i] = Suv[i*2];
+                         V[i] = Suv[i*2+1];
+                    }
+
+                    span( Sy, U, V, true, D, n, m );
+
+                    Sy  += n;
+                    Suv += n;
+                    D   += n * dst_bpp;
+                    w   -= n;
+               }
+               break;
+          }
+
+          case DSPF_YUY2: {
+               u8 *S = gfxs->Bop[0];
+               u8  Y[YCBCR_CHUNK];
+               u8  U[YCBCR_CHUNK/2];
+               u8  V[YCBCR_CHUNK/2];
+
+               while (w) {
+                    int i, n = MIN( w, YCBCR_CHUNK );
+
+                    for (i = 0; i < n / 2; i++) {
+                         Y[i*2]   = S[i*4];
+                         U[i]     = S[i*4+1];
+                         Y[i*2+1] = S[i*4+2];
+                         V[i]     = S[i*4+3];
+                    }
+
+                    /* Like Sop_yuy2_to_Dacc(), a trailing half macro pixel has no Cr. */
+                    if (n & 1) {
+                         Y[n-1] = S[i*4];
+                         U[i]   = S[i*4+1];
+                         V[i]   = 0x00;
+                    }
+
+                    span( Y, U, V, true, D, n, m );
+
+                    S += n * 2;
+                    D += n * dst_bpp;
+                    w -= n;
+               }
+               break;
+          }
+
+          default:
+               D_BUG( "unexpected format" );
+     }
+}
+
+/*
+ * Scaled I420 / YV12, NV12 and YUY2 to ARGB / RGB32 / RGB16 conversion, sampling like Sacc_Sto_Aop_PFI().
+ */
+static inline void
+Bop_ycbcr_Sto_Aop( GenefxState           *gfxs,
+                   DFBSurfacePixelFormat  format,
+                   GenefxYCbCrSpanFunc    span,
+                   int                    dst_bpp )
+{
+     int                     i     = gfxs->Xphase;
+     int                     w     = gfxs->length;
+     int                     SperD = gfxs->SperD;
+     int                     Slen  = gfxs->Slen;
+     u8                     *D     = gfxs->Aop[0];
+     u8                     *S0    = gfxs->Bop[0];
+     u8                     *S1    = gfxs->Bop[1];
+     u8                     *S2    = gfxs->Bop[2];
+     const GenefxYCbCrToRGB *m     = gfxs->YCbCr;
+     u8                      Y[YCBCR_CHUNK];
+     u8                      U[YCBCR_CHUNK];
+     u8                      V[YCBCR_CHUNK];
+
+     while (w) {
+          int k, n = MIN( w, YCBCR_CHUNK );
+
+          for (k = 0; k < n; k++) {
+               int j = i >> 16;
+
+               switch (format) {
+                    case DSPF_I420:
+                         Y[k] = S0[j];
+                         U[k] = S1[j>>1];
+                         V[k] = S2[j>>1];
+                         break;
+
+                    case DSPF_NV12:
+                         Y[k] = S0[j];
+                         U[k] = S1[j&~1];
+                         V[k] = S1[j|1];
+                         break;
+
+                    case DSPF_YUY2:
+                         Y[k] = S0[j*2];
+                         U[k] = S0[(j&~1)*2+1];
+                         V[k] = (j|1) < Slen ? S0[(j&~1)*2+3] : 0x00;
+                         break;
+
+                    default:
+                         D_BUG( "unexpected format" );
+               }
+
+               i += SperD;
+          }
+
+          span( Y, U, V, false, D, n, m );
+
+          D += n * dst_bpp;
+          w -= n;
+     }
+}
+
+static void Bop_i420_to_Aop_argb  ( GenefxState *gfxs ) { Bop_ycbcr_to_Aop ( gfxs, DSPF_I420, YCbCr_span_to_argb,  4 ); }
+static void Bop_i420_to_Aop_rgb16 ( GenefxState *gfxs ) { Bop_ycbcr_to_Aop ( gfxs, DSPF_I420, YCbCr_span_to_rgb16, 2 ); }
+static void Bop_i420_Sto_Aop_argb ( GenefxState *gfxs ) { Bop_ycbcr_Sto_Aop( gfxs, DSPF_I420, YCbCr_span_to_argb,  4 ); }
+static void Bop_i420_Sto_Aop_rgb16( GenefxState *gfxs ) { Bop_ycbcr_Sto_Aop( gfxs, DSPF_I420, YCbCr_span_to_rgb16, 2 ); }
+static void Bop_nv12_to_Aop_argb  ( GenefxState *gfxs ) { Bop_ycbcr_to_Aop ( gfxs, DSPF_NV12, YCbCr_span_to_argb,  4 ); }
+static void Bop_nv12_to_Aop_rgb16 ( GenefxState *gfxs ) { Bop_ycbcr_to_Aop ( gfxs, DSPF_NV12, YCbCr_span_to_rgb16, 2 ); }
+static void Bop_nv12_Sto_Aop_argb ( GenefxState *gfxs ) { Bop_ycbcr_Sto_Aop( gfxs, DSPF_NV12, YCbCr_span_to_argb,  4 ); }
+static void Bop_nv12_Sto_Aop_rgb16( GenefxState *gfxs ) { Bop_ycbcr_Sto_Aop( gfxs, DSPF_NV12, YCbCr_span_to_rgb16, 2 ); }
+static void Bop_yuy2_to_Aop_argb  ( GenefxState *gfxs ) { Bop_ycbcr_to_Aop ( gfxs, DSPF_YUY2, YCbCr_span_to_argb,  4 ); }
+static void Bop_yuy2_to_Aop_rgb16 ( GenefxState *gfxs ) { Bop_ycbcr_to_Aop ( gfxs, DSPF_YUY2, YCbCr_span_to_rgb16, 2 ); }
+static void Bop_yuy2_Sto_Aop_argb ( GenefxState *gfxs ) { Bop_ycbcr_Sto_Aop( gfxs, DSPF_YUY2, YCbCr_span_to_argb,  4 ); }
+static void Bop_yuy2_Sto_Aop_rgb16( GenefxState *gfxs ) { Bop_ycbcr_Sto_Aop( gfxs, DSPF_YUY2, YCbCr_span_to_rgb16, 2 ); }
+
+static GenefxFunc Bop_i420_to_Aop_PFI[DFB_NUM_PIXELFORMATS] = {
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB1555)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB16)]      = Bop_i420_to_Aop_rgb16,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB24)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB32)]      = Bop_i420_to_Aop_argb,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]       = Bop_i420_to_Aop_argb,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A8)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YUY2)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB332)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_UYVY)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_I420)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV12)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT8)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ALUT44)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AiRGB)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A1)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV12)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV16)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB2554)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB4444)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBA4444)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV21)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AYUV)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A4)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB1666)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB6666)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB18)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT2)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB444)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB555)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_BGR555)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBA5551)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_Y444)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB8565)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AVYU)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_VYU)]        = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A1_LSB)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV16)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ABGR)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBAF88871)] = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT1)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV61)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_Y42B)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV24)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV24)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV42)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_BGR24)]      = NULL,
+};
+
+static GenefxFunc Bop_i420_Sto_Aop_PFI[DFB_NUM_PIXELFORMATS] = {
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB1555)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB16)]      = Bop_i420_Sto_Aop_rgb16,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB24)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB32)]      = Bop_i420_Sto_Aop_argb,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]       = Bop_i420_Sto_Aop_argb,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A8)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YUY2)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB332)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_UYVY)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_I420)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV12)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT8)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ALUT44)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AiRGB)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A1)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV12)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV16)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB2554)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB4444)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBA4444)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV21)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AYUV)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A4)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB1666)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB6666)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB18)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT2)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB444)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB555)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_BGR555)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBA5551)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_Y444)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB8565)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AVYU)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_VYU)]        = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A1_LSB)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV16)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ABGR)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBAF88871)] = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT1)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV61)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_Y42B)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV24)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV24)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV42)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_BGR24)]      = NULL,
+};
+
+static GenefxFunc Bop_nv12_to_Aop_PFI[DFB_NUM_PIXELFORMATS] = {
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB1555)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB16)]      = Bop_nv12_to_Aop_rgb16,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB24)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB32)]      = Bop_nv12_to_Aop_argb,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]       = Bop_nv12_to_Aop_argb,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A8)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YUY2)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB332)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_UYVY)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_I420)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV12)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT8)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ALUT44)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AiRGB)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A1)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV12)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV16)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB2554)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB4444)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBA4444)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV21)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AYUV)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A4)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB1666)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB6666)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB18)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT2)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB444)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB555)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_BGR555)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBA5551)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_Y444)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB8565)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AVYU)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_VYU)]        = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A1_LSB)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV16)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ABGR)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBAF88871)] = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT1)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV61)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_Y42B)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV24)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV24)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV42)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_BGR24)]      = NULL,
+};
+
+static GenefxFunc Bop_nv12_Sto_Aop_PFI[DFB_NUM_PIXELFORMATS] = {
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB1555)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB16)]      = Bop_nv12_Sto_Aop_rgb16,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB24)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB32)]      = Bop_nv12_Sto_Aop_argb,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]       = Bop_nv12_Sto_Aop_argb,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A8)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YUY2)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB332)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_UYVY)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_I420)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV12)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT8)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ALUT44)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AiRGB)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A1)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV12)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV16)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB2554)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB4444)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBA4444)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV21)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AYUV)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A4)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB1666)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB6666)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB18)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT2)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB444)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB555)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_BGR555)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBA5551)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_Y444)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB8565)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AVYU)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_VYU)]        = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A1_LSB)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV16)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ABGR)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBAF88871)] = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT1)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV61)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_Y42B)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV24)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV24)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV42)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_BGR24)]      = NULL,
+};
+
+static GenefxFunc Bop_yuy2_to_Aop_PFI[DFB_NUM_PIXELFORMATS] = {
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB1555)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB16)]      = Bop_yuy2_to_Aop_rgb16,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB24)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB32)]      = Bop_yuy2_to_Aop_argb,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]       = Bop_yuy2_to_Aop_argb,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A8)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YUY2)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB332)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_UYVY)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_I420)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV12)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT8)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ALUT44)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AiRGB)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A1)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV12)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV16)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB2554)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB4444)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBA4444)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV21)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AYUV)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A4)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB1666)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB6666)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB18)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT2)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB444)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB555)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_BGR555)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBA5551)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_Y444)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB8565)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AVYU)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_VYU)]        = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A1_LSB)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV16)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ABGR)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBAF88871)] = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT1)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV61)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_Y42B)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV24)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV24)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV42)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_BGR24)]      = NULL,
+};
+
+static GenefxFunc Bop_yuy2_Sto_Aop_PFI[DFB_NUM_PIXELFORMATS] = {
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB1555)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB16)]      = Bop_yuy2_Sto_Aop_rgb16,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB24)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB32)]      = Bop_yuy2_Sto_Aop_argb,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]       = Bop_yuy2_Sto_Aop_argb,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A8)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YUY2)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB332)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_UYVY)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_I420)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV12)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT8)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ALUT44)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AiRGB)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A1)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV12)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV16)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB2554)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB4444)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBA4444)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV21)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AYUV)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A4)]         = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB1666)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB6666)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB18)]      = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT2)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB444)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGB555)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_BGR555)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBA5551)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_Y444)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ARGB8565)]   = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_AVYU)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_VYU)]        = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_A1_LSB)]     = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV16)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_ABGR)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_RGBAF88871)] = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_LUT1)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV61)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_Y42B)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_YV24)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV24)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_NV42)]       = NULL,
+     [DFB_PIXELFORMAT_INDEX(DSPF_BGR24)]      = NULL,
+};
+
+/**********************************************************************************************************************/
+
+/*
+ * Fused blits doing the whole operation in one pass over the span, without the accumulators.
+ */
+typedef struct {
+     DFBSurfacePixelFormat    src_format;
+     DFBSurfaceBlittingFlags  flags;          /* simplified blitting flags */
+     DFBSurfaceBlendFunction  src_blend;      /* only checked if blending */
+     DFBSurfaceBlendFunction  dst_blend;      /* only checked if blending */
+     GenefxFunc              *Aop_PFI;        /* per destination format, NULL if not supported */
+     GenefxFunc              *Sto_Aop_PFI;    /* same for scaled blits, NULL if none is supported */
+     const char              *name;
+} GenefxFusedBlit;
+
+static const GenefxFusedBlit fused_blits[] = {
+     { DSPF_ARGB,   DSBLIT_BLEND_ALPHACHANNEL,
+       DSBF_SRCALPHA, DSBF_INVSRCALPHA, Bop_argb_blend_alphachannel_src_invsrc_Aop_PFI, NULL,
+       "argb_blend_alphachannel_src_invsrc" },
+     { DSPF_ARGB,   DSBLIT_BLEND_ALPHACHANNEL,
+       DSBF_ONE, DSBF_INVSRCALPHA, Bop_argb_blend_alphachannel_one_invsrc_Aop_PFI, NULL,
+       "argb_blend_alphachannel_one_invsrc" },
+     { DSPF_ARGB,   DSBLIT_BLEND_ALPHACHANNEL | DSBLIT_SRC_PREMULTIPLY,
+       DSBF_ONE, DSBF_INVSRCALPHA, Bop_argb_blend_alphachannel_one_invsrc_premultiply_Aop_PFI, NULL,
+       "argb_blend_alphachannel_one_invsrc_premultiply" },
+     { DSPF_A8,     DSBLIT_COLORIZE | DSBLIT_BLEND_ALPHACHANNEL | DSBLIT_SRC_PREMULTIPLY,
+       DSBF_ONE, DSBF_INVSRCALPHA, Bop_a8_set_alphapixel_Aop_PFI, NULL,
+       "a8_set_alphapixel" },
+     { DSPF_A8,     DSBLIT_COLORIZE | DSBLIT_BLEND_ALPHACHANNEL,
+       DSBF_SRCALPHA, DSBF_INVSRCALPHA, Bop_a8_set_alphapixel_Aop_PFI, NULL,
+       "a8_set_alphapixel" },
+     { DSPF_A1,     DSBLIT_COLORIZE | DSBLIT_BLEND_ALPHACHANNEL | DSBLIT_SRC_PREMULTIPLY,
+       DSBF_ONE, DSBF_INVSRCALPHA, Bop_a1_set_alphapixel_Aop_PFI, NULL,
+       "a1_set_alphapixel" },
+     { DSPF_A1,     DSBLIT_COLORIZE | DSBLIT_BLEND_ALPHACHANNEL,
+       DSBF_SRCALPHA, DSBF_INVSRCALPHA, Bop_a1_set_alphapixel_Aop_PFI, NULL,
+       "a1_set_alphapixel" },
+     { DSPF_A1_LSB, DSBLIT_COLORIZE | DSBLIT_BLEND_ALPHACHANNEL | DSBLIT_SRC_PREMULTIPLY,
+       DSBF_ONE, DSBF_INVSRCALPHA, Bop_a1_lsb_set_alphapixel_Aop_PFI, NULL,
+       "a1_lsb_set_alphapixel" },
+     { DSPF_A1_LSB, DSBLIT_COLORIZE | DSBLIT_BLEND_ALPHACHANNEL,
+       DSBF_SRCALPHA, DSBF_INVSRCALPHA, Bop_a1_lsb_set_alphapixel_Aop_PFI, NULL,
+       "a1_lsb_set_alphapixel" },
+     { DSPF_RGB16,  DSBLIT_NOFX, 0, 0, Bop_rgb16_to_Aop_PFI, NULL,                 "rgb16_to" },
+     { DSPF_RGB24,  DSBLIT_NOFX, 0, 0, Bop_rgb24_to_Aop_PFI, NULL,                 "rgb24_to" },
+     { DSPF_RGB32,  DSBLIT_NOFX, 0, 0, Bop_rgb32_to_Aop_PFI, NULL,                 "rgb32_to" },
+     { DSPF_ARGB,   DSBLIT_NOFX, 0, 0, Bop_argb_to_Aop_PFI,  NULL,                 "argb_to" },
+     { DSPF_I420,   DSBLIT_NOFX, 0, 0, Bop_i420_to_Aop_PFI,  Bop_i420_Sto_Aop_PFI, "i420_to" },
+     { DSPF_YV12,   DSBLIT_NOFX, 0, 0, Bop_i420_to_Aop_PFI,  Bop_i420_Sto_Aop_PFI, "yv12_to" },
+     { DSPF_NV12,   DSBLIT_NOFX, 0, 0, Bop_nv12_to_Aop_PFI,  Bop_nv12_Sto_Aop_PFI, "nv12_to" },
+     { DSPF_YUY2,   DSBLIT_NOFX, 0, 0, Bop_yuy2_to_Aop_PFI,  Bop_yuy2_Sto_Aop_PFI, "yuy2_to" },
+};
+
+/*
+ * Look up a fused blit for the source and destination format, the blitting flags and the blend functions.
+ * YCbCr sources also need a known colorspace.
+ */
+static const GenefxFusedBlit *
+gAcquireFusedBlit( CardState               *state,
+                   DFBAccelerationMask      accel,
+                   DFBSurfaceBlittingFlags  flags,
+                   int                      dst_pfi )
+{
+     int          i;
+     CoreSurface *source = state->source;
+
+     if (is_ycbcr[DFB_PIXELFORMAT_INDEX(source->config.format)] && !ycbcr_to_rgb( source->config.colorspace ))
+          return NULL;
+
+     for (i = 0; i < D_ARRAY_SIZE( fused_blits ); i++) {
+          const GenefxFusedBlit *fused   = &fused_blits[i];
+          GenefxFunc            *Aop_PFI = (accel == DFXL_STRETCHBLIT) ? fused->Sto_Aop_PFI : fused->Aop_PFI;
+
+          if (fused->src_format != source->config.format || fused->flags != flags || !Aop_PFI)
+               continue;
+
+          if (flags & (DSBLIT_BLEND_ALPHACHANNEL | DSBLIT_BLEND_COLORALPHA) &&
+              (fused->src_blend != state->src_blend || fused->dst_blend != state->dst_blend))
+               continue;
+
+          if (Aop_PFI[dst_pfi])
+               return fused;
+     }
+
+     return NULL;
+}
+
+/*
+ * Prepare modulating an ARGB, RGB32 or A8 source and blending it over an ARGB or RGB32 destination on packed channels,
+ * returns false if the blitting flags or blend functions need the accumulators.
+ */
+static bool
+gAcquirePacked( CardState               *state,
+                GenefxState             *gfxs,
+                DFBSurfaceBlittingFlags  flags )
+{
+     GenefxPacked *P     = &gfxs->Packed;
+     DFBColor      color = state->color;
+
+     if (gfxs->src_format != DSPF_ARGB && gfxs->src_format != DSPF_RGB32 && gfxs->src_format != DSPF_A8)
+          return false;
+
+     if (gfxs->dst_format != DSPF_ARGB && gfxs->dst_format != DSPF_RGB32)
+          return false;
+
+     if (!flags || (flags & ~(DSBLIT_BLEND_ALPHACHANNEL | DSBLIT_BLEND_COLORALPHA | DSBLIT_COLORIZE |
+                              DSBLIT_SRC_PREMULTIPLY | DSBLIT_SRC_PREMULTCOLOR)))
+          return false;
+
+     if (flags & (DSBLIT_BLEND_ALPHACHANNEL | DSBLIT_BLEND_COLORALPHA)) {
+          if (state->dst_blend != DSBF_INVSRCALPHA ||
+              (state->src_blend != DSBF_ONE && state->src_blend != DSBF_SRCALPHA))
+               return false;
+
+          P->src_blend = state->src_blend;
+     }
+     else
+          P->src_blend = 0;
+
+     /* Setting the color alpha is modulating an opaque source alpha. */
+     if (gfxs->src_format == DSPF_RGB32 ||
+         (flags & (DSBLIT_BLEND_ALPHACHANNEL | DSBLIT_BLEND_COLORALPHA)) == DSBLIT_BLEND_COLORALPHA)
+          P->src_or = 0xff000000;
+     else
+          P->src_or = 0;
+
+     P->dst_or       = (gfxs->dst_format == DSPF_RGB32) ? 0xff000000 : 0;
+     P->premultcolor = (flags & DSBLIT_SRC_PREMULTCOLOR) ? color.a + 1 : 0x100;
+     P->modulate[0]  = (flags & DSBLIT_COLORIZE)         ? color.b + 1 : 0x100;
+     P->modulate[1]  = (flags & DSBLIT_COLORIZE)         ? color.g + 1 : 0x100;
+     P->modulate[2]  = (flags & DSBLIT_COLORIZE)         ? color.r + 1 : 0x100;
+     P->modulate[3]  = (flags & DSBLIT_BLEND_COLORALPHA) ? color.a + 1 : 0x100;
+     P->premultiply  = (flags & DSBLIT_SRC_PREMULTIPLY)  ? true        : false;
+
+     return true;
+}
+
+/**********************************************************************************************************************/
+
+static int use_mmx = 0;
+
+#ifdef USE_MMX
+
+#include "generic_mmx.h"
+
+/*
+ * patches function pointers to MMX functions
+ */
+static void
+gInit_MMX()
+{
+     use_mmx = 1;
+
+/********************************* Xacc_blend *********************************/
+     Xacc_blend[DSBF_SRCALPHA-1]    = Xacc_blend_srcalpha_MMX;
+     Xacc_blend[DSBF_INVSRCALPHA-1] = Xacc_blend_invsrcalpha_MMX;
+/********************************* Dacc_modulation ****************************/
+     Dacc_modulation[DSBLIT_BLEND_ALPHACHANNEL | DSBLIT_BLEND_COLORALPHA | DSBLIT_COLORIZE] = Dacc_modulate_argb_MMX;
+/********************************* Misc accumulator operations ****************/
+     SCacc_add_to_Dacc = SCacc_add_to_Dacc_MMX;
+     Sacc_add_to_Dacc  = Sacc_add_to_Dacc_MMX;
+}
+
+#endif
+
+static int use_sse2 = 0;
+static int use_avx2 = 0;
+
+#ifdef USE_SSE2
+
+#include "generic_sse2.h"
+
+/*
+ * patches function pointers to SSE2 functions
+ */
+static void
+gInit_SSE2()
+{
+     use_sse2 = 1;
+
+/********************************* Xacc_blend *********************************/
+     Xacc_blend[DSBF_SRCALPHA-1]    = Xacc_blend_srcalpha_SSE2;
+     Xacc_blend[DSBF_INVSRCALPHA-1] = Xacc_blend_invsrcalpha_SSE2;
+/********************************* Dacc_modulation ****************************/
+     Dacc_modulation[DSBLIT_BLEND_ALPHACHANNEL | DSBLIT_BLEND_COLORALPHA | DSBLIT_COLORIZE] = Dacc_modulate_argb_SSE2;
+/********************************* Sop_PFI_to_Dacc ****************************/
+     Sop_PFI_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Sop_argb_to_Dacc_SSE2;
+     Sop_PFI_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Sop_rgb32_to_Dacc_SSE2;
+     Sop_PFI_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_RGB16)] = Sop_rgb16_to_Dacc_SSE2;
+     Sop_PFI_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_A8)]    = Sop_a8_to_Dacc_SSE2;
+/********************************* Sop_PFI_TEX_to_Dacc ************************/
+     Sop_PFI_TEX_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Sop_argb_TEX_to_Dacc_SSE2;
+     Sop_PFI_TEX_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Sop_rgb32_TEX_to_Dacc_SSE2;
+/********************************* Sacc_to_Aop_PFI ****************************/
+     Sacc_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Sacc_to_Aop_argb_SSE2;
+     Sacc_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Sacc_to_Aop_rgb32_SSE2;
+     Sacc_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB16)] = Sacc_to_Aop_rgb16_SSE2;
+     Sacc_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_A8)]    = Sacc_to_Aop_a8_SSE2;
+/********************************* Cop_toK_Aop_PFI ****************************/
+     Cop_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB16)]    = Cop_toK_Aop_16_SSE2;
+     Cop_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB1555)] = Cop_toK_Aop_15_SSE2;
+     Cop_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB555)]   = Cop_toK_Aop_15_SSE2;
+     Cop_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_BGR555)]   = Cop_toK_Aop_15_SSE2;
+     Cop_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGBA5551)] = Cop_toK_Aop_15_SSE2;
+     Cop_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB4444)] = Cop_toK_Aop_12_SSE2;
+     Cop_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB444)]   = Cop_toK_Aop_12_SSE2;
+     Cop_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)]    = Cop_toK_Aop_32_SSE2;
+     Cop_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]     = Cop_toK_Aop_32_SSE2;
+     Cop_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_AiRGB)]    = Cop_toK_Aop_32_SSE2;
+     Cop_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ABGR)]     = Cop_toK_Aop_32_SSE2;
+     Cop_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_AYUV)]     = Cop_toK_Aop_32_SSE2;
+/********************************* Bop_PFI_toK_Aop_PFI ************************/
+     Bop_PFI_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB16)]    = Bop_16_toK_Aop_SSE2;
+     Bop_PFI_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB1555)] = Bop_15_toK_Aop_SSE2;
+     Bop_PFI_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB555)]   = Bop_15_toK_Aop_SSE2;
+     Bop_PFI_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_BGR555)]   = Bop_15_toK_Aop_SSE2;
+     Bop_PFI_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGBA5551)] = Bop_15_toK_Aop_SSE2;
+     Bop_PFI_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB4444)] = Bop_12_toK_Aop_SSE2;
+     Bop_PFI_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB444)]   = Bop_12_toK_Aop_SSE2;
+     Bop_PFI_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)]    = Bop_32_toK_Aop_SSE2;
+     Bop_PFI_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]     = Bop_32_toK_Aop_SSE2;
+     Bop_PFI_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_AiRGB)]    = Bop_32_toK_Aop_SSE2;
+     Bop_PFI_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ABGR)]     = Bop_32_toK_Aop_SSE2;
+     Bop_PFI_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_AYUV)]     = Bop_32_toK_Aop_SSE2;
+/********************************* Bop_PFI_Kto_Aop_PFI ************************/
+     Bop_PFI_Kto_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB16)]    = Bop_16_Kto_Aop_SSE2;
+     Bop_PFI_Kto_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB1555)] = Bop_15_Kto_Aop_SSE2;
+     Bop_PFI_Kto_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB555)]   = Bop_15_Kto_Aop_SSE2;
+     Bop_PFI_Kto_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_BGR555)]   = Bop_15_Kto_Aop_SSE2;
+     Bop_PFI_Kto_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGBA5551)] = Bop_15_Kto_Aop_SSE2;
+     Bop_PFI_Kto_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB4444)] = Bop_12_Kto_Aop_SSE2;
+     Bop_PFI_Kto_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB444)]   = Bop_12_Kto_Aop_SSE2;
+     Bop_PFI_Kto_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)]    = Bop_32_Kto_Aop_SSE2;
+     Bop_PFI_Kto_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]     = Bop_32_Kto_Aop_SSE2;
+     Bop_PFI_Kto_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_AiRGB)]    = Bop_32_Kto_Aop_SSE2;
+     Bop_PFI_Kto_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ABGR)]     = Bop_32_Kto_Aop_SSE2;
+     Bop_PFI_Kto_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_AYUV)]     = Bop_32_Kto_Aop_SSE2;
+/********************************* Bop_PFI_KtoK_Aop_PFI ***********************/
+     Bop_PFI_KtoK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB16)]    = Bop_16_KtoK_Aop_SSE2;
+     Bop_PFI_KtoK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB1555)] = Bop_15_KtoK_Aop_SSE2;
+     Bop_PFI_KtoK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB555)]   = Bop_15_KtoK_Aop_SSE2;
+     Bop_PFI_KtoK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_BGR555)]   = Bop_15_KtoK_Aop_SSE2;
+     Bop_PFI_KtoK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGBA5551)] = Bop_15_KtoK_Aop_SSE2;
+     Bop_PFI_KtoK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB4444)] = Bop_12_KtoK_Aop_SSE2;
+     Bop_PFI_KtoK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB444)]   = Bop_12_KtoK_Aop_SSE2;
+     Bop_PFI_KtoK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)]    = Bop_32_KtoK_Aop_SSE2;
+     Bop_PFI_KtoK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]     = Bop_32_KtoK_Aop_SSE2;
+     Bop_PFI_KtoK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_AiRGB)]    = Bop_32_KtoK_Aop_SSE2;
+     Bop_PFI_KtoK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ABGR)]     = Bop_32_KtoK_Aop_SSE2;
+/********************************* Bop_PFI_packed_Aop_32 **********************/
+     Bop_32_packed_Aop_32 = Bop_32_packed_Aop_32_SSE2;
+     Bop_a8_packed_Aop_32 = Bop_a8_packed_Aop_32_SSE2;
+/********************************* Misc accumulator operations ****************/
+     SCacc_add_to_Dacc  = SCacc_add_to_Dacc_SSE2;
+     Sacc_add_to_Dacc   = Sacc_add_to_Dacc_SSE2;
+     Dacc_Skey_extended = Dacc_Skey_extended_SSE2;
+/********************************* YCbCr span conversion **********************/
+     YCbCr_span_to_argb  = YCbCr_span_to_argb_SSE2;
+     YCbCr_span_to_rgb16 = YCbCr_span_to_rgb16_SSE2;
+/********************************* Source filters *****************************/
+     Dacc_src_colormatrix    = Dacc_src_colormatrix_SSE2;
+     Dacc_src_convolve       = Dacc_convolve_SSE2;
+     Dacc_src_convolve_keyed = Dacc_convolve_keyed_SSE2;
+}
+
+#include "generic_avx2.h"
+
+/*
+ * patches function pointers to AVX2 functions, to be called after gInit_SSE2()
+ */
+static void
+gInit_AVX2()
+{
+     use_avx2 = 1;
+
+/********************************* Xacc_blend *********************************/
+     Xacc_blend[DSBF_SRCALPHA-1]    = Xacc_blend_srcalpha_AVX2;
+     Xacc_blend[DSBF_INVSRCALPHA-1] = Xacc_blend_invsrcalpha_AVX2;
+/********************************* Dacc_modulation ****************************/
+     Dacc_modulation[DSBLIT_BLEND_ALPHACHANNEL | DSBLIT_BLEND_COLORALPHA | DSBLIT_COLORIZE] = Dacc_modulate_argb_AVX2;
+/********************************* Sop_PFI_to_Dacc ****************************/
+     Sop_PFI_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Sop_argb_to_Dacc_AVX2;
+     Sop_PFI_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Sop_rgb32_to_Dacc_AVX2;
+/********************************* Sacc_to_Aop_PFI ****************************/
+     Sacc_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Sacc_to_Aop_argb_AVX2;
+     Sacc_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Sacc_to_Aop_rgb32_AVX2;
+/********************************* Misc accumulator operations ****************/
+     SCacc_add_to_Dacc = SCacc_add_to_Dacc_AVX2;
+     Sacc_add_to_Dacc  = Sacc_add_to_Dacc_AVX2;
+}
+
+#endif
+
+#if SIZEOF_LONG == 8
+
+#include "generic_64.h"
+
+/*
+ * patches function pointers to 64 bits functions
+ */
+static void
+gInit_64bit()
+{
+/********************************* Cop_to_Aop_PFI ********************************/
+     Cop_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Cop_to_Aop_32_64;
+     Cop_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Cop_to_Aop_32_64;
+     Cop_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_AiRGB)] = Cop_to_Aop_32_64;
+/********************************* Bop_PFI_toK_Aop_PFI ***************************/
+     Bop_PFI_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Bop_rgb32_toK_Aop_64;
+     Bop_PFI_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Bop_rgb32_toK_Aop_64;
+     Bop_PFI_toK_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_AiRGB)] = Bop_rgb32_toK_Aop_64;
+/********************************* Bop_PFI_Kto_Aop_PFI ***************************/
+     Bop_PFI_Kto_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Bop_rgb32_Kto_Aop_64;
+     Bop_PFI_Kto_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Bop_rgb32_Kto_Aop_64;
+     Bop_PFI_Kto_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_AiRGB)] = Bop_rgb32_Kto_Aop_64;
+/********************************* Bop_PFI_Sto_Aop_PFI ***************************/
+     Bop_PFI_Sto_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Bop_32_Sto_Aop_64;
+     Bop_PFI_Sto_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Bop_32_Sto_Aop_64;
+     Bop_PFI_Sto_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_AiRGB)] = Bop_32_Sto_Aop_64;
+/********************************* Misc accumulator operations *******************/
+     Dacc_xor = Dacc_xor_64;
+}
+
+#endif
+
+#if !defined(WORDS_BIGENDIAN) && defined(__has_builtin)
+#if __has_builtin(__builtin_convertvector)
+#define USE_VECTOR_EXTENSIONS
+#endif
+#endif
+
+#ifdef USE_VECTOR_EXTENSIONS
+
+#include "generic_vector.h"
+
+/*
+ * patches function pointers to vector extensions functions
+ */
+static void
+gInit_Vector()
+{
+/********************************* Xacc_blend ************************************/
+     Xacc_blend[DSBF_SRCALPHA-1]    = Xacc_blend_srcalpha_vector;
+     Xacc_blend[DSBF_INVSRCALPHA-1] = Xacc_blend_invsrcalpha_vector;
+/********************************* Dacc_modulation *******************************/
+     Dacc_modulation[DSBLIT_BLEND_ALPHACHANNEL | DSBLIT_BLEND_COLORALPHA | DSBLIT_COLORIZE] = Dacc_modulate_argb_vector;
+/********************************* Sop_PFI_to_Dacc *******************************/
+     Sop_PFI_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Sop_argb_to_Dacc_vector;
+     Sop_PFI_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Sop_rgb32_to_Dacc_vector;
+     Sop_PFI_to_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_RGB16)] = Sop_rgb16_to_Dacc_vector;
+/********************************* Sop_PFI_Kto_Dacc ******************************/
+     Sop_PFI_Kto_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Sop_argb_Kto_Dacc_vector;
+     Sop_PFI_Kto_Dacc[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Sop_rgb32_Kto_Dacc_vector;
+/********************************* Bop_PFI_Kto_Aop_PFI ***************************/
+     Bop_PFI_Kto_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB16)] = Bop_16_Kto_Aop_vector;
+     Bop_PFI_Kto_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Bop_32_Kto_Aop_vector;
+     Bop_PFI_Kto_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Bop_32_Kto_Aop_vector;
+/********************************* Sacc_to_Aop_PFI *******************************/
+     Sacc_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_ARGB)]  = Sacc_to_Aop_argb_vector;
+     Sacc_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB32)] = Sacc_to_Aop_rgb32_vector;
+     Sacc_to_Aop_PFI[DFB_PIXELFORMAT_INDEX(DSPF_RGB16)] = Sacc_to_Aop_rgb16_vector;
+/********************************* Misc accumulator operations *******************/
+     SCacc_add_to_Dacc = SCacc_add_to_Dacc_vector;
+     Sacc_add_to_Dacc  = Sacc_add_to_Dacc_vector;
+}
+
+#endif
+
+#ifdef WORDS_BIGENDIAN
+
+/*
+ * patches function pointers to big endian functions
+ */
+static void
 gInit_BigEndian()
 {
 /********************************* Cop_to_Aop_PFI ********************************/
@@ -9834,6 +11354,10 @@ gGetDriverInfo( GraphicsDriverInfo *driver_info )
      gInit_BigEndian();
 #endif
 
+#ifdef USE_VECTOR_EXTENSIONS
+     gInit_Vector();
+#endif
+
 #ifdef USE_MMX
      if (!dfb_config->mmx) {
           D_INFO( "DirectFB/Genefx: MMX disabled by option 'no-mmx'\n" );
@@ -9847,6 +11371,32 @@ gGetDriverInfo( GraphicsDriverInfo *driver_info )
      }
 #endif
 
+#ifdef USE_SSE2
+     if (!dfb_config->sse2) {
+          D_INFO( "DirectFB/Genefx: SSE2 disabled by option 'no-sse2'\n" );
+     }
+     else if (__builtin_cpu_supports( "sse2" )) {
+          gInit_SSE2();
+
+          if (!dfb_config->avx2) {
+               D_INFO( "DirectFB/Genefx: AVX2 disabled by option 'no-avx2'\n" );
+          }
+          else if (__builtin_cpu_supports( "avx2" )) {
+               gInit_AVX2();
+
+               snprintf( driver_info->name, DFB_GRAPHICS_DRIVER_INFO_NAME_LENGTH, "AVX2 Software Driver" );
+
+               D_INFO( "DirectFB/Genefx: AVX2 enabled\n" );
+          }
+
+          if (!use_avx2) {
+               snprintf( driver_info->name, DFB_GRAPHICS_DRIVER_INFO_NAME_LENGTH, "SSE2 Software Driver" );
+
+               D_INFO( "DirectFB/Genefx: SSE2 enabled\n" );
+          }
+     }
+#endif
+
      snprintf( driver_info->vendor, DFB_GRAPHICS_DRIVER_INFO_VENDOR_LENGTH, "DirectFB" );
 
      driver_info->version.major = 0;
@@ -9858,7 +11408,8 @@ gGetDeviceInfo( GraphicsDeviceInfo *device_info )
 {
      snprintf( device_info->name, DFB_GRAPHICS_DEVICE_INFO_NAME_LENGTH, "Software Rasterizer" );
 
-     snprintf( device_info->vendor, DFB_GRAPHICS_DEVICE_INFO_VENDOR_LENGTH, use_mmx ? "MMX" : "Generic" );
+     snprintf( device_info->vendor, DFB_GRAPHICS_DEVICE_INFO_VENDOR_LENGTH,
+               use_avx2 ? "AVX2" : use_sse2 ? "SSE2" : use_mmx ? "MMX" : "Generic" );
 
      device_info->caps.flags    = 0;
      device_info->caps.accel    = DFXL_NONE;
@@ -9867,6 +11418,12 @@ gGetDeviceInfo( GraphicsDeviceInfo *device_info )
      device_info->caps.clip     = 0;
 }
 
+void
+gShutdown()
+{
+     Genefx_Bands_Shutdown();
+}
+
 static bool
 gAcquireCheck( CardState           *state,
                DFBAccelerationMask  accel )
@@ -9921,6 +11478,10 @@ gAcquireCheck( CardState           *state,
                if (!source_mask)
                     return false;
           }
+
+          /* The convolution filters lines of the source, which are not read as a whole by scaled blits. */
+          if (state->blittingflags & DSBLIT_SRC_CONVOLUTION && accel != DFXL_BLIT)
+               return false;
      }
 
      return true;
@@ -9936,6 +11497,10 @@ gAcquireLockBuffers( CardState           *state,
      CoreSurface            *source_mask = state->source_mask;
      CoreSurfaceAccessFlags  access      = CSAF_WRITE;
 
+     /* Already locked when the operation has been queued. */
+     if (state->flags & CSF_BUFFERS_LOCKED)
+          return DFB_OK;
+
      if (core_dfb->shutdown_running)
           return DFB_DEAD;
 
@@ -10005,6 +11570,10 @@ gAcquireLockBuffers( CardState           *state,
 static DFBResult
 gAcquireUnlockBuffers( CardState *state )
 {
+     /* Unlocked by the render queue after the operation. */
+     if (state->flags & CSF_BUFFERS_LOCKED)
+          return DFB_OK;
+
      dfb_surface_unlock_buffer( state->destination, &state->dst );
 
      if (state->flags & CSF_SOURCE_LOCKED) {
@@ -10022,6 +11591,160 @@ gAcquireUnlockBuffers( CardState *state )
      return DFB_OK;
 }
 
+/*
+ * Fill in the state bits the pipeline depends on, returns false if the pipeline must not be cached.
+ */
+static bool
+gAcquirePipelineKey( CardState           *state,
+                     DFBAccelerationMask  accel,
+                     GenefxPipelineKey   *key )
+{
+     CoreSurface *destination = state->destination;
+     CoreSurface *source      = state->source;
+
+     memset( key, 0, sizeof(GenefxPipelineKey) );
+
+     key->accel          = accel;
+     key->dst_format     = destination->config.format;
+     key->dst_colorspace = destination->config.colorspace;
+     key->dst_palette    = destination->palette;
+     key->src_blend      = state->src_blend;
+     key->dst_blend      = state->dst_blend;
+     key->color          = state->color;
+     key->color_index    = state->color_index;
+     key->src_colorkey   = state->src_colorkey;
+     key->dst_colorkey   = state->dst_colorkey;
+
+     if (DFB_BLITTING_FUNCTION( accel )) {
+          key->src_format        = source->config.format;
+          key->src_colorspace    = source->config.colorspace;
+          key->src_palette       = source->palette;
+          key->blittingflags     = state->blittingflags;
+          key->index_translation = state->index_translation;
+          key->num_translation   = state->num_translation;
+
+          if (state->blittingflags & (DSBLIT_SRC_MASK_ALPHA | DSBLIT_SRC_MASK_COLOR))
+               key->mask_format = state->source_mask->config.format;
+
+          if (state->blittingflags & DSBLIT_SRC_COLORKEY_EXTENDED)
+               key->src_colorkey_extended = state->src_colorkey_extended;
+
+          if (state->blittingflags & DSBLIT_SRC_COLORMATRIX)
+               direct_memcpy( key->src_colormatrix, state->src_colormatrix, sizeof(key->src_colormatrix) );
+
+          if (state->blittingflags & DSBLIT_SRC_CONVOLUTION)
+               key->src_convolution = state->src_convolution;
+
+          /* The pipeline depends on the palette entries if both formats are indexed. */
+          if (DFB_PIXELFORMAT_IS_INDEXED( key->src_format ) && DFB_PIXELFORMAT_IS_INDEXED( key->dst_format ) &&
+              source->palette != destination->palette)
+               return false;
+     }
+     else
+          key->drawingflags = state->drawingflags;
+
+     return true;
+}
+
+/*
+ * Restore the pipeline and constants if they have been prepared for the same key before.
+ */
+static bool
+gAcquirePipelineLookup( GenefxState             *gfxs,
+                        const GenefxPipelineKey *key )
+{
+     int i;
+
+     for (i = 0; i < gfxs->num_pipelines; i++) {
+          const GenefxPipeline *pipeline = &gfxs->pipelines[i];
+
+          if (memcmp( &pipeline->key, key, sizeof(GenefxPipelineKey) ))
+               continue;
+
+          direct_memcpy( gfxs->funcs, pipeline->funcs, sizeof(gfxs->funcs) );
+          direct_memcpy( gfxs->SrcMatrix, pipeline->SrcMatrix, sizeof(gfxs->SrcMatrix) );
+          direct_memcpy( gfxs->SrcKernel, pipeline->SrcKernel, sizeof(gfxs->SrcKernel) );
+          direct_memcpy( gfxs->Kfuncs, pipeline->Kfuncs, sizeof(gfxs->Kfuncs) );
+
+          gfxs->color            = pipeline->color;
+          gfxs->Cop              = pipeline->Cop;
+          gfxs->YCop             = pipeline->YCop;
+          gfxs->CbCop            = pipeline->CbCop;
+          gfxs->CrCop            = pipeline->CrCop;
+          gfxs->Dkey             = pipeline->Dkey;
+          gfxs->Skey             = pipeline->Skey;
+          gfxs->SkeyExtended     = pipeline->SkeyExtended;
+          gfxs->YCbCr            = pipeline->YCbCr;
+          gfxs->SrcBias          = pipeline->SrcBias;
+          gfxs->Alut             = pipeline->Alut;
+          gfxs->Blut             = pipeline->Blut;
+          gfxs->Cacc             = pipeline->Cacc;
+          gfxs->SCacc            = pipeline->SCacc;
+          gfxs->Packed           = pipeline->Packed;
+          gfxs->Sop              = pipeline->Sop;
+          gfxs->need_accumulator = pipeline->need_accumulator;
+          gfxs->fill_bpp         = pipeline->fill_bpp;
+          gfxs->trans            = pipeline->trans;
+          gfxs->num_trans        = pipeline->num_trans;
+
+          gfxs->Astep = gfxs->Bstep = gfxs->Ostep = 1;
+
+          gfxs->pipeline_hits++;
+
+          D_DEBUG_AT( Genefx_Path, "%s( 0x%08x ) -> cached pipeline %d (%u hits, %u misses)\n", __FUNCTION__,
+                      key->accel, i, gfxs->pipeline_hits, gfxs->pipeline_misses );
+
+          return true;
+     }
+
+     gfxs->pipeline_misses++;
+
+     return false;
+}
+
+/*
+ * Remember the pipeline and constants prepared for the key, replacing the oldest entry if the cache is full.
+ */
+static void
+gAcquirePipelineStore( GenefxState             *gfxs,
+                       const GenefxPipelineKey *key )
+{
+     GenefxPipeline *pipeline = &gfxs->pipelines[gfxs->next_pipeline];
+
+     pipeline->key = *key;
+
+     direct_memcpy( pipeline->funcs, gfxs->funcs, sizeof(pipeline->funcs) );
+     direct_memcpy( pipeline->SrcMatrix, gfxs->SrcMatrix, sizeof(pipeline->SrcMatrix) );
+     direct_memcpy( pipeline->SrcKernel, gfxs->SrcKernel, sizeof(pipeline->SrcKernel) );
+     direct_memcpy( pipeline->Kfuncs, gfxs->Kfuncs, sizeof(pipeline->Kfuncs) );
+
+     pipeline->color            = gfxs->color;
+     pipeline->Cop              = gfxs->Cop;
+     pipeline->YCop             = gfxs->YCop;
+     pipeline->CbCop            = gfxs->CbCop;
+     pipeline->CrCop            = gfxs->CrCop;
+     pipeline->Dkey             = gfxs->Dkey;
+     pipeline->Skey             = gfxs->Skey;
+     pipeline->SkeyExtended     = gfxs->SkeyExtended;
+     pipeline->YCbCr            = gfxs->YCbCr;
+     pipeline->SrcBias          = gfxs->SrcBias;
+     pipeline->Alut             = gfxs->Alut;
+     pipeline->Blut             = gfxs->Blut;
+     pipeline->Cacc             = gfxs->Cacc;
+     pipeline->SCacc            = gfxs->SCacc;
+     pipeline->Packed           = gfxs->Packed;
+     pipeline->Sop              = gfxs->Sop;
+     pipeline->need_accumulator = gfxs->need_accumulator;
+     pipeline->fill_bpp         = gfxs->fill_bpp;
+     pipeline->trans            = gfxs->trans;
+     pipeline->num_trans        = gfxs->num_trans;
+
+     gfxs->next_pipeline = (gfxs->next_pipeline + 1) % GENEFX_PIPELINE_CACHE_SIZE;
+
+     if (gfxs->num_pipelines < GENEFX_PIPELINE_CACHE_SIZE)
+          gfxs->num_pipelines++;
+}
+
 static bool
 gAcquireSetup( CardState           *state,
                DFBAccelerationMask  accel )
@@ -10037,6 +11760,10 @@ gAcquireSetup( CardState           *state,
      bool                     src_ycbcr            = false;
      bool                     dst_ycbcr            = false;
      DFBSurfaceBlittingFlags  simpld_blittingflags = state->blittingflags;
+     const GenefxFusedBlit   *fused                = NULL;
+     bool                     packed               = false;
+     GenefxPipelineKey        key;
+     bool                     cacheable;
      u16                      ca;
 
      dfb_simplify_blittingflags( &simpld_blittingflags );
@@ -10059,6 +11786,7 @@ gAcquireSetup( CardState           *state,
       */
 
      gfxs->dst_caps         = destination->config.caps;
+     gfxs->dst_width        = destination->config.size.w;
      gfxs->dst_height       = destination->config.size.h;
      gfxs->dst_format       = destination->config.format;
      gfxs->dst_bpp          = DFB_BYTES_PER_PIXEL( gfxs->dst_format );
@@ -10113,6 +11841,7 @@ gAcquireSetup( CardState           *state,
           CoreSurface *source_mask = state->source_mask;
 
           gfxs->src_caps         = source->config.caps;
+          gfxs->src_width        = source->config.size.w;
           gfxs->src_height       = source->config.size.h;
           gfxs->src_format       = source->config.format;
           gfxs->src_bpp          = DFB_BYTES_PER_PIXEL( gfxs->src_format );
@@ -10165,6 +11894,7 @@ gAcquireSetup( CardState           *state,
 
           if (simpld_blittingflags & (DSBLIT_SRC_MASK_ALPHA | DSBLIT_SRC_MASK_COLOR)) {
                gfxs->mask_caps         = source_mask->config.caps;
+               gfxs->mask_width        = source_mask->config.size.w;
                gfxs->mask_height       = source_mask->config.size.h;
                gfxs->mask_format       = source_mask->config.format;
                gfxs->mask_bpp          = DFB_BYTES_PER_PIXEL( gfxs->mask_format );
@@ -10213,6 +11943,15 @@ gAcquireSetup( CardState           *state,
           }
      }
 
+     /* Reuse the pipeline if nothing relevant changed. */
+     cacheable = gAcquirePipelineKey( state, accel, &key );
+
+     if (cacheable && gAcquirePipelineLookup( gfxs, &key )) {
+          dfb_state_update( state, state->flags & CSF_SOURCE_LOCKED );
+
+          return true;
+     }
+
      /* Premultiply source (color). */
      if (DFB_DRAWING_FUNCTION(accel) && (state->drawingflags & DSDRAW_SRC_PREMULTIPLY)) {
           ca = color.a + 1;
@@ -10444,6 +12183,8 @@ gAcquireSetup( CardState           *state,
 
      gfxs->need_accumulator = true;
 
+     gfxs->Kfuncs[0] = NULL;
+
      gfxs->Astep = gfxs->Bstep = gfxs->Ostep = 1;
 
      switch (accel) {
@@ -10664,77 +12405,42 @@ gAcquireSetup( CardState           *state,
                }
                break;
           case DFXL_BLIT:
-               if (simpld_blittingflags == DSBLIT_BLEND_ALPHACHANNEL &&
-                   state->src_blend == DSBF_SRCALPHA &&
-                   state->dst_blend == DSBF_INVSRCALPHA) {
-                    if (gfxs->src_format == DSPF_ARGB &&
-                        Bop_argb_blend_alphachannel_src_invsrc_Aop_PFI[dst_pfi]) {
-                         *funcs++ = Bop_argb_blend_alphachannel_src_invsrc_Aop_PFI[dst_pfi];
-                         break;
-                    }
-               }
-               if (simpld_blittingflags == DSBLIT_BLEND_ALPHACHANNEL &&
-                   state->src_blend == DSBF_ONE &&
-                   state->dst_blend == DSBF_INVSRCALPHA) {
-                    if (gfxs->src_format == DSPF_ARGB &&
-                        Bop_argb_blend_alphachannel_one_invsrc_Aop_PFI[dst_pfi]) {
-                         *funcs++ = Bop_argb_blend_alphachannel_one_invsrc_Aop_PFI[dst_pfi];
-                         break;
-                    }
-               }
-               if (simpld_blittingflags == (DSBLIT_BLEND_ALPHACHANNEL | DSBLIT_SRC_PREMULTIPLY) &&
-                   state->src_blend == DSBF_ONE &&
-                   state->dst_blend == DSBF_INVSRCALPHA) {
-                    if (gfxs->src_format == DSPF_ARGB &&
-                        Bop_argb_blend_alphachannel_one_invsrc_premultiply_Aop_PFI[dst_pfi]) {
-                         *funcs++ = Bop_argb_blend_alphachannel_one_invsrc_premultiply_Aop_PFI[dst_pfi];
-                         break;
-                    }
-               }
-               if (((simpld_blittingflags == (DSBLIT_COLORIZE | DSBLIT_BLEND_ALPHACHANNEL | DSBLIT_SRC_PREMULTIPLY) &&
-                     state->src_blend == DSBF_ONE) ||
-                    (simpld_blittingflags == (DSBLIT_COLORIZE | DSBLIT_BLEND_ALPHACHANNEL) &&
-                     state->src_blend == DSBF_SRCALPHA)) &&
-                   state->dst_blend   == DSBF_INVSRCALPHA) {
-                    if (gfxs->src_format == DSPF_A8 && Bop_a8_set_alphapixel_Aop_PFI[dst_pfi]) {
-                         *funcs++ = Bop_a8_set_alphapixel_Aop_PFI[dst_pfi];
-                         break;
-                    }
-                    if (gfxs->src_format == DSPF_A1 && Bop_a1_set_alphapixel_Aop_PFI[dst_pfi]) {
-                         *funcs++ = Bop_a1_set_alphapixel_Aop_PFI[dst_pfi];
-                         break;
-                    }
-                    if (gfxs->src_format == DSPF_A1_LSB && Bop_a1_lsb_set_alphapixel_Aop_PFI[dst_pfi]) {
-                         *funcs++ = Bop_a1_lsb_set_alphapixel_Aop_PFI[dst_pfi];
-                         break;
-                    }
-               }
-#ifndef WORDS_BIGENDIAN
-               if (simpld_blittingflags       == DSBLIT_NOFX &&
-                   source->config.format      == DSPF_RGB24 &&
-                   destination->config.format == DSPF_RGB16) {
-                    *funcs++ = Bop_rgb24_to_Aop_rgb16_LE;
+          case DFXL_STRETCHBLIT:
+               fused = gAcquireFusedBlit( state, accel, simpld_blittingflags, dst_pfi );
+               if (fused) {
+                    gfxs->need_accumulator = false;
+                    gfxs->YCbCr            = ycbcr_to_rgb( source->config.colorspace );
+
+                    if (accel == DFXL_STRETCHBLIT)
+                         *funcs++ = fused->Sto_Aop_PFI[dst_pfi];
+                    else
+                         *funcs++ = fused->Aop_PFI[dst_pfi];
                     break;
                }
-               if (simpld_blittingflags       == DSBLIT_NOFX &&
-                   (source->config.format     == DSPF_RGB32 || source->config.format == DSPF_ARGB) &&
-                   destination->config.format == DSPF_RGB16) {
-                    *funcs++ = Bop_rgb32_to_Aop_rgb16_LE;
+
+               if (accel == DFXL_BLIT && gAcquirePacked( state, gfxs, simpld_blittingflags )) {
+                    gfxs->need_accumulator = false;
+                    packed                 = true;
+
+                    *funcs++ = (gfxs->src_format == DSPF_A8) ? Bop_a8_packed_Aop_32 : Bop_32_packed_Aop_32;
                     break;
                }
-#endif
                /* fall through */
-          case DFXL_TEXTRIANGLES:
-          case DFXL_STRETCHBLIT: {
+          case DFXL_TEXTRIANGLES: {
                int modulation = simpld_blittingflags & MODULATION_FLAGS;
 
                if (modulation                                                                   ||
                    (accel == DFXL_TEXTRIANGLES && (src_pfi != dst_pfi || simpld_blittingflags)) ||
                    (simpld_blittingflags & (DSBLIT_SRC_MASK_ALPHA | DSBLIT_SRC_MASK_COLOR))     ||
+                   (simpld_blittingflags & DSBLIT_SRC_COLORKEY_EXTENDED)                        ||
+                   (simpld_blittingflags & (DSBLIT_SRC_COLORMATRIX | DSBLIT_SRC_CONVOLUTION))   ||
                    ((simpld_blittingflags & DSBLIT_ROTATE90) && accel == DFXL_STRETCHBLIT)) {
-                    bool read_destination         = false;
-                    bool source_needs_destination = false;
-                    bool scale_from_accumulator;
+                    bool       read_destination         = false;
+                    bool       source_needs_destination = false;
+                    bool       scale_from_accumulator;
+                    bool       source_keyed             = simpld_blittingflags & (DSBLIT_SRC_COLORKEY |
+                                                                                  DSBLIT_SRC_COLORKEY_EXTENDED);
+                    GenefxFunc source_to_rgb            = NULL;
 
                     /* Check if destination has to be read. */
                     if (simpld_blittingflags & (DSBLIT_BLEND_ALPHACHANNEL | DSBLIT_BLEND_COLORALPHA)) {
@@ -10782,44 +12488,77 @@ gAcquireSetup( CardState           *state,
                          *funcs++ = Len_is_Slen;
                     }
 
+                    if (src_ycbcr) {
+                         if (source->config.colorspace == DSCS_BT601)
+                              source_to_rgb = Dacc_YCbCr_to_RGB_BT601;
+                         else if (source->config.colorspace == DSCS_BT709)
+                              source_to_rgb = Dacc_YCbCr_to_RGB_BT709;
+                         else if (source->config.colorspace == DSCS_BT2020)
+                              source_to_rgb = Dacc_YCbCr_to_RGB_BT2020;
+                    }
+
                     /* Read the source */
                     *funcs++ = Sop_is_Bop;
                     if (DFB_PIXELFORMAT_IS_INDEXED( gfxs->src_format ))
                          *funcs++ = Slut_is_Blut;
                     *funcs++ = Dacc_is_Bacc;
-                    if (accel == DFXL_TEXTRIANGLES) {
-                         if (simpld_blittingflags & DSBLIT_SRC_COLORKEY) {
-                              gfxs->Skey = state->src_colorkey;
 
-                              *funcs++ = Sop_PFI_TEX_Kto_Dacc[src_pfi];
+                    /* Without keys, the convolution reads the source itself. */
+                    if (!(simpld_blittingflags & DSBLIT_SRC_CONVOLUTION) || source_keyed) {
+                         if (accel == DFXL_TEXTRIANGLES) {
+                              if (simpld_blittingflags & DSBLIT_SRC_COLORKEY) {
+                                   gfxs->Skey = state->src_colorkey;
+
+                                   *funcs++ = Sop_PFI_TEX_Kto_Dacc[src_pfi];
+                              }
+                              else {
+                                   *funcs++ = Sop_PFI_TEX_to_Dacc[src_pfi];
+                              }
                          }
                          else {
-                              *funcs++ = Sop_PFI_TEX_to_Dacc[src_pfi];
+                              if (simpld_blittingflags & DSBLIT_SRC_COLORKEY) {
+                                   gfxs->Skey = state->src_colorkey;
+                                   if (accel == DFXL_BLIT || scale_from_accumulator)
+                                        *funcs++ = Sop_PFI_Kto_Dacc[src_pfi];
+                                   else
+                                        *funcs++ = Sop_PFI_SKto_Dacc[src_pfi];
+                              }
+                              else {
+                                   if (accel == DFXL_BLIT || scale_from_accumulator)
+                                        *funcs++ = Sop_PFI_to_Dacc[src_pfi];
+                                   else
+                                        *funcs++ = Sop_PFI_Sto_Dacc[src_pfi];
+                              }
                          }
+
+                         if (source_to_rgb)
+                              *funcs++ = source_to_rgb;
                     }
-                    else {
-                         if (simpld_blittingflags & DSBLIT_SRC_COLORKEY) {
-                              gfxs->Skey = state->src_colorkey;
-                              if (accel == DFXL_BLIT || scale_from_accumulator)
-                                   *funcs++ = Sop_PFI_Kto_Dacc[src_pfi];
-                              else
-                                   *funcs++ = Sop_PFI_SKto_Dacc[src_pfi];
-                         }
-                         else {
-                              if (accel == DFXL_BLIT || scale_from_accumulator)
-                                   *funcs++ = Sop_PFI_to_Dacc[src_pfi];
-                              else
-                                   *funcs++ = Sop_PFI_Sto_Dacc[src_pfi];
-                         }
+
+                    /* Key the source by color range. */
+                    if (simpld_blittingflags & DSBLIT_SRC_COLORKEY_EXTENDED) {
+                         gfxs->SkeyExtended = state->src_colorkey_extended;
+                         *funcs++ = Dacc_Skey_extended;
                     }
 
-                    if (src_ycbcr) {
-                         if (source->config.colorspace == DSCS_BT601)
-                              *funcs++ = Dacc_YCbCr_to_RGB_BT601;
-                         else if (source->config.colorspace == DSCS_BT709)
-                              *funcs++ = Dacc_YCbCr_to_RGB_BT709;
-                         else if (source->config.colorspace == DSCS_BT2020)
-                              *funcs++ = Dacc_YCbCr_to_RGB_BT2020;
+                    /* Filter the source, leaving pixels keyed above as they are. */
+                    if (simpld_blittingflags & DSBLIT_SRC_CONVOLUTION) {
+                         gfxs->Kfuncs[0] = Sop_PFI_to_Dacc[src_pfi];
+                         gfxs->Kfuncs[1] = source_to_rgb;
+                         gfxs->Kfuncs[2] = NULL;
+
+                         if (src_convolution_prepare( gfxs, &state->src_convolution ))
+                              *funcs++ = source_keyed ? Dacc_src_convolve_keyed : Dacc_src_convolve;
+                         else
+                              *funcs++ = source_keyed ? Dacc_convolve_keyed_C : Dacc_convolve_C;
+                    }
+
+                    /* Transform the colors of the source. */
+                    if (simpld_blittingflags & DSBLIT_SRC_COLORMATRIX) {
+                         if (src_colormatrix_prepare( gfxs, state->src_colormatrix ))
+                              *funcs++ = Dacc_src_colormatrix;
+                         else
+                              *funcs++ = Dacc_src_colormatrix_C;
                     }
 
                     /* Premultiply color alpha. */
@@ -11110,6 +12849,37 @@ gAcquireSetup( CardState           *state,
 
      *funcs = NULL;
 
+     /* Recognize fills just storing Cop, which gFillRectangle() does without running the pipeline. */
+     gfxs->fill_bpp = 0;
+
+     if (accel == DFXL_FILLRECTANGLE && funcs - gfxs->funcs == 1) {
+          if (gfxs->funcs[0] == Cop_to_Aop_8)
+               gfxs->fill_bpp = 1;
+          else if (gfxs->funcs[0] == Cop_to_Aop_16)
+               gfxs->fill_bpp = 2;
+#if SIZEOF_LONG == 8
+          else if (gfxs->funcs[0] == Cop_to_Aop_32 || gfxs->funcs[0] == Cop_to_Aop_32_64)
+#else
+          else if (gfxs->funcs[0] == Cop_to_Aop_32)
+#endif
+               gfxs->fill_bpp = 4;
+     }
+
+     if (fused)
+          D_DEBUG_AT( Genefx_Path, "%s( 0x%08x, %s <- %s ) -> fused %s\n", __FUNCTION__, accel,
+                      dfb_pixelformat_name( gfxs->dst_format ), dfb_pixelformat_name( gfxs->src_format ), fused->name );
+     else if (packed)
+          D_DEBUG_AT( Genefx_Path, "%s( 0x%08x, %s <- %s ) -> packed\n", __FUNCTION__, accel,
+                      dfb_pixelformat_name( gfxs->dst_format ), dfb_pixelformat_name( gfxs->src_format ) );
+     else
+          D_DEBUG_AT( Genefx_Path, "%s( 0x%08x, %s <- %s ) -> %s pipeline with %d functions\n", __FUNCTION__, accel,
+                      dfb_pixelformat_name( gfxs->dst_format ),
+                      DFB_BLITTING_FUNCTION( accel ) ? dfb_pixelformat_name( gfxs->src_format ) : "none",
+                      gfxs->need_accumulator ? "accumulator" : "direct", (int) (funcs - gfxs->funcs) );
+
+     if (cacheable)
+          gAcquirePipelineStore( gfxs, &key );
+
      dfb_state_update( state, state->flags & CSF_SOURCE_LOCKED );
 
      return true;
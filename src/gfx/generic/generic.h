@@ -40,6 +40,112 @@ typedef union {
      } YUV;
 } GenefxAccumulator;
 
+/*
+ * Weights of Cb and Cr in the YCbCr to RGB conversion of a colorspace, scaled by 256 like the weight of Y (298).
+ */
+typedef struct {
+     int                      cr_r;
+     int                      cb_g;
+     int                      cr_g;
+     int                      cb_b;
+} GenefxYCbCrToRGB;
+
+/*
+ * Constants of a blit of 32 bit pixels done on packed 8 bit channels, multipliers are 0x100 if not modulating.
+ */
+typedef struct {
+     u32                      src_or;            /* setting the alpha of sources without alpha or with color alpha */
+     u32                      dst_or;            /* setting the alpha written to destinations without alpha */
+     u16                      premultcolor;      /* multiplier of the source color by the color alpha */
+     u16                      modulate[4];       /* multipliers of the source b, g, r and a */
+     bool                     premultiply;       /* multiply the source color by the (modulated) source alpha */
+     DFBSurfaceBlendFunction  src_blend;         /* DSBF_ONE or DSBF_SRCALPHA blending over, zero if not blending */
+} GenefxPacked;
+
+/*
+ * Filter bank of the polyphase scaler for a range of output pixels, kept for the following blits.
+ */
+typedef struct {
+     int                      src_size;          /* scaling and output pixels the bank is computed for */
+     int                      dst_size;
+     int                      start;
+     int                      count;
+     bool                     bicubic;
+
+     void                    *mem;
+     int                      size;              /* of the allocation */
+     int                     *first;             /* first source pixel of each output pixel */
+     s16                     *weights;           /* weights of the taps of each output pixel */
+} GenefxScaleBank;
+
+#define GENEFX_PIPELINE_CACHE_SIZE 4
+
+/*
+ * State bits the pipeline built by gAcquireSetup() depends on.
+ */
+typedef struct {
+     DFBAccelerationMask      accel;
+
+     DFBSurfacePixelFormat    dst_format;
+     DFBSurfacePixelFormat    src_format;
+     DFBSurfacePixelFormat    mask_format;
+
+     DFBSurfaceColorSpace     dst_colorspace;
+     DFBSurfaceColorSpace     src_colorspace;
+
+     DFBSurfaceDrawingFlags   drawingflags;
+     DFBSurfaceBlittingFlags  blittingflags;
+     DFBSurfaceBlendFunction  src_blend;
+     DFBSurfaceBlendFunction  dst_blend;
+
+     DFBColor                 color;
+     unsigned int             color_index;
+     u32                      src_colorkey;
+     u32                      dst_colorkey;
+     DFBColorKeyExtended      src_colorkey_extended;
+     s32                      src_colormatrix[12];
+     DFBConvolutionFilter     src_convolution;
+
+     CorePalette             *dst_palette;
+     CorePalette             *src_palette;
+
+     int                     *index_translation;
+     int                      num_translation;
+} GenefxPipelineKey;
+
+/*
+ * Pipeline and constants prepared by gAcquireSetup() for a key.
+ */
+typedef struct {
+     GenefxPipelineKey        key;
+
+     GenefxFunc               funcs[32];
+
+     DFBColor                 color;
+     u32                      Cop;
+     u8                       YCop;
+     u8                       CbCop;
+     u8                       CrCop;
+     u32                      Dkey;
+     u32                      Skey;
+     DFBColorKeyExtended      SkeyExtended;
+     const GenefxYCbCrToRGB  *YCbCr;
+     s32                      SrcMatrix[12];
+     s32                      SrcKernel[9];
+     s32                      SrcBias;
+     GenefxFunc               Kfuncs[3];
+     CorePalette             *Alut;
+     CorePalette             *Blut;
+     GenefxAccumulator        Cacc;
+     GenefxAccumulator        SCacc;
+     GenefxPacked             Packed;
+     void                   **Sop;
+     bool                     need_accumulator;
+     int                      fill_bpp;
+     int                     *trans;
+     int                      num_trans;
+} GenefxPipeline;
+
 struct __DFB_GenefxState {
      GenefxFunc               funcs[32];
 
@@ -67,6 +173,10 @@ struct __DFB_GenefxState {
      DFBSurfacePixelFormat    src_format;
      DFBSurfacePixelFormat    mask_format;
 
+     int                      dst_width;
+     int                      src_width;
+     int                      mask_width;
+
      int                      dst_height;
      int                      src_height;
      int                      mask_height;
@@ -100,6 +210,8 @@ struct __DFB_GenefxState {
      int                      BopY;
      int                      MopY;
 
+     int                      BopX;              /* for the source convolution only */
+
      int                      s;
      int                      t;
 
@@ -108,6 +220,20 @@ struct __DFB_GenefxState {
       */
      u32                      Dkey;
      u32                      Skey;
+     DFBColorKeyExtended      SkeyExtended;
+
+     /*
+      * source conversion of fused YCbCr to RGB blits
+      */
+     const GenefxYCbCrToRGB  *YCbCr;
+
+     /*
+      * source color matrix and convolution kernel, coefficients in 20.12 fixed point
+      */
+     s32                      SrcMatrix[12];
+     s32                      SrcKernel[9];
+     s32                      SrcBias;
+     GenefxFunc               Kfuncs[3];         /* reading a line of the source to be filtered, NULL terminated */
 
      /*
       * color lookup tables
@@ -116,16 +242,16 @@ struct __DFB_GenefxState {
      CorePalette             *Blut;
 
      /*
-      * accumulators
+      * color accumulators
       */
-     void                    *ABstart;
-     int                      ABsize;
-     GenefxAccumulator       *Aacc;
-     GenefxAccumulator       *Bacc;
-     GenefxAccumulator       *Tacc;              /* for simultaneous S+D blending */
      GenefxAccumulator        Cacc;
      GenefxAccumulator        SCacc;
 
+     /*
+      * packed blending without accumulators
+      */
+     GenefxPacked             Packed;
+
      /*
       * dataflow control
       */
@@ -145,8 +271,35 @@ struct __DFB_GenefxState {
 
      bool                     need_accumulator;
 
+     int                      fill_bpp;          /* bytes per pixel of a plain fill with Cop, zero if not applicable */
+
+     bool                     band;              /* rendering a band of an operation split by Genefx_Bands_*() */
+
      int                     *trans;
      int                      num_trans;
+
+     /*
+      * accumulators, the fields from here on are owned by each state and not copied to the bands of an operation
+      */
+     void                    *ABstart;
+     int                      ABsize;
+     GenefxAccumulator       *Aacc;
+     GenefxAccumulator       *Bacc;
+     GenefxAccumulator       *Tacc;              /* for simultaneous S+D blending */
+     void                    *Kstart;            /* lines of the source kept for the convolution */
+     int                      Ksize;
+     GenefxAccumulator       *Kacc;
+     int                      KaccY[3];          /* source line held by each, -1 if none */
+     GenefxScaleBank          ScaleBanks[2];     /* horizontal and vertical filter banks of Genefx_Scale() */
+
+     /*
+      * pipeline cache
+      */
+     GenefxPipeline           pipelines[GENEFX_PIPELINE_CACHE_SIZE];
+     int                      num_pipelines;
+     int                      next_pipeline;     /* entry replaced next */
+     unsigned int             pipeline_hits;
+     unsigned int             pipeline_misses;
 };
 
 /**********************************************************************************************************************/
@@ -155,6 +308,8 @@ void gGetDriverInfo( GraphicsDriverInfo  *driver_info );
 
 void gGetDeviceInfo( GraphicsDeviceInfo  *device_info );
 
+void gShutdown     ( void );
+
 bool gAcquire      ( CardState           *state,
                      DFBAccelerationMask  accel );
 
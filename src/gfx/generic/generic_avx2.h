@@ -0,0 +1,351 @@
+/*
+   This file is part of DirectFB.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+*/
+
+#include <immintrin.h>
+
+/*
+ * The AVX2 functions process four accumulators per register, remaining accumulators are handled using the SSE2
+ * helpers from "generic_sse2.h" which must be included before.
+ */
+
+#define AVX2_FUNC __attribute__((target("avx2")))
+
+/**********************************************************************************************************************/
+
+static inline AVX2_FUNC __m256i
+acc_mul8_AVX2( __m256i a, __m256i f )
+{
+     __m256i lo = _mm256_mullo_epi16( a, f );
+     __m256i hi = _mm256_mulhi_epu16( a, f );
+
+     return _mm256_or_si256( _mm256_srli_epi16( lo, 8 ), _mm256_slli_epi16( hi, 8 ) );
+}
+
+static inline AVX2_FUNC __m256i
+acc_alpha_AVX2( __m256i a )
+{
+     return _mm256_shufflehi_epi16( _mm256_shufflelo_epi16( a, 0xff ), 0xff );
+}
+
+static inline AVX2_FUNC __m256i
+acc_keep_AVX2( __m256i a )
+{
+     return acc_alpha_AVX2( _mm256_cmpeq_epi16( _mm256_and_si256( a, _mm256_set1_epi16( 0xf000 ) ),
+                                                _mm256_setzero_si256() ) );
+}
+
+static inline AVX2_FUNC __m256i
+acc_clamp_AVX2( __m256i a )
+{
+     __m256i fit = _mm256_cmpeq_epi16( _mm256_and_si256( a, _mm256_set1_epi16( 0xff00 ) ), _mm256_setzero_si256() );
+
+     return _mm256_blendv_epi8( _mm256_set1_epi16( 0x00ff ), a, fit );
+}
+
+/**********************************************************************************************************************/
+
+static inline AVX2_FUNC __m256i
+Xacc_blend_alpha_AVX2( __m256i y, __m256i f )
+{
+     return _mm256_blendv_epi8( y, acc_mul8_AVX2( y, f ), acc_keep_AVX2( y ) );
+}
+
+static AVX2_FUNC void
+Xacc_blend_srcalpha_AVX2( GenefxState *gfxs )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *X = gfxs->Xacc;
+     GenefxAccumulator *Y = gfxs->Yacc;
+
+     if (gfxs->Sacc) {
+          GenefxAccumulator *S = gfxs->Sacc;
+
+          for (; w > 3; w -= 4) {
+               __m256i f = _mm256_add_epi16( acc_alpha_AVX2( _mm256_loadu_si256( (__m256i*) S ) ),
+                                             _mm256_set1_epi16( 1 ) );
+
+               _mm256_storeu_si256( (__m256i*) X, Xacc_blend_alpha_AVX2( _mm256_loadu_si256( (__m256i*) Y ), f ) );
+
+               S += 4;
+               X += 4; Y += 4;
+          }
+
+          for (; w; w--) {
+               __m128i f = _mm_add_epi16( acc_alpha_SSE2( _mm_loadl_epi64( (__m128i*) S ) ), _mm_set1_epi16( 1 ) );
+
+               _mm_storel_epi64( (__m128i*) X, Xacc_blend_alpha_SSE2( _mm_loadl_epi64( (__m128i*) Y ), f ) );
+
+               S++;
+               X++; Y++;
+          }
+     }
+     else {
+          __m256i f = _mm256_set1_epi16( gfxs->color.a + 1 );
+
+          for (; w > 3; w -= 4) {
+               _mm256_storeu_si256( (__m256i*) X, Xacc_blend_alpha_AVX2( _mm256_loadu_si256( (__m256i*) Y ), f ) );
+
+               X += 4; Y += 4;
+          }
+
+          for (; w; w--) {
+               _mm_storel_epi64( (__m128i*) X, Xacc_blend_alpha_SSE2( _mm_loadl_epi64( (__m128i*) Y ),
+                                                                      _mm256_castsi256_si128( f ) ) );
+
+               X++; Y++;
+          }
+     }
+}
+
+static AVX2_FUNC void
+Xacc_blend_invsrcalpha_AVX2( GenefxState *gfxs )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *X = gfxs->Xacc;
+     GenefxAccumulator *Y = gfxs->Yacc;
+
+     if (gfxs->Sacc) {
+          GenefxAccumulator *S = gfxs->Sacc;
+
+          for (; w > 3; w -= 4) {
+               __m256i f = _mm256_sub_epi16( _mm256_set1_epi16( 0x100 ),
+                                             acc_alpha_AVX2( _mm256_loadu_si256( (__m256i*) S ) ) );
+
+               _mm256_storeu_si256( (__m256i*) X, Xacc_blend_alpha_AVX2( _mm256_loadu_si256( (__m256i*) Y ), f ) );
+
+               S += 4;
+               X += 4; Y += 4;
+          }
+
+          for (; w; w--) {
+               __m128i f = _mm_sub_epi16( _mm_set1_epi16( 0x100 ), acc_alpha_SSE2( _mm_loadl_epi64( (__m128i*) S ) ) );
+
+               _mm_storel_epi64( (__m128i*) X, Xacc_blend_alpha_SSE2( _mm_loadl_epi64( (__m128i*) Y ), f ) );
+
+               S++;
+               X++; Y++;
+          }
+     }
+     else {
+          __m256i f = _mm256_set1_epi16( 0x100 - gfxs->color.a );
+
+          for (; w > 3; w -= 4) {
+               _mm256_storeu_si256( (__m256i*) X, Xacc_blend_alpha_AVX2( _mm256_loadu_si256( (__m256i*) Y ), f ) );
+
+               X += 4; Y += 4;
+          }
+
+          for (; w; w--) {
+               _mm_storel_epi64( (__m128i*) X, Xacc_blend_alpha_SSE2( _mm_loadl_epi64( (__m128i*) Y ),
+                                                                      _mm256_castsi256_si128( f ) ) );
+
+               X++; Y++;
+          }
+     }
+}
+
+/**********************************************************************************************************************/
+
+static AVX2_FUNC void
+Dacc_modulate_argb_AVX2( GenefxState *gfxs )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *D = gfxs->Dacc;
+     __m256i            C = _mm256_broadcastq_epi64( _mm_loadl_epi64( (__m128i*) &gfxs->Cacc ) );
+
+     for (; w > 3; w -= 4) {
+          _mm256_storeu_si256( (__m256i*) D, Xacc_blend_alpha_AVX2( _mm256_loadu_si256( (__m256i*) D ), C ) );
+
+          D += 4;
+     }
+
+     for (; w; w--) {
+          _mm_storel_epi64( (__m128i*) D, Xacc_blend_alpha_SSE2( _mm_loadl_epi64( (__m128i*) D ),
+                                                                 _mm256_castsi256_si128( C ) ) );
+
+          D++;
+     }
+}
+
+/**********************************************************************************************************************/
+
+static inline AVX2_FUNC __m256i
+Dacc_add_AVX2( __m256i d, __m256i s )
+{
+     return _mm256_blendv_epi8( d, _mm256_add_epi16( d, s ), acc_keep_AVX2( d ) );
+}
+
+static AVX2_FUNC void
+SCacc_add_to_Dacc_AVX2( GenefxState *gfxs )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *D = gfxs->Dacc;
+     __m256i            S = _mm256_broadcastq_epi64( _mm_loadl_epi64( (__m128i*) &gfxs->SCacc ) );
+
+     for (; w > 3; w -= 4) {
+          _mm256_storeu_si256( (__m256i*) D, Dacc_add_AVX2( _mm256_loadu_si256( (__m256i*) D ), S ) );
+
+          D += 4;
+     }
+
+     for (; w; w--) {
+          _mm_storel_epi64( (__m128i*) D, Dacc_add_SSE2( _mm_loadl_epi64( (__m128i*) D ),
+                                                         _mm256_castsi256_si128( S ) ) );
+
+          D++;
+     }
+}
+
+static AVX2_FUNC void
+Sacc_add_to_Dacc_AVX2( GenefxState *gfxs )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *S = gfxs->Sacc;
+     GenefxAccumulator *D = gfxs->Dacc;
+
+     for (; w > 3; w -= 4) {
+          _mm256_storeu_si256( (__m256i*) D, Dacc_add_AVX2( _mm256_loadu_si256( (__m256i*) D ),
+                                                            _mm256_loadu_si256( (__m256i*) S ) ) );
+
+          S += 4;
+          D += 4;
+     }
+
+     for (; w; w--) {
+          _mm_storel_epi64( (__m128i*) D, Dacc_add_SSE2( _mm_loadl_epi64( (__m128i*) D ),
+                                                         _mm_loadl_epi64( (__m128i*) S ) ) );
+
+          S++;
+          D++;
+     }
+}
+
+/**********************************************************************************************************************/
+
+static inline AVX2_FUNC void
+Sop_32_to_Dacc_AVX2( GenefxState *gfxs,
+                     u32          alpha )
+{
+     int                w = gfxs->length;
+     u32               *S = gfxs->Sop[0];
+     GenefxAccumulator *D = gfxs->Dacc;
+     __m128i            A = _mm_set1_epi32( alpha );
+
+     for (; w > 3; w -= 4) {
+          __m128i s = _mm_or_si128( _mm_loadu_si128( (__m128i*) S ), A );
+
+          _mm256_storeu_si256( (__m256i*) D, _mm256_cvtepu8_epi16( s ) );
+
+          S += 4;
+          D += 4;
+     }
+
+     for (; w; w--) {
+          _mm_storel_epi64( (__m128i*) D, _mm_unpacklo_epi8( _mm_cvtsi32_si128( *S | alpha ), _mm_setzero_si128() ) );
+
+          S++;
+          D++;
+     }
+}
+
+static AVX2_FUNC void
+Sop_argb_to_Dacc_AVX2( GenefxState *gfxs )
+{
+     if (gfxs->Ostep != 1)
+          Sop_argb_to_Dacc( gfxs );
+     else
+          Sop_32_to_Dacc_AVX2( gfxs, 0 );
+}
+
+static AVX2_FUNC void
+Sop_rgb32_to_Dacc_AVX2( GenefxState *gfxs )
+{
+     if (gfxs->Ostep != 1)
+          Sop_rgb32_to_Dacc( gfxs );
+     else
+          Sop_32_to_Dacc_AVX2( gfxs, 0xff000000 );
+}
+
+/**********************************************************************************************************************/
+
+static inline AVX2_FUNC void
+Sacc_to_Aop_32_AVX2( GenefxState *gfxs,
+                     u32          alpha )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *S = gfxs->Sacc;
+     u32               *D = gfxs->Aop[0];
+     __m256i            A = _mm256_set1_epi32( alpha );
+
+     for (; w > 7; w -= 8) {
+          __m256i s0   = _mm256_loadu_si256( (__m256i*) S );
+          __m256i s1   = _mm256_loadu_si256( (__m256i*) (S + 4) );
+          __m256i keep = _mm256_packs_epi16( acc_keep_AVX2( s0 ), acc_keep_AVX2( s1 ) );
+          __m256i p    = _mm256_packus_epi16( acc_clamp_AVX2( s0 ), acc_clamp_AVX2( s1 ) );
+
+          /* packing works within 128 bit lanes, restore the pixel order */
+          keep = _mm256_permute4x64_epi64( keep, 0xd8 );
+          p    = _mm256_permute4x64_epi64( _mm256_or_si256( p, A ), 0xd8 );
+
+          _mm256_storeu_si256( (__m256i*) D, _mm256_blendv_epi8( _mm256_loadu_si256( (__m256i*) D ), p, keep ) );
+
+          S += 8;
+          D += 8;
+     }
+
+     for (; w > 3; w -= 4) {
+          __m128i keep;
+          __m128i p = _mm_or_si128( Sacc_pack_SSE2( S, &keep ), _mm256_castsi256_si128( A ) );
+
+          _mm_storeu_si128( (__m128i*) D, acc_select_SSE2( keep, p, _mm_loadu_si128( (__m128i*) D ) ) );
+
+          S += 4;
+          D += 4;
+     }
+
+     for (; w; w--) {
+          if (!(S->RGB.a & 0xf000))
+               *D = PIXEL_ARGB( (S->RGB.a & 0xff00) ? 0xff : S->RGB.a,
+                                (S->RGB.r & 0xff00) ? 0xff : S->RGB.r,
+                                (S->RGB.g & 0xff00) ? 0xff : S->RGB.g,
+                                (S->RGB.b & 0xff00) ? 0xff : S->RGB.b ) | alpha;
+
+          ++S;
+          ++D;
+     }
+}
+
+static AVX2_FUNC void
+Sacc_to_Aop_argb_AVX2( GenefxState *gfxs )
+{
+     if (gfxs->Astep != 1)
+          Sacc_to_Aop_argb( gfxs );
+     else
+          Sacc_to_Aop_32_AVX2( gfxs, 0 );
+}
+
+static AVX2_FUNC void
+Sacc_to_Aop_rgb32_AVX2( GenefxState *gfxs )
+{
+     if (gfxs->Astep != 1)
+          Sacc_to_Aop_rgb32( gfxs );
+     else
+          Sacc_to_Aop_32_AVX2( gfxs, 0xff000000 );
+}
+
+#undef AVX2_FUNC
@@ -0,0 +1,468 @@
+/*
+   This file is part of DirectFB.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+*/
+
+#include <core/state.h>
+#include <direct/memcpy.h>
+#include <direct/thread.h>
+#include <gfx/generic/generic.h>
+#include <gfx/generic/generic_bands.h>
+#include <gfx/generic/generic_blit.h>
+#include <gfx/generic/generic_fill_rectangle.h>
+#include <gfx/generic/generic_scale.h>
+#include <gfx/generic/generic_stretch_blit.h>
+#include <gfx/generic/generic_texture_triangles.h>
+#include <gfx/util.h>
+#include <misc/conf.h>
+#include <stddef.h>
+
+D_DEBUG_DOMAIN( Genefx_Bands, "Genefx/Bands", "Genefx Band Rendering" );
+
+/**********************************************************************************************************************/
+
+#define GENEFX_BANDS_MAX         16           /* maximum number of bands (and threads) */
+#define GENEFX_BANDS_MIN_HEIGHT  16           /* minimum height of a band */
+#define GENEFX_BANDS_MIN_PIXELS  (256 * 256)  /* minimum size of an operation being split */
+
+typedef enum {
+     GBO_FILLRECTANGLE,
+     GBO_BLIT,
+     GBO_STRETCHBLIT,
+     GBO_TEXTURE_TRIANGLES
+} GenefxBandOp;
+
+typedef struct {
+     CardState    state;  /* copy of the state, clipped to the band */
+     GenefxState  gfxs;   /* copy of the operation's part of the Genefx state, with accumulators of the band */
+
+     DFBRectangle rect;
+     DFBRectangle drect;
+     int          dx;
+     int          dy;
+} GenefxBand;
+
+static DirectMutex               bands_lock = DIRECT_MUTEX_INITIALIZER();  /* serializes split operations */
+static GenefxBand                bands[GENEFX_BANDS_MAX];
+static GenefxBandOp              bands_op;
+static const GenefxTriangleBins *bands_bins;                               /* triangles of GBO_TEXTURE_TRIANGLES */
+
+static DirectMutex      pool_lock = DIRECT_MUTEX_INITIALIZER();   /* protects the following */
+static bool             pool_inited;
+static DirectWaitQueue  pool_work;
+static DirectWaitQueue  pool_idle;
+static DirectThread    *pool_threads[GENEFX_BANDS_MAX];
+static int              pool_num_threads;
+static int              pool_num_bands;
+static int              pool_next;
+static int              pool_done;
+static bool             pool_quit;
+
+/**********************************************************************************************************************/
+
+static void
+band_render( GenefxBand *band )
+{
+     switch (bands_op) {
+          case GBO_FILLRECTANGLE:
+               gFillRectangle( &band->state, &band->rect );
+               break;
+
+          case GBO_BLIT:
+               gBlit( &band->state, &band->rect, band->dx, band->dy );
+               break;
+
+          case GBO_STRETCHBLIT:
+               gStretchBlit( &band->state, &band->rect, &band->drect );
+               break;
+
+          case GBO_TEXTURE_TRIANGLES:
+               Genefx_TextureTriangleBins_Render( &band->state, bands_bins, &band->state.clip );
+               break;
+     }
+}
+
+static void *
+band_worker( DirectThread *thread,
+             void         *arg )
+{
+     direct_mutex_lock( &pool_lock );
+
+     while (true) {
+          int index;
+
+          while (pool_next >= pool_num_bands && !pool_quit)
+               direct_waitqueue_wait( &pool_work, &pool_lock );
+
+          if (pool_next >= pool_num_bands)
+               break;
+
+          index = pool_next++;
+
+          direct_mutex_unlock( &pool_lock );
+
+          band_render( &bands[index] );
+
+          direct_mutex_lock( &pool_lock );
+
+          if (++pool_done == pool_num_bands)
+               direct_waitqueue_broadcast( &pool_idle );
+     }
+
+     direct_mutex_unlock( &pool_lock );
+
+     return NULL;
+}
+
+/*
+ * Start the worker threads needed for the number of bands, the calling thread renders a band itself.
+ */
+static int
+bands_prepare_pool( int num )
+{
+     direct_mutex_lock( &pool_lock );
+
+     if (!pool_inited) {
+          direct_waitqueue_init( &pool_work );
+          direct_waitqueue_init( &pool_idle );
+
+          pool_inited = true;
+     }
+
+     while (pool_num_threads < num - 1) {
+          DirectThread *thread = direct_thread_create( DTT_DEFAULT, band_worker, NULL, "Genefx Band" );
+
+          if (!thread)
+               break;
+
+          pool_threads[pool_num_threads++] = thread;
+     }
+
+     num = MIN( num, pool_num_threads + 1 );
+
+     direct_mutex_unlock( &pool_lock );
+
+     return num;
+}
+
+/*
+ * Render all bands, participating with the calling thread, and wait for the workers to finish.
+ */
+static void
+bands_run( int num )
+{
+     direct_mutex_lock( &pool_lock );
+
+     pool_num_bands = num;
+     pool_next      = 0;
+     pool_done      = 0;
+
+     direct_waitqueue_broadcast( &pool_work );
+
+     while (pool_next < pool_num_bands) {
+          int index = pool_next++;
+
+          direct_mutex_unlock( &pool_lock );
+
+          band_render( &bands[index] );
+
+          direct_mutex_lock( &pool_lock );
+
+          pool_done++;
+     }
+
+     while (pool_done < pool_num_bands)
+          direct_waitqueue_wait( &pool_idle, &pool_lock );
+
+     pool_num_bands = 0;
+     pool_next      = 0;
+
+     direct_mutex_unlock( &pool_lock );
+}
+
+/*
+ * Set up the copies of the state for the bands covering the destination area.
+ */
+static void
+bands_setup( CardState       *state,
+             const DFBRegion *area,
+             int              num )
+{
+     int i;
+     int y = area->y1;
+     int h = area->y2 - area->y1 + 1;
+
+     for (i = 0; i < num; i++) {
+          GenefxBand  *band = &bands[i];
+          GenefxState *gfxs = state->gfxs;
+          int          y1, y2;
+
+          /* Split at even lines for formats with vertically subsampled chroma. */
+          y1 = (i == 0)       ? y        : ((y + h * i / num) & ~1);
+          y2 = (i == num - 1) ? area->y2 : ((y + h * (i + 1) / num) & ~1) - 1;
+
+          /* Copy the pipeline and operands, keeping the accumulators of the band, without the pipeline cache. */
+          direct_memcpy( &band->gfxs, gfxs, offsetof(GenefxState, ABstart) );
+
+          band->gfxs.band = true;
+
+          if (gfxs->Sop == gfxs->Aop)
+               band->gfxs.Sop = band->gfxs.Aop;
+          else if (gfxs->Sop == gfxs->Bop)
+               band->gfxs.Sop = band->gfxs.Bop;
+
+          band->state = *state;
+
+          band->state.gfxs    = &band->gfxs;
+          band->state.clip.y1 = MAX( state->clip.y1, y1 );
+          band->state.clip.y2 = MIN( state->clip.y2, y2 );
+
+          band->rect.y = y1;
+          band->rect.h = y2 - y1 + 1;
+     }
+}
+
+/*
+ * Determine the number of bands for the destination area, zero if the operation is not split.
+ */
+static int
+bands_count( CardState       *state,
+             const DFBRegion *area )
+{
+     int num;
+     int w = area->x2 - area->x1 + 1;
+     int h = area->y2 - area->y1 + 1;
+
+     if (dfb_config->genefx_threads < 2 || state->gfxs->band)
+          return 0;
+
+     if (w * h < GENEFX_BANDS_MIN_PIXELS)
+          return 0;
+
+     num = MIN( MIN( dfb_config->genefx_threads, GENEFX_BANDS_MAX ), h / GENEFX_BANDS_MIN_HEIGHT );
+     if (num < 2)
+          return 0;
+
+     return bands_prepare_pool( num );
+}
+
+/**********************************************************************************************************************/
+
+void
+Genefx_Bands_Shutdown()
+{
+     int i;
+
+     D_DEBUG_AT( Genefx_Bands, "%s()\n", __FUNCTION__ );
+
+     direct_mutex_lock( &pool_lock );
+
+     if (!pool_inited) {
+          direct_mutex_unlock( &pool_lock );
+          return;
+     }
+
+     pool_quit = true;
+
+     direct_waitqueue_broadcast( &pool_work );
+
+     direct_mutex_unlock( &pool_lock );
+
+     for (i = 0; i < pool_num_threads; i++) {
+          direct_thread_join( pool_threads[i] );
+          direct_thread_destroy( pool_threads[i] );
+
+          pool_threads[i] = NULL;
+     }
+
+     pool_num_threads = 0;
+     pool_quit        = false;
+     pool_inited      = false;
+
+     direct_waitqueue_deinit( &pool_idle );
+     direct_waitqueue_deinit( &pool_work );
+
+     for (i = 0; i < GENEFX_BANDS_MAX; i++) {
+          GenefxState *gfxs = &bands[i].gfxs;
+
+          if (gfxs->ABstart)
+               D_FREE( gfxs->ABstart );
+
+          if (gfxs->Kstart)
+               D_FREE( gfxs->Kstart );
+
+          Genefx_Scale_Flush( gfxs );
+
+          memset( gfxs, 0, sizeof(GenefxState) );
+     }
+}
+
+bool
+Genefx_Bands_FillRectangle( CardState    *state,
+                            DFBRectangle *rect )
+{
+     int       i, num;
+     DFBRegion area = DFB_REGION_INIT_FROM_RECTANGLE( rect );
+
+     num = bands_count( state, &area );
+     if (num < 2)
+          return false;
+
+     D_DEBUG_AT( Genefx_Bands, "%s( %4d,%4d-%4dx%4d ) <- %d bands\n", __FUNCTION__, DFB_RECTANGLE_VALS( rect ), num );
+
+     direct_mutex_lock( &bands_lock );
+
+     bands_op = GBO_FILLRECTANGLE;
+
+     bands_setup( state, &area, num );
+
+     for (i = 0; i < num; i++) {
+          bands[i].rect.x = rect->x;
+          bands[i].rect.w = rect->w;
+     }
+
+     bands_run( num );
+
+     direct_mutex_unlock( &bands_lock );
+
+     return true;
+}
+
+bool
+Genefx_Bands_Blit( CardState    *state,
+                   DFBRectangle *rect,
+                   int           dx,
+                   int           dy )
+{
+     int                      i, num;
+     DFBRegion                area = { dx, dy, dx + rect->w - 1, dy + rect->h - 1 };
+     GenefxState             *gfxs = state->gfxs;
+     DFBSurfaceBlittingFlags  flags = state->blittingflags;
+
+     dfb_simplify_blittingflags( &flags );
+
+     /* Bands of rotated or flipped blits don't map to bands of the source. */
+     if (flags & (DSBLIT_FLIP_HORIZONTAL | DSBLIT_FLIP_VERTICAL | DSBLIT_ROTATE90 |
+                  DSBLIT_SRC_MASK_ALPHA | DSBLIT_SRC_MASK_COLOR))
+          return false;
+
+     /* Overlapping blits within a buffer depend on the order of lines. */
+     if (gfxs->src_org[0] == gfxs->dst_org[0])
+          return false;
+
+     num = bands_count( state, &area );
+     if (num < 2)
+          return false;
+
+     D_DEBUG_AT( Genefx_Bands, "%s( %4d,%4d-%4dx%4d -> %4d,%4d ) <- %d bands\n", __FUNCTION__,
+                 DFB_RECTANGLE_VALS( rect ), dx, dy, num );
+
+     direct_mutex_lock( &bands_lock );
+
+     bands_op = GBO_BLIT;
+
+     bands_setup( state, &area, num );
+
+     for (i = 0; i < num; i++) {
+          bands[i].dx     = dx;
+          bands[i].dy     = bands[i].rect.y;
+          bands[i].rect.x = rect->x;
+          bands[i].rect.y = rect->y + bands[i].dy - dy;
+          bands[i].rect.w = rect->w;
+     }
+
+     bands_run( num );
+
+     direct_mutex_unlock( &bands_lock );
+
+     return true;
+}
+
+bool
+Genefx_Bands_StretchBlit( CardState    *state,
+                          DFBRectangle *srect,
+                          DFBRectangle *drect )
+{
+     int           i, num;
+     DFBRegion     area = DFB_REGION_INIT_FROM_RECTANGLE( drect );
+     GenefxState  *gfxs = state->gfxs;
+
+     /* Overlapping blits within a buffer depend on the order of lines. */
+     if (gfxs->src_org[0] == gfxs->dst_org[0])
+          return false;
+
+     if (!dfb_region_region_intersect( &area, &state->clip ))
+          return false;
+
+     num = bands_count( state, &area );
+     if (num < 2)
+          return false;
+
+     D_DEBUG_AT( Genefx_Bands, "%s( %4d,%4d-%4dx%4d <- %4d,%4d-%4dx%4d ) <- %d bands\n", __FUNCTION__,
+                 DFB_RECTANGLE_VALS( drect ), DFB_RECTANGLE_VALS( srect ), num );
+
+     direct_mutex_lock( &bands_lock );
+
+     bands_op = GBO_STRETCHBLIT;
+
+     /* Each band scales the whole rectangle, clipped to the band. */
+     bands_setup( state, &area, num );
+
+     for (i = 0; i < num; i++) {
+          bands[i].rect  = *srect;
+          bands[i].drect = *drect;
+     }
+
+     bands_run( num );
+
+     direct_mutex_unlock( &bands_lock );
+
+     return true;
+}
+
+bool
+Genefx_Bands_TextureTriangles( CardState                *state,
+                               const GenefxTriangleBins *bins )
+{
+     int           num;
+     DFBRegion     area = bins->area;
+     GenefxState  *gfxs = state->gfxs;
+
+     /* Texture lookups may read any part of the destination being written by other bands. */
+     if (gfxs->src_org[0] == gfxs->dst_org[0])
+          return false;
+
+     num = bands_count( state, &area );
+     if (num < 2)
+          return false;
+
+     D_DEBUG_AT( Genefx_Bands, "%s( %4d,%4d-%4d,%4d ) <- %d bands\n", __FUNCTION__, DFB_REGION_VALS( &area ), num );
+
+     direct_mutex_lock( &bands_lock );
+
+     bands_op   = GBO_TEXTURE_TRIANGLES;
+     bands_bins = bins;
+
+     bands_setup( state, &area, num );
+
+     bands_run( num );
+
+     bands_bins = NULL;
+
+     direct_mutex_unlock( &bands_lock );
+
+     return true;
+}
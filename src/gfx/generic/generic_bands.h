@@ -0,0 +1,53 @@
+/*
+   This file is part of DirectFB.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+*/
+
+#ifndef __GENERIC_BANDS_H__
+#define __GENERIC_BANDS_H__
+
+#include <core/coretypes.h>
+#include <gfx/generic/generic_texture_triangles.h>
+
+/**********************************************************************************************************************/
+
+/*
+ * The following functions split an operation into horizontal bands of the destination, which are rendered in parallel
+ * by the calling thread and the workers enabled with 'genefx-threads'. Each band uses its own copy of the Genefx
+ * state. They return once all bands are done, or return false without rendering if the operation is not split.
+ */
+
+bool Genefx_Bands_FillRectangle( CardState    *state,
+                                 DFBRectangle *rect );
+
+bool Genefx_Bands_Blit         ( CardState    *state,
+                                 DFBRectangle *rect,
+                                 int           dx,
+                                 int           dy );
+
+bool Genefx_Bands_StretchBlit  ( CardState    *state,
+                                 DFBRectangle *srect,
+                                 DFBRectangle *drect );
+
+bool Genefx_Bands_TextureTriangles( CardState                *state,
+                                    const GenefxTriangleBins *bins );
+
+/*
+ * Stop the worker threads and free the accumulators of the bands.
+ */
+void Genefx_Bands_Shutdown( void );
+
+#endif
@@ -17,8 +17,12 @@
 */
 
 #include <core/state.h>
+#include <direct/memcpy.h>
+#include <gfx/clip.h>
 #include <gfx/generic/generic.h>
+#include <gfx/generic/generic_bands.h>
 #include <gfx/generic/generic_blit.h>
+#include <gfx/generic/generic_rotate.h>
 #include <gfx/generic/generic_util.h>
 #include <gfx/util.h>
 
@@ -72,8 +76,14 @@ gBlit( CardState    *state,
      D_ASSERT( !(rotflip_blittingflags & DSBLIT_ROTATE90) || state->clip.x2 >= (dx + rect->h - 1) );
      D_ASSERT( !(rotflip_blittingflags & DSBLIT_ROTATE90) || state->clip.y2 >= (dy + rect->w - 1) );
 
+     if (Genefx_Bands_Blit( state, rect, dx, dy ))
+          return;
+
      CHECK_PIPELINE();
 
+     if ((rotflip_blittingflags & DSBLIT_ROTATE90) && Genefx_Rotate( state, rect, dx, dy ))
+          return;
+
      if (!Genefx_ABacc_prepare( gfxs, rect->w ))
           return;
 
@@ -99,7 +109,8 @@ gBlit( CardState    *state,
 
      gfxs->length = rect->w;
 
-     if (gfxs->src_org[0] == gfxs->dst_org[0] && dy == rect->y && dx > rect->x)
+     /* Lines of the source are read as a whole for the convolution. */
+     if (gfxs->src_org[0] == gfxs->dst_org[0] && dy == rect->y && dx > rect->x && !gfxs->Kfuncs[0])
           /* We must blit from right to left. */
           gfxs->Astep = gfxs->Bstep = -1;
      else
@@ -353,3 +364,109 @@ gBlit( CardState    *state,
 
      Genefx_ABacc_flush( gfxs );
 }
+
+/**********************************************************************************************************************/
+
+static void
+copy_area( GenefxState *gfxs,
+           int          x,
+           int          y,
+           int          w,
+           int          h,
+           int          dx,
+           int          dy )
+{
+     int   bytes = DFB_BYTES_PER_LINE( gfxs->dst_format, w );
+     void *src;
+
+     for (; h; h--) {
+          Genefx_Aop_xy( gfxs, x, y++ );
+          src = gfxs->Aop[0];
+
+          Genefx_Aop_xy( gfxs, dx, dy++ );
+
+          direct_memcpy( gfxs->Aop[0], src, bytes );
+     }
+}
+
+bool
+gTileBlit( CardState          *state,
+           const DFBRectangle *rect,
+           int                 dx1,
+           int                 dy1,
+           int                 dx2,
+           int                 dy2 )
+{
+     GenefxState  *gfxs;
+     DFBRegion     area;
+     DFBRegion     cell;
+     DFBRectangle  srect;
+     int           x, y;
+     int           w, h;
+
+     D_ASSERT( state != NULL );
+     D_ASSERT( state->gfxs != NULL );
+     D_ASSERT( rect != NULL );
+     D_ASSERT( rect->w >= 1 );
+     D_ASSERT( rect->h >= 1 );
+
+     gfxs = state->gfxs;
+
+     /* The tiles must not depend on the destination or on their position, nor be read from the destination. */
+     if (state->blittingflags & ~(DSBLIT_COLORIZE | DSBLIT_SRC_PREMULTIPLY | DSBLIT_SRC_PREMULTCOLOR |
+                                  DSBLIT_INDEX_TRANSLATION))
+          return false;
+
+     if (state->source == state->destination || !gfxs->funcs[0])
+          return false;
+
+     /* Whole pixels are copied within the destination. */
+     if (DFB_PLANAR_PIXELFORMAT( gfxs->dst_format ) || !DFB_BYTES_PER_PIXEL( gfxs->dst_format ) ||
+         DFB_PIXELFORMAT_ALIGNMENT( gfxs->dst_format ))
+          return false;
+
+     if (dx1 >= dx2 || dy1 >= dy2)
+          return true;
+
+     /* Area covered by the tiles. */
+     area.x1 = dx1;
+     area.y1 = dy1;
+     area.x2 = dx1 + (dx2 - dx1 + rect->w - 1) / rect->w * rect->w - 1;
+     area.y2 = dy1 + (dy2 - dy1 + rect->h - 1) / rect->h * rect->h - 1;
+
+     if (!dfb_region_region_intersect( &area, &state->clip ))
+          return true;
+
+     /* First cell of the area with the size of a tile, consisting of up to four partial tiles. */
+     cell.x1 = area.x1;
+     cell.y1 = area.y1;
+     cell.x2 = MIN( area.x2, area.x1 + rect->w - 1 );
+     cell.y2 = MIN( area.y2, area.y1 + rect->h - 1 );
+
+     for (y = dy1 + (cell.y1 - dy1) / rect->h * rect->h; y <= cell.y2; y += rect->h) {
+          for (x = dx1 + (cell.x1 - dx1) / rect->w * rect->w; x <= cell.x2; x += rect->w) {
+               int tx = x;
+               int ty = y;
+
+               srect = *rect;
+
+               dfb_clip_blit( &cell, &srect, &tx, &ty );
+
+               gBlit( state, &srect, tx, ty );
+          }
+     }
+
+     /* Fill the first row of the area by copying the filled part with doubling widths, tiles of one pixel width
+        included, as the offsets are multiples of the tile width. */
+     for (w = cell.x2 - cell.x1 + 1; area.x1 + w <= area.x2; w *= 2)
+          copy_area( gfxs, area.x1, cell.y1, MIN( w, area.x2 - area.x1 - w + 1 ), cell.y2 - cell.y1 + 1,
+                     area.x1 + w, cell.y1 );
+
+     /* Fill the rest of the area by copying the filled rows with doubling heights, tiles of one pixel height
+        included, as the offsets are multiples of the tile height. */
+     for (h = cell.y2 - cell.y1 + 1; area.y1 + h <= area.y2; h *= 2)
+          copy_area( gfxs, area.x1, area.y1, area.x2 - area.x1 + 1, MIN( h, area.y2 - area.y1 - h + 1 ),
+                     area.x1, area.y1 + h );
+
+     return true;
+}
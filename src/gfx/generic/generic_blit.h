@@ -23,9 +23,21 @@
 
 /**********************************************************************************************************************/
 
-void gBlit( CardState    *state,
-            DFBRectangle *rect,
-            int           dx,
-            int           dy );
+void gBlit    ( CardState          *state,
+                DFBRectangle       *rect,
+                int                 dx,
+                int                 dy );
+
+/*
+ * Blit the tiles starting at (dx1,dy1) left of dx2 and above dy2 by blitting the tiles of the first cell only and
+ * copying the filled area of the destination with doubling sizes. Returns false without blitting if the blitting flags
+ * or the destination format do not allow this.
+ */
+bool gTileBlit( CardState          *state,
+                const DFBRectangle *rect,
+                int                 dx1,
+                int                 dy1,
+                int                 dx2,
+                int                 dy2 );
 
 #endif
@@ -16,10 +16,221 @@
    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
 */
 
+#include <config.h>
 #include <core/state.h>
 #include <gfx/generic/generic.h>
+#include <gfx/generic/generic_bands.h>
 #include <gfx/generic/generic_fill_rectangle.h>
 #include <gfx/generic/generic_util.h>
+#include <misc/conf.h>
+
+#ifdef USE_SSE2
+#include <emmintrin.h>
+#endif
+
+D_DEBUG_DOMAIN( Genefx_Fill, "Genefx/Fill", "Genefx Solid Fill" );
+
+/**********************************************************************************************************************/
+
+static void
+fill_pixels( u8  *D,
+             u64  pattern,
+             int  bpp,
+             int  len )
+{
+     switch (bpp) {
+          case 1:
+               while (len--)
+                    *D++ = pattern;
+               break;
+
+          case 2:
+               for (; len > 0; len -= 2, D += 2)
+                    *(u16*) D = pattern;
+               break;
+
+          default:
+               for (; len > 0; len -= 4, D += 4)
+                    *(u32*) D = pattern;
+               break;
+     }
+}
+
+/*
+ * Fill 'len' bytes with the pattern of identical pixels, using aligned 64 bit stores for the bulk.
+ */
+static void
+fill_span( u8  *D,
+           u64  pattern,
+           int  bpp,
+           int  len )
+{
+     int  head = (-(unsigned long) D) & 7;
+     u64 *D64;
+     int  l;
+
+     if (head > len)
+          head = len;
+
+     fill_pixels( D, pattern, bpp, head );
+
+     D   += head;
+     len -= head;
+
+     D64 = (u64*) D;
+
+     for (l = len >> 5; l; l--) {
+          D64[0] = pattern;
+          D64[1] = pattern;
+          D64[2] = pattern;
+          D64[3] = pattern;
+
+          D64 += 4;
+     }
+
+     for (l = (len & 31) >> 3; l; l--)
+          *D64++ = pattern;
+
+     fill_pixels( (u8*) D64, pattern, bpp, len & 7 );
+}
+
+#ifdef USE_SSE2
+
+#define SSE2_FUNC __attribute__((target("sse2")))
+
+/*
+ * Fill 'len' bytes bypassing the cache, to not evict the working set when filling large surfaces.
+ */
+static void SSE2_FUNC
+fill_span_stream_SSE2( u8  *D,
+                       u64  pattern,
+                       int  bpp,
+                       int  len )
+{
+     int      head = (-(unsigned long) D) & 15;
+     __m128i  P    = _mm_set1_epi64x( pattern );
+     __m128i *D128;
+     int      l;
+
+     if (head > len)
+          head = len;
+
+     fill_pixels( D, pattern, bpp, head );
+
+     D   += head;
+     len -= head;
+
+     D128 = (__m128i*) D;
+
+     for (l = len >> 6; l; l--) {
+          _mm_stream_si128( D128 + 0, P );
+          _mm_stream_si128( D128 + 1, P );
+          _mm_stream_si128( D128 + 2, P );
+          _mm_stream_si128( D128 + 3, P );
+
+          D128 += 4;
+     }
+
+     for (l = (len & 63) >> 4; l; l--)
+          _mm_stream_si128( D128++, P );
+
+     fill_pixels( (u8*) D128, pattern, bpp, len & 15 );
+}
+
+static void SSE2_FUNC
+fill_stream_fence_SSE2( void )
+{
+     _mm_sfence();
+}
+
+static bool
+fill_use_stream( int size )
+{
+     static int use_sse2 = -1;
+
+     if (use_sse2 < 0)
+          use_sse2 = dfb_config->sse2 && __builtin_cpu_supports( "sse2" );
+
+     return use_sse2 && dfb_config->genefx_stream_size > 0 && size > dfb_config->genefx_stream_size;
+}
+
+#endif
+
+/*
+ * Fill the rectangle with Cop directly if the pipeline does nothing else, see 'fill_bpp'.
+ */
+static bool
+fill_solid( GenefxState  *gfxs,
+            DFBRectangle *rect )
+{
+     int  bpp   = gfxs->fill_bpp;
+     int  pitch = gfxs->dst_pitch;
+     int  len   = rect->w * bpp;
+     int  h     = rect->h;
+     u64  pattern;
+     u8  *D;
+
+     if (!bpp || (gfxs->dst_caps & DSCAPS_SEPARATED))
+          return false;
+
+     switch (bpp) {
+          case 1:
+               pattern = (gfxs->Cop & 0xff) * 0x0101010101010101ULL;
+               break;
+
+          case 2:
+               pattern = (gfxs->Cop & 0xffff) * 0x0001000100010001ULL;
+               break;
+
+          default:
+               pattern = gfxs->Cop * 0x0000000100000001ULL;
+               break;
+     }
+
+     D = gfxs->dst_org[0] + rect->y * pitch + rect->x * bpp;
+
+     /* Fill full lines as one span. */
+     if (len == pitch) {
+          len *= h;
+          h    = 1;
+     }
+
+     D_DEBUG_AT( Genefx_Fill, "%s( %4d,%4d-%4dx%4d ) <- %d bpp, pattern 0x%016llx\n", __FUNCTION__,
+                 DFB_RECTANGLE_VALS( rect ), bpp, (unsigned long long) pattern );
+
+#ifdef USE_SSE2
+     if (fill_use_stream( rect->w * rect->h * bpp )) {
+          while (h--) {
+               fill_span_stream_SSE2( D, pattern, bpp, len );
+
+               D += pitch;
+          }
+
+          fill_stream_fence_SSE2();
+
+          return true;
+     }
+#endif
+
+     /* All bytes being equal, e.g. when clearing to black. */
+     if (pattern == (pattern & 0xff) * 0x0101010101010101ULL) {
+          while (h--) {
+               memset( D, pattern, len );
+
+               D += pitch;
+          }
+
+          return true;
+     }
+
+     while (h--) {
+          fill_span( D, pattern, bpp, len );
+
+          D += pitch;
+     }
+
+     return true;
+}
 
 /**********************************************************************************************************************/
 
@@ -39,6 +250,9 @@ gFillRectangle( CardState    *state,
 
      gfxs = state->gfxs;
 
+     if (Genefx_Bands_FillRectangle( state, rect ))
+          return;
+
      if (dfb_config->software_warn) {
           D_WARN( "FillRectangle (%4d,%4d-%4dx%4d) %6s, flags 0x%08x, color 0x%02x%02x%02x%02x",
                   DFB_RECTANGLE_VALS( rect ), dfb_pixelformat_name( gfxs->dst_format ), state->drawingflags,
@@ -47,6 +261,9 @@ gFillRectangle( CardState    *state,
 
      CHECK_PIPELINE();
 
+     if (fill_solid( gfxs, rect ))
+          return;
+
      if (!Genefx_ABacc_prepare( gfxs, rect->w ))
           return;
 
@@ -0,0 +1,219 @@
+/*
+   This file is part of DirectFB.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+*/
+
+#include <config.h>
+#include <core/state.h>
+#include <core/surface.h>
+#include <gfx/clip.h>
+#include <gfx/generic/generic.h>
+#include <gfx/generic/generic_glyphs.h>
+#include <gfx/generic/generic_util.h>
+#include <gfx/util.h>
+
+D_DEBUG_DOMAIN( Genefx_Glyphs, "Genefx/Glyphs", "Genefx Glyph Runs" );
+
+/**********************************************************************************************************************/
+
+/*
+ * Glyphs are clipped and composited in chunks of this size, each one being complete before the next one.
+ */
+#define GLYPHS_CHUNK 64
+
+typedef struct {
+     int   x;                   /* destination */
+     int   y;
+     int   sx;                  /* source */
+     int   sy;
+     int   w;
+     int   h;
+
+     void *Aop;                 /* current line */
+     void *Bop;
+} GlyphSpan;
+
+/*
+ * Lines of each glyph are advanced by the pitch, for pixel formats with a single plane in surfaces without fields.
+ */
+static bool
+glyphs_supported( const GenefxState *gfxs )
+{
+     if (DFB_PLANAR_PIXELFORMAT( gfxs->src_format ) || DFB_PLANAR_PIXELFORMAT( gfxs->dst_format ))
+          return false;
+
+     if ((gfxs->src_caps | gfxs->dst_caps) & DSCAPS_SEPARATED)
+          return false;
+
+     switch (gfxs->src_format) {
+          case DSPF_A4:
+          case DSPF_YUY2:
+          case DSPF_UYVY:
+               return false;
+          default:
+               break;
+     }
+
+     switch (gfxs->dst_format) {
+          case DSPF_A4:
+          case DSPF_YUY2:
+          case DSPF_UYVY:
+               return false;
+          default:
+               break;
+     }
+
+     return true;
+}
+
+/*
+ * Glyphs are taken in the order of their top line, while the list of those crossing the current line keeps the order
+ * of the batch, which is the order of compositing overlapping glyphs.
+ */
+static void
+glyphs_render( GenefxState *gfxs,
+               GlyphSpan   *spans,
+               int          num )
+{
+     int i, j, y, y2, width = 0;
+     int next   = 0;
+     int active = 0;
+     u8  order[GLYPHS_CHUNK];
+     u8  list[GLYPHS_CHUNK];
+
+     y2 = spans[0].y + spans[0].h;
+
+     for (i = 0; i < num; i++) {
+          for (j = i; j > 0 && spans[order[j-1]].y > spans[i].y; j--)
+               order[j] = order[j-1];
+
+          order[j] = i;
+
+          y2    = MAX( y2, spans[i].y + spans[i].h );
+          width = MAX( width, spans[i].w );
+     }
+
+     if (!Genefx_ABacc_prepare( gfxs, width ))
+          return;
+
+     for (y = spans[order[0]].y; y < y2; y++) {
+          /* Remove glyphs ending above the line. */
+          for (i = 0, j = 0; i < active; i++) {
+               if (spans[list[i]].y + spans[list[i]].h > y)
+                    list[j++] = list[i];
+          }
+
+          active = j;
+
+          /* Insert glyphs starting at the line. */
+          for (; next < num && spans[order[next]].y == y; next++) {
+               GlyphSpan *span = &spans[order[next]];
+
+               Genefx_Aop_xy( gfxs, span->x, span->y );
+               Genefx_Bop_xy( gfxs, span->sx, span->sy );
+
+               span->Aop = gfxs->Aop[0];
+               span->Bop = gfxs->Bop[0];
+
+               for (j = active++; j > 0 && list[j-1] > order[next]; j--)
+                    list[j] = list[j-1];
+
+               list[j] = order[next];
+          }
+
+          for (i = 0; i < active; i++) {
+               GlyphSpan *span = &spans[list[i]];
+
+               gfxs->Aop[0] = span->Aop;
+               gfxs->Bop[0] = span->Bop;
+               gfxs->length = span->w;
+
+               RUN_PIPELINE();
+
+               span->Aop += gfxs->dst_pitch;
+               span->Bop += gfxs->src_pitch;
+          }
+     }
+
+     Genefx_ABacc_flush( gfxs );
+}
+
+bool
+Genefx_BlitGlyphs( CardState          *state,
+                   const DFBRectangle *rects,
+                   const DFBPoint     *points,
+                   int                 num )
+{
+     GenefxState             *gfxs;
+     DFBSurfaceBlittingFlags  flags;
+     GlyphSpan                spans[GLYPHS_CHUNK];
+     int                      i, n = 0;
+
+     D_ASSERT( state != NULL );
+     D_ASSERT( state->gfxs != NULL );
+     D_ASSERT( rects != NULL );
+     D_ASSERT( points != NULL );
+
+     gfxs = state->gfxs;
+
+     if (!(state->source->type & CSTF_FONT) || gfxs->src_org[0] == gfxs->dst_org[0] || !glyphs_supported( gfxs ))
+          return false;
+
+     flags = state->blittingflags;
+
+     dfb_simplify_blittingflags( &flags );
+
+     if (flags & (DSBLIT_ROTATE90 | DSBLIT_FLIP_HORIZONTAL | DSBLIT_FLIP_VERTICAL | DSBLIT_DEINTERLACE |
+                  DSBLIT_SRC_MASK_ALPHA | DSBLIT_SRC_MASK_COLOR | DSBLIT_SRC_CONVOLUTION))
+          return false;
+
+     D_DEBUG_AT( Genefx_Glyphs, "%s( %d )\n", __FUNCTION__, num );
+
+     if (dfb_config->software_warn) {
+          D_WARN( "Glyphs (%d) %6s, flags 0x%08x, funcs %u/%u, color 0x%02x%02x%02x%02x <- %6s",
+                  num, dfb_pixelformat_name( gfxs->dst_format ), state->blittingflags, state->src_blend,
+                  state->dst_blend, state->color.a, state->color.r, state->color.g, state->color.b,
+                  dfb_pixelformat_name( gfxs->src_format ) );
+     }
+
+     if (!gfxs->funcs[0])
+          return true;
+
+     gfxs->Astep = gfxs->Bstep = 1;
+
+     for (i = 0; i < num; i++) {
+          DFBRectangle srect = rects[i];
+          int          dx    = points[i].x;
+          int          dy    = points[i].y;
+
+          if (!dfb_clip_blit_precheck( &state->clip, srect.w, srect.h, dx, dy ))
+               continue;
+
+          dfb_clip_blit( &state->clip, &srect, &dx, &dy );
+
+          spans[n++] = (GlyphSpan) { dx, dy, srect.x, srect.y, srect.w, srect.h, NULL, NULL };
+
+          if (n == GLYPHS_CHUNK) {
+               glyphs_render( gfxs, spans, n );
+               n = 0;
+          }
+     }
+
+     if (n)
+          glyphs_render( gfxs, spans, n );
+
+     return true;
+}
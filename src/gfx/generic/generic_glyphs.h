@@ -0,0 +1,36 @@
+/*
+   This file is part of DirectFB.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+*/
+
+#ifndef __GENERIC_GLYPHS_H__
+#define __GENERIC_GLYPHS_H__
+
+#include <core/coretypes.h>
+
+/**********************************************************************************************************************/
+
+/*
+ * Blit a batch of glyphs from a font surface, clipping each one. All glyphs crossing a line of the destination are
+ * composited in their order before advancing to the next line, while the line is in the cache. Returns false without
+ * rendering if the source is not a font surface or the blitting flags are not supported.
+ */
+bool Genefx_BlitGlyphs( CardState          *state,
+                        const DFBRectangle *rects,
+                        const DFBPoint     *points,
+                        int                 num );
+
+#endif
@@ -0,0 +1,695 @@
+/*
+   This file is part of DirectFB.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+*/
+
+#include <core/core.h>
+#include <core/gfxcard.h>
+#include <core/state.h>
+#include <core/surface_allocation.h>
+#include <direct/memcpy.h>
+#include <direct/thread.h>
+#include <gfx/generic/generic.h>
+#include <gfx/generic/generic_queue.h>
+#include <gfx/generic/generic_scale.h>
+
+D_DEBUG_DOMAIN( Genefx_Queue, "Genefx/Queue", "Genefx Render Queue" );
+
+/**********************************************************************************************************************/
+
+typedef struct {
+     DirectLink            link;       /* in the list of free commands */
+
+     CardState             state;      /* snapshot of the state, with the buffers locked */
+
+     GenefxQueueOperation  operation;  /* arguments, arrays pointing into 'data' */
+
+     void                 *data;
+     size_t                data_size;
+
+     CoreGraphicsSerial    serial;
+} GenefxQueueCommand;
+
+static DirectMutex          queue_lock = DIRECT_MUTEX_INITIALIZER();  /* protects the following */
+static DirectWaitQueue      queue_cond;
+static DirectThread        *queue_thread;
+static DirectTLS            queue_putting;                             /* set while locking buffers for an operation */
+static GenefxQueueCommand **queue_ring;
+static unsigned int         queue_size;
+static unsigned int         queue_head;                                /* next command to execute */
+static unsigned int         queue_tail;                                /* next free slot */
+static unsigned int         queue_reserved;                            /* slots reserved by operations being queued */
+static bool                 queue_quit;
+static DirectLink          *queue_free;
+static CoreGraphicsSerial   queue_serial;                              /* serial of the last queued operation */
+static CoreGraphicsSerial   queue_done;                                /* serial of the last executed operation */
+
+static GenefxState         *queue_gfxs;                                /* used by the render thread only, keeping the
+                                                                          accumulators and cached pipelines */
+
+/**********************************************************************************************************************/
+
+static inline bool
+serial_reached( const CoreGraphicsSerial *done,
+                const CoreGraphicsSerial *serial )
+{
+     return done->generation > serial->generation ||
+            (done->generation == serial->generation && done->serial >= serial->serial);
+}
+
+static bool
+operation_blits( const GenefxQueueOperation *operation )
+{
+     switch (operation->op) {
+          case GQO_BLIT:
+          case GQO_BATCHBLIT:
+          case GQO_BATCHSTRETCHBLIT:
+          case GQO_TILEBLIT:
+          case GQO_TEXTURE_TRIANGLES:
+               return true;
+
+          default:
+               break;
+     }
+
+     return false;
+}
+
+static void
+operation_sizes( const GenefxQueueOperation *operation,
+                 size_t                     *ret_size,
+                 size_t                     *ret_size2 )
+{
+     size_t size  = 0;
+     size_t size2 = 0;
+
+     switch (operation->op) {
+          case GQO_FILLRECTANGLES:
+               size = operation->num * sizeof(DFBRectangle);
+               break;
+
+          case GQO_DRAWRECTANGLE:
+          case GQO_BLIT:
+          case GQO_TILEBLIT:
+               size = sizeof(DFBRectangle);
+               break;
+
+          case GQO_DRAWLINES:
+               size = operation->num * sizeof(DFBRegion);
+               break;
+
+          case GQO_FILLTRIANGLES:
+               size = operation->num * sizeof(DFBTriangle);
+               break;
+
+          case GQO_FILLTRAPEZOIDS:
+               size = operation->num * sizeof(DFBTrapezoid);
+               break;
+
+          case GQO_FILLQUADRANGLES:
+               size = operation->num * 4 * sizeof(DFBPoint);
+               break;
+
+          case GQO_FILLSPANS:
+               size = operation->num * sizeof(DFBSpan);
+               break;
+
+          case GQO_BATCHBLIT:
+               size  = operation->num * sizeof(DFBRectangle);
+               size2 = operation->num * sizeof(DFBPoint);
+               break;
+
+          case GQO_BATCHSTRETCHBLIT:
+               size  = operation->num * sizeof(DFBRectangle);
+               size2 = operation->num * sizeof(DFBRectangle);
+               break;
+
+          case GQO_TEXTURE_TRIANGLES:
+               size = operation->num * sizeof(DFBVertex);
+               break;
+     }
+
+     *ret_size  = size;
+     *ret_size2 = size2;
+}
+
+/**********************************************************************************************************************/
+
+static void
+command_snapshot( GenefxQueueCommand *command,
+                  CardState          *state,
+                  bool                blit )
+{
+     CardState *copy = &command->state;
+
+     dfb_state_init( copy, state->core );
+
+     dfb_state_set_destination( copy, state->destination );
+
+     if (blit) {
+          dfb_state_set_source( copy, state->source );
+
+          if (state->blittingflags & (DSBLIT_SRC_MASK_ALPHA | DSBLIT_SRC_MASK_COLOR))
+               dfb_state_set_source_mask( copy, state->source_mask );
+     }
+
+     if (state->num_translation)
+          dfb_state_set_index_translation( copy, state->index_translation, state->num_translation );
+
+     copy->drawingflags          = state->drawingflags;
+     copy->blittingflags         = state->blittingflags;
+     copy->clip                  = state->clip;
+     copy->color                 = state->color;
+     copy->color_index           = state->color_index;
+     copy->src_blend             = state->src_blend;
+     copy->dst_blend             = state->dst_blend;
+     copy->src_colorkey          = state->src_colorkey;
+     copy->dst_colorkey          = state->dst_colorkey;
+     copy->from                  = state->from;
+     copy->from_eye              = state->from_eye;
+     copy->to                    = state->to;
+     copy->to_eye                = state->to_eye;
+     copy->render_options        = state->render_options;
+     copy->colorkey              = state->colorkey;
+     copy->affine_matrix         = state->affine_matrix;
+     copy->src_mask_offset       = state->src_mask_offset;
+     copy->src_mask_flags        = state->src_mask_flags;
+     copy->src_colorkey_extended = state->src_colorkey_extended;
+     copy->dst_colorkey_extended = state->dst_colorkey_extended;
+     copy->src_convolution       = state->src_convolution;
+
+     direct_memcpy( copy->matrix,          state->matrix,          sizeof(state->matrix) );
+     direct_memcpy( copy->src_colormatrix, state->src_colormatrix, sizeof(state->src_colormatrix) );
+     direct_memcpy( copy->colors,          state->colors,          sizeof(state->colors) );
+     direct_memcpy( copy->color_indices,   state->color_indices,   sizeof(state->color_indices) );
+}
+
+/*
+ * Lock the buffers the operation would be executed with now, the render thread keeps using them after a flip.
+ */
+static DFBResult
+command_lock_buffers( GenefxQueueCommand *command,
+                      CardState          *state,
+                      bool                blit )
+{
+     DFBResult  ret;
+     CardState *copy = &command->state;
+
+     ret = dfb_surface_lock_buffer2( copy->destination, copy->to,
+                                     state->destination_flip_count_used ?
+                                     state->destination_flip_count : copy->destination->flips,
+                                     copy->to_eye, CSAID_CPU, CSAF_READ | CSAF_WRITE, &copy->dst );
+     if (ret)
+          return ret;
+
+     if (blit) {
+          ret = dfb_surface_lock_buffer2( copy->source, copy->from,
+                                          state->source_flip_count_used ?
+                                          state->source_flip_count : copy->source->flips,
+                                          copy->from_eye, CSAID_CPU, CSAF_READ, &copy->src );
+          if (ret) {
+               dfb_surface_unlock_buffer( copy->destination, &copy->dst );
+               return ret;
+          }
+
+          copy->flags |= CSF_SOURCE_LOCKED;
+
+          if (copy->source_mask) {
+               ret = dfb_surface_lock_buffer2( copy->source_mask, copy->from, copy->source_mask->flips, copy->from_eye,
+                                               CSAID_CPU, CSAF_READ, &copy->src_mask );
+               if (ret) {
+                    dfb_surface_unlock_buffer( copy->source, &copy->src );
+                    dfb_surface_unlock_buffer( copy->destination, &copy->dst );
+
+                    copy->flags &= ~CSF_SOURCE_LOCKED;
+
+                    return ret;
+               }
+
+               copy->flags |= CSF_SOURCE_MASK_LOCKED;
+          }
+     }
+
+     copy->flags |= CSF_BUFFERS_LOCKED;
+
+     return DFB_OK;
+}
+
+/*
+ * Let CPU and layer accesses to the allocations wait for the operation, like for a graphics processor.
+ */
+static void
+command_tag_allocations( GenefxQueueCommand *command )
+{
+     CardState             *copy = &command->state;
+     CoreSurfaceAllocation *allocation;
+
+     allocation = copy->dst.allocation;
+
+     allocation->accessed[CSAID_GPU] |= CSAF_READ | CSAF_WRITE;
+     allocation->gfx_serial           = command->serial;
+
+     if (copy->flags & CSF_SOURCE_LOCKED) {
+          allocation = copy->src.allocation;
+
+          allocation->accessed[CSAID_GPU] |= CSAF_READ;
+          allocation->gfx_serial           = command->serial;
+     }
+
+     if (copy->flags & CSF_SOURCE_MASK_LOCKED) {
+          allocation = copy->src_mask.allocation;
+
+          allocation->accessed[CSAID_GPU] |= CSAF_READ;
+          allocation->gfx_serial           = command->serial;
+     }
+}
+
+static void
+command_release( GenefxQueueCommand *command )
+{
+     CardState *copy = &command->state;
+
+     if (copy->flags & CSF_BUFFERS_LOCKED) {
+          Core_PushIdentity( 0 );
+
+          dfb_surface_unlock_buffer( copy->destination, &copy->dst );
+
+          if (copy->flags & CSF_SOURCE_LOCKED)
+               dfb_surface_unlock_buffer( copy->source, &copy->src );
+
+          if (copy->flags & CSF_SOURCE_MASK_LOCKED)
+               dfb_surface_unlock_buffer( copy->source_mask, &copy->src_mask );
+
+          Core_PopIdentity();
+
+          copy->flags &= ~(CSF_BUFFERS_LOCKED | CSF_SOURCE_LOCKED | CSF_SOURCE_MASK_LOCKED);
+     }
+
+     dfb_state_stop_drawing( copy );
+
+     dfb_state_set_destination( copy, NULL );
+     dfb_state_set_source( copy, NULL );
+     dfb_state_set_source_mask( copy, NULL );
+
+     dfb_state_destroy( copy );
+}
+
+static void
+command_execute( GenefxQueueCommand *command )
+{
+     GenefxQueueOperation *operation = &command->operation;
+     CardState            *copy      = &command->state;
+
+     D_DEBUG_AT( Genefx_Queue, "%s( %u, op %u )\n", __FUNCTION__, command->serial.serial, operation->op );
+
+     copy->gfxs = queue_gfxs;
+
+     switch (operation->op) {
+          case GQO_FILLRECTANGLES:
+               dfb_gfxcard_fillrectangles( (DFBRectangle*) operation->data, operation->num, copy );
+               break;
+
+          case GQO_DRAWRECTANGLE:
+               dfb_gfxcard_drawrectangle( (DFBRectangle*) operation->data, copy );
+               break;
+
+          case GQO_DRAWLINES:
+               dfb_gfxcard_drawlines( (DFBRegion*) operation->data, operation->num, copy );
+               break;
+
+          case GQO_FILLTRIANGLES:
+               dfb_gfxcard_filltriangles( (DFBTriangle*) operation->data, operation->num, copy );
+               break;
+
+          case GQO_FILLTRAPEZOIDS:
+               dfb_gfxcard_filltrapezoids( (DFBTrapezoid*) operation->data, operation->num, copy );
+               break;
+
+          case GQO_FILLQUADRANGLES:
+               dfb_gfxcard_fillquadrangles( (DFBPoint*) operation->data, operation->num, copy );
+               break;
+
+          case GQO_FILLSPANS:
+               dfb_gfxcard_fillspans( operation->y, (DFBSpan*) operation->data, operation->num, copy );
+               break;
+
+          case GQO_BLIT:
+               dfb_gfxcard_blit( (DFBRectangle*) operation->data, operation->x, operation->y, copy );
+               break;
+
+          case GQO_BATCHBLIT:
+               dfb_gfxcard_batchblit( (DFBRectangle*) operation->data, (DFBPoint*) operation->data2, operation->num,
+                                      copy );
+               break;
+
+          case GQO_BATCHSTRETCHBLIT:
+               dfb_gfxcard_batchstretchblit( (DFBRectangle*) operation->data, (DFBRectangle*) operation->data2,
+                                             operation->num, copy );
+               break;
+
+          case GQO_TILEBLIT:
+               dfb_gfxcard_tileblit( (DFBRectangle*) operation->data, operation->x, operation->y,
+                                     operation->x2, operation->y2, copy );
+               break;
+
+          case GQO_TEXTURE_TRIANGLES:
+               dfb_gfxcard_texture_triangles( (DFBVertex*) operation->data, operation->num, operation->formation,
+                                              copy );
+               break;
+     }
+
+     queue_gfxs = copy->gfxs;
+     copy->gfxs = NULL;
+}
+
+static void *
+queue_worker( DirectThread *thread,
+              void         *arg )
+{
+     direct_mutex_lock( &queue_lock );
+
+     while (true) {
+          GenefxQueueCommand *command;
+
+          while (queue_head == queue_tail && !queue_quit)
+               direct_waitqueue_wait( &queue_cond, &queue_lock );
+
+          if (queue_head == queue_tail)
+               break;
+
+          command = queue_ring[queue_head % queue_size];
+
+          direct_mutex_unlock( &queue_lock );
+
+          command_execute( command );
+
+          /* Signal completion before unlocking, waiters may hold the surface lock needed for this. */
+          direct_mutex_lock( &queue_lock );
+
+          queue_done = command->serial;
+
+          direct_waitqueue_broadcast( &queue_cond );
+
+          direct_mutex_unlock( &queue_lock );
+
+          command_release( command );
+
+          direct_mutex_lock( &queue_lock );
+
+          queue_head++;
+
+          direct_list_prepend( &queue_free, &command->link );
+
+          direct_waitqueue_broadcast( &queue_cond );
+     }
+
+     direct_mutex_unlock( &queue_lock );
+
+     return NULL;
+}
+
+/**********************************************************************************************************************/
+
+DFBResult
+Genefx_Queue_Start( unsigned int size )
+{
+     DFBResult ret;
+
+     D_DEBUG_AT( Genefx_Queue, "%s( %u )\n", __FUNCTION__, size );
+
+     D_ASSERT( size > 0 );
+     D_ASSERT( queue_thread == NULL );
+
+     queue_ring = D_CALLOC( size, sizeof(GenefxQueueCommand*) );
+     if (!queue_ring)
+          return D_OOM();
+
+     ret = direct_tls_register( &queue_putting, NULL );
+     if (ret) {
+          D_FREE( queue_ring );
+          return ret;
+     }
+
+     direct_waitqueue_init( &queue_cond );
+
+     queue_size = size;
+     queue_head     = 0;
+     queue_tail     = 0;
+     queue_reserved = 0;
+     queue_quit     = false;
+
+     queue_serial.serial     = 0;
+     queue_serial.generation = 0;
+     queue_done              = queue_serial;
+
+     queue_thread = direct_thread_create( DTT_DEFAULT, queue_worker, NULL, "Genefx Queue" );
+     if (!queue_thread) {
+          direct_waitqueue_deinit( &queue_cond );
+          direct_tls_unregister( &queue_putting );
+          D_FREE( queue_ring );
+          return DFB_INIT;
+     }
+
+     return DFB_OK;
+}
+
+void
+Genefx_Queue_Stop()
+{
+     GenefxQueueCommand *command, *next;
+
+     D_DEBUG_AT( Genefx_Queue, "%s()\n", __FUNCTION__ );
+
+     if (!queue_thread)
+          return;
+
+     direct_mutex_lock( &queue_lock );
+
+     queue_quit = true;
+
+     direct_waitqueue_broadcast( &queue_cond );
+
+     direct_mutex_unlock( &queue_lock );
+
+     direct_thread_join( queue_thread );
+     direct_thread_destroy( queue_thread );
+
+     queue_thread = NULL;
+
+     direct_list_foreach_safe (command, next, queue_free) {
+          if (command->data)
+               D_FREE( command->data );
+
+          D_FREE( command );
+     }
+
+     queue_free = NULL;
+
+     if (queue_gfxs) {
+          if (queue_gfxs->ABstart)
+               D_FREE( queue_gfxs->ABstart );
+
+          if (queue_gfxs->Kstart)
+               D_FREE( queue_gfxs->Kstart );
+
+          Genefx_Scale_Flush( queue_gfxs );
+
+          D_FREE( queue_gfxs );
+
+          queue_gfxs = NULL;
+     }
+
+     D_FREE( queue_ring );
+
+     direct_tls_unregister( &queue_putting );
+
+     direct_waitqueue_deinit( &queue_cond );
+}
+
+bool
+Genefx_Queue_Put( CardState                  *state,
+                  const GenefxQueueOperation *operation )
+{
+     DFBResult           ret;
+     GenefxQueueCommand *command;
+     size_t              size, size2;
+     bool                blit;
+
+     D_MAGIC_ASSERT( state, CardState );
+     D_ASSERT( operation != NULL );
+
+     if (!queue_thread || direct_thread_self() == queue_thread)
+          return false;
+
+     D_DEBUG_AT( Genefx_Queue, "%s( %p, op %u )\n", __FUNCTION__, state, operation->op );
+
+     blit = operation_blits( operation );
+
+     /* Operations which are dropped anyway are done right away. */
+     if (!state->destination || !state->destination->num_buffers || core_dfb->shutdown_running)
+          return false;
+
+     if (blit) {
+          if (!state->source)
+               return false;
+
+          if (state->blittingflags & (DSBLIT_SRC_MASK_ALPHA | DSBLIT_SRC_MASK_COLOR) && !state->source_mask)
+               return false;
+     }
+
+     operation_sizes( operation, &size, &size2 );
+
+     /* Reserve a slot before locking the state and the buffers. Callers may still hold surface locks while waiting here
+        or in Genefx_Queue_Wait(), the render thread never takes any. */
+     direct_mutex_lock( &queue_lock );
+
+     while (queue_tail + queue_reserved - queue_head >= queue_size)
+          direct_waitqueue_wait( &queue_cond, &queue_lock );
+
+     queue_reserved++;
+
+     /* Reuse a command with its data. */
+     command = (GenefxQueueCommand*) queue_free;
+     if (command)
+          direct_list_remove( &queue_free, &command->link );
+
+     direct_mutex_unlock( &queue_lock );
+
+     if (!command) {
+          command = D_CALLOC( 1, sizeof(GenefxQueueCommand) );
+          if (!command) {
+               D_OOM();
+               goto error;
+          }
+     }
+
+     if (command->data_size < size + size2) {
+          void *data = D_REALLOC( command->data, size + size2 );
+
+          if (!data) {
+               D_OOM();
+               goto error;
+          }
+
+          command->data      = data;
+          command->data_size = size + size2;
+     }
+
+     command->operation       = *operation;
+     command->operation.data  = command->data;
+     command->operation.data2 = size2 ? (u8*) command->data + size : NULL;
+
+     if (size)
+          direct_memcpy( command->data, operation->data, size );
+
+     if (size2)
+          direct_memcpy( (u8*) command->data + size, operation->data2, size2 );
+
+     dfb_state_lock( state );
+
+     command_snapshot( command, state, blit );
+
+     /* Waiting for the pending operations is not needed, this one will be executed after them. */
+     direct_tls_set( &queue_putting, (void*) 1 );
+
+     Core_PushIdentity( 0 );
+
+     ret = command_lock_buffers( command, state, blit );
+
+     Core_PopIdentity();
+
+     direct_tls_set( &queue_putting, NULL );
+
+     if (ret) {
+          D_DEBUG_AT( Genefx_Queue, "  -> locking buffers failed (%s)\n", DirectFBErrorString( ret ) );
+          command_release( command );
+          dfb_state_unlock( state );
+          goto error;
+     }
+
+     direct_mutex_lock( &queue_lock );
+
+     queue_reserved--;
+
+     if (!++queue_serial.serial)
+          queue_serial.generation++;
+
+     command->serial = queue_serial;
+
+     command_tag_allocations( command );
+
+     queue_ring[queue_tail++ % queue_size] = command;
+
+     state->serial = command->serial;
+
+     direct_waitqueue_broadcast( &queue_cond );
+
+     direct_mutex_unlock( &queue_lock );
+
+     dfb_state_unlock( state );
+
+     D_DEBUG_AT( Genefx_Queue, "  -> serial %u\n", command->serial.serial );
+
+     return true;
+
+error:
+     direct_mutex_lock( &queue_lock );
+
+     if (command)
+          direct_list_prepend( &queue_free, &command->link );
+
+     queue_reserved--;
+
+     direct_waitqueue_broadcast( &queue_cond );
+
+     direct_mutex_unlock( &queue_lock );
+
+     return false;
+}
+
+void
+Genefx_Queue_Wait( const CoreGraphicsSerial *serial )
+{
+     D_ASSERT( serial != NULL );
+
+     if (!queue_thread || direct_thread_self() == queue_thread || direct_tls_get( &queue_putting ))
+          return;
+
+     D_DEBUG_AT( Genefx_Queue, "%s( %u )\n", __FUNCTION__, serial->serial );
+
+     direct_mutex_lock( &queue_lock );
+
+     while (!serial_reached( &queue_done, serial ))
+          direct_waitqueue_wait( &queue_cond, &queue_lock );
+
+     direct_mutex_unlock( &queue_lock );
+}
+
+void
+Genefx_Queue_Sync()
+{
+     if (!queue_thread || direct_thread_self() == queue_thread)
+          return;
+
+     D_DEBUG_AT( Genefx_Queue, "%s()\n", __FUNCTION__ );
+
+     direct_mutex_lock( &queue_lock );
+
+     while (queue_head != queue_tail)
+          direct_waitqueue_wait( &queue_cond, &queue_lock );
+
+     direct_mutex_unlock( &queue_lock );
+}
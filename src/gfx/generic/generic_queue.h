@@ -0,0 +1,89 @@
+/*
+   This file is part of DirectFB.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+*/
+
+#ifndef __GENERIC_QUEUE_H__
+#define __GENERIC_QUEUE_H__
+
+#include <core/coretypes.h>
+
+/**********************************************************************************************************************/
+
+typedef enum {
+     GQO_FILLRECTANGLES,
+     GQO_DRAWRECTANGLE,
+     GQO_DRAWLINES,
+     GQO_FILLTRIANGLES,
+     GQO_FILLTRAPEZOIDS,
+     GQO_FILLQUADRANGLES,
+     GQO_FILLSPANS,
+     GQO_BLIT,
+     GQO_BATCHBLIT,
+     GQO_BATCHSTRETCHBLIT,
+     GQO_TILEBLIT,
+     GQO_TEXTURE_TRIANGLES
+} GenefxQueueOp;
+
+/*
+ * Arguments of a graphics operation, the arrays are copied when the operation is queued.
+ */
+typedef struct {
+     GenefxQueueOp         op;
+
+     const void           *data;       /* rectangles, lines, triangles, trapezoids, points, spans or vertices */
+     const void           *data2;      /* destination points of batch blits, destination rectangles of stretch blits */
+     int                   num;        /* number of elements, quadrangles for GQO_FILLQUADRANGLES */
+
+     int                   x;          /* blit destination or tile blit start, unused otherwise */
+     int                   y;          /* blit destination, tile blit start or span line, unused otherwise */
+     int                   x2;         /* tile blit end */
+     int                   y2;         /* tile blit end */
+
+     DFBTriangleFormation  formation;  /* formation of GQO_TEXTURE_TRIANGLES */
+} GenefxQueueOperation;
+
+/*
+ * Start the render thread executing software operations in order, with up to 'size' operations pending.
+ */
+DFBResult Genefx_Queue_Start( unsigned int                size );
+
+/*
+ * Execute the pending operations and stop the render thread.
+ */
+void      Genefx_Queue_Stop ( void );
+
+/*
+ * Queue an operation with a snapshot of the state, locking the buffers involved in advance and tagging their allocations
+ * with the serial of the operation, which is also stored in the state.
+ *
+ * Returns false if the operation must be executed directly instead, e.g. by the render thread itself.
+ */
+bool      Genefx_Queue_Put  ( CardState                  *state,
+                              const GenefxQueueOperation *operation );
+
+/*
+ * Wait for the operation with the serial to be executed, returns immediately within the render thread or while queueing
+ * an operation, which will be executed after the ones already pending.
+ */
+void      Genefx_Queue_Wait ( const CoreGraphicsSerial   *serial );
+
+/*
+ * Wait for all pending operations to be executed.
+ */
+void      Genefx_Queue_Sync ( void );
+
+#endif
@@ -0,0 +1,345 @@
+/*
+   This file is part of DirectFB.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+*/
+
+#include <config.h>
+#include <core/state.h>
+#include <core/surface.h>
+#include <gfx/generic/generic.h>
+#include <gfx/generic/generic_rotate.h>
+#include <gfx/util.h>
+#include <misc/conf.h>
+
+D_DEBUG_DOMAIN( Genefx_Rotation, "Genefx/Rotation", "Genefx Tiled Rotation" );
+
+/**********************************************************************************************************************/
+
+/*
+ * Size of the square tiles being transposed, keeping the destination lines written by a tile in the cache.
+ */
+#define ROTATE_TILE 16
+
+/*
+ * Transpose a tile of w x h source pixels, 'Sstep' being the offset between source lines, 'Dxstep' the offset between
+ * the destination pixels of a source line and 'Dystep' the offset between the destination pixels of a source column.
+ */
+typedef void (*RotateTileFunc)( const u8 *S,
+                                int       Sstep,
+                                u8       *D,
+                                int       Dxstep,
+                                int       Dystep,
+                                int       w,
+                                int       h );
+
+static void
+rotate_tile_16( const u8 *S,
+                int       Sstep,
+                u8       *D,
+                int       Dxstep,
+                int       Dystep,
+                int       w,
+                int       h )
+{
+     int x, y;
+
+     for (y = 0; y < h; y++) {
+          const u16 *s = (const u16*) (S + y * Sstep);
+          u8        *d = D + y * Dystep;
+
+          for (x = 0; x < w; x++) {
+               *(u16*) d = s[x];
+
+               d += Dxstep;
+          }
+     }
+}
+
+static void
+rotate_tile_32( const u8 *S,
+                int       Sstep,
+                u8       *D,
+                int       Dxstep,
+                int       Dystep,
+                int       w,
+                int       h )
+{
+     int x, y;
+
+     for (y = 0; y < h; y++) {
+          const u32 *s = (const u32*) (S + y * Sstep);
+          u8        *d = D + y * Dystep;
+
+          for (x = 0; x < w; x++) {
+               *(u32*) d = s[x];
+
+               d += Dxstep;
+          }
+     }
+}
+
+#ifdef USE_SSE2
+
+#include <emmintrin.h>
+
+#define SSE2_FUNC __attribute__((target("sse2")))
+
+/*
+ * The SSE2 functions transpose blocks of 8x8 (16 bit) or 4x4 (32 bit) pixels in registers, each source column being
+ * written with a single store. The remaining pixels of the tile are handled by the C functions.
+ */
+
+static void SSE2_FUNC
+rotate_tile_16_SSE2( const u8 *S,
+                     int       Sstep,
+                     u8       *D,
+                     int       Dxstep,
+                     int       Dystep,
+                     int       w,
+                     int       h )
+{
+     int x, y;
+     int bw = w & ~7;
+     int bh = h & ~7;
+
+     for (y = 0; y < bh; y += 8) {
+          const u8 *s = S + y * Sstep;
+          u8       *d = D + y * Dystep;
+
+          for (x = 0; x < bw; x += 8) {
+               int     i;
+               __m128i a[8], b[8], c[8];
+
+               for (i = 0; i < 8; i++)
+                    a[i] = _mm_loadu_si128( (const __m128i*) (s + i * Sstep) );
+
+               b[0] = _mm_unpacklo_epi16( a[0], a[1] );
+               b[1] = _mm_unpackhi_epi16( a[0], a[1] );
+               b[2] = _mm_unpacklo_epi16( a[2], a[3] );
+               b[3] = _mm_unpackhi_epi16( a[2], a[3] );
+               b[4] = _mm_unpacklo_epi16( a[4], a[5] );
+               b[5] = _mm_unpackhi_epi16( a[4], a[5] );
+               b[6] = _mm_unpacklo_epi16( a[6], a[7] );
+               b[7] = _mm_unpackhi_epi16( a[6], a[7] );
+
+               a[0] = _mm_unpacklo_epi32( b[0], b[2] );
+               a[1] = _mm_unpackhi_epi32( b[0], b[2] );
+               a[2] = _mm_unpacklo_epi32( b[1], b[3] );
+               a[3] = _mm_unpackhi_epi32( b[1], b[3] );
+               a[4] = _mm_unpacklo_epi32( b[4], b[6] );
+               a[5] = _mm_unpackhi_epi32( b[4], b[6] );
+               a[6] = _mm_unpacklo_epi32( b[5], b[7] );
+               a[7] = _mm_unpackhi_epi32( b[5], b[7] );
+
+               c[0] = _mm_unpacklo_epi64( a[0], a[4] );
+               c[1] = _mm_unpackhi_epi64( a[0], a[4] );
+               c[2] = _mm_unpacklo_epi64( a[1], a[5] );
+               c[3] = _mm_unpackhi_epi64( a[1], a[5] );
+               c[4] = _mm_unpacklo_epi64( a[2], a[6] );
+               c[5] = _mm_unpackhi_epi64( a[2], a[6] );
+               c[6] = _mm_unpacklo_epi64( a[3], a[7] );
+               c[7] = _mm_unpackhi_epi64( a[3], a[7] );
+
+               if (Dystep > 0) {
+                    for (i = 0; i < 8; i++)
+                         _mm_storeu_si128( (__m128i*) (d + i * Dxstep), c[i] );
+               }
+               else {
+                    for (i = 0; i < 8; i++) {
+                         __m128i r = _mm_shufflehi_epi16( _mm_shufflelo_epi16( c[i], 0x1b ), 0x1b );
+
+                         _mm_storeu_si128( (__m128i*) (d + i * Dxstep - 14), _mm_shuffle_epi32( r, 0x4e ) );
+                    }
+               }
+
+               s += 16;
+               d += 8 * Dxstep;
+          }
+     }
+
+     if (bw < w)
+          rotate_tile_16( S + bw * 2, Sstep, D + bw * Dxstep, Dxstep, Dystep, w - bw, bh );
+
+     if (bh < h)
+          rotate_tile_16( S + bh * Sstep, Sstep, D + bh * Dystep, Dxstep, Dystep, w, h - bh );
+}
+
+static void SSE2_FUNC
+rotate_tile_32_SSE2( const u8 *S,
+                     int       Sstep,
+                     u8       *D,
+                     int       Dxstep,
+                     int       Dystep,
+                     int       w,
+                     int       h )
+{
+     int x, y;
+     int bw = w & ~3;
+     int bh = h & ~3;
+
+     for (y = 0; y < bh; y += 4) {
+          const u8 *s = S + y * Sstep;
+          u8       *d = D + y * Dystep;
+
+          for (x = 0; x < bw; x += 4) {
+               int     i;
+               __m128i a[4], b[4], c[4];
+
+               for (i = 0; i < 4; i++)
+                    a[i] = _mm_loadu_si128( (const __m128i*) (s + i * Sstep) );
+
+               b[0] = _mm_unpacklo_epi32( a[0], a[1] );
+               b[1] = _mm_unpacklo_epi32( a[2], a[3] );
+               b[2] = _mm_unpackhi_epi32( a[0], a[1] );
+               b[3] = _mm_unpackhi_epi32( a[2], a[3] );
+
+               c[0] = _mm_unpacklo_epi64( b[0], b[1] );
+               c[1] = _mm_unpackhi_epi64( b[0], b[1] );
+               c[2] = _mm_unpacklo_epi64( b[2], b[3] );
+               c[3] = _mm_unpackhi_epi64( b[2], b[3] );
+
+               if (Dystep > 0) {
+                    for (i = 0; i < 4; i++)
+                         _mm_storeu_si128( (__m128i*) (d + i * Dxstep), c[i] );
+               }
+               else {
+                    for (i = 0; i < 4; i++)
+                         _mm_storeu_si128( (__m128i*) (d + i * Dxstep - 12), _mm_shuffle_epi32( c[i], 0x1b ) );
+               }
+
+               s += 16;
+               d += 4 * Dxstep;
+          }
+     }
+
+     if (bw < w)
+          rotate_tile_32( S + bw * 4, Sstep, D + bw * Dxstep, Dxstep, Dystep, w - bw, bh );
+
+     if (bh < h)
+          rotate_tile_32( S + bh * Sstep, Sstep, D + bh * Dystep, Dxstep, Dystep, w, h - bh );
+}
+
+#endif
+
+/**********************************************************************************************************************/
+
+static RotateTileFunc
+rotate_tile_func( int bpp )
+{
+#ifdef USE_SSE2
+     static int use_sse2 = -1;
+
+     if (use_sse2 < 0)
+          use_sse2 = dfb_config->sse2 && __builtin_cpu_supports( "sse2" );
+
+     if (use_sse2)
+          return (bpp == 2) ? rotate_tile_16_SSE2 : rotate_tile_32_SSE2;
+#endif
+
+     return (bpp == 2) ? rotate_tile_16 : rotate_tile_32;
+}
+
+bool
+Genefx_Rotate( CardState    *state,
+               DFBRectangle *rect,
+               int           dx,
+               int           dy )
+{
+     int                      x, y;
+     int                      bpp;
+     int                      Sstep, Dxstep, Dystep;
+     const u8                *S;
+     u8                      *D;
+     RotateTileFunc           tile;
+     GenefxState             *gfxs  = state->gfxs;
+     DFBSurfaceBlittingFlags  flags = state->blittingflags;
+
+     dfb_simplify_blittingflags( &flags );
+
+     /* Only plain copies, rotated by 90 or 270 degrees, optionally flipped. */
+     if (!(flags & DSBLIT_ROTATE90) || (flags & ~(DSBLIT_FLIP_HORIZONTAL | DSBLIT_FLIP_VERTICAL | DSBLIT_ROTATE90)))
+          return false;
+
+     if (gfxs->src_format != gfxs->dst_format ||
+         state->source->config.colorspace != state->destination->config.colorspace)
+          return false;
+
+     /* Pixels must be self-contained, chroma being shared by pairs of pixels in packed YUV formats. */
+     if (DFB_PLANAR_PIXELFORMAT( gfxs->dst_format ) ||
+         gfxs->dst_format == DSPF_YUY2 || gfxs->dst_format == DSPF_UYVY)
+          return false;
+
+     if ((gfxs->src_caps | gfxs->dst_caps) & DSCAPS_SEPARATED)
+          return false;
+
+     /* The columns of the source would overwrite lines not being read yet. */
+     if (gfxs->src_org[0] == gfxs->dst_org[0])
+          return false;
+
+     bpp = gfxs->dst_bpp;
+     if (bpp != 2 && bpp != 4)
+          return false;
+
+     D_DEBUG_AT( Genefx_Rotation, "%s( %4d,%4d-%4dx%4d -> %4d,%4d ) <- flags 0x%08x\n", __FUNCTION__,
+                 DFB_RECTANGLE_VALS( rect ), dx, dy, flags );
+
+     S = gfxs->src_org[0] + rect->y * gfxs->src_pitch + rect->x * bpp;
+
+     Sstep = gfxs->src_pitch;
+
+     switch ((unsigned int) flags) {
+          case DSBLIT_ROTATE90 | DSBLIT_FLIP_HORIZONTAL | DSBLIT_FLIP_VERTICAL:
+               S     += (rect->h - 1) * gfxs->src_pitch;
+               Sstep  = -gfxs->src_pitch;
+
+               D      = gfxs->dst_org[0] + dy * gfxs->dst_pitch + dx * bpp;
+               Dxstep = gfxs->dst_pitch;
+               Dystep = bpp;
+               break;
+
+          case DSBLIT_ROTATE90 | DSBLIT_FLIP_VERTICAL:
+               D      = gfxs->dst_org[0] + (dy + rect->w - 1) * gfxs->dst_pitch + (dx + rect->h - 1) * bpp;
+               Dxstep = -gfxs->dst_pitch;
+               Dystep = -bpp;
+               break;
+
+          case DSBLIT_ROTATE90 | DSBLIT_FLIP_HORIZONTAL:
+               D      = gfxs->dst_org[0] + dy * gfxs->dst_pitch + dx * bpp;
+               Dxstep = gfxs->dst_pitch;
+               Dystep = bpp;
+               break;
+
+          default:
+               D      = gfxs->dst_org[0] + (dy + rect->w - 1) * gfxs->dst_pitch + dx * bpp;
+               Dxstep = -gfxs->dst_pitch;
+               Dystep = bpp;
+               break;
+     }
+
+     tile = rotate_tile_func( bpp );
+
+     for (y = 0; y < rect->h; y += ROTATE_TILE) {
+          int th = MIN( ROTATE_TILE, rect->h - y );
+
+          for (x = 0; x < rect->w; x += ROTATE_TILE) {
+               int tw = MIN( ROTATE_TILE, rect->w - x );
+
+               tile( S + y * Sstep + x * bpp, Sstep, D + y * Dystep + x * Dxstep, Dxstep, Dystep, tw, th );
+          }
+     }
+
+     return true;
+}
@@ -0,0 +1,35 @@
+/*
+   This file is part of DirectFB.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+*/
+
+#ifndef __GENERIC_ROTATE_H__
+#define __GENERIC_ROTATE_H__
+
+#include <core/coretypes.h>
+
+/**********************************************************************************************************************/
+
+/*
+ * Copy the source rectangle to (dx,dy) rotated by 90 or 270 degrees (optionally flipped), transposing it in tiles.
+ * Only plain copies of 16 or 32 bit formats are handled, otherwise false is returned without rendering.
+ */
+bool Genefx_Rotate( CardState    *state,
+                    DFBRectangle *rect,
+                    int           dx,
+                    int           dy );
+
+#endif
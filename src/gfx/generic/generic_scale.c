@@ -0,0 +1,654 @@
+/*
+   This file is part of DirectFB.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+*/
+
+#include <config.h>
+#include <core/state.h>
+#include <core/surface.h>
+#include <gfx/convert.h>
+#include <gfx/generic/generic.h>
+#include <gfx/generic/generic_scale.h>
+#include <misc/conf.h>
+
+D_DEBUG_DOMAIN( Genefx_Scaling, "Genefx/Scaling", "Genefx Polyphase Scaling" );
+
+/**********************************************************************************************************************/
+
+/*
+ * Filter weights are in 2.14 fixed point, the channels of horizontally scaled lines keep 6 fractional bits.
+ */
+#define SCALE_WEIGHT_BITS 14
+#define SCALE_LINE_BITS   6
+
+/*
+ * Scale a line of 'count' pixels, each one being the sum of 'taps' source pixels starting at 'first' weighted by
+ * 'weights'. The channels (b, g, r, a) of the result are stored as signed 16 bit values.
+ */
+typedef void (*ScaleLineFunc)  ( const u32        *S,
+                                 s16              *D,
+                                 const int        *first,
+                                 const s16        *weights,
+                                 int               taps,
+                                 int               count );
+
+/*
+ * Scale the columns of 'taps' horizontally scaled lines weighted by 'weights' to 'count' premultiplied pixels.
+ */
+typedef void (*ScaleColumnFunc)( const s16 * const *L,
+                                 const s16         *weights,
+                                 int                taps,
+                                 u32               *D,
+                                 int                count );
+
+static void
+scale_line( const u32 *S,
+            s16       *D,
+            const int *first,
+            const s16 *weights,
+            int        taps,
+            int        count )
+{
+     int i, t;
+
+     for (i = 0; i < count; i++) {
+          const u32 *s = S + first[i];
+          const s16 *w = weights + i * taps;
+          int        b = 1 << (SCALE_WEIGHT_BITS - SCALE_LINE_BITS - 1);
+          int        g = b;
+          int        r = b;
+          int        a = b;
+
+          for (t = 0; t < taps; t++) {
+               u32 p = s[t];
+
+               b += w[t] * (int) ( p        & 0xff);
+               g += w[t] * (int) ((p >>  8) & 0xff);
+               r += w[t] * (int) ((p >> 16) & 0xff);
+               a += w[t] * (int) ( p >> 24        );
+          }
+
+          D[0] = b >> (SCALE_WEIGHT_BITS - SCALE_LINE_BITS);
+          D[1] = g >> (SCALE_WEIGHT_BITS - SCALE_LINE_BITS);
+          D[2] = r >> (SCALE_WEIGHT_BITS - SCALE_LINE_BITS);
+          D[3] = a >> (SCALE_WEIGHT_BITS - SCALE_LINE_BITS);
+
+          D += 4;
+     }
+}
+
+static inline u32
+scale_column_pixel( const s16 * const *L,
+                    const s16         *weights,
+                    int                taps,
+                    int                i )
+{
+     int c, t;
+     int v[4];
+
+     for (c = 0; c < 4; c++) {
+          int sum = 1 << (SCALE_WEIGHT_BITS + SCALE_LINE_BITS - 1);
+
+          for (t = 0; t < taps; t++)
+               sum += weights[t] * L[t][i*4+c];
+
+          v[c] = CLAMP( sum >> (SCALE_WEIGHT_BITS + SCALE_LINE_BITS), 0, 255 );
+     }
+
+     /* Overshooting colors are limited by the alpha of the premultiplied result. */
+     return PIXEL_ARGB( v[3], MIN( v[2], v[3] ), MIN( v[1], v[3] ), MIN( v[0], v[3] ) );
+}
+
+static void
+scale_column( const s16 * const *L,
+              const s16         *weights,
+              int                taps,
+              u32               *D,
+              int                count )
+{
+     int i;
+
+     for (i = 0; i < count; i++)
+          D[i] = scale_column_pixel( L, weights, taps, i );
+}
+
+#ifdef USE_SSE2
+
+#include <emmintrin.h>
+
+#define SSE2_FUNC __attribute__((target("sse2")))
+
+/*
+ * The SSE2 functions multiply pairs of taps with a single madd, producing exactly the same results as the C functions.
+ * They require an even number of taps.
+ */
+
+static void SSE2_FUNC
+scale_line_SSE2( const u32 *S,
+                 s16       *D,
+                 const int *first,
+                 const s16 *weights,
+                 int        taps,
+                 int        count )
+{
+     int     i, t;
+     __m128i zero = _mm_setzero_si128();
+
+     for (i = 0; i < count; i++) {
+          const u32 *s   = S + first[i];
+          const s16 *w   = weights + i * taps;
+          __m128i    sum = _mm_set1_epi32( 1 << (SCALE_WEIGHT_BITS - SCALE_LINE_BITS - 1) );
+
+          for (t = 0; t < taps; t += 2) {
+               __m128i p = _mm_unpacklo_epi8( _mm_loadl_epi64( (const __m128i*) (s + t) ), zero );
+
+               /* interleave the channels of both pixels */
+               p = _mm_unpacklo_epi16( p, _mm_shuffle_epi32( p, 0x0e ) );
+
+               sum = _mm_add_epi32( sum, _mm_madd_epi16( p, _mm_set1_epi32( ((u32) (u16) w[t+1] << 16) |
+                                                                            (u16) w[t] ) ) );
+          }
+
+          sum = _mm_srai_epi32( sum, SCALE_WEIGHT_BITS - SCALE_LINE_BITS );
+
+          _mm_storel_epi64( (__m128i*) D, _mm_packs_epi32( sum, sum ) );
+
+          D += 4;
+     }
+}
+
+static void SSE2_FUNC
+scale_column_SSE2( const s16 * const *L,
+                   const s16         *weights,
+                   int                taps,
+                   u32               *D,
+                   int                count )
+{
+     int     i, t;
+     __m128i zero = _mm_setzero_si128();
+     __m128i max  = _mm_set1_epi16( 255 );
+
+     for (i = 0; i < (count & ~1); i += 2) {
+          __m128i lo = _mm_set1_epi32( 1 << (SCALE_WEIGHT_BITS + SCALE_LINE_BITS - 1) );
+          __m128i hi = lo;
+          __m128i v;
+
+          for (t = 0; t < taps; t += 2) {
+               __m128i a = _mm_load_si128( (const __m128i*) (L[t]   + i * 4) );
+               __m128i b = _mm_load_si128( (const __m128i*) (L[t+1] + i * 4) );
+               __m128i k = _mm_set1_epi32( ((u32) (u16) weights[t+1] << 16) | (u16) weights[t] );
+
+               lo = _mm_add_epi32( lo, _mm_madd_epi16( _mm_unpacklo_epi16( a, b ), k ) );
+               hi = _mm_add_epi32( hi, _mm_madd_epi16( _mm_unpackhi_epi16( a, b ), k ) );
+          }
+
+          v = _mm_packs_epi32( _mm_srai_epi32( lo, SCALE_WEIGHT_BITS + SCALE_LINE_BITS ),
+                               _mm_srai_epi32( hi, SCALE_WEIGHT_BITS + SCALE_LINE_BITS ) );
+
+          v = _mm_min_epi16( _mm_max_epi16( v, zero ), max );
+          v = _mm_min_epi16( v, _mm_shufflehi_epi16( _mm_shufflelo_epi16( v, 0xff ), 0xff ) );
+
+          _mm_storel_epi64( (__m128i*) (D + i), _mm_packus_epi16( v, v ) );
+     }
+
+     if (i < count)
+          D[i] = scale_column_pixel( L, weights, taps, i );
+}
+
+#endif
+
+/**********************************************************************************************************************/
+
+static inline int
+scale_floor( float x )
+{
+     int i = (int) x;
+
+     return (i > x) ? i - 1 : i;
+}
+
+static inline int
+scale_round( float x )
+{
+     return (x < 0) ? (int) (x - 0.5f) : (int) (x + 0.5f);
+}
+
+static float
+scale_kernel( float x,
+              bool  bicubic )
+{
+     if (x < 0)
+          x = -x;
+
+     /* Catmull-Rom spline */
+     if (bicubic) {
+          if (x < 1)
+               return (1.5f * x - 2.5f) * x * x + 1;
+
+          if (x < 2)
+               return ((-0.5f * x + 2.5f) * x - 4) * x + 2;
+
+          return 0;
+     }
+
+     return (x < 1) ? 1 - x : 0;
+}
+
+/*
+ * Return the support of the filter in source pixels, being widened when downscaling.
+ */
+static float
+scale_radius( int  src_size,
+              int  dst_size,
+              bool bicubic )
+{
+     float radius = bicubic ? 2 : 1;
+
+     if (src_size > dst_size)
+          radius = radius * src_size / dst_size;
+
+     return radius;
+}
+
+/*
+ * Return the maximum number of source pixels within the support of the filter.
+ */
+static int
+scale_span( float radius )
+{
+     int span = (int) (2 * radius);
+
+     return (span < 2 * radius) ? span + 1 : span;
+}
+
+/*
+ * Return the number of taps of the filter, made even for pairs of taps as long as the source is large enough.
+ */
+static int
+scale_taps( int  src_size,
+            int  dst_size,
+            bool bicubic )
+{
+     int taps = scale_span( scale_radius( src_size, dst_size, bicubic ) );
+
+     taps += taps & 1;
+
+     return MIN( taps, src_size );
+}
+
+/*
+ * Compute the filter bank of the output pixels 'start' to 'start + count - 1', i.e. the first source pixel and the
+ * weights of the taps for each output pixel. Taps outside of the source are folded into the edge pixels, summed up
+ * in 'k' first.
+ */
+static void
+scale_bank( int    src_size,
+            int    dst_size,
+            int    start,
+            int    count,
+            bool   bicubic,
+            int    taps,
+            int   *first,
+            s16   *weights,
+            float *k )
+{
+     int   i, j;
+     float scale  = (float) src_size / dst_size;
+     float step   = (scale > 1) ? scale : 1;
+     float radius = scale_radius( src_size, dst_size, bicubic );
+     int   span   = scale_span( radius );
+
+     for (i = 0; i < count; i++) {
+          float center = (start + i + 0.5f) * scale - 0.5f;
+          int   left   = scale_floor( center - radius ) + 1;
+          int   f      = CLAMP( left, 0, src_size - taps );
+          s16  *w      = weights + i * taps;
+          float sum    = 0;
+          int   total  = 0;
+          int   peak   = 0;
+
+          for (j = 0; j < taps; j++)
+               k[j] = 0;
+
+          for (j = left; j < left + span; j++) {
+               float v = scale_kernel( (j - center) / step, bicubic );
+
+               k[CLAMP( j, 0, src_size - 1 ) - f] += v;
+
+               sum += v;
+          }
+
+          for (j = 0; j < taps; j++) {
+               w[j] = scale_round( k[j] * (1 << SCALE_WEIGHT_BITS) / sum );
+
+               total += w[j];
+
+               if (w[j] > w[peak])
+                    peak = j;
+          }
+
+          /* Make the weights sum up to one exactly. */
+          w[peak] += (1 << SCALE_WEIGHT_BITS) - total;
+
+          first[i] = f;
+     }
+}
+
+/*
+ * Return the filter bank of the output pixels 'start' to 'start + count - 1', computing it only if the bank kept from
+ * a previous blit has a different scaling or does not cover these pixels.
+ */
+static bool
+scale_bank_get( GenefxScaleBank  *bank,
+                int               src_size,
+                int               dst_size,
+                int               start,
+                int               count,
+                bool              bicubic,
+                int             **ret_first,
+                s16             **ret_weights )
+{
+     int taps = scale_taps( src_size, dst_size, bicubic );
+
+     if (bank->src_size != src_size || bank->dst_size != dst_size || bank->bicubic != bicubic ||
+         start < bank->start || start + count > bank->start + bank->count) {
+          float *k;
+          int    size = taps * sizeof(float) + count * (sizeof(int) + taps * sizeof(s16));
+
+          /* Nothing is kept if the allocation fails. */
+          bank->count = 0;
+
+          if (bank->size < size) {
+               if (bank->mem)
+                    D_FREE( bank->mem );
+
+               bank->mem  = D_MALLOC( size );
+               bank->size = 0;
+
+               if (!bank->mem) {
+                    D_OOM();
+                    return false;
+               }
+
+               bank->size = size;
+          }
+
+          k             = bank->mem;
+          bank->first   = (int*) (k + taps);
+          bank->weights = (s16*) (bank->first + count);
+
+          scale_bank( src_size, dst_size, start, count, bicubic, taps, bank->first, bank->weights, k );
+
+          bank->src_size = src_size;
+          bank->dst_size = dst_size;
+          bank->start    = start;
+          bank->count    = count;
+          bank->bicubic  = bicubic;
+     }
+
+     *ret_first   = bank->first   + start - bank->start;
+     *ret_weights = bank->weights + (start - bank->start) * taps;
+
+     return true;
+}
+
+static void
+scale_premultiply( const u32 *S,
+                   u32       *D,
+                   int        count )
+{
+     int i;
+
+     for (i = 0; i < count; i++) {
+          u32 p = S[i];
+          u32 a = (p >> 24) + 1;
+
+          if (a == 0x100)
+               D[i] = p;
+          else
+               D[i] = (p & 0xff000000) | ((((p & 0x00ff00ff) * a) >> 8) & 0x00ff00ff) |
+                                         ((((p & 0x0000ff00) * a) >> 8) & 0x0000ff00);
+     }
+}
+
+static void
+scale_opaque( const u32 *S,
+              u32       *D,
+              int        count )
+{
+     int i;
+
+     for (i = 0; i < count; i++)
+          D[i] = S[i] | 0xff000000;
+}
+
+static void
+scale_unpremultiply( const u32 *S,
+                     u32       *D,
+                     int        count,
+                     const u32 *recip,
+                     u32        alpha )
+{
+     int i;
+
+     for (i = 0; i < count; i++) {
+          u32 p = S[i];
+          u32 a = p >> 24;
+          u32 f = recip[a];
+
+          if (a == 0xff)
+               D[i] = p | alpha;
+          else if (!a)
+               D[i] = alpha;
+          else
+               D[i] = PIXEL_ARGB( a, MIN( ((p >> 16 & 0xff) * f + 0x8000) >> 16, 0xff ),
+                                     MIN( ((p >>  8 & 0xff) * f + 0x8000) >> 16, 0xff ),
+                                     MIN( ((p       & 0xff) * f + 0x8000) >> 16, 0xff ) ) | alpha;
+     }
+}
+
+bool
+Genefx_Scale( CardState    *state,
+              DFBRectangle *srect,
+              DFBRectangle *drect )
+{
+     int              x, y, t;
+     int              cw, ch;
+     int              tx, ty;
+     int              sx0, sx1;
+     int              rsize;
+     bool             bicubic;
+     bool             premultiply;
+     bool             unpremultiply;
+     bool             opaque;
+     u32              alpha;
+     u32              recip[256];
+     void            *mem;
+     s16             *rows;
+     const s16      **L;
+     int             *tags;
+     u32             *line;
+     u32             *out;
+     int             *xfirst;
+     int             *yfirst;
+     s16             *xweights;
+     s16             *yweights;
+     ScaleLineFunc    scale_line_func   = scale_line;
+     ScaleColumnFunc  scale_column_func = scale_column;
+     DFBRegion        clip;
+     GenefxState     *gfxs              = state->gfxs;
+
+     /* Only unblended blits, optionally premultiplying the source. */
+     if (state->blittingflags & ~DSBLIT_SRC_PREMULTIPLY)
+          return false;
+
+     if (srect->w > drect->w && srect->h > drect->h) {
+          if (!(state->render_options & DSRO_SMOOTH_DOWNSCALE))
+               return false;
+     }
+     else {
+          if (!(state->render_options & DSRO_SMOOTH_UPSCALE))
+               return false;
+     }
+
+     if ((gfxs->src_format != DSPF_ARGB && gfxs->src_format != DSPF_RGB32) ||
+         (gfxs->dst_format != DSPF_ARGB && gfxs->dst_format != DSPF_RGB32))
+          return false;
+
+     if ((gfxs->src_caps | gfxs->dst_caps) & DSCAPS_SEPARATED)
+          return false;
+
+     /* Scaled lines of the source would overwrite lines not being read yet. */
+     if (gfxs->src_org[0] == gfxs->dst_org[0])
+          return false;
+
+     opaque        = gfxs->src_format == DSPF_RGB32;
+     premultiply   = !opaque && !(gfxs->src_caps & DSCAPS_PREMULTIPLIED);
+     unpremultiply = premultiply && !(state->blittingflags & DSBLIT_SRC_PREMULTIPLY);
+     alpha         = (gfxs->dst_format == DSPF_RGB32) ? 0xff000000 : 0;
+     bicubic       = state->render_options & DSRO_SMOOTH_BICUBIC;
+
+     /* A premultiplied source is not premultiplied again. */
+     if (!opaque && !premultiply && (state->blittingflags & DSBLIT_SRC_PREMULTIPLY))
+          return false;
+
+     clip = state->clip;
+
+     if (!dfb_region_rectangle_intersect( &clip, drect ))
+          return true;
+
+     D_DEBUG_AT( Genefx_Scaling, "%s( %4d,%4d-%4dx%4d <- %4d,%4d-%4dx%4d ) <- %s\n", __FUNCTION__,
+                 DFB_RECTANGLE_VALS( drect ), DFB_RECTANGLE_VALS( srect ), bicubic ? "bicubic" : "bilinear" );
+
+     cw = clip.x2 - clip.x1 + 1;
+     ch = clip.y2 - clip.y1 + 1;
+
+     tx = scale_taps( srect->w, drect->w, bicubic );
+     ty = scale_taps( srect->h, drect->h, bicubic );
+
+     /* Horizontally scaled lines with four channels per pixel, aligned for loading pairs of pixels. */
+     rsize = ((cw + 1) & ~1) * 4;
+
+     /* The filter banks are kept in the state, e.g. for the following rectangles of a batch. */
+     if (!scale_bank_get( &gfxs->ScaleBanks[0], srect->w, drect->w, clip.x1 - drect->x, cw, bicubic,
+                          &xfirst, &xweights ) ||
+         !scale_bank_get( &gfxs->ScaleBanks[1], srect->h, drect->h, clip.y1 - drect->y, ch, bicubic,
+                          &yfirst, &yweights ))
+          return false;
+
+     mem = D_MALLOC( ty * rsize * sizeof(s16) + ty * (sizeof(s16*) + sizeof(int)) + (srect->w + cw) * sizeof(u32) +
+                     15 );
+     if (!mem) {
+          D_OOM();
+          return false;
+     }
+
+     rows = (s16*) (((unsigned long) mem + 15) & ~15);
+     L    = (const s16**) (rows + ty * rsize);
+     tags = (int*) (L + ty);
+     line = (u32*) (tags + ty);
+     out  = line + srect->w;
+
+     /* Part of the source lines being read, as the first source pixel increases with the output pixel. */
+     sx0 = xfirst[0];
+     sx1 = xfirst[cw-1] + tx;
+
+     if (unpremultiply) {
+          recip[0] = 0;
+
+          for (x = 1; x < 256; x++)
+               recip[x] = ((0xff << 16) + x / 2) / x;
+     }
+
+#ifdef USE_SSE2
+     {
+          static int use_sse2 = -1;
+
+          if (use_sse2 < 0)
+               use_sse2 = dfb_config->sse2 && __builtin_cpu_supports( "sse2" );
+
+          if (use_sse2) {
+               if (!(tx & 1))
+                    scale_line_func = scale_line_SSE2;
+
+               if (!(ty & 1))
+                    scale_column_func = scale_column_SSE2;
+          }
+     }
+#endif
+
+     for (t = 0; t < ty; t++)
+          tags[t] = -1;
+
+     for (y = 0; y < ch; y++) {
+          u32 *D = (u32*) (gfxs->dst_org[0] + (clip.y1 + y) * gfxs->dst_pitch) + clip.x1;
+
+          /* Horizontally scale the source lines not being kept from the previous output line. */
+          for (t = 0; t < ty; t++) {
+               int  sy   = yfirst[y] + t;
+               int  slot = sy % ty;
+               s16 *row  = rows + slot * rsize;
+
+               if (tags[slot] != sy) {
+                    const u32 *S = (const u32*) (gfxs->src_org[0] + (srect->y + sy) * gfxs->src_pitch) + srect->x;
+
+                    if (premultiply) {
+                         scale_premultiply( S + sx0, line + sx0, sx1 - sx0 );
+                         S = line;
+                    }
+                    else if (opaque) {
+                         scale_opaque( S + sx0, line + sx0, sx1 - sx0 );
+                         S = line;
+                    }
+
+                    scale_line_func( S, row, xfirst, xweights, tx, cw );
+
+                    tags[slot] = sy;
+               }
+
+               L[t] = row;
+          }
+
+          if (unpremultiply || (alpha && !opaque)) {
+               scale_column_func( L, yweights + y * ty, ty, out, cw );
+
+               if (unpremultiply)
+                    scale_unpremultiply( out, D, cw, recip, alpha );
+               else
+                    for (x = 0; x < cw; x++)
+                         D[x] = out[x] | alpha;
+          }
+          else
+               scale_column_func( L, yweights + y * ty, ty, D, cw );
+     }
+
+     D_FREE( mem );
+
+     return true;
+}
+
+void
+Genefx_Scale_Flush( GenefxState *gfxs )
+{
+     int i;
+
+     for (i = 0; i < D_ARRAY_SIZE(gfxs->ScaleBanks); i++) {
+          if (gfxs->ScaleBanks[i].mem)
+               D_FREE( gfxs->ScaleBanks[i].mem );
+     }
+
+     memset( gfxs->ScaleBanks, 0, sizeof(gfxs->ScaleBanks) );
+}
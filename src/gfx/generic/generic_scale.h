@@ -0,0 +1,40 @@
+/*
+   This file is part of DirectFB.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+*/
+
+#ifndef __GENERIC_SCALE_H__
+#define __GENERIC_SCALE_H__
+
+#include <core/coretypes.h>
+
+/**********************************************************************************************************************/
+
+/*
+ * Scale the source rectangle to the destination rectangle with a separable bilinear or bicubic (DSRO_SMOOTH_BICUBIC)
+ * filter, in premultiplied alpha. Only unblended ARGB or RGB32 blits are handled, optionally with
+ * DSBLIT_SRC_PREMULTIPLY, otherwise false is returned without rendering.
+ */
+bool Genefx_Scale      ( CardState    *state,
+                        DFBRectangle *srect,
+                        DFBRectangle *drect );
+
+/*
+ * Free the filter banks kept in the state.
+ */
+void Genefx_Scale_Flush( GenefxState  *gfxs );
+
+#endif
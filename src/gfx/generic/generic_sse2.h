@@ -0,0 +1,1373 @@
+/*
+   This file is part of DirectFB.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+*/
+
+#include <emmintrin.h>
+
+/*
+ * The SSE2 functions process two accumulators per register and produce exactly the same results as the C functions:
+ * products are computed with 32 bit precision before the shift and the 0xf000 alpha marker of skipped pixels is
+ * honored.
+ */
+
+#define SSE2_FUNC __attribute__((target("sse2")))
+
+/**********************************************************************************************************************/
+
+/* (a * f) >> 8, truncated to 16 bits per channel */
+static inline SSE2_FUNC __m128i
+acc_mul8_SSE2( __m128i a, __m128i f )
+{
+     __m128i lo = _mm_mullo_epi16( a, f );
+     __m128i hi = _mm_mulhi_epu16( a, f );
+
+     return _mm_or_si128( _mm_srli_epi16( lo, 8 ), _mm_slli_epi16( hi, 8 ) );
+}
+
+/* replicate the alpha channel of each accumulator to all four channels */
+static inline SSE2_FUNC __m128i
+acc_alpha_SSE2( __m128i a )
+{
+     return _mm_shufflehi_epi16( _mm_shufflelo_epi16( a, 0xff ), 0xff );
+}
+
+/* all bits set in the channels of accumulators that are not skipped */
+static inline SSE2_FUNC __m128i
+acc_keep_SSE2( __m128i a )
+{
+     return acc_alpha_SSE2( _mm_cmpeq_epi16( _mm_and_si128( a, _mm_set1_epi16( 0xf000 ) ), _mm_setzero_si128() ) );
+}
+
+static inline SSE2_FUNC __m128i
+acc_select_SSE2( __m128i mask, __m128i a, __m128i b )
+{
+     return _mm_or_si128( _mm_and_si128( mask, a ), _mm_andnot_si128( mask, b ) );
+}
+
+/* channels having bits in 0xff00 are saturated to 0xff */
+static inline SSE2_FUNC __m128i
+acc_clamp_SSE2( __m128i a )
+{
+     __m128i fit = _mm_cmpeq_epi16( _mm_and_si128( a, _mm_set1_epi16( 0xff00 ) ), _mm_setzero_si128() );
+
+     return acc_select_SSE2( fit, a, _mm_set1_epi16( 0x00ff ) );
+}
+
+/* two RGB16 pixels replicated to all channels of two accumulators to expanded ARGB */
+static inline SSE2_FUNC __m128i
+acc_expand_rgb16_SSE2( __m128i p )
+{
+     const __m128i lane_b = _mm_set_epi16( 0, 0, 0, -1, 0, 0, 0, -1 );
+     const __m128i lane_g = _mm_set_epi16( 0, 0, -1, 0, 0, 0, -1, 0 );
+     const __m128i lane_r = _mm_set_epi16( 0, -1, 0, 0, 0, -1, 0, 0 );
+     const __m128i alpha  = _mm_set_epi16( 0xff, 0, 0, 0, 0xff, 0, 0, 0 );
+     __m128i       c, e5, e6;
+
+     c = _mm_or_si128( _mm_and_si128( lane_b, _mm_and_si128( p, _mm_set1_epi16( 0x1f ) ) ),
+         _mm_or_si128( _mm_and_si128( lane_g, _mm_and_si128( _mm_srli_epi16( p, 5 ), _mm_set1_epi16( 0x3f ) ) ),
+                       _mm_and_si128( lane_r, _mm_srli_epi16( p, 11 ) ) ) );
+
+     e5 = _mm_or_si128( _mm_slli_epi16( c, 3 ), _mm_srli_epi16( c, 2 ) );
+     e6 = _mm_or_si128( _mm_slli_epi16( c, 2 ), _mm_srli_epi16( c, 4 ) );
+
+     return _mm_or_si128( _mm_or_si128( _mm_and_si128( _mm_or_si128( lane_b, lane_r ), e5 ),
+                                        _mm_and_si128( lane_g, e6 ) ), alpha );
+}
+
+/**********************************************************************************************************************/
+
+static inline SSE2_FUNC __m128i
+Xacc_blend_alpha_SSE2( __m128i y, __m128i f )
+{
+     return acc_select_SSE2( acc_keep_SSE2( y ), acc_mul8_SSE2( y, f ), y );
+}
+
+static SSE2_FUNC void
+Xacc_blend_srcalpha_SSE2( GenefxState *gfxs )
+{
+     int                w   = gfxs->length;
+     GenefxAccumulator *X   = gfxs->Xacc;
+     GenefxAccumulator *Y   = gfxs->Yacc;
+     const __m128i      one = _mm_set1_epi16( 1 );
+
+     if (gfxs->Sacc) {
+          GenefxAccumulator *S = gfxs->Sacc;
+
+          for (; w > 1; w -= 2) {
+               __m128i f = _mm_add_epi16( acc_alpha_SSE2( _mm_loadu_si128( (__m128i*) S ) ), one );
+
+               _mm_storeu_si128( (__m128i*) X, Xacc_blend_alpha_SSE2( _mm_loadu_si128( (__m128i*) Y ), f ) );
+
+               S += 2;
+               X += 2; Y += 2;
+          }
+
+          if (w) {
+               __m128i f = _mm_add_epi16( acc_alpha_SSE2( _mm_loadl_epi64( (__m128i*) S ) ), one );
+
+               _mm_storel_epi64( (__m128i*) X, Xacc_blend_alpha_SSE2( _mm_loadl_epi64( (__m128i*) Y ), f ) );
+          }
+     }
+     else {
+          __m128i f = _mm_set1_epi16( gfxs->color.a + 1 );
+
+          for (; w > 1; w -= 2) {
+               _mm_storeu_si128( (__m128i*) X, Xacc_blend_alpha_SSE2( _mm_loadu_si128( (__m128i*) Y ), f ) );
+
+               X += 2; Y += 2;
+          }
+
+          if (w)
+               _mm_storel_epi64( (__m128i*) X, Xacc_blend_alpha_SSE2( _mm_loadl_epi64( (__m128i*) Y ), f ) );
+     }
+}
+
+static SSE2_FUNC void
+Xacc_blend_invsrcalpha_SSE2( GenefxState *gfxs )
+{
+     int                w     = gfxs->length;
+     GenefxAccumulator *X     = gfxs->Xacc;
+     GenefxAccumulator *Y     = gfxs->Yacc;
+     const __m128i      x0100 = _mm_set1_epi16( 0x100 );
+
+     if (gfxs->Sacc) {
+          GenefxAccumulator *S = gfxs->Sacc;
+
+          for (; w > 1; w -= 2) {
+               __m128i f = _mm_sub_epi16( x0100, acc_alpha_SSE2( _mm_loadu_si128( (__m128i*) S ) ) );
+
+               _mm_storeu_si128( (__m128i*) X, Xacc_blend_alpha_SSE2( _mm_loadu_si128( (__m128i*) Y ), f ) );
+
+               S += 2;
+               X += 2; Y += 2;
+          }
+
+          if (w) {
+               __m128i f = _mm_sub_epi16( x0100, acc_alpha_SSE2( _mm_loadl_epi64( (__m128i*) S ) ) );
+
+               _mm_storel_epi64( (__m128i*) X, Xacc_blend_alpha_SSE2( _mm_loadl_epi64( (__m128i*) Y ), f ) );
+          }
+     }
+     else {
+          __m128i f = _mm_set1_epi16( 0x100 - gfxs->color.a );
+
+          for (; w > 1; w -= 2) {
+               _mm_storeu_si128( (__m128i*) X, Xacc_blend_alpha_SSE2( _mm_loadu_si128( (__m128i*) Y ), f ) );
+
+               X += 2; Y += 2;
+          }
+
+          if (w)
+               _mm_storel_epi64( (__m128i*) X, Xacc_blend_alpha_SSE2( _mm_loadl_epi64( (__m128i*) Y ), f ) );
+     }
+}
+
+/**********************************************************************************************************************/
+
+static SSE2_FUNC void
+Dacc_modulate_argb_SSE2( GenefxState *gfxs )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *D = gfxs->Dacc;
+     __m128i            C = _mm_set_epi16( gfxs->Cacc.RGB.a, gfxs->Cacc.RGB.r, gfxs->Cacc.RGB.g, gfxs->Cacc.RGB.b,
+                                           gfxs->Cacc.RGB.a, gfxs->Cacc.RGB.r, gfxs->Cacc.RGB.g, gfxs->Cacc.RGB.b );
+
+     for (; w > 1; w -= 2) {
+          _mm_storeu_si128( (__m128i*) D, Xacc_blend_alpha_SSE2( _mm_loadu_si128( (__m128i*) D ), C ) );
+
+          D += 2;
+     }
+
+     if (w)
+          _mm_storel_epi64( (__m128i*) D, Xacc_blend_alpha_SSE2( _mm_loadl_epi64( (__m128i*) D ), C ) );
+}
+
+/**********************************************************************************************************************/
+
+static inline SSE2_FUNC __m128i
+Dacc_add_SSE2( __m128i d, __m128i s )
+{
+     return acc_select_SSE2( acc_keep_SSE2( d ), _mm_add_epi16( d, s ), d );
+}
+
+static SSE2_FUNC void
+SCacc_add_to_Dacc_SSE2( GenefxState *gfxs )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *D = gfxs->Dacc;
+     __m128i            S = _mm_set_epi16( gfxs->SCacc.RGB.a, gfxs->SCacc.RGB.r, gfxs->SCacc.RGB.g, gfxs->SCacc.RGB.b,
+                                           gfxs->SCacc.RGB.a, gfxs->SCacc.RGB.r, gfxs->SCacc.RGB.g, gfxs->SCacc.RGB.b );
+
+     for (; w > 1; w -= 2) {
+          _mm_storeu_si128( (__m128i*) D, Dacc_add_SSE2( _mm_loadu_si128( (__m128i*) D ), S ) );
+
+          D += 2;
+     }
+
+     if (w)
+          _mm_storel_epi64( (__m128i*) D, Dacc_add_SSE2( _mm_loadl_epi64( (__m128i*) D ), S ) );
+}
+
+static SSE2_FUNC void
+Sacc_add_to_Dacc_SSE2( GenefxState *gfxs )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *S = gfxs->Sacc;
+     GenefxAccumulator *D = gfxs->Dacc;
+
+     for (; w > 1; w -= 2) {
+          _mm_storeu_si128( (__m128i*) D, Dacc_add_SSE2( _mm_loadu_si128( (__m128i*) D ),
+                                                         _mm_loadu_si128( (__m128i*) S ) ) );
+
+          S += 2;
+          D += 2;
+     }
+
+     if (w)
+          _mm_storel_epi64( (__m128i*) D, Dacc_add_SSE2( _mm_loadl_epi64( (__m128i*) D ),
+                                                         _mm_loadl_epi64( (__m128i*) S ) ) );
+}
+
+/**********************************************************************************************************************/
+
+static SSE2_FUNC void
+Sop_argb_to_Dacc_SSE2( GenefxState *gfxs )
+{
+     int                w    = gfxs->length;
+     u32               *S    = gfxs->Sop[0];
+     GenefxAccumulator *D    = gfxs->Dacc;
+     const __m128i      zero = _mm_setzero_si128();
+
+     if (gfxs->Ostep != 1) {
+          Sop_argb_to_Dacc( gfxs );
+          return;
+     }
+
+     for (; w > 3; w -= 4) {
+          __m128i s = _mm_loadu_si128( (__m128i*) S );
+
+          _mm_storeu_si128( (__m128i*) D,       _mm_unpacklo_epi8( s, zero ) );
+          _mm_storeu_si128( (__m128i*) (D + 2), _mm_unpackhi_epi8( s, zero ) );
+
+          S += 4;
+          D += 4;
+     }
+
+     if (w > 1) {
+          _mm_storeu_si128( (__m128i*) D, _mm_unpacklo_epi8( _mm_loadl_epi64( (__m128i*) S ), zero ) );
+
+          S += 2;
+          D += 2;
+          w -= 2;
+     }
+
+     if (w)
+          _mm_storel_epi64( (__m128i*) D, _mm_unpacklo_epi8( _mm_cvtsi32_si128( *S ), zero ) );
+}
+
+static SSE2_FUNC void
+Sop_rgb32_to_Dacc_SSE2( GenefxState *gfxs )
+{
+     int                w     = gfxs->length;
+     u32               *S     = gfxs->Sop[0];
+     GenefxAccumulator *D     = gfxs->Dacc;
+     const __m128i      zero  = _mm_setzero_si128();
+     const __m128i      alpha = _mm_set1_epi32( 0xff000000 );
+
+     if (gfxs->Ostep != 1) {
+          Sop_rgb32_to_Dacc( gfxs );
+          return;
+     }
+
+     for (; w > 3; w -= 4) {
+          __m128i s = _mm_or_si128( _mm_loadu_si128( (__m128i*) S ), alpha );
+
+          _mm_storeu_si128( (__m128i*) D,       _mm_unpacklo_epi8( s, zero ) );
+          _mm_storeu_si128( (__m128i*) (D + 2), _mm_unpackhi_epi8( s, zero ) );
+
+          S += 4;
+          D += 4;
+     }
+
+     if (w > 1) {
+          __m128i s = _mm_or_si128( _mm_loadl_epi64( (__m128i*) S ), alpha );
+
+          _mm_storeu_si128( (__m128i*) D, _mm_unpacklo_epi8( s, zero ) );
+
+          S += 2;
+          D += 2;
+          w -= 2;
+     }
+
+     if (w)
+          _mm_storel_epi64( (__m128i*) D, _mm_unpacklo_epi8( _mm_or_si128( _mm_cvtsi32_si128( *S ), alpha ), zero ) );
+}
+
+/* texture lookup of 32 bit pixels, stepping the texture coordinates per pixel and expanding four pixels at once */
+static inline SSE2_FUNC void
+tex_32_to_Dacc_SSE2( GenefxState *gfxs,
+                     __m128i      alpha )
+{
+     int                s     = gfxs->s;
+     int                t     = gfxs->t;
+     int                w     = gfxs->length;
+     const u32         *S     = gfxs->Sop[0];
+     GenefxAccumulator *D     = gfxs->Dacc;
+     int                sp4   = gfxs->src_pitch / 4;
+     int                SperD = gfxs->SperD;
+     int                TperD = gfxs->TperD;
+     const __m128i      zero  = _mm_setzero_si128();
+
+     for (; w > 3; w -= 4) {
+          u32     p[4];
+          int     i;
+          __m128i v;
+
+          for (i = 0; i < 4; i++) {
+               p[i] = S[(s>>16) + (t>>16) * sp4];
+
+               s += SperD;
+               t += TperD;
+          }
+
+          v = _mm_or_si128( _mm_set_epi32( p[3], p[2], p[1], p[0] ), alpha );
+
+          _mm_storeu_si128( (__m128i*) D,       _mm_unpacklo_epi8( v, zero ) );
+          _mm_storeu_si128( (__m128i*) (D + 2), _mm_unpackhi_epi8( v, zero ) );
+
+          D += 4;
+     }
+
+     while (w--) {
+          __m128i v = _mm_or_si128( _mm_cvtsi32_si128( S[(s>>16) + (t>>16) * sp4] ), alpha );
+
+          _mm_storel_epi64( (__m128i*) D, _mm_unpacklo_epi8( v, zero ) );
+
+          s += SperD;
+          t += TperD;
+          D++;
+     }
+}
+
+static SSE2_FUNC void
+Sop_argb_TEX_to_Dacc_SSE2( GenefxState *gfxs )
+{
+     if (gfxs->Ostep != 1) {
+          Sop_argb_TEX_to_Dacc( gfxs );
+          return;
+     }
+
+     tex_32_to_Dacc_SSE2( gfxs, _mm_setzero_si128() );
+}
+
+static SSE2_FUNC void
+Sop_rgb32_TEX_to_Dacc_SSE2( GenefxState *gfxs )
+{
+     if (gfxs->Ostep != 1) {
+          Sop_rgb32_TEX_to_Dacc( gfxs );
+          return;
+     }
+
+     tex_32_to_Dacc_SSE2( gfxs, _mm_set1_epi32( 0xff000000 ) );
+}
+
+static SSE2_FUNC void
+Sop_rgb16_to_Dacc_SSE2( GenefxState *gfxs )
+{
+     int                w = gfxs->length;
+     u16               *S = gfxs->Sop[0];
+     GenefxAccumulator *D = gfxs->Dacc;
+
+     if (gfxs->Ostep != 1) {
+          Sop_rgb16_to_Dacc( gfxs );
+          return;
+     }
+
+     for (; w > 3; w -= 4) {
+          __m128i s = _mm_loadl_epi64( (__m128i*) S );
+
+          s = _mm_unpacklo_epi16( s, s );
+
+          _mm_storeu_si128( (__m128i*) D,       acc_expand_rgb16_SSE2( _mm_unpacklo_epi32( s, s ) ) );
+          _mm_storeu_si128( (__m128i*) (D + 2), acc_expand_rgb16_SSE2( _mm_unpackhi_epi32( s, s ) ) );
+
+          S += 4;
+          D += 4;
+     }
+
+     for (; w; w--) {
+          __m128i s = _mm_set1_epi16( *S );
+
+          _mm_storel_epi64( (__m128i*) D, acc_expand_rgb16_SSE2( s ) );
+
+          S++;
+          D++;
+     }
+}
+
+static SSE2_FUNC void
+Sop_a8_to_Dacc_SSE2( GenefxState *gfxs )
+{
+     int                w     = gfxs->length;
+     u8                *S     = gfxs->Sop[0];
+     GenefxAccumulator *D     = gfxs->Dacc;
+     const __m128i      zero  = _mm_setzero_si128();
+     const __m128i      white = _mm_set1_epi16( 0xff );
+
+     for (; w > 3; w -= 4) {
+          __m128i a = _mm_unpacklo_epi8( _mm_cvtsi32_si128( *(u32*) S ), zero );
+
+          a = _mm_unpacklo_epi16( white, a );
+
+          _mm_storeu_si128( (__m128i*) D,       _mm_unpacklo_epi32( white, a ) );
+          _mm_storeu_si128( (__m128i*) (D + 2), _mm_unpackhi_epi32( white, a ) );
+
+          S += 4;
+          D += 4;
+     }
+
+     for (; w; w--) {
+          D->RGB.a = *S++;
+          D->RGB.r = 0xff;
+          D->RGB.g = 0xff;
+          D->RGB.b = 0xff;
+
+          ++D;
+     }
+}
+
+/**********************************************************************************************************************/
+
+/* clamp and pack four accumulators, returning the byte mask of the pixels to be written in 'ret_keep' */
+static inline SSE2_FUNC __m128i
+Sacc_pack_SSE2( GenefxAccumulator *S,
+                __m128i           *ret_keep )
+{
+     __m128i s0 = _mm_loadu_si128( (__m128i*) S );
+     __m128i s1 = _mm_loadu_si128( (__m128i*) (S + 2) );
+
+     *ret_keep = _mm_packs_epi16( acc_keep_SSE2( s0 ), acc_keep_SSE2( s1 ) );
+
+     return _mm_packus_epi16( acc_clamp_SSE2( s0 ), acc_clamp_SSE2( s1 ) );
+}
+
+static SSE2_FUNC void
+Sacc_to_Aop_argb_SSE2( GenefxState *gfxs )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *S = gfxs->Sacc;
+     u32               *D = gfxs->Aop[0];
+
+     if (gfxs->Astep != 1) {
+          Sacc_to_Aop_argb( gfxs );
+          return;
+     }
+
+     for (; w > 3; w -= 4) {
+          __m128i keep;
+          __m128i p = Sacc_pack_SSE2( S, &keep );
+
+          _mm_storeu_si128( (__m128i*) D, acc_select_SSE2( keep, p, _mm_loadu_si128( (__m128i*) D ) ) );
+
+          S += 4;
+          D += 4;
+     }
+
+     for (; w; w--) {
+          if (!(S->RGB.a & 0xf000))
+               *D = PIXEL_ARGB( (S->RGB.a & 0xff00) ? 0xff : S->RGB.a,
+                                (S->RGB.r & 0xff00) ? 0xff : S->RGB.r,
+                                (S->RGB.g & 0xff00) ? 0xff : S->RGB.g,
+                                (S->RGB.b & 0xff00) ? 0xff : S->RGB.b );
+
+          ++S;
+          ++D;
+     }
+}
+
+static SSE2_FUNC void
+Sacc_to_Aop_rgb32_SSE2( GenefxState *gfxs )
+{
+     int                w     = gfxs->length;
+     GenefxAccumulator *S     = gfxs->Sacc;
+     u32               *D     = gfxs->Aop[0];
+     const __m128i      alpha = _mm_set1_epi32( 0xff000000 );
+
+     if (gfxs->Astep != 1) {
+          Sacc_to_Aop_rgb32( gfxs );
+          return;
+     }
+
+     for (; w > 3; w -= 4) {
+          __m128i keep;
+          __m128i p = _mm_or_si128( Sacc_pack_SSE2( S, &keep ), alpha );
+
+          _mm_storeu_si128( (__m128i*) D, acc_select_SSE2( keep, p, _mm_loadu_si128( (__m128i*) D ) ) );
+
+          S += 4;
+          D += 4;
+     }
+
+     for (; w; w--) {
+          if (!(S->RGB.a & 0xf000))
+               *D = PIXEL_RGB32( (S->RGB.r & 0xff00) ? 0xff : S->RGB.r,
+                                 (S->RGB.g & 0xff00) ? 0xff : S->RGB.g,
+                                 (S->RGB.b & 0xff00) ? 0xff : S->RGB.b );
+
+          ++S;
+          ++D;
+     }
+}
+
+static SSE2_FUNC void
+Sacc_to_Aop_rgb16_SSE2( GenefxState *gfxs )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *S = gfxs->Sacc;
+     u16               *D = gfxs->Aop[0];
+
+     if (gfxs->Astep != 1) {
+          Sacc_to_Aop_rgb16( gfxs );
+          return;
+     }
+
+     for (; w > 3; w -= 4) {
+          __m128i keep;
+          __m128i p = Sacc_pack_SSE2( S, &keep );
+
+          /* 32 bit ARGB to RGB16, sign extended for the signed saturation of packs */
+          p = _mm_or_si128( _mm_or_si128( _mm_and_si128( _mm_srli_epi32( p, 8 ), _mm_set1_epi32( 0xf800 ) ),
+                                          _mm_and_si128( _mm_srli_epi32( p, 5 ), _mm_set1_epi32( 0x07e0 ) ) ),
+                                          _mm_and_si128( _mm_srli_epi32( p, 3 ), _mm_set1_epi32( 0x001f ) ) );
+          p = _mm_srai_epi32( _mm_slli_epi32( p, 16 ), 16 );
+          p = _mm_packs_epi32( p, p );
+
+          /* one 16 bit mask per pixel */
+          keep = _mm_packs_epi32( keep, keep );
+
+          _mm_storel_epi64( (__m128i*) D, acc_select_SSE2( keep, p, _mm_loadl_epi64( (__m128i*) D ) ) );
+
+          S += 4;
+          D += 4;
+     }
+
+     for (; w; w--) {
+          if (!(S->RGB.a & 0xf000))
+               *D = PIXEL_RGB16( (S->RGB.r & 0xff00) ? 0xff : S->RGB.r,
+                                 (S->RGB.g & 0xff00) ? 0xff : S->RGB.g,
+                                 (S->RGB.b & 0xff00) ? 0xff : S->RGB.b );
+
+          ++S;
+          ++D;
+     }
+}
+
+static SSE2_FUNC void
+Sacc_to_Aop_a8_SSE2( GenefxState *gfxs )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *S = gfxs->Sacc;
+     u8                *D = gfxs->Aop[0];
+
+     for (; w > 3; w -= 4) {
+          __m128i keep;
+          __m128i p = Sacc_pack_SSE2( S, &keep );
+          u32     d = *(u32*) D;
+
+          /* alpha bytes of the four packed pixels */
+          p    = _mm_srli_epi32( p, 24 );
+          p    = _mm_packus_epi16( _mm_packs_epi32( p, p ), p );
+          keep = _mm_srai_epi32( keep, 24 );
+          keep = _mm_packs_epi16( _mm_packs_epi32( keep, keep ), keep );
+
+          *(u32*) D = _mm_cvtsi128_si32( acc_select_SSE2( keep, p, _mm_cvtsi32_si128( d ) ) );
+
+          S += 4;
+          D += 4;
+     }
+
+     for (; w; w--) {
+          if (!(S->RGB.a & 0xf000))
+               *D = (S->RGB.a & 0xff00) ? 0xff : S->RGB.a;
+
+          ++S;
+          ++D;
+     }
+}
+
+/**********************************************************************************************************************/
+
+/*
+ * The colorkey functions compare eight 16 bit or four 32 bit pixels at once, selecting the pixels to write with the
+ * resulting masks instead of branching per pixel. Spans not written left to right pixel by pixel, i.e. for rotated or
+ * overlapping blits, are done by the C functions.
+ */
+
+static inline SSE2_FUNC void
+Cop_toK_Aop_16_masked_SSE2( GenefxState *gfxs,
+                            u16          mask )
+{
+     int           w    = gfxs->length;
+     u16          *D    = gfxs->Aop[0];
+     u16           Cop  = gfxs->Cop;
+     u16           Dkey = gfxs->Dkey;
+     const __m128i m    = _mm_set1_epi16( mask );
+     const __m128i k    = _mm_set1_epi16( Dkey );
+     const __m128i c    = _mm_set1_epi16( Cop );
+
+     for (; w > 7; w -= 8) {
+          __m128i d = _mm_loadu_si128( (__m128i*) D );
+
+          _mm_storeu_si128( (__m128i*) D, acc_select_SSE2( _mm_cmpeq_epi16( _mm_and_si128( d, m ), k ), c, d ) );
+
+          D += 8;
+     }
+
+     for (; w; w--) {
+          if ((*D & mask) == Dkey)
+               *D = Cop;
+
+          ++D;
+     }
+}
+
+static inline SSE2_FUNC void
+Bop_16_Kto_Aop_masked_SSE2( GenefxState *gfxs,
+                            u16          mask )
+{
+     int           w    = gfxs->length;
+     u16          *S    = gfxs->Bop[0];
+     u16          *D    = gfxs->Aop[0];
+     u16           Skey = gfxs->Skey;
+     const __m128i m    = _mm_set1_epi16( mask );
+     const __m128i k    = _mm_set1_epi16( Skey );
+
+     for (; w > 7; w -= 8) {
+          __m128i s = _mm_loadu_si128( (__m128i*) S );
+          __m128i d = _mm_loadu_si128( (__m128i*) D );
+
+          _mm_storeu_si128( (__m128i*) D, acc_select_SSE2( _mm_cmpeq_epi16( _mm_and_si128( s, m ), k ), d, s ) );
+
+          S += 8;
+          D += 8;
+     }
+
+     for (; w; w--) {
+          u16 s = *S;
+
+          if ((s & mask) != Skey)
+               *D = s;
+
+          ++S;
+          ++D;
+     }
+}
+
+static inline SSE2_FUNC void
+Bop_16_toK_Aop_masked_SSE2( GenefxState *gfxs,
+                            u16          mask )
+{
+     int           w    = gfxs->length;
+     u16          *S    = gfxs->Bop[0];
+     u16          *D    = gfxs->Aop[0];
+     u16           Dkey = gfxs->Dkey;
+     const __m128i m    = _mm_set1_epi16( mask );
+     const __m128i k    = _mm_set1_epi16( Dkey );
+
+     for (; w > 7; w -= 8) {
+          __m128i s = _mm_loadu_si128( (__m128i*) S );
+          __m128i d = _mm_loadu_si128( (__m128i*) D );
+
+          _mm_storeu_si128( (__m128i*) D, acc_select_SSE2( _mm_cmpeq_epi16( _mm_and_si128( d, m ), k ), s, d ) );
+
+          S += 8;
+          D += 8;
+     }
+
+     for (; w; w--) {
+          if ((*D & mask) == Dkey)
+               *D = *S;
+
+          ++S;
+          ++D;
+     }
+}
+
+static inline SSE2_FUNC void
+Bop_16_KtoK_Aop_masked_SSE2( GenefxState *gfxs,
+                             u16          mask )
+{
+     int           w    = gfxs->length;
+     u16          *S    = gfxs->Bop[0];
+     u16          *D    = gfxs->Aop[0];
+     u16           Skey = gfxs->Skey;
+     u16           Dkey = gfxs->Dkey;
+     const __m128i m    = _mm_set1_epi16( mask );
+     const __m128i sk   = _mm_set1_epi16( Skey );
+     const __m128i dk   = _mm_set1_epi16( Dkey );
+
+     for (; w > 7; w -= 8) {
+          __m128i s     = _mm_loadu_si128( (__m128i*) S );
+          __m128i d     = _mm_loadu_si128( (__m128i*) D );
+          __m128i write = _mm_andnot_si128( _mm_cmpeq_epi16( _mm_and_si128( s, m ), sk ),
+                                            _mm_cmpeq_epi16( _mm_and_si128( d, m ), dk ) );
+
+          _mm_storeu_si128( (__m128i*) D, acc_select_SSE2( write, s, d ) );
+
+          S += 8;
+          D += 8;
+     }
+
+     for (; w; w--) {
+          u16 s = *S;
+
+          if ((s & mask) != Skey && (*D & mask) == Dkey)
+               *D = s;
+
+          ++S;
+          ++D;
+     }
+}
+
+static inline SSE2_FUNC void
+Cop_toK_Aop_32_masked_SSE2( GenefxState *gfxs,
+                            u32          mask )
+{
+     int           w    = gfxs->length;
+     u32          *D    = gfxs->Aop[0];
+     u32           Cop  = gfxs->Cop;
+     u32           Dkey = gfxs->Dkey;
+     const __m128i m    = _mm_set1_epi32( mask );
+     const __m128i k    = _mm_set1_epi32( Dkey );
+     const __m128i c    = _mm_set1_epi32( Cop );
+
+     for (; w > 3; w -= 4) {
+          __m128i d = _mm_loadu_si128( (__m128i*) D );
+
+          _mm_storeu_si128( (__m128i*) D, acc_select_SSE2( _mm_cmpeq_epi32( _mm_and_si128( d, m ), k ), c, d ) );
+
+          D += 4;
+     }
+
+     for (; w; w--) {
+          if ((*D & mask) == Dkey)
+               *D = Cop;
+
+          ++D;
+     }
+}
+
+static inline SSE2_FUNC void
+Bop_32_Kto_Aop_masked_SSE2( GenefxState *gfxs,
+                            u32          mask )
+{
+     int           w    = gfxs->length;
+     u32          *S    = gfxs->Bop[0];
+     u32          *D    = gfxs->Aop[0];
+     u32           Skey = gfxs->Skey;
+     const __m128i m    = _mm_set1_epi32( mask );
+     const __m128i k    = _mm_set1_epi32( Skey );
+
+     for (; w > 3; w -= 4) {
+          __m128i s = _mm_loadu_si128( (__m128i*) S );
+          __m128i d = _mm_loadu_si128( (__m128i*) D );
+
+          _mm_storeu_si128( (__m128i*) D, acc_select_SSE2( _mm_cmpeq_epi32( _mm_and_si128( s, m ), k ), d, s ) );
+
+          S += 4;
+          D += 4;
+     }
+
+     for (; w; w--) {
+          u32 s = *S;
+
+          if ((s & mask) != Skey)
+               *D = s;
+
+          ++S;
+          ++D;
+     }
+}
+
+static inline SSE2_FUNC void
+Bop_32_toK_Aop_masked_SSE2( GenefxState *gfxs,
+                            u32          mask )
+{
+     int           w    = gfxs->length;
+     u32          *S    = gfxs->Bop[0];
+     u32          *D    = gfxs->Aop[0];
+     u32           Dkey = gfxs->Dkey;
+     const __m128i m    = _mm_set1_epi32( mask );
+     const __m128i k    = _mm_set1_epi32( Dkey );
+
+     for (; w > 3; w -= 4) {
+          __m128i s = _mm_loadu_si128( (__m128i*) S );
+          __m128i d = _mm_loadu_si128( (__m128i*) D );
+
+          _mm_storeu_si128( (__m128i*) D, acc_select_SSE2( _mm_cmpeq_epi32( _mm_and_si128( d, m ), k ), s, d ) );
+
+          S += 4;
+          D += 4;
+     }
+
+     for (; w; w--) {
+          if ((*D & mask) == Dkey)
+               *D = *S;
+
+          ++S;
+          ++D;
+     }
+}
+
+static inline SSE2_FUNC void
+Bop_32_KtoK_Aop_masked_SSE2( GenefxState *gfxs,
+                             u32          mask )
+{
+     int           w    = gfxs->length;
+     u32          *S    = gfxs->Bop[0];
+     u32          *D    = gfxs->Aop[0];
+     u32           Skey = gfxs->Skey;
+     u32           Dkey = gfxs->Dkey;
+     const __m128i m    = _mm_set1_epi32( mask );
+     const __m128i sk   = _mm_set1_epi32( Skey );
+     const __m128i dk   = _mm_set1_epi32( Dkey );
+
+     for (; w > 3; w -= 4) {
+          __m128i s     = _mm_loadu_si128( (__m128i*) S );
+          __m128i d     = _mm_loadu_si128( (__m128i*) D );
+          __m128i write = _mm_andnot_si128( _mm_cmpeq_epi32( _mm_and_si128( s, m ), sk ),
+                                            _mm_cmpeq_epi32( _mm_and_si128( d, m ), dk ) );
+
+          _mm_storeu_si128( (__m128i*) D, acc_select_SSE2( write, s, d ) );
+
+          S += 4;
+          D += 4;
+     }
+
+     for (; w; w--) {
+          u32 s = *S;
+
+          if ((s & mask) != Skey && (*D & mask) == Dkey)
+               *D = s;
+
+          ++S;
+          ++D;
+     }
+}
+
+/* linear spans only, the C functions handle the other directions */
+#define GENEFX_SPAN_IS_LINEAR(gfxs) ((gfxs)->Ostep == 1 && (gfxs)->Astep == 1 && (gfxs)->Bstep == 1)
+
+#define COLORKEY_FUNCS_SSE2(PFI,bits,mask)                                  \
+                                                                            \
+static SSE2_FUNC void                                                       \
+Cop_toK_Aop_##PFI##_SSE2( GenefxState *gfxs )                               \
+{                                                                           \
+     Cop_toK_Aop_##bits##_masked_SSE2( gfxs, mask );                        \
+}                                                                           \
+                                                                            \
+static SSE2_FUNC void                                                       \
+Bop_##PFI##_Kto_Aop_SSE2( GenefxState *gfxs )                               \
+{                                                                           \
+     if (GENEFX_SPAN_IS_LINEAR( gfxs ))                                     \
+          Bop_##bits##_Kto_Aop_masked_SSE2( gfxs, mask );                   \
+     else                                                                   \
+          Bop_##PFI##_Kto_Aop( gfxs );                                      \
+}                                                                           \
+                                                                            \
+static SSE2_FUNC void                                                       \
+Bop_##PFI##_toK_Aop_SSE2( GenefxState *gfxs )                               \
+{                                                                           \
+     if (GENEFX_SPAN_IS_LINEAR( gfxs ))                                     \
+          Bop_##bits##_toK_Aop_masked_SSE2( gfxs, mask );                   \
+     else                                                                   \
+          Bop_##PFI##_toK_Aop( gfxs );                                      \
+}                                                                           \
+                                                                            \
+static SSE2_FUNC void                                                       \
+Bop_##PFI##_KtoK_Aop_SSE2( GenefxState *gfxs )                              \
+{                                                                           \
+     if (GENEFX_SPAN_IS_LINEAR( gfxs ))                                     \
+          Bop_##bits##_KtoK_Aop_masked_SSE2( gfxs, mask );                  \
+     else                                                                   \
+          Bop_##PFI##_KtoK_Aop( gfxs );                                     \
+}
+
+/* ARGB1555 / RGB555 / BGR555 / RGBA5551 */
+COLORKEY_FUNCS_SSE2( 15, 16, 0x7fff )
+
+/* RGB16 */
+COLORKEY_FUNCS_SSE2( 16, 16, 0xffff )
+
+/* ARGB4444 / RGB444 */
+COLORKEY_FUNCS_SSE2( 12, 16, 0x0fff )
+
+/* RGB32 / ARGB / ABGR / AiRGB / AYUV / AVYU */
+COLORKEY_FUNCS_SSE2( 32, 32, 0x00ffffff )
+
+#undef COLORKEY_FUNCS_SSE2
+#undef GENEFX_SPAN_IS_LINEAR
+
+/**********************************************************************************************************************/
+
+static SSE2_FUNC void
+Dacc_Skey_extended_SSE2( GenefxState *gfxs )
+{
+     int                w     = gfxs->length;
+     GenefxAccumulator *D     = gfxs->Dacc;
+     DFBColor           lower = gfxs->SkeyExtended.lower;
+     DFBColor           upper = gfxs->SkeyExtended.upper;
+     bool               other = gfxs->SkeyExtended.polarity == DCKP_OTHER;
+     const __m128i      alpha = _mm_set_epi16( -1, 0, 0, 0, -1, 0, 0, 0 );
+     const __m128i      mark  = _mm_set1_epi16( 0xf000 );
+     /* the alpha channel is always in range, including the marker of skipped pixels */
+     const __m128i      lo    = _mm_set_epi16( -0x8000, lower.r, lower.g, lower.b, -0x8000, lower.r, lower.g, lower.b );
+     const __m128i      hi    = _mm_set_epi16(  0x7fff, upper.r, upper.g, upper.b,  0x7fff, upper.r, upper.g, upper.b );
+
+     for (; w > 1; w -= 2) {
+          __m128i d   = _mm_loadu_si128( (__m128i*) D );
+          __m128i out = _mm_or_si128( _mm_cmplt_epi16( d, lo ), _mm_cmpgt_epi16( d, hi ) );
+          __m128i key;
+
+          /* any channel out of range */
+          out = _mm_or_si128( out, _mm_shufflehi_epi16( _mm_shufflelo_epi16( out, 0xb1 ), 0xb1 ) );
+          out = _mm_or_si128( out, _mm_shufflehi_epi16( _mm_shufflelo_epi16( out, 0x4e ), 0x4e ) );
+
+          key = other ? out : _mm_andnot_si128( out, _mm_set1_epi16( -1 ) );
+          key = _mm_and_si128( _mm_and_si128( key, acc_keep_SSE2( d ) ), alpha );
+
+          _mm_storeu_si128( (__m128i*) D, acc_select_SSE2( key, mark, d ) );
+
+          D += 2;
+     }
+
+     if (w && !(D->RGB.a & 0xf000)) {
+          bool in_range = D->RGB.r >= lower.r && D->RGB.r <= upper.r &&
+                          D->RGB.g >= lower.g && D->RGB.g <= upper.g &&
+                          D->RGB.b >= lower.b && D->RGB.b <= upper.b;
+
+          if (in_range != other)
+               D->RGB.a = 0xf000;
+     }
+}
+
+/**********************************************************************************************************************/
+
+/*
+ * Convert eight pixels of Y, Cb and Cr samples (widened to 16 bit) to 8 bit R, G and B in the low half of the results,
+ * computing the sums of YCBCR_TO_RGB() exactly with 32 bit products and clamping by saturation.
+ */
+static inline SSE2_FUNC void
+ycbcr_to_rgb_SSE2( __m128i                 y,
+                   __m128i                 u,
+                   __m128i                 v,
+                   const GenefxYCbCrToRGB *m,
+                   __m128i                *r,
+                   __m128i                *g,
+                   __m128i                *b )
+{
+     const __m128i one   = _mm_set1_epi16( 1 );
+     const __m128i round = _mm_set1_epi32( 128 );
+     const __m128i k_r   = _mm_set1_epi32( ((u32) m->cr_r << 16) | 298 );
+     const __m128i k_gy  = _mm_set1_epi32( ((u32) m->cb_g << 16) | 298 );
+     const __m128i k_gv  = _mm_set1_epi32( ((u32) 128     << 16) | ((u32) m->cr_g & 0xffff) );
+     const __m128i k_b   = _mm_set1_epi32( ((u32) m->cb_b << 16) | 298 );
+     __m128i       yu_l, yu_h, yv_l, yv_h, v1_l, v1_h, lo, hi;
+
+     y = _mm_sub_epi16( y, _mm_set1_epi16(  16 ) );
+     u = _mm_sub_epi16( u, _mm_set1_epi16( 128 ) );
+     v = _mm_sub_epi16( v, _mm_set1_epi16( 128 ) );
+
+     yu_l = _mm_unpacklo_epi16( y, u );
+     yu_h = _mm_unpackhi_epi16( y, u );
+     yv_l = _mm_unpacklo_epi16( y, v );
+     yv_h = _mm_unpackhi_epi16( y, v );
+     v1_l = _mm_unpacklo_epi16( v, one );
+     v1_h = _mm_unpackhi_epi16( v, one );
+
+     lo = _mm_srai_epi32( _mm_add_epi32( _mm_madd_epi16( yv_l, k_r ), round ), 8 );
+     hi = _mm_srai_epi32( _mm_add_epi32( _mm_madd_epi16( yv_h, k_r ), round ), 8 );
+     lo = _mm_packs_epi32( lo, hi );
+     *r = _mm_packus_epi16( lo, lo );
+
+     lo = _mm_srai_epi32( _mm_add_epi32( _mm_madd_epi16( yu_l, k_gy ), _mm_madd_epi16( v1_l, k_gv ) ), 8 );
+     hi = _mm_srai_epi32( _mm_add_epi32( _mm_madd_epi16( yu_h, k_gy ), _mm_madd_epi16( v1_h, k_gv ) ), 8 );
+     lo = _mm_packs_epi32( lo, hi );
+     *g = _mm_packus_epi16( lo, lo );
+
+     lo = _mm_srai_epi32( _mm_add_epi32( _mm_madd_epi16( yu_l, k_b ), round ), 8 );
+     hi = _mm_srai_epi32( _mm_add_epi32( _mm_madd_epi16( yu_h, k_b ), round ), 8 );
+     lo = _mm_packs_epi32( lo, hi );
+     *b = _mm_packus_epi16( lo, lo );
+}
+
+/* load eight Y samples and the Cb and Cr samples for them, widened to 16 bit */
+static inline SSE2_FUNC void
+ycbcr_load_SSE2( const u8 *Y,
+                 const u8 *U,
+                 const u8 *V,
+                 bool      subsampled,
+                 __m128i  *y,
+                 __m128i  *u,
+                 __m128i  *v )
+{
+     const __m128i zero = _mm_setzero_si128();
+
+     *y = _mm_unpacklo_epi8( _mm_loadl_epi64( (__m128i*) Y ), zero );
+
+     if (subsampled) {
+          __m128i u4 = _mm_cvtsi32_si128( *(const int*) U );
+          __m128i v4 = _mm_cvtsi32_si128( *(const int*) V );
+
+          *u = _mm_unpacklo_epi8( _mm_unpacklo_epi8( u4, u4 ), zero );
+          *v = _mm_unpacklo_epi8( _mm_unpacklo_epi8( v4, v4 ), zero );
+     }
+     else {
+          *u = _mm_unpacklo_epi8( _mm_loadl_epi64( (__m128i*) U ), zero );
+          *v = _mm_unpacklo_epi8( _mm_loadl_epi64( (__m128i*) V ), zero );
+     }
+}
+
+static SSE2_FUNC void
+YCbCr_span_to_argb_SSE2( const u8               *Y,
+                         const u8               *U,
+                         const u8               *V,
+                         bool                    subsampled,
+                         void                   *D,
+                         int                     w,
+                         const GenefxYCbCrToRGB *m )
+{
+     int           n     = w & ~7;
+     u32          *D32   = D;
+     const __m128i alpha = _mm_set1_epi8( 0xff );
+     int           i;
+
+     for (i = 0; i < n; i += 8) {
+          __m128i y, u, v, r, g, b, bg, ra;
+
+          ycbcr_load_SSE2( Y + i, U + (subsampled ? i / 2 : i), V + (subsampled ? i / 2 : i), subsampled, &y, &u, &v );
+          ycbcr_to_rgb_SSE2( y, u, v, m, &r, &g, &b );
+
+          bg = _mm_unpacklo_epi8( b, g );
+          ra = _mm_unpacklo_epi8( r, alpha );
+
+          _mm_storeu_si128( (__m128i*) (D32 + i),     _mm_unpacklo_epi16( bg, ra ) );
+          _mm_storeu_si128( (__m128i*) (D32 + i + 4), _mm_unpackhi_epi16( bg, ra ) );
+     }
+
+     if (n < w)
+          YCbCr_span_to_argb_C( Y + n, U + (subsampled ? n / 2 : n), V + (subsampled ? n / 2 : n), subsampled,
+                                D32 + n, w - n, m );
+}
+
+static SSE2_FUNC void
+YCbCr_span_to_rgb16_SSE2( const u8               *Y,
+                          const u8               *U,
+                          const u8               *V,
+                          bool                    subsampled,
+                          void                   *D,
+                          int                     w,
+                          const GenefxYCbCrToRGB *m )
+{
+     int           n    = w & ~7;
+     u16          *D16  = D;
+     const __m128i zero = _mm_setzero_si128();
+     int           i;
+
+     for (i = 0; i < n; i += 8) {
+          __m128i y, u, v, r, g, b;
+
+          ycbcr_load_SSE2( Y + i, U + (subsampled ? i / 2 : i), V + (subsampled ? i / 2 : i), subsampled, &y, &u, &v );
+          ycbcr_to_rgb_SSE2( y, u, v, m, &r, &g, &b );
+
+          r = _mm_slli_epi16( _mm_and_si128( _mm_unpacklo_epi8( r, zero ), _mm_set1_epi16( 0xf8 ) ), 8 );
+          g = _mm_slli_epi16( _mm_and_si128( _mm_unpacklo_epi8( g, zero ), _mm_set1_epi16( 0xfc ) ), 3 );
+          b = _mm_srli_epi16( _mm_unpacklo_epi8( b, zero ), 3 );
+
+          _mm_storeu_si128( (__m128i*) (D16 + i), _mm_or_si128( _mm_or_si128( r, g ), b ) );
+     }
+
+     if (n < w)
+          YCbCr_span_to_rgb16_C( Y + n, U + (subsampled ? n / 2 : n), V + (subsampled ? n / 2 : n), subsampled,
+                                 D16 + n, w - n, m );
+}
+
+/**********************************************************************************************************************/
+
+/*
+ * Transform two accumulators with the color matrix, k holding the coefficients and the rounded offsets for R, G and B.
+ */
+static inline SSE2_FUNC __m128i
+colormatrix_SSE2( __m128i        p,
+                  const __m128i *k )
+{
+     const __m128i zero = _mm_setzero_si128();
+     const __m128i max  = _mm_set1_epi16( 0xff );
+     __m128i       r, g, b, bg, ra;
+
+     /* Sums of the pairs (B,G) and (R,A) are added to get the results in both halves of each accumulator. */
+     r = _mm_madd_epi16( p, k[0] );
+     g = _mm_madd_epi16( p, k[1] );
+     b = _mm_madd_epi16( p, k[2] );
+
+     r = _mm_srai_epi32( _mm_add_epi32( _mm_add_epi32( r, _mm_shuffle_epi32( r, _MM_SHUFFLE( 2, 3, 0, 1 ) ) ), k[3] ), 12 );
+     g = _mm_srai_epi32( _mm_add_epi32( _mm_add_epi32( g, _mm_shuffle_epi32( g, _MM_SHUFFLE( 2, 3, 0, 1 ) ) ), k[4] ), 12 );
+     b = _mm_srai_epi32( _mm_add_epi32( _mm_add_epi32( b, _mm_shuffle_epi32( b, _MM_SHUFFLE( 2, 3, 0, 1 ) ) ), k[5] ), 12 );
+
+     /* B0 B0 B1 B1 G0 G0 G1 G1 and R0 R0 R1 R1 (twice), clamped */
+     bg = _mm_min_epi16( _mm_max_epi16( _mm_packs_epi32( b, g ), zero ), max );
+     r  = _mm_min_epi16( _mm_max_epi16( _mm_packs_epi32( r, r ), zero ), max );
+
+     /* B0 G0 B0 G0 B1 G1 B1 G1 and R0 A0 R0 A0 R1 A1 R1 A1 */
+     bg = _mm_unpacklo_epi16( bg, _mm_srli_si128( bg, 8 ) );
+     ra = _mm_unpacklo_epi16( r, _mm_shuffle_epi32( acc_alpha_SSE2( p ), _MM_SHUFFLE( 3, 1, 2, 0 ) ) );
+
+     bg = _mm_shuffle_epi32( bg, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+     ra = _mm_shuffle_epi32( ra, _MM_SHUFFLE( 3, 1, 2, 0 ) );
+
+     return acc_select_SSE2( acc_keep_SSE2( p ), _mm_unpacklo_epi32( bg, ra ), p );
+}
+
+static SSE2_FUNC void
+Dacc_src_colormatrix_SSE2( GenefxState *gfxs )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *D = gfxs->Dacc;
+     const s32         *m = gfxs->SrcMatrix;
+     __m128i            k[6];
+
+     k[0] = _mm_set_epi16( 0, m[0], m[1], m[2],  0, m[0], m[1], m[2]  );
+     k[1] = _mm_set_epi16( 0, m[4], m[5], m[6],  0, m[4], m[5], m[6]  );
+     k[2] = _mm_set_epi16( 0, m[8], m[9], m[10], 0, m[8], m[9], m[10] );
+     k[3] = _mm_set1_epi32( m[3]  + 0x800 );
+     k[4] = _mm_set1_epi32( m[7]  + 0x800 );
+     k[5] = _mm_set1_epi32( m[11] + 0x800 );
+
+     for (; w > 1; w -= 2) {
+          _mm_storeu_si128( (__m128i*) D, colormatrix_SSE2( _mm_loadu_si128( (__m128i*) D ), k ) );
+
+          D += 2;
+     }
+
+     if (w)
+          _mm_storel_epi64( (__m128i*) D, colormatrix_SSE2( _mm_loadl_epi64( (__m128i*) D ), k ) );
+}
+
+/*
+ * Two accumulators per iteration, the taps of each line being multiplied in pairs of neighbouring pixels.
+ */
+static inline SSE2_FUNC void
+convolve_SSE2( GenefxState *gfxs,
+               bool         keyed )
+{
+     int                      i, j;
+     int                      w    = gfxs->length;
+     GenefxAccumulator       *D    = gfxs->Dacc;
+     const s32               *k    = gfxs->SrcKernel;
+     const __m128i            zero = _mm_setzero_si128();
+     const __m128i            max  = _mm_set1_epi16( 0xff );
+     const __m128i            bias = _mm_set1_epi32( gfxs->SrcBias + 0x800 );
+     const GenefxAccumulator *L[3];
+     __m128i                  k01[3];
+     __m128i                  k2[3];
+
+     for (j = 0; j < 3; j++) {
+          L[j]   = Kacc_line( gfxs, gfxs->BopY - 1 + j, gfxs->BopY );
+          k01[j] = _mm_set1_epi32( ((u32) k[j*3+1] << 16) | ((u32) k[j*3] & 0xffff) );
+          k2[j]  = _mm_set1_epi32( (u32) k[j*3+2] & 0xffff );
+     }
+
+     for (i = 0; i < w - 1; i += 2) {
+          __m128i lo = bias;
+          __m128i hi = bias;
+          __m128i s;
+
+          for (j = 0; j < 3; j++) {
+               __m128i p0 = _mm_loadu_si128( (const __m128i*) &L[j][i] );
+               __m128i p1 = _mm_loadu_si128( (const __m128i*) &L[j][i+1] );
+               __m128i p2 = _mm_loadu_si128( (const __m128i*) &L[j][i+2] );
+
+               lo = _mm_add_epi32( lo, _mm_madd_epi16( _mm_unpacklo_epi16( p0, p1 ), k01[j] ) );
+               hi = _mm_add_epi32( hi, _mm_madd_epi16( _mm_unpackhi_epi16( p0, p1 ), k01[j] ) );
+               lo = _mm_add_epi32( lo, _mm_madd_epi16( _mm_unpacklo_epi16( p2, zero ), k2[j] ) );
+               hi = _mm_add_epi32( hi, _mm_madd_epi16( _mm_unpackhi_epi16( p2, zero ), k2[j] ) );
+          }
+
+          s = _mm_packs_epi32( _mm_srai_epi32( lo, 12 ), _mm_srai_epi32( hi, 12 ) );
+          s = _mm_min_epi16( _mm_max_epi16( s, zero ), max );
+
+          if (keyed) {
+               __m128i d = _mm_loadu_si128( (__m128i*) &D[i] );
+
+               s = acc_select_SSE2( acc_keep_SSE2( d ), s, d );
+          }
+
+          _mm_storeu_si128( (__m128i*) &D[i], s );
+     }
+
+     if (i < w && (!keyed || !(D[i].RGB.a & 0xf000)))
+          convolve_pixel( L, i, k, gfxs->SrcBias, &D[i] );
+}
+
+static SSE2_FUNC void
+Dacc_convolve_SSE2( GenefxState *gfxs )
+{
+     convolve_SSE2( gfxs, false );
+}
+
+static SSE2_FUNC void
+Dacc_convolve_keyed_SSE2( GenefxState *gfxs )
+{
+     convolve_SSE2( gfxs, true );
+}
+
+/**********************************************************************************************************************/
+
+/*
+ * Modulate and blend two pixels unpacked to the high byte of 16 bit lanes, returning the channels in the low byte.
+ * The pmulhuw of a channel in the high byte by a multiplier up to 0x100 is the truncated product of the accumulators.
+ */
+static inline SSE2_FUNC __m128i
+packed_source_SSE2( __m128i        s,
+                    const __m128i *k,
+                    bool           premultiply )
+{
+     s = _mm_mulhi_epu16( s, k[0] );
+     s = _mm_mulhi_epu16( _mm_slli_epi16( s, 8 ), k[1] );
+
+     if (premultiply)
+          s = _mm_mulhi_epu16( _mm_slli_epi16( s, 8 ),
+                               _mm_or_si128( _mm_and_si128( _mm_add_epi16( acc_alpha_SSE2( s ), k[2] ), k[3] ), k[4] ) );
+
+     return s;
+}
+
+static inline SSE2_FUNC __m128i
+packed_over_SSE2( __m128i        s,
+                  __m128i        d,
+                  const __m128i *k,
+                  bool           srcalpha )
+{
+     __m128i sa = acc_alpha_SSE2( s );
+
+     if (srcalpha)
+          s = _mm_mulhi_epu16( _mm_slli_epi16( s, 8 ), _mm_add_epi16( sa, k[2] ) );
+
+     return _mm_packus_epi16( s, _mm_mulhi_epu16( d, _mm_sub_epi16( k[5], sa ) ) );
+}
+
+/*
+ * Four pixels per iteration, keeping the spans packed in 32 bit and adding source and destination with saturation.
+ * A8 sources are expanded to white with their alpha.
+ */
+static inline SSE2_FUNC void
+packed_SSE2( GenefxState *gfxs,
+             bool         a8 )
+{
+     int                 w    = gfxs->length;
+     u8                 *S    = gfxs->Bop[0];
+     u32                *D    = gfxs->Aop[0];
+     const GenefxPacked *P    = &gfxs->Packed;
+     const __m128i       zero = _mm_setzero_si128();
+     const __m128i       ones = _mm_set1_epi32( 0xffffffff );
+     __m128i             src_or, dst_or, k[6];
+
+     src_or = _mm_set1_epi32( P->src_or );
+     dst_or = _mm_set1_epi32( P->dst_or );
+
+     k[0] = _mm_set_epi16( 0x100, P->premultcolor, P->premultcolor, P->premultcolor,
+                           0x100, P->premultcolor, P->premultcolor, P->premultcolor );
+     k[1] = _mm_set_epi16( P->modulate[3], P->modulate[2], P->modulate[1], P->modulate[0],
+                           P->modulate[3], P->modulate[2], P->modulate[1], P->modulate[0] );
+     k[2] = _mm_set1_epi16( 1 );
+     k[3] = _mm_set_epi16( 0, -1, -1, -1, 0, -1, -1, -1 );
+     k[4] = _mm_set_epi16( 0x100, 0, 0, 0, 0x100, 0, 0, 0 );
+     k[5] = _mm_set1_epi16( 0x100 );
+
+     for (; w >= 4; w -= 4) {
+          __m128i s, lo, hi;
+
+          if (a8) {
+               s = _mm_unpacklo_epi16( ones, _mm_unpacklo_epi8( ones, _mm_cvtsi32_si128( *(u32*) S ) ) );
+               S += 4;
+          }
+          else {
+               s = _mm_loadu_si128( (__m128i*) S );
+               S += 16;
+          }
+
+          s  = _mm_or_si128( s, src_or );
+          lo = packed_source_SSE2( _mm_unpacklo_epi8( zero, s ), k, P->premultiply );
+          hi = packed_source_SSE2( _mm_unpackhi_epi8( zero, s ), k, P->premultiply );
+
+          if (P->src_blend) {
+               __m128i d = _mm_loadu_si128( (__m128i*) D );
+
+               lo = packed_over_SSE2( lo, _mm_unpacklo_epi8( zero, d ), k, P->src_blend == DSBF_SRCALPHA );
+               hi = packed_over_SSE2( hi, _mm_unpackhi_epi8( zero, d ), k, P->src_blend == DSBF_SRCALPHA );
+
+               /* Source and destination of two pixels each are in the low and high halves. */
+               s = _mm_adds_epu8( _mm_unpacklo_epi64( lo, hi ), _mm_unpackhi_epi64( lo, hi ) );
+          }
+          else
+               s = _mm_packus_epi16( lo, hi );
+
+          _mm_storeu_si128( (__m128i*) D, _mm_or_si128( s, dst_or ) );
+
+          D += 4;
+     }
+
+     for (; w; w--) {
+          u32 s;
+
+          if (a8) {
+               s = (*S << 24) | 0x00ffffff;
+               S++;
+          }
+          else {
+               s = *(u32*) S;
+               S += 4;
+          }
+
+          if (P->src_blend)
+               *D = packed_over( P, packed_source( P, s ), *D ) | P->dst_or;
+          else
+               *D = packed_source( P, s ) | P->dst_or;
+
+          D++;
+     }
+}
+
+static SSE2_FUNC void
+Bop_32_packed_Aop_32_SSE2( GenefxState *gfxs )
+{
+     if (gfxs->Astep != 1 || gfxs->Bstep != 1)
+          Bop_32_packed_Aop_32_C( gfxs );
+     else
+          packed_SSE2( gfxs, false );
+}
+
+static SSE2_FUNC void
+Bop_a8_packed_Aop_32_SSE2( GenefxState *gfxs )
+{
+     if (gfxs->Astep != 1 || gfxs->Bstep != 1)
+          Bop_a8_packed_Aop_32_C( gfxs );
+     else
+          packed_SSE2( gfxs, true );
+}
+
+#undef SSE2_FUNC
@@ -21,6 +21,9 @@
 #include <core/palette.h>
 #include <gfx/convert.h>
 #include <gfx/generic/generic.h>
+#include <gfx/generic/generic_bands.h>
+#include <gfx/generic/generic_rotate.h>
+#include <gfx/generic/generic_scale.h>
 #include <gfx/generic/generic_util.h>
 #include <gfx/util.h>
 
@@ -671,8 +674,14 @@ gStretchBlit( CardState    *state,
                   srect->x, srect->y, srect->w, srect->h, dfb_pixelformat_name( gfxs->src_format ) );
      }
 
+     if (Genefx_Bands_StretchBlit( state, srect, drect ))
+          return;
+
      CHECK_PIPELINE();
 
+     if (state->render_options & (DSRO_SMOOTH_UPSCALE | DSRO_SMOOTH_DOWNSCALE) && Genefx_Scale( state, srect, drect ))
+          return;
+
 #if DFB_SMOOTH_SCALING
      if (state->render_options & (DSRO_SMOOTH_UPSCALE | DSRO_SMOOTH_DOWNSCALE) && stretch_hvx( state, srect, drect ))
           return;
@@ -755,6 +764,10 @@ gStretchBlit( CardState    *state,
      D_ASSERT( drect->x + drect->w <= state->clip.x2 + 1 );
      D_ASSERT( drect->y + drect->h <= state->clip.y2 + 1 );
 
+     /* Unscaled rotation is a plain transposition. */
+     if (rotated && fx == 0x10000 && fy == 0x10000 && Genefx_Rotate( state, srect, drect->x, drect->y ))
+          return;
+
      if (!Genefx_ABacc_prepare( gfxs, MAX( srect->w, drect->w ) ))
           return;
 
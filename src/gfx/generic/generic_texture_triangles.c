@@ -18,9 +18,17 @@
 
 #include <core/state.h>
 #include <gfx/generic/generic.h>
+#include <gfx/generic/generic_bands.h>
 #include <gfx/generic/generic_texture_triangles.h>
 #include <gfx/generic/generic_util.h>
 
+D_DEBUG_DOMAIN( Genefx_Triangles, "Genefx/Triangles", "Genefx Texture Triangles" );
+
+/**********************************************************************************************************************/
+
+#define TRIANGLES_TILE_SIZE  64  /* width and height of the destination tiles triangles are binned into */
+#define TRIANGLES_BIN_MIN    8   /* minimum number of triangles being binned */
+
 /**********************************************************************************************************************/
 
 typedef struct {
@@ -325,6 +333,267 @@ Genefx_TextureTriangleAffine( GenefxState        *gfxs,
      }
 }
 
+/*
+ * Get the vertices of the triangle at 'index' within the formation and advance 'index' to the next one.
+ */
+static bool
+triangle_next( GenefxVertexAffine    *vertices,
+               DFBTriangleFormation   formation,
+               int                   *index,
+               GenefxVertexAffine   **v )
+{
+     int i = *index;
+
+     if (i == 0) {
+          v[0] = &vertices[i+0];
+          v[1] = &vertices[i+1];
+          v[2] = &vertices[i+2];
+
+          *index = i + 3;
+
+          return true;
+     }
+
+     switch (formation) {
+          case DTTF_LIST:
+               v[0] = &vertices[i+0];
+               v[1] = &vertices[i+1];
+               v[2] = &vertices[i+2];
+
+               *index = i + 3;
+               break;
+
+          case DTTF_STRIP:
+               v[0] = &vertices[i-2];
+               v[1] = &vertices[i-1];
+               v[2] = &vertices[i+0];
+
+               *index = i + 1;
+               break;
+
+          case DTTF_FAN:
+               v[0] = &vertices[0];
+               v[1] = &vertices[i-1];
+               v[2] = &vertices[i+0];
+
+               *index = i + 1;
+               break;
+
+          default:
+               D_BUG( "unknown formation %u", formation );
+               return false;
+     }
+
+     return true;
+}
+
+static void
+triangle_warn( CardState           *state,
+               GenefxVertexAffine **v )
+{
+     GenefxState *gfxs = state->gfxs;
+
+     D_WARN( "TexTriangles (%d,%d-%d,%d-%d,%d) %6s, flags 0x%08x, color 0x%02x%02x%02x%02x <- (%4d,%4d) %6s",
+             v[0]->x, v[0]->y, v[1]->x, v[1]->y, v[2]->x, v[2]->y, dfb_pixelformat_name( gfxs->dst_format ),
+             state->blittingflags, state->color.a, state->color.r, state->color.g, state->color.b,
+             state->source->config.size.w, state->source->config.size.h, dfb_pixelformat_name( gfxs->src_format ) );
+}
+
+/**********************************************************************************************************************/
+
+void
+Genefx_TextureTriangleBins_Render( CardState                *state,
+                                   const GenefxTriangleBins *bins,
+                                   const DFBRegion          *clip )
+{
+     int          col, row;
+     int          i;
+     DFBRegion    area = bins->area;
+     GenefxState *gfxs = state->gfxs;
+
+     if (!dfb_region_region_intersect( &area, clip ))
+          return;
+
+     if (!Genefx_ABacc_prepare( gfxs, state->destination->config.size.w ))
+          return;
+
+     /* Reset Bop to 0,0 as texture lookup accesses the whole buffer arbitrarily. */
+     Genefx_Bop_xy( gfxs, 0, 0 );
+
+     for (row = area.y1 / TRIANGLES_TILE_SIZE; row <= area.y2 / TRIANGLES_TILE_SIZE; row++) {
+          for (col = area.x1 / TRIANGLES_TILE_SIZE; col <= area.x2 / TRIANGLES_TILE_SIZE; col++) {
+               int       tile = (row - bins->row0) * bins->columns + col - bins->col0;
+               DFBRegion tclip;
+
+               if (bins->first[tile] == bins->first[tile+1])
+                    continue;
+
+               tclip.x1 = MAX( col * TRIANGLES_TILE_SIZE, area.x1 );
+               tclip.y1 = MAX( row * TRIANGLES_TILE_SIZE, area.y1 );
+               tclip.x2 = MIN( col * TRIANGLES_TILE_SIZE + TRIANGLES_TILE_SIZE - 1, area.x2 );
+               tclip.y2 = MIN( row * TRIANGLES_TILE_SIZE + TRIANGLES_TILE_SIZE - 1, area.y2 );
+
+               /* The triangles of a tile are rendered in their original order. */
+               for (i = bins->first[tile]; i < bins->first[tile+1]; i++) {
+                    GenefxVertexAffine **v = bins->triangles[bins->indices[i]].v;
+
+                    Genefx_TextureTriangleAffine( gfxs, v[0], v[1], v[2], &tclip );
+               }
+          }
+     }
+
+     Genefx_ABacc_flush( gfxs );
+}
+
+/*
+ * Sort the triangles into the tiles covered by their bounding boxes and render the tiles one after another, keeping
+ * the destination tile in the cache, or in parallel bands. Returns false if the triangles are not binned.
+ */
+static bool
+texture_triangles_binned( CardState            *state,
+                          GenefxVertexAffine   *vertices,
+                          int                   num,
+                          DFBTriangleFormation  formation,
+                          const DFBRegion      *clip )
+{
+     int                 i, n;
+     int                 index;
+     int                 num_tiles;
+     int                 num_refs = 0;
+     int                 num_triangles;
+     void               *mem;
+     GenefxTriangleBins  bins;
+
+     switch (formation) {
+          case DTTF_LIST:
+               num_triangles = num / 3;
+               break;
+
+          case DTTF_STRIP:
+          case DTTF_FAN:
+               num_triangles = num - 2;
+               break;
+
+          default:
+               return false;
+     }
+
+     if (num_triangles < TRIANGLES_BIN_MIN)
+          return false;
+
+     bins.triangles = D_MALLOC( num_triangles * sizeof(GenefxTriangle) );
+     if (!bins.triangles) {
+          D_OOM();
+          return false;
+     }
+
+     bins.clip = *clip;
+
+     /* Collect the bounding boxes within the clip. */
+     for (index = 0, n = 0; n < num_triangles; n++) {
+          GenefxTriangle *tri = &bins.triangles[n];
+
+          triangle_next( vertices, formation, &index, tri->v );
+
+          if (dfb_config->software_warn)
+               triangle_warn( state, tri->v );
+
+          tri->bounds.x1 = MIN( MIN( tri->v[0]->x, tri->v[1]->x ), tri->v[2]->x );
+          tri->bounds.y1 = MIN( MIN( tri->v[0]->y, tri->v[1]->y ), tri->v[2]->y );
+          tri->bounds.x2 = MAX( MAX( tri->v[0]->x, tri->v[1]->x ), tri->v[2]->x );
+          tri->bounds.y2 = MAX( MAX( tri->v[0]->y, tri->v[1]->y ), tri->v[2]->y );
+
+          if (tri->bounds.y1 == tri->bounds.y2 || !dfb_region_region_intersect( &tri->bounds, clip )) {
+               tri->bounds.x1 = -1;
+               continue;
+          }
+
+          if (num_refs++)
+               dfb_region_region_union( &bins.area, &tri->bounds );
+          else
+               bins.area = tri->bounds;
+     }
+
+     if (!num_refs) {
+          D_FREE( bins.triangles );
+          return true;
+     }
+
+     bins.col0    = bins.area.x1 / TRIANGLES_TILE_SIZE;
+     bins.row0    = bins.area.y1 / TRIANGLES_TILE_SIZE;
+     bins.columns = bins.area.x2 / TRIANGLES_TILE_SIZE - bins.col0 + 1;
+     bins.rows    = bins.area.y2 / TRIANGLES_TILE_SIZE - bins.row0 + 1;
+
+     num_tiles = bins.columns * bins.rows;
+
+     /* Count the triangles of each tile. */
+     num_refs = 0;
+
+     for (n = 0; n < num_triangles; n++) {
+          GenefxTriangle *tri = &bins.triangles[n];
+
+          if (tri->bounds.x1 < 0)
+               continue;
+
+          num_refs += (tri->bounds.x2 / TRIANGLES_TILE_SIZE - tri->bounds.x1 / TRIANGLES_TILE_SIZE + 1) *
+                      (tri->bounds.y2 / TRIANGLES_TILE_SIZE - tri->bounds.y1 / TRIANGLES_TILE_SIZE + 1);
+     }
+
+     mem = D_CALLOC( num_tiles + 1 + num_refs, sizeof(int) );
+     if (!mem) {
+          D_OOM();
+          D_FREE( bins.triangles );
+          return false;
+     }
+
+     bins.first   = mem;
+     bins.indices = bins.first + num_tiles + 1;
+
+     for (n = 0; n < num_triangles; n++) {
+          GenefxTriangle *tri = &bins.triangles[n];
+          int             col, row;
+
+          if (tri->bounds.x1 < 0)
+               continue;
+
+          for (row = tri->bounds.y1 / TRIANGLES_TILE_SIZE; row <= tri->bounds.y2 / TRIANGLES_TILE_SIZE; row++)
+               for (col = tri->bounds.x1 / TRIANGLES_TILE_SIZE; col <= tri->bounds.x2 / TRIANGLES_TILE_SIZE; col++)
+                    bins.first[(row - bins.row0) * bins.columns + col - bins.col0 + 1]++;
+     }
+
+     for (i = 0; i < num_tiles; i++)
+          bins.first[i+1] += bins.first[i];
+
+     /* Fill the tiles in the original order of the triangles, using the start of the next tile as the fill index. */
+     for (n = 0; n < num_triangles; n++) {
+          GenefxTriangle *tri = &bins.triangles[n];
+          int             col, row;
+
+          if (tri->bounds.x1 < 0)
+               continue;
+
+          for (row = tri->bounds.y1 / TRIANGLES_TILE_SIZE; row <= tri->bounds.y2 / TRIANGLES_TILE_SIZE; row++)
+               for (col = tri->bounds.x1 / TRIANGLES_TILE_SIZE; col <= tri->bounds.x2 / TRIANGLES_TILE_SIZE; col++)
+                    bins.indices[bins.first[(row - bins.row0) * bins.columns + col - bins.col0]++] = n;
+     }
+
+     for (i = num_tiles; i > 0; i--)
+          bins.first[i] = bins.first[i-1];
+
+     bins.first[0] = 0;
+
+     D_DEBUG_AT( Genefx_Triangles, "%s( %d triangles ) <- %dx%d tiles, %d references\n", __FUNCTION__,
+                 num_triangles, bins.columns, bins.rows, num_refs );
+
+     if (!Genefx_Bands_TextureTriangles( state, &bins ))
+          Genefx_TextureTriangleBins_Render( state, &bins, clip );
+
+     D_FREE( mem );
+     D_FREE( bins.triangles );
+
+     return true;
+}
+
 void
 Genefx_TextureTrianglesAffine( CardState            *state,
                                GenefxVertexAffine   *vertices,
@@ -342,6 +611,9 @@ Genefx_TextureTrianglesAffine( CardState            *state,
 
      CHECK_PIPELINE();
 
+     if (texture_triangles_binned( state, vertices, num, formation, clip ))
+          return;
+
      if (!Genefx_ABacc_prepare( gfxs, state->destination->config.size.w ))
           return;
 
@@ -349,56 +621,14 @@ Genefx_TextureTrianglesAffine( CardState            *state,
      Genefx_Bop_xy( gfxs, 0, 0 );
 
      /* Render triangles. */
-     for (index = 0; index < num;) {
+     while (index < num) {
           GenefxVertexAffine *v[3];
 
-          if (index == 0) {
-               v[0] = &vertices[index+0];
-               v[1] = &vertices[index+1];
-               v[2] = &vertices[index+2];
+          if (!triangle_next( vertices, formation, &index, v ))
+               break;
 
-               index += 3;
-          }
-          else {
-               switch (formation) {
-                    case DTTF_LIST:
-                         v[0] = &vertices[index+0];
-                         v[1] = &vertices[index+1];
-                         v[2] = &vertices[index+2];
-
-                         index += 3;
-                         break;
-
-                    case DTTF_STRIP:
-                         v[0] = &vertices[index-2];
-                         v[1] = &vertices[index-1];
-                         v[2] = &vertices[index+0];
-
-                         index += 1;
-                         break;
-
-                    case DTTF_FAN:
-                         v[0] = &vertices[0];
-                         v[1] = &vertices[index-1];
-                         v[2] = &vertices[index+0];
-
-                         index += 1;
-                         break;
-
-                    default:
-                         D_BUG( "unknown formation %u", formation );
-                         Genefx_ABacc_flush( gfxs );
-                         return;
-               }
-          }
-
-          if (dfb_config->software_warn) {
-               D_WARN( "TexTriangles (%d,%d-%d,%d-%d,%d) %6s, flags 0x%08x, color 0x%02x%02x%02x%02x <- (%4d,%4d) %6s",
-                       v[0]->x, v[0]->y, v[1]->x, v[1]->y, v[2]->x, v[2]->y, dfb_pixelformat_name( gfxs->dst_format ),
-                       state->blittingflags, state->color.a, state->color.r, state->color.g, state->color.b,
-                       state->source->config.size.w, state->source->config.size.h,
-                       dfb_pixelformat_name( gfxs->src_format ) );
-          }
+          if (dfb_config->software_warn)
+               triangle_warn( state, v );
 
           Genefx_TextureTriangleAffine( gfxs, v[0], v[1], v[2], clip );
      }
@@ -30,6 +30,29 @@ typedef struct {
      int t;
 } GenefxVertexAffine;
 
+typedef struct {
+     GenefxVertexAffine  *v[3];
+     DFBRegion            bounds;     /* bounding box within the clip, x1 being negative if the triangle is skipped */
+} GenefxTriangle;
+
+/*
+ * Triangles sorted into square tiles of the destination, the triangles of a tile being referenced in their original
+ * order by 'indices' from 'first[tile]' to 'first[tile + 1] - 1'.
+ */
+typedef struct {
+     GenefxTriangle      *triangles;
+     int                 *first;
+     int                 *indices;
+
+     DFBRegion            clip;
+     DFBRegion            area;       /* bounds of all triangles within the clip */
+
+     int                  col0;       /* first column and row of the tiles covering the area */
+     int                  row0;
+     int                  columns;
+     int                  rows;
+} GenefxTriangleBins;
+
 /**********************************************************************************************************************/
 
 void Genefx_TextureTrianglesAffine( CardState            *state,
@@ -38,4 +61,11 @@ void Genefx_TextureTrianglesAffine( CardState            *state,
                                     DFBTriangleFormation  formation,
                                     const DFBRegion      *clip );
 
+/*
+ * Render the tiles of the binned triangles within the clip, e.g. of a band.
+ */
+void Genefx_TextureTriangleBins_Render( CardState                *state,
+                                        const GenefxTriangleBins *bins,
+                                        const DFBRegion          *clip );
+
 #endif
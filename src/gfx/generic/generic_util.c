@@ -329,6 +329,7 @@ Genefx_Bop_xy( GenefxState *gfxs,
      int pitch = gfxs->src_pitch;
 
      gfxs->Bop[0] = gfxs->src_org[0];
+     gfxs->BopX   = x;
      gfxs->BopY   = y;
 
      if (gfxs->src_caps & DSCAPS_SEPARATED) {
@@ -923,6 +924,30 @@ Genefx_ABacc_prepare( GenefxState *gfxs, int width )
 
      gfxs->Sacc = gfxs->Dacc = gfxs->Aacc;
 
+     /* The convolution keeps three lines of the source, read with up to four extra pixels and one more for padding. */
+     if (gfxs->Kfuncs[0]) {
+          size = (width + 5 + 31) & ~31;
+
+          if (gfxs->Ksize < size) {
+               void *Kstart = D_MALLOC( size * sizeof(GenefxAccumulator) * 3 + 31 );
+
+               if (!Kstart) {
+                    D_WARN( "out of memory" );
+                    return false;
+               }
+
+               if (gfxs->Kstart)
+                    D_FREE( gfxs->Kstart );
+
+               gfxs->Kstart = Kstart;
+               gfxs->Ksize  = size;
+               gfxs->Kacc   = (GenefxAccumulator*) (((unsigned long) Kstart+31) & ~31);
+          }
+
+          /* The source may have changed since the last operation. */
+          gfxs->KaccY[0] = gfxs->KaccY[1] = gfxs->KaccY[2] = -1;
+     }
+
      return true;
 }
 
@@ -939,4 +964,12 @@ Genefx_ABacc_flush( GenefxState *gfxs )
           gfxs->Sacc    = NULL;
           gfxs->Dacc    = NULL;
      }
+
+     if (dfb_config->keep_accumulators >= 0 && gfxs->Ksize > dfb_config->keep_accumulators) {
+          D_FREE( gfxs->Kstart );
+
+          gfxs->Ksize  = 0;
+          gfxs->Kstart = NULL;
+          gfxs->Kacc   = NULL;
+     }
 }
@@ -0,0 +1,538 @@
+/*
+   This file is part of DirectFB.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+*/
+
+/*
+ * Portable functions using the GCC/Clang vector extensions, lowered to NEON, SSE2 or scalar code by the compiler.
+ * Four accumulators (or four 32 bit pixels) are processed at once, remaining ones are processed through a temporary
+ * copy, and the results are identical to the C functions. The accumulator layout requires a little endian host.
+ */
+
+#if defined(__GNUC__) && !defined(__clang__)
+/* functions taking or returning vectors are static, the ABI of wide vectors does not matter */
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+typedef u8  u8x16  __attribute__((vector_size(16)));
+typedef u16 u16x4  __attribute__((vector_size(8)));
+typedef u16 u16x8  __attribute__((vector_size(16)));
+typedef u16 u16x16 __attribute__((vector_size(32)));
+typedef s16 s16x4  __attribute__((vector_size(8)));
+typedef u32 u32x4  __attribute__((vector_size(16)));
+typedef s32 s32x4  __attribute__((vector_size(16)));
+typedef u32 u32x16 __attribute__((vector_size(64)));
+typedef u64 u64x4  __attribute__((vector_size(32)));
+typedef s64 s64x4  __attribute__((vector_size(32)));
+
+/**********************************************************************************************************************/
+
+/* load 'n' elements of 'size' bytes into a vector, the remaining elements are cleared */
+#define VEC_LOAD(v,p,n,size)                        \
+do {                                                \
+     memset( &(v), 0, sizeof(v) );                  \
+     memcpy( &(v), (p), (n) * (size) );             \
+} while (0)
+
+#define VEC_STORE(v,p,n,size)                       \
+do {                                                \
+     memcpy( (p), &(v), (n) * (size) );             \
+} while (0)
+
+/* (a * f) >> 8, truncated to 16 bits per channel */
+static inline u16x16
+acc_mul8_vector( u16x16 a, u16x16 f )
+{
+     return __builtin_convertvector( (__builtin_convertvector( a, u32x16 ) *
+                                      __builtin_convertvector( f, u32x16 )) >> 8, u16x16 );
+}
+
+/* replicate the alpha channel of each accumulator to all four channels */
+static inline u16x16
+acc_alpha_vector( u16x16 a )
+{
+     u64x4 t = (u64x4) a >> 48;
+
+     t |= t << 16;
+     t |= t << 32;
+
+     return (u16x16) t;
+}
+
+/* all bits set in the accumulators that are not skipped */
+static inline s64x4
+acc_keep_vector( u16x16 a )
+{
+     return ((u64x4) a & 0xf000000000000000ull) == 0;
+}
+
+static inline u16x16
+acc_select_vector( s64x4 mask, u16x16 a, u16x16 b )
+{
+     return (u16x16) (((u64x4) a & (u64x4) mask) | ((u64x4) b & ~(u64x4) mask));
+}
+
+static inline u64x4
+acc_broadcast_vector( const GenefxAccumulator *acc )
+{
+     u64 v;
+
+     memcpy( &v, acc, sizeof(v) );
+
+     return (u64x4) { v, v, v, v };
+}
+
+/* clamp and convert four accumulators to ARGB pixels, returning all bits set for the pixels to be written */
+static inline u32x4
+acc_to_argb_vector( u16x16  s,
+                    s32x4  *ret_keep )
+{
+     u16x16 over = (u16x16) ((s & 0xff00) != 0);
+
+     *ret_keep = __builtin_convertvector( acc_keep_vector( s ), s32x4 );
+
+     return (u32x4) __builtin_convertvector( (s & ~over) | (0xff & over), u8x16 );
+}
+
+static inline u16x16
+argb_to_acc_vector( u32x4 p )
+{
+     return __builtin_convertvector( (u8x16) p, u16x16 );
+}
+
+/**********************************************************************************************************************/
+
+static inline u16x16
+Xacc_blend_alpha_vector( u16x16 y, u16x16 f )
+{
+     return acc_select_vector( acc_keep_vector( y ), acc_mul8_vector( y, f ), y );
+}
+
+static void
+Xacc_blend_srcalpha_vector( GenefxState *gfxs )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *X = gfxs->Xacc;
+     GenefxAccumulator *Y = gfxs->Yacc;
+     GenefxAccumulator *S = gfxs->Sacc;
+     u16                Sa = gfxs->color.a + 1;
+     u16x16             f  = { 0 };
+     u16x16             s, y;
+
+     f += Sa;
+
+     for (; w > 0; w -= 4) {
+          int n = MIN( w, 4 );
+
+          VEC_LOAD( y, Y, n, sizeof(GenefxAccumulator) );
+
+          if (S) {
+               VEC_LOAD( s, S, n, sizeof(GenefxAccumulator) );
+
+               f = acc_alpha_vector( s ) + 1;
+
+               S += 4;
+          }
+
+          y = Xacc_blend_alpha_vector( y, f );
+
+          VEC_STORE( y, X, n, sizeof(GenefxAccumulator) );
+
+          X += 4; Y += 4;
+     }
+}
+
+static void
+Xacc_blend_invsrcalpha_vector( GenefxState *gfxs )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *X = gfxs->Xacc;
+     GenefxAccumulator *Y = gfxs->Yacc;
+     GenefxAccumulator *S = gfxs->Sacc;
+     u16                Sa = 0x100 - gfxs->color.a;
+     u16x16             f  = { 0 };
+     u16x16             s, y;
+
+     f += Sa;
+
+     for (; w > 0; w -= 4) {
+          int n = MIN( w, 4 );
+
+          VEC_LOAD( y, Y, n, sizeof(GenefxAccumulator) );
+
+          if (S) {
+               VEC_LOAD( s, S, n, sizeof(GenefxAccumulator) );
+
+               f = 0x100 - acc_alpha_vector( s );
+
+               S += 4;
+          }
+
+          y = Xacc_blend_alpha_vector( y, f );
+
+          VEC_STORE( y, X, n, sizeof(GenefxAccumulator) );
+
+          X += 4; Y += 4;
+     }
+}
+
+/**********************************************************************************************************************/
+
+static void
+Dacc_modulate_argb_vector( GenefxState *gfxs )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *D = gfxs->Dacc;
+     u16x16             C = (u16x16) acc_broadcast_vector( &gfxs->Cacc );
+     u16x16             d;
+
+     for (; w > 0; w -= 4) {
+          int n = MIN( w, 4 );
+
+          VEC_LOAD( d, D, n, sizeof(GenefxAccumulator) );
+
+          d = Xacc_blend_alpha_vector( d, C );
+
+          VEC_STORE( d, D, n, sizeof(GenefxAccumulator) );
+
+          D += 4;
+     }
+}
+
+/**********************************************************************************************************************/
+
+static void
+SCacc_add_to_Dacc_vector( GenefxState *gfxs )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *D = gfxs->Dacc;
+     u16x16             S = (u16x16) acc_broadcast_vector( &gfxs->SCacc );
+     u16x16             d;
+
+     for (; w > 0; w -= 4) {
+          int n = MIN( w, 4 );
+
+          VEC_LOAD( d, D, n, sizeof(GenefxAccumulator) );
+
+          d = acc_select_vector( acc_keep_vector( d ), d + S, d );
+
+          VEC_STORE( d, D, n, sizeof(GenefxAccumulator) );
+
+          D += 4;
+     }
+}
+
+static void
+Sacc_add_to_Dacc_vector( GenefxState *gfxs )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *S = gfxs->Sacc;
+     GenefxAccumulator *D = gfxs->Dacc;
+     u16x16             d, s;
+
+     for (; w > 0; w -= 4) {
+          int n = MIN( w, 4 );
+
+          VEC_LOAD( d, D, n, sizeof(GenefxAccumulator) );
+          VEC_LOAD( s, S, n, sizeof(GenefxAccumulator) );
+
+          d = acc_select_vector( acc_keep_vector( d ), d + s, d );
+
+          VEC_STORE( d, D, n, sizeof(GenefxAccumulator) );
+
+          S += 4;
+          D += 4;
+     }
+}
+
+/**********************************************************************************************************************/
+
+static inline void
+Sop_32_to_Dacc_vector( GenefxState *gfxs,
+                       u32          alpha )
+{
+     int                w = gfxs->length;
+     u32               *S = gfxs->Sop[0];
+     GenefxAccumulator *D = gfxs->Dacc;
+     u32x4              s;
+     u16x16             d;
+
+     for (; w > 0; w -= 4) {
+          int n = MIN( w, 4 );
+
+          VEC_LOAD( s, S, n, 4 );
+
+          d = argb_to_acc_vector( s | alpha );
+
+          VEC_STORE( d, D, n, sizeof(GenefxAccumulator) );
+
+          S += 4;
+          D += 4;
+     }
+}
+
+static void
+Sop_argb_to_Dacc_vector( GenefxState *gfxs )
+{
+     if (gfxs->Ostep != 1)
+          Sop_argb_to_Dacc( gfxs );
+     else
+          Sop_32_to_Dacc_vector( gfxs, 0 );
+}
+
+static void
+Sop_rgb32_to_Dacc_vector( GenefxState *gfxs )
+{
+     if (gfxs->Ostep != 1)
+          Sop_rgb32_to_Dacc( gfxs );
+     else
+          Sop_32_to_Dacc_vector( gfxs, 0xff000000 );
+}
+
+static void
+Sop_rgb16_to_Dacc_vector( GenefxState *gfxs )
+{
+     int                w = gfxs->length;
+     u16               *S = gfxs->Sop[0];
+     GenefxAccumulator *D = gfxs->Dacc;
+     u16x4              s;
+     u32x4              p, r, g, b;
+     u16x16             d;
+
+     if (gfxs->Ostep != 1) {
+          Sop_rgb16_to_Dacc( gfxs );
+          return;
+     }
+
+     for (; w > 0; w -= 4) {
+          int n = MIN( w, 4 );
+
+          VEC_LOAD( s, S, n, 2 );
+
+          p = __builtin_convertvector( s, u32x4 );
+
+          r = p >> 11;
+          g = (p >> 5) & 0x3f;
+          b = p & 0x1f;
+
+          p = 0xff000000 | ((r << 3) | (r >> 2)) << 16 | ((g << 2) | (g >> 4)) << 8 | ((b << 3) | (b >> 2));
+
+          d = argb_to_acc_vector( p );
+
+          VEC_STORE( d, D, n, sizeof(GenefxAccumulator) );
+
+          S += 4;
+          D += 4;
+     }
+}
+
+/**********************************************************************************************************************/
+
+static inline void
+Sop_32_Kto_Dacc_vector( GenefxState *gfxs,
+                        u32          alpha )
+{
+     int                w    = gfxs->length;
+     u32               *S    = gfxs->Sop[0];
+     GenefxAccumulator *D    = gfxs->Dacc;
+     u32                Skey = gfxs->Skey;
+     u32x4              s;
+     u16x16             d;
+     s64x4              key;
+
+     for (; w > 0; w -= 4) {
+          int n = MIN( w, 4 );
+
+          VEC_LOAD( s, S, n, 4 );
+          VEC_LOAD( d, D, n, sizeof(GenefxAccumulator) );
+
+          /* keyed pixels only get the alpha channel of the accumulator marked */
+          key = __builtin_convertvector( (s & 0x00ffffff) == Skey, s64x4 );
+          d   = acc_select_vector( key, (u16x16) (((u64x4) d & 0x0000ffffffffffffull) | 0xf000000000000000ull),
+                                   argb_to_acc_vector( s | alpha ) );
+
+          VEC_STORE( d, D, n, sizeof(GenefxAccumulator) );
+
+          S += 4;
+          D += 4;
+     }
+}
+
+static void
+Sop_argb_Kto_Dacc_vector( GenefxState *gfxs )
+{
+     if (gfxs->Ostep != 1)
+          Sop_argb_Kto_Dacc( gfxs );
+     else
+          Sop_32_Kto_Dacc_vector( gfxs, 0 );
+}
+
+static void
+Sop_rgb32_Kto_Dacc_vector( GenefxState *gfxs )
+{
+     if (gfxs->Ostep != 1)
+          Sop_rgb32_Kto_Dacc( gfxs );
+     else
+          Sop_32_Kto_Dacc_vector( gfxs, 0xff000000 );
+}
+
+/**********************************************************************************************************************/
+
+static void
+Bop_16_Kto_Aop_vector( GenefxState *gfxs )
+{
+     int    w    = gfxs->length;
+     u16   *S    = gfxs->Bop[0];
+     u16   *D    = gfxs->Aop[0];
+     u16    Skey = gfxs->Skey;
+     u16x8  s, d;
+
+     if (gfxs->Ostep != 1) {
+          Bop_16_Kto_Aop( gfxs );
+          return;
+     }
+
+     for (; w > 0; w -= 8) {
+          int   n = MIN( w, 8 );
+          u16x8 m;
+
+          VEC_LOAD( s, S, n, 2 );
+          VEC_LOAD( d, D, n, 2 );
+
+          m = (u16x8) (s != Skey);
+          d = (s & m) | (d & ~m);
+
+          VEC_STORE( d, D, n, 2 );
+
+          S += 8;
+          D += 8;
+     }
+}
+
+static void
+Bop_32_Kto_Aop_vector( GenefxState *gfxs )
+{
+     int    w    = gfxs->length;
+     u32   *S    = gfxs->Bop[0];
+     u32   *D    = gfxs->Aop[0];
+     u32    Skey = gfxs->Skey;
+     u32x4  s, d;
+
+     if (gfxs->Bstep != 1 || gfxs->Astep != 1) {
+          Bop_32_Kto_Aop( gfxs );
+          return;
+     }
+
+     for (; w > 0; w -= 4) {
+          int   n = MIN( w, 4 );
+          u32x4 m;
+
+          VEC_LOAD( s, S, n, 4 );
+          VEC_LOAD( d, D, n, 4 );
+
+          m = (u32x4) ((s & 0x00ffffff) != Skey);
+          d = (s & m) | (d & ~m);
+
+          VEC_STORE( d, D, n, 4 );
+
+          S += 4;
+          D += 4;
+     }
+}
+
+/**********************************************************************************************************************/
+
+static inline void
+Sacc_to_Aop_32_vector( GenefxState *gfxs,
+                       u32          alpha )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *S = gfxs->Sacc;
+     u32               *D = gfxs->Aop[0];
+     u16x16             s;
+     u32x4              p, d;
+     s32x4              keep;
+
+     for (; w > 0; w -= 4) {
+          int n = MIN( w, 4 );
+
+          VEC_LOAD( s, S, n, sizeof(GenefxAccumulator) );
+          VEC_LOAD( d, D, n, 4 );
+
+          p = acc_to_argb_vector( s, &keep ) | alpha;
+          d = (p & (u32x4) keep) | (d & ~(u32x4) keep);
+
+          VEC_STORE( d, D, n, 4 );
+
+          S += 4;
+          D += 4;
+     }
+}
+
+static void
+Sacc_to_Aop_argb_vector( GenefxState *gfxs )
+{
+     if (gfxs->Astep != 1)
+          Sacc_to_Aop_argb( gfxs );
+     else
+          Sacc_to_Aop_32_vector( gfxs, 0 );
+}
+
+static void
+Sacc_to_Aop_rgb32_vector( GenefxState *gfxs )
+{
+     if (gfxs->Astep != 1)
+          Sacc_to_Aop_rgb32( gfxs );
+     else
+          Sacc_to_Aop_32_vector( gfxs, 0xff000000 );
+}
+
+static void
+Sacc_to_Aop_rgb16_vector( GenefxState *gfxs )
+{
+     int                w = gfxs->length;
+     GenefxAccumulator *S = gfxs->Sacc;
+     u16               *D = gfxs->Aop[0];
+     u16x16             s;
+     u16x4              d, m;
+     u32x4              p;
+     s32x4              keep;
+
+     if (gfxs->Astep != 1) {
+          Sacc_to_Aop_rgb16( gfxs );
+          return;
+     }
+
+     for (; w > 0; w -= 4) {
+          int n = MIN( w, 4 );
+
+          VEC_LOAD( s, S, n, sizeof(GenefxAccumulator) );
+          VEC_LOAD( d, D, n, 2 );
+
+          p = acc_to_argb_vector( s, &keep );
+          p = ((p >> 8) & 0xf800) | ((p >> 5) & 0x07e0) | ((p >> 3) & 0x001f);
+          m = (u16x4) __builtin_convertvector( keep, s16x4 );
+          d = (__builtin_convertvector( p, u16x4 ) & m) | (d & ~m);
+
+          VEC_STORE( d, D, n, 2 );
+
+          S += 4;
+          D += 4;
+     }
+}
+
+#undef VEC_LOAD
+#undef VEC_STORE
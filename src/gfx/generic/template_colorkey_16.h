@@ -115,16 +115,16 @@ Bop_PFI_OP_Aop_PFI(toK)( GenefxState *gfxs )
           else {
                if (MASK_RGB_L( d ) == Dkey) {
 #ifdef WORDS_BIGENDIAN
-                    D[0] = S[0];
-#else
                     D[1] = S[1];
+#else
+                    D[0] = S[0];
 #endif
                }
                else if (MASK_RGB_H( d ) == DkeyH) {
 #ifdef WORDS_BIGENDIAN
-                    D[1] = S[1];
-#else
                     D[0] = S[0];
+#else
+                    D[1] = S[1];
 #endif
                }
           }
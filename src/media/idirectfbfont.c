@@ -18,6 +18,7 @@
 
 #include <core/fonts.h>
 #include <direct/filesystem.h>
+#include <direct/thread.h>
 #include <direct/utf8.h>
 #include <direct/util.h>
 #include <directfb_util.h>
@@ -53,13 +54,121 @@ sqrt16( unsigned int val )
 
 /**********************************************************************************************************************/
 
+/*
+ * Number of glyphs cached by the prewarm thread per font lock.
+ */
+#define PREWARM_CHUNK 16
+
+/*
+ * Number of glyphs looked up at once when measuring a string, not more than the glyph cache is expected to hold.
+ */
+#define MEASURE_CHUNK 32
+
+typedef struct {
+     DirectLink              link;
+
+     unsigned int           *indices;
+     int                     num;
+
+     DFBFontPrewarmCallback  callback;
+     void                   *callbackdata;
+} PrewarmRequest;
+
+static void *
+IDirectFBFont_Prewarm( DirectThread *thread,
+                       void         *arg )
+{
+     IDirectFBFont_data *data   = arg;
+     CoreFont           *font   = data->font;
+     unsigned int        layers = (font->attributes & DFFA_OUTLINED) ? 2 : 1;
+
+     direct_mutex_lock( &data->prewarm_lock );
+
+     while (true) {
+          int             i;
+          PrewarmRequest *request;
+
+          while (!data->prewarm_queue && !data->prewarm_quit)
+               direct_waitqueue_wait( &data->prewarm_wq, &data->prewarm_lock );
+
+          if (data->prewarm_quit)
+               break;
+
+          request = (PrewarmRequest*) data->prewarm_queue;
+
+          direct_list_remove( &data->prewarm_queue, &request->link );
+
+          for (i = 0; i < request->num && !data->prewarm_quit;) {
+               int end = MIN( i + PREWARM_CHUNK, request->num );
+
+               direct_mutex_unlock( &data->prewarm_lock );
+
+               /* Hold the font lock for a few glyphs only, drawing is not blocked for longer. */
+               dfb_font_lock( font );
+
+               for (; i < end; i++) {
+                    unsigned int   l;
+                    CoreGlyphData *glyph;
+
+                    for (l = 0; l < layers; l++)
+                         dfb_font_get_glyph_data( font, request->indices[i], l, &glyph );
+               }
+
+               dfb_font_unlock( font );
+
+               direct_mutex_lock( &data->prewarm_lock );
+          }
+
+          direct_mutex_unlock( &data->prewarm_lock );
+
+          D_DEBUG_AT( Font, "  -> prewarmed %d/%d glyphs\n", i, request->num );
+
+          if (request->callback)
+               request->callback( i == request->num ? DFB_OK : DFB_DESTROYED, request->callbackdata );
+
+          D_FREE( request );
+
+          direct_mutex_lock( &data->prewarm_lock );
+     }
+
+     direct_mutex_unlock( &data->prewarm_lock );
+
+     return NULL;
+}
+
+/**********************************************************************************************************************/
+
 void
 IDirectFBFont_Destruct( IDirectFBFont *thiz )
 {
      IDirectFBFont_data *data = thiz->priv;
+     PrewarmRequest     *request, *next;
 
      D_DEBUG_AT( Font, "%s( %p )\n", __FUNCTION__, thiz );
 
+     if (data->prewarm_thread) {
+          direct_mutex_lock( &data->prewarm_lock );
+
+          data->prewarm_quit = true;
+
+          direct_waitqueue_broadcast( &data->prewarm_wq );
+
+          direct_mutex_unlock( &data->prewarm_lock );
+
+          direct_thread_join( data->prewarm_thread );
+          direct_thread_destroy( data->prewarm_thread );
+     }
+
+     direct_list_foreach_safe (request, next, data->prewarm_queue) {
+          if (request->callback)
+               request->callback( DFB_DESTROYED, request->callbackdata );
+
+          D_FREE( request );
+     }
+
+     direct_waitqueue_deinit( &data->prewarm_wq );
+     direct_mutex_deinit( &data->prewarm_lock );
+
      dfb_font_destroy( data->font );
 
      if (data->content) {
@@ -244,8 +353,8 @@ IDirectFBFont_GetStringWidth( IDirectFBFont *thiz,
 
      if (bytes > 0) {
           int          i, num;
-          unsigned int prev = 0;
           unsigned int indices[bytes];
+          DFBPoint     advances[bytes];
 
           dfb_font_lock( data->font );
 
@@ -257,27 +366,14 @@ IDirectFBFont_GetStringWidth( IDirectFBFont *thiz,
           }
 
           /* Calculate string width. */
-          for (i = 0; i < num; i++) {
-               unsigned int   current = indices[i];
-               CoreGlyphData *glyph;
-
-               if (dfb_font_get_glyph_data( data->font, current, 0, &glyph ) == DFB_OK) {
-                    int kx, ky;
+          dfb_font_get_glyph_data_array( data->font, 0, indices, num, 0, NULL, advances );
 
-                    xsize += glyph->xadvance;
-                    ysize += glyph->yadvance;
-
-                    if (prev && data->font->GetKerning &&
-                        data->font->GetKerning( data->font, prev, current, &kx, &ky ) == DFB_OK) {
-                         xsize += kx << 8;
-                         ysize += ky << 8;
-                    }
-               }
+          dfb_font_unlock( data->font );
 
-               prev = current;
+          for (i = 0; i < num; i++) {
+               xsize += advances[i].x;
+               ysize += advances[i].y;
           }
-
-          dfb_font_unlock( data->font );
      }
 
      if (!ysize) {
@@ -323,9 +419,10 @@ IDirectFBFont_GetStringExtents( IDirectFBFont *thiz,
      dfb_font_lock( data->font );
 
      if (bytes > 0) {
-          int          i, num;
-          unsigned int prev  = 0;
-          unsigned int indices[bytes];
+          int            c, i, num;
+          unsigned int   indices[bytes];
+          CoreGlyphData *glyphs[MEASURE_CHUNK];
+          DFBPoint       advances[MEASURE_CHUNK];
 
           /* Decode string to character indices. */
           ret = dfb_font_decode_text( data->font, data->encoding, text, bytes, indices, &num );
@@ -334,31 +431,27 @@ IDirectFBFont_GetStringExtents( IDirectFBFont *thiz,
                return ret;
           }
 
-          for (i = 0; i < num; i++) {
-               unsigned int   current = indices[i];
-               CoreGlyphData *glyph;
+          for (c = 0; c < num; c += MEASURE_CHUNK) {
+               int n = MIN( num - c, MEASURE_CHUNK );
 
-               if (dfb_font_get_glyph_data( data->font, current, 0, &glyph ) == DFB_OK) {
-                    int kx, ky;
+               dfb_font_get_glyph_data_array( data->font, c ? indices[c - 1] : 0, indices + c, n, 0,
+                                              glyphs, advances );
 
-                    if (prev && data->font->GetKerning &&
-                        data->font->GetKerning( data->font, prev, current, &kx, &ky ) == DFB_OK) {
-                         xbaseline += kx << 8;
-                         ybaseline += ky << 8;
-                    }
+               for (i = 0; i < n; i++) {
+                    CoreGlyphData *glyph = glyphs[i];
+
+                    xbaseline += advances[i].x;
+                    ybaseline += advances[i].y;
 
-                    if (ret_ink_rect) {
-                         DFBRectangle glyph_rect = { xbaseline + (glyph->left << 8), ybaseline + (glyph->top << 8),
-                                                     glyph->width << 8,              glyph->height << 8 };
+                    /* The advance includes the kerning, the glyph is placed before its own advance. */
+                    if (glyph && ret_ink_rect) {
+                         DFBRectangle glyph_rect = { xbaseline - glyph->xadvance + (glyph->left << 8),
+                                                     ybaseline - glyph->yadvance + (glyph->top << 8),
+                                                     glyph->width << 8, glyph->height << 8 };
 
                          dfb_rectangle_union( ret_ink_rect, &glyph_rect );
                     }
-
-                    xbaseline += glyph->xadvance;
-                    ybaseline += glyph->yadvance;
                }
-
-               prev = current;
           }
      }
 
@@ -466,20 +559,15 @@ IDirectFBFont_GetStringBreak( IDirectFBFont  *thiz,
                               int            *ret_str_length,
                               const char    **ret_next_line )
 {
-     DFBResult      ret;
-     const u8      *string;
-     const u8      *last;
-     const u8      *end;
-     CoreGlyphData *glyph;
-     int            kern_x;
-     int            kern_y;
-     int            length = 0;
-     int            xsize = 0;
-     int            ysize = 0;
-     int            width = 0;
-     unichar        current;
-     unsigned int   index;
-     unsigned int   prev  = 0;
+     const u8     *string;
+     const u8     *last;
+     const u8     *end;
+     int           length = 0;
+     int           xsize  = 0;
+     int           ysize  = 0;
+     int           width  = 0;
+     unichar       current;
+     unsigned int  prev   = 0;
 
      DIRECT_INTERFACE_GET_DATA( IDirectFBFont )
 
@@ -501,62 +589,81 @@ IDirectFBFont_GetStringBreak( IDirectFBFont  *thiz,
      }
 
      string = (const u8*) text;
+     last   = string;
      end    = string + bytes;
 
      *ret_next_line = NULL;
 
      dfb_font_lock( data->font );
 
-     do {
-          *ret_width = width >> 8;
+     while (true) {
+          int           i, j, n, num = 0;
+          const u8     *pos = string;
+          unichar       chars[MEASURE_CHUNK];
+          const u8     *next[MEASURE_CHUNK];
+          bool          valid[MEASURE_CHUNK];
+          unsigned int  indices[MEASURE_CHUNK];
+          DFBPoint      advances[MEASURE_CHUNK];
 
-          current = DIRECT_UTF8_GET_CHAR( string );
+          /* Decode a chunk of characters. */
+          for (n = 0; n < MEASURE_CHUNK && pos < end; n++) {
+               chars[n] = DIRECT_UTF8_GET_CHAR( pos );
 
-          last    = string;
-          string += DIRECT_UTF8_SKIP( string[0] );
+               pos    += DIRECT_UTF8_SKIP( pos[0] );
+               next[n] = pos;
 
-          if (current == ' ' || current == 0x0a) {
-               *ret_next_line  = (const char*) string;
-               *ret_str_length = length;
-               *ret_width      = width >> 8;
+               valid[n] = dfb_font_decode_character( data->font, data->encoding, chars[n], &indices[num] ) == DFB_OK;
+               if (valid[n])
+                    num++;
+
+               if (chars[n] == 0x0a) {
+                    n++;
+                    break;
+               }
           }
 
-          length++;
+          dfb_font_get_glyph_data_array( data->font, prev, indices, num, 0, NULL, advances );
 
-          ret = dfb_font_decode_character( data->font, data->encoding, current, &index );
-          if (ret)
-               continue;
+          /* Accumulate the width until the line is full. */
+          for (i = 0, j = 0; i < n; i++) {
+               *ret_width = width >> 8;
 
-          ret = dfb_font_get_glyph_data( data->font, index, 0, &glyph );
-          if (ret)
-               continue;
+               current = chars[i];
 
-          xsize += glyph->xadvance;
-          ysize += glyph->yadvance;
+               last   = string;
+               string = next[i];
 
-          if (prev && data->font->GetKerning &&
-              data->font->GetKerning( data->font, prev, index, &kern_x, NULL ) == DFB_OK)
-               width += kern_x << 8;
+               if (current == ' ' || current == 0x0a) {
+                    *ret_next_line  = (const char*) string;
+                    *ret_str_length = length;
+                    *ret_width      = width >> 8;
+               }
 
-          if (prev && data->font->GetKerning &&
-              data->font->GetKerning( data->font, prev, index, &kern_x, &kern_y) == DFB_OK) {
-               xsize += kern_x << 8;
-               ysize += kern_y << 8;
-          }
+               length++;
 
-          if (!ysize) {
-               width = xsize;
-          }
-          else if (!xsize) {
-               width = ysize;
-          }
-          else {
-               width = sqrt16( xsize * xsize + ysize * ysize ) / 256.0f;
-          }
+               if (valid[i]) {
+                    xsize += advances[j].x;
+                    ysize += advances[j].y;
 
-          prev = index;
-     } while ((width >> 8) < max_width && string < end && current != 0x0a);
+                    if (!ysize) {
+                         width = xsize;
+                    }
+                    else if (!xsize) {
+                         width = ysize;
+                    }
+                    else {
+                         width = sqrt16( xsize * xsize + ysize * ysize ) / 256.0f;
+                    }
+
+                    prev = indices[j++];
+               }
+
+               if ((width >> 8) >= max_width || string >= end || current == 0x0a)
+                    goto out;
+          }
+     }
 
+out:
      dfb_font_unlock( data->font );
 
      if ((width >> 8) < max_width && string >= end) {
@@ -774,6 +881,71 @@ IDirectFBFont_GetDescription( IDirectFBFont      *thiz,
      return DFB_OK;
 }
 
+static DFBResult
+IDirectFBFont_PrewarmGlyphs( IDirectFBFont          *thiz,
+                             const char             *text,
+                             int                     bytes,
+                             DFBFontPrewarmCallback  callback,
+                             void                   *callbackdata )
+{
+     DFBResult       ret;
+     int             num;
+     PrewarmRequest *request;
+
+     DIRECT_INTERFACE_GET_DATA( IDirectFBFont )
+
+     D_DEBUG_AT( Font, "%s( %p )\n", __FUNCTION__, thiz );
+
+     if (!text)
+          return DFB_INVARG;
+
+     if (bytes < 0)
+          bytes = strlen( text );
+
+     request = D_CALLOC( 1, sizeof(PrewarmRequest) + bytes * sizeof(unsigned int) );
+     if (!request)
+          return D_OOM();
+
+     request->indices      = (unsigned int*) (request + 1);
+     request->callback     = callback;
+     request->callbackdata = callbackdata;
+
+     if (bytes > 0) {
+          dfb_font_lock( data->font );
+
+          /* Decode string to character indices. */
+          ret = dfb_font_decode_text( data->font, data->encoding, text, bytes, request->indices, &num );
+
+          dfb_font_unlock( data->font );
+
+          if (ret) {
+               D_FREE( request );
+               return ret;
+          }
+
+          request->num = num;
+     }
+
+     direct_mutex_lock( &data->prewarm_lock );
+
+     if (!data->prewarm_thread) {
+          data->prewarm_thread = direct_thread_create( DTT_DEFAULT, IDirectFBFont_Prewarm, data, "Font Prewarm" );
+          if (!data->prewarm_thread) {
+               direct_mutex_unlock( &data->prewarm_lock );
+               D_FREE( request );
+               return DFB_INIT;
+          }
+     }
+
+     direct_list_append( &data->prewarm_queue, &request->link );
+
+     direct_waitqueue_signal( &data->prewarm_wq );
+
+     direct_mutex_unlock( &data->prewarm_lock );
+
+     return DFB_OK;
+}
+
 DFBResult
 IDirectFBFont_Construct( IDirectFBFont *thiz, CoreFont *font )
 {
@@ -784,6 +956,9 @@ IDirectFBFont_Construct( IDirectFBFont *thiz, CoreFont *font )
      data->ref  = 1;
      data->font = font;
 
+     direct_mutex_init( &data->prewarm_lock );
+     direct_waitqueue_init( &data->prewarm_wq );
+
      thiz->AddRef               = IDirectFBFont_AddRef;
      thiz->Release              = IDirectFBFont_Release;
      thiz->GetAscender          = IDirectFBFont_GetAscender;
@@ -803,6 +978,7 @@ IDirectFBFont_Construct( IDirectFBFont *thiz, CoreFont *font )
      thiz->GetGlyphExtentsXY    = IDirectFBFont_GetGlyphExtentsXY;
      thiz->GetUnderline         = IDirectFBFont_GetUnderline;
      thiz->GetDescription       = IDirectFBFont_GetDescription;
+     thiz->PrewarmGlyphs        = IDirectFBFont_PrewarmGlyphs;
 
      return DFB_OK;
 }
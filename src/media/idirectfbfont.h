@@ -20,6 +20,8 @@
 #define __MEDIA__IDIRECTFBFONT_H__
 
 #include <core/coretypes.h>
+#include <direct/mutex.h>
+#include <direct/waitqueue.h>
 
 /*
  * type of probing context
@@ -54,6 +56,12 @@ typedef struct {
      unsigned int                           content_size;
      IDirectFBFont_ProbeContextContentType  content_type;
      DFBTextEncodingID                      encoding;
+
+     DirectMutex                            prewarm_lock; /* protects the prewarm queue */
+     DirectWaitQueue                        prewarm_wq;
+     DirectThread                          *prewarm_thread;
+     DirectLink                            *prewarm_queue;
+     bool                                   prewarm_quit;
 } IDirectFBFont_data;
 
 /*
@@ -91,9 +91,15 @@ static const char *dfb_config_usage =
      "  [no-]startstop                 Issue StartDrawing/StopDrawing to driver\n"
      "  [no-]smooth-upscale            Enable smooth upscaling\n"
      "  [no-]smooth-downscale          Enable smooth downscaling\n"
+     "  [no-]smooth-bicubic            Use bicubic instead of bilinear interpolation for smooth scaling\n"
      "  keep-accumulators=<limit>      Free accumulators above the limit (default = 1024)\n"
      "                                 Setting -1 never frees accumulators until the state is destroyed\n"
      "  [no-]mmx                       Enable MMX assembly support (enabled by default if available)\n"
+     "  [no-]sse2                      Enable SSE2 support (enabled by default if available)\n"
+     "  [no-]avx2                      Enable AVX2 support (enabled by default if available)\n"
+     "  genefx-threads=<num>           Split large software blits and fills into bands rendered by <num> threads\n"
+     "  genefx-stream-size=<kb>        Bypass the cache for software fills larger than this (default = 4096)\n"
+     "  software-queue=<num>           Render software operations in a thread, queueing up to <num> of them\n"
      "  warn=<type[:<width>x<height>]> Print warnings on surface/window creations or surface buffer allocations\n"
      "                                 [ create-surface | create-window | allocate-buffer ]\n"
      "  [no-]surface-clear             Clear all surface buffers after creation\n"
@@ -135,8 +141,14 @@ static const char *dfb_config_usage =
      "  font-format=<pixelformat>      Set the preferred font format (default is 8 bit alpha)\n"
      "  [no-]font-premult              Enable premultiplied glyph images in ARGB format (default enabled)\n"
      "  font-resource-id=<id>          Resource ID to use for font cache row surfaces\n"
-     "  max-font-rows=<number>         Maximum number of glyph cache rows (default = 99)\n"
-     "  max-font-row-width=<pixels>    Maximum width of glyph cache row surface (default = 2048)\n"
+     "  max-font-pages=<number>        Maximum number of glyph cache pages (default = 8)\n"
+     "  font-page-size=<pixels>        Width and height of glyph cache page surfaces (default = 512)\n"
+     "  max-font-rows=<number>         Deprecated, sets max-font-pages to hold as many rows of 32 pixels\n"
+     "  max-font-row-width=<pixels>    Deprecated, sets font-page-size\n"
+     "  font-run-cache=<kb>            Cache rendered text runs up to this size (default = 0, disabled)\n"
+     "  font-shared-pages=<number>     Glyph cache pages shared between processes (default = 0, disabled)\n"
+     "  [no-]font-preload              Read ahead the glyphs of memory mapped fonts when loading (default disabled)\n"
+     "  [no-]font-mlock                Lock the glyphs of memory mapped fonts in memory (default disabled)\n"
      "\n";
 
 /**********************************************************************************************************************/
@@ -270,6 +282,9 @@ config_allocate()
      dfb_config->keep_accumulators                     = 1024;
 
      dfb_config->mmx                                   = true;
+     dfb_config->sse2                                  = true;
+     dfb_config->avx2                                  = true;
+     dfb_config->genefx_stream_size                    = 4096 * 1024;
 
      dfb_config->surface_shmpool_size                  = 64 * 1024 * 1024;
 
@@ -281,6 +296,8 @@ config_allocate()
 
      dfb_config->font_format                           = DSPF_A8;
      dfb_config->font_premult                          = true;
+     dfb_config->max_font_pages                        = 8;
+     dfb_config->font_page_size                        = 512;
      dfb_config->max_font_rows                         = 99;
      dfb_config->max_font_row_width                    = 2048;
 }
@@ -1026,6 +1043,12 @@ dfb_config_set( const char *name,
      if (strcmp( name, "no-smooth-downscale" ) == 0) {
           dfb_config->render_options &= ~DSRO_SMOOTH_DOWNSCALE;
      } else
+     if (strcmp( name, "smooth-bicubic" ) == 0) {
+          dfb_config->render_options |= DSRO_SMOOTH_BICUBIC;
+     } else
+     if (strcmp( name, "no-smooth-bicubic" ) == 0) {
+          dfb_config->render_options &= ~DSRO_SMOOTH_BICUBIC;
+     } else
      if (strcmp( name, "keep-accumulators" ) == 0) {
           if (value) {
                int limit;
@@ -1048,6 +1071,66 @@ dfb_config_set( const char *name,
      if (strcmp( name, "no-mmx" ) == 0) {
           dfb_config->mmx = false;
      } else
+     if (strcmp( name, "sse2" ) == 0) {
+          dfb_config->sse2 = true;
+     } else
+     if (strcmp( name, "no-sse2" ) == 0) {
+          dfb_config->sse2 = false;
+     } else
+     if (strcmp( name, "avx2" ) == 0) {
+          dfb_config->avx2 = true;
+     } else
+     if (strcmp( name, "no-avx2" ) == 0) {
+          dfb_config->avx2 = false;
+     } else
+     if (strcmp( name, "genefx-threads" ) == 0) {
+          if (value) {
+               int threads;
+
+               if (sscanf( value, "%d", &threads ) < 1) {
+                    D_ERROR( "DirectFB/Config: '%s': Could not parse value!\n", name );
+                    return DFB_INVARG;
+               }
+
+               dfb_config->genefx_threads = threads;
+          }
+          else {
+               D_ERROR( "DirectFB/Config: '%s': No value specified!\n", name );
+               return DFB_INVARG;
+          }
+     } else
+     if (strcmp( name, "genefx-stream-size" ) == 0) {
+          if (value) {
+               int size_kb;
+
+               if (sscanf( value, "%d", &size_kb ) < 1) {
+                    D_ERROR( "DirectFB/Config: '%s': Could not parse value!\n", name );
+                    return DFB_INVARG;
+               }
+
+               dfb_config->genefx_stream_size = size_kb * 1024;
+          }
+          else {
+               D_ERROR( "DirectFB/Config: '%s': No value specified!\n", name );
+               return DFB_INVARG;
+          }
+     } else
+     if (strcmp( name, "software-queue" ) == 0) {
+          if (value) {
+               int entries;
+
+               if (sscanf( value, "%d", &entries ) < 1) {
+                    D_ERROR( "DirectFB/Config: '%s': Could not parse value!\n", name );
+                    return DFB_INVARG;
+               }
+
+               dfb_config->software_queue = entries;
+          }
+          else {
+               D_ERROR( "DirectFB/Config: '%s': No value specified!\n", name );
+               return DFB_INVARG;
+          }
+     } else
      if (strcmp( name, "warn" ) == 0 || strcmp( name, "no-warn" ) == 0) {
           DFBConfigWarnFlags flags = DCWF_ALL;
 
@@ -1357,6 +1440,38 @@ dfb_config_set( const char *name,
                return DFB_INVARG;
           }
      } else
+     if (strcmp( name, "max-font-pages" ) == 0) {
+          if (value) {
+               int pages;
+
+               if (sscanf( value, "%d", &pages ) < 1) {
+                    D_ERROR( "DirectFB/Config: '%s': Could not parse value!\n", name );
+                    return DFB_INVARG;
+               }
+
+               dfb_config->max_font_pages = pages;
+          }
+          else {
+               D_ERROR( "DirectFB/Config: '%s': No value specified!\n", name );
+               return DFB_INVARG;
+          }
+     } else
+     if (strcmp( name, "font-page-size" ) == 0) {
+          if (value) {
+               int size;
+
+               if (sscanf( value, "%d", &size ) < 1) {
+                    D_ERROR( "DirectFB/Config: '%s': Could not parse value!\n", name );
+                    return DFB_INVARG;
+               }
+
+               dfb_config->font_page_size = size;
+          }
+          else {
+               D_ERROR( "DirectFB/Config: '%s': No value specified!\n", name );
+               return DFB_INVARG;
+          }
+     } else
      if (strcmp( name, "max-font-rows" ) == 0) {
           if (value) {
                int rows;
@@ -1366,7 +1481,10 @@ dfb_config_set( const char *name,
                     return DFB_INVARG;
                }
 
-               dfb_config->max_font_rows = rows;
+               D_WARN( "'%s' is deprecated, use 'max-font-pages'", name );
+
+               dfb_config->max_font_rows  = rows;
+               dfb_config->max_font_pages = (rows * 32 + dfb_config->font_page_size - 1) / dfb_config->font_page_size;
           }
           else {
                D_ERROR( "DirectFB/Config: '%s': No value specified!\n", name );
@@ -1382,13 +1500,59 @@ dfb_config_set( const char *name,
                     return DFB_INVARG;
                }
 
+               D_WARN( "'%s' is deprecated, use 'font-page-size'", name );
 
                dfb_config->max_font_row_width = row_width;
+               dfb_config->font_page_size     = row_width;
           }
           else {
                D_ERROR( "DirectFB/Config: '%s': No value specified!\n", name );
                return DFB_INVARG;
           }
+     } else
+     if (strcmp( name, "font-run-cache" ) == 0) {
+          if (value) {
+               int size_kb;
+
+               if (sscanf( value, "%d", &size_kb ) < 1) {
+                    D_ERROR( "DirectFB/Config: '%s': Could not parse value!\n", name );
+                    return DFB_INVARG;
+               }
+
+               dfb_config->font_run_cache = size_kb * 1024;
+          }
+          else {
+               D_ERROR( "DirectFB/Config: '%s': No value specified!\n", name );
+               return DFB_INVARG;
+          }
+     } else
+     if (strcmp( name, "font-shared-pages" ) == 0) {
+          if (value) {
+               int pages;
+
+               if (sscanf( value, "%d", &pages ) < 1) {
+                    D_ERROR( "DirectFB/Config: '%s': Could not parse value!\n", name );
+                    return DFB_INVARG;
+               }
+
+               dfb_config->font_shared_pages = pages;
+          }
+          else {
+               D_ERROR( "DirectFB/Config: '%s': No value specified!\n", name );
+               return DFB_INVARG;
+          }
+     } else
+     if (strcmp( name, "font-preload" ) == 0) {
+          dfb_config->font_preload = true;
+     } else
+     if (strcmp( name, "no-font-preload" ) == 0) {
+          dfb_config->font_preload = false;
+     } else
+     if (strcmp( name, "font-mlock" ) == 0) {
+          dfb_config->font_mlock = true;
+     } else
+     if (strcmp( name, "no-font-mlock" ) == 0) {
+          dfb_config->font_mlock = false;
      }
      else {
           dfboption = false;
@@ -97,6 +97,11 @@ typedef struct
      DFBSurfaceRenderOptions     render_options;
      int                         keep_accumulators;
      bool                        mmx;
+     bool                        sse2;
+     bool                        avx2;
+     int                         genefx_threads;
+     int                         genefx_stream_size;
+     int                         software_queue;
      struct {
           DFBConfigWarnFlags     flags;
           struct {
@@ -134,8 +139,14 @@ typedef struct
      DFBSurfacePixelFormat       font_format;
      bool                        font_premult;
      unsigned long               font_resource_id;
+     int                         max_font_pages;
+     int                         font_page_size;
      int                         max_font_rows;
      int                         max_font_row_width;
+     int                         font_run_cache;
+     int                         font_shared_pages;
+     bool                        font_preload;
+     bool                        font_mlock;
 } DFBConfig;
 
 /**********************************************************************************************************************/
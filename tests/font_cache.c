@@ -0,0 +1,286 @@
+/*
+   This file is part of DirectFB.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+*/
+
+/*
+ * Draw a string with more distinct glyphs than the glyph cache holds, and compare it with the glyphs drawn one by one.
+ *
+ * Arguments are the dummy system and default wm modules to load.
+ */
+
+#include <core/fonts.h>
+#include <core/surface.h>
+#include <core/surface_buffer.h>
+#include <dlfcn.h>
+#include <media/idirectfbfont.h>
+
+#define GLYPH_SIZE    12
+#define GLYPH_ADVANCE 13
+#define NUM_GLYPHS    60
+
+static DFBResult Probe    ( IDirectFBFont_ProbeContext *ctx );
+
+static DFBResult Construct( IDirectFBFont              *thiz,
+                            CoreDFB                    *core,
+                            IDirectFBFont_ProbeContext *ctx,
+                            DFBFontDescription         *desc );
+
+#include <direct/interface_implementation.h>
+
+DIRECT_INTERFACE_IMPLEMENTATION( IDirectFBFont, Test )
+
+static const char font_magic[] = "TESTFONT";
+
+/**********************************************************************************************************************/
+
+static DFBResult
+test_get_glyph_data( CoreFont      *thiz,
+                     unsigned int   index,
+                     CoreGlyphData *data )
+{
+     data->width    = GLYPH_SIZE;
+     data->height   = GLYPH_SIZE;
+     data->left     = 0;
+     data->top      = 0;
+     data->xadvance = GLYPH_ADVANCE;
+     data->yadvance = 0;
+
+     return DFB_OK;
+}
+
+static DFBResult
+test_render_glyph( CoreFont      *thiz,
+                   unsigned int   index,
+                   CoreGlyphData *data )
+{
+     DFBResult              ret;
+     int                    x, y;
+     CoreSurfaceBufferLock  lock;
+
+     ret = dfb_surface_lock_buffer( data->surface, DSBR_BACK, CSAID_CPU, CSAF_WRITE, &lock );
+     if (ret)
+          return ret;
+
+     /* Every glyph gets a pattern of its own. */
+     for (y = 0; y < data->height; y++) {
+          u8 *dst = lock.addr + y * lock.pitch + data->start;
+
+          for (x = 0; x < data->width; x++)
+               dst[x] = (index * 37 + x * 7 + y * 13) | 1;
+     }
+
+     dfb_surface_unlock_buffer( data->surface, &lock );
+
+     return DFB_OK;
+}
+
+static DFBResult
+Probe( IDirectFBFont_ProbeContext *ctx )
+{
+     if (ctx->content_size >= sizeof(font_magic) && !memcmp( ctx->content, font_magic, sizeof(font_magic) ))
+          return DFB_OK;
+
+     return DFB_UNSUPPORTED;
+}
+
+static DFBResult
+Construct( IDirectFBFont              *thiz,
+           CoreDFB                    *core,
+           IDirectFBFont_ProbeContext *ctx,
+           DFBFontDescription         *desc )
+{
+     DFBResult  ret;
+     CoreFont  *font;
+
+     ret = dfb_font_create( core, desc, font_magic, &font );
+     if (ret)
+          return ret;
+
+     font->pixel_format = DSPF_A8;
+     font->surface_caps = DSCAPS_NONE;
+     font->ascender     = GLYPH_SIZE;
+     font->descender    = 0;
+     font->height       = GLYPH_SIZE;
+     font->maxadvance   = GLYPH_ADVANCE;
+     font->up_unit_x    =  0.0;
+     font->up_unit_y    = -1.0;
+
+     font->GetGlyphData = test_get_glyph_data;
+     font->RenderGlyph  = test_render_glyph;
+
+     return IDirectFBFont_Construct( thiz, font );
+}
+
+/**********************************************************************************************************************/
+
+static IDirectFBSurface *
+create_target( IDirectFB     *dfb,
+               IDirectFBFont *font )
+{
+     DFBResult              ret;
+     DFBSurfaceDescription  desc;
+     IDirectFBSurface      *surface;
+
+     desc.flags       = DSDESC_WIDTH | DSDESC_HEIGHT | DSDESC_PIXELFORMAT;
+     desc.width       = NUM_GLYPHS * GLYPH_ADVANCE;
+     desc.height      = GLYPH_SIZE;
+     desc.pixelformat = DSPF_ARGB;
+
+     ret = dfb->CreateSurface( dfb, &desc, &surface );
+     if (ret) {
+          DirectFBError( "CreateSurface", ret );
+          return NULL;
+     }
+
+     surface->Clear( surface, 0, 0, 0, 0 );
+     surface->SetColor( surface, 0xff, 0xff, 0xff, 0xff );
+     surface->SetFont( surface, font );
+
+     return surface;
+}
+
+static int
+compare_targets( IDirectFBSurface *string,
+                 IDirectFBSurface *glyphs )
+{
+     int   x, y;
+     int   diffs  = 0;
+     int   pixels = 0;
+     void *string_ptr, *glyphs_ptr;
+     int   string_pitch, glyphs_pitch;
+
+     if (string->Lock( string, DSLF_READ, &string_ptr, &string_pitch ))
+          return -1;
+
+     if (glyphs->Lock( glyphs, DSLF_READ, &glyphs_ptr, &glyphs_pitch )) {
+          string->Unlock( string );
+          return -1;
+     }
+
+     for (y = 0; y < GLYPH_SIZE; y++) {
+          const u32 *s = string_ptr + y * string_pitch;
+          const u32 *g = glyphs_ptr + y * glyphs_pitch;
+
+          for (x = 0; x < NUM_GLYPHS * GLYPH_ADVANCE; x++) {
+               if (s[x] != g[x])
+                    diffs++;
+
+               if (g[x])
+                    pixels++;
+          }
+     }
+
+     glyphs->Unlock( glyphs );
+     string->Unlock( string );
+
+     if (!pixels) {
+          fprintf( stderr, "No glyph has been drawn!\n" );
+          return -1;
+     }
+
+     return diffs;
+}
+
+int
+main( int argc, char *argv[] )
+{
+     DFBResult                 ret;
+     int                       i, diffs;
+     char                      text[NUM_GLYPHS + 1];
+     DFBDataBufferDescription  bdesc;
+     DFBFontDescription        fdesc;
+     IDirectFB                *dfb;
+     IDirectFBDataBuffer      *buffer;
+     IDirectFBFont            *font;
+     IDirectFBSurface         *string;
+     IDirectFBSurface         *glyphs;
+
+     /* Register the modules given on the command line. */
+     for (i = 1; i < argc; i++) {
+          if (!dlopen( argv[i], RTLD_NOW | RTLD_GLOBAL )) {
+               fprintf( stderr, "Could not load '%s': %s\n", argv[i], dlerror() );
+               return 1;
+          }
+     }
+
+     ret = DirectFBInit( &argc, &argv );
+     if (ret) {
+          DirectFBError( "DirectFBInit", ret );
+          return 1;
+     }
+
+     /* A single small page of the glyph cache holds 25 glyphs, less than the string has. */
+     DirectFBSetOption( "system", "dummy" );
+     DirectFBSetOption( "no-cursor", NULL );
+     DirectFBSetOption( "quiet", NULL );
+     DirectFBSetOption( "max-font-pages", "1" );
+     DirectFBSetOption( "font-page-size", "64" );
+
+     ret = DirectFBCreate( &dfb );
+     if (ret) {
+          DirectFBError( "DirectFBCreate", ret );
+          return 1;
+     }
+
+     bdesc.flags         = DBDESC_MEMORY;
+     bdesc.memory.data   = font_magic;
+     bdesc.memory.length = sizeof(font_magic);
+
+     ret = dfb->CreateDataBuffer( dfb, &bdesc, &buffer );
+     if (ret) {
+          DirectFBError( "CreateDataBuffer", ret );
+          return 1;
+     }
+
+     fdesc.flags  = DFDESC_HEIGHT;
+     fdesc.height = GLYPH_SIZE;
+
+     ret = buffer->CreateFont( buffer, &fdesc, &font );
+     if (ret) {
+          DirectFBError( "CreateFont", ret );
+          return 1;
+     }
+
+     string = create_target( dfb, font );
+     glyphs = create_target( dfb, font );
+     if (!string || !glyphs)
+          return 1;
+
+     for (i = 0; i < NUM_GLYPHS; i++)
+          text[i] = '!' + i;
+
+     text[NUM_GLYPHS] = 0;
+
+     /* The whole string at once, loading glyphs evicts the ones loaded before. */
+     string->DrawString( string, text, -1, 0, 0, DSTF_TOPLEFT );
+
+     /* Each glyph on its own. */
+     for (i = 0; i < NUM_GLYPHS; i++)
+          glyphs->DrawString( glyphs, text + i, 1, i * GLYPH_ADVANCE, 0, DSTF_TOPLEFT );
+
+     diffs = compare_targets( string, glyphs );
+     if (diffs)
+          fprintf( stderr, "String differs from single glyphs in %d pixels!\n", diffs );
+
+     glyphs->Release( glyphs );
+     string->Release( string );
+     font->Release( font );
+     buffer->Release( buffer );
+     dfb->Release( dfb );
+
+     return diffs ? 1 : 0;
+}
@@ -0,0 +1,614 @@
+/*
+   This file is part of DirectFB.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+*/
+
+/*
+ * Compare every function patched in by the gInit_*() functions with the C function it replaces, byte for byte on
+ * random spans. A patched entry of the tables below that is not covered by a test fails as well.
+ *
+ * The YCbCr span conversion has functions of its own signature, compared on random samples, and so do the line and
+ * column functions of the polyphase scaler, compared on the filter banks of random scalings.
+ */
+
+#include "gfx/generic/generic.c"
+#include "gfx/generic/generic_scale.c"
+
+#define MAX_LENGTH 67    /* not a multiple of the vector widths, leaving a tail */
+#define NUM_PIXELS 256   /* pixels of each buffer, with room for spans in both directions and for textures */
+#define TEX_SIZE   16    /* width and height of a texture at the start of the source buffer */
+#define NUM_RUNS   200   /* random spans per function */
+#define SRC_WIDTH  85    /* widest source of the convolution, with three lines fitting in a buffer */
+#define KACC_SIZE  96    /* accumulators per source line kept by the convolution, rounded up like Genefx */
+#define ROW_SIZE   272   /* channels of each line scaled horizontally, aligned for loading pairs of pixels */
+
+typedef enum {
+     TF_NONE     = 0x00000000,
+     TF_FORMAT   = 0x00000001,  /* indexed by the pixel format, with pixels of the format in Aop and Bop */
+     TF_NO_SACC  = 0x00000002,  /* also run without Sacc, using the color alpha instead */
+     TF_WIDE     = 0x00000004,  /* accumulators with channels beyond 8 bit, to be clamped */
+     TF_TEX      = 0x00000008,  /* texture lookup, left to right only */
+     TF_CONVOLVE = 0x00000010,  /* convolution of three lines of the source, left to right only */
+     TF_PACKED   = 0x00000020,  /* blending an ARGB or RGB32 source on packed channels, set up for random flags */
+     TF_A8       = 0x00000040   /* with an A8 source instead */
+} TableFlags;
+
+typedef struct {
+     const char            *name;
+     GenefxFunc            *funcs;
+     int                    num;
+     TableFlags             flags;
+
+     GenefxFunc             ref[DFB_NUM_PIXELFORMATS];  /* the C functions */
+} FuncTable;
+
+typedef struct {
+     const char            *name;
+     GenefxYCbCrSpanFunc   *func;
+     int                    bpp;     /* of the destination */
+
+     GenefxYCbCrSpanFunc    ref;     /* the C function */
+} YCbCrFunc;
+
+typedef struct {
+     u8                     Aop[NUM_PIXELS * 4];
+     u8                     Bop[NUM_PIXELS * 4];
+     GenefxAccumulator      Xacc[NUM_PIXELS];
+     GenefxAccumulator      Yacc[NUM_PIXELS];
+     GenefxAccumulator      Sacc[NUM_PIXELS];
+     GenefxAccumulator      Dacc[NUM_PIXELS];
+     GenefxAccumulator      Kacc[3 * KACC_SIZE];
+} SpanBuffers;
+
+#define TABLE(funcs,flags)  { #funcs, funcs, D_ARRAY_SIZE(funcs), flags, { NULL } }
+#define SINGLE(func,flags)  { #func, &func, 1, flags, { NULL } }
+
+static FuncTable tables[] = {
+     TABLE( Xacc_blend,               TF_NO_SACC ),
+     TABLE( Dacc_modulation,          TF_NONE ),
+     TABLE( Sop_PFI_to_Dacc,          TF_FORMAT ),
+     TABLE( Sop_PFI_Kto_Dacc,         TF_FORMAT ),
+     TABLE( Sop_PFI_TEX_to_Dacc,      TF_FORMAT | TF_TEX ),
+     TABLE( Sacc_to_Aop_PFI,          TF_FORMAT | TF_WIDE ),
+     TABLE( Cop_toK_Aop_PFI,          TF_FORMAT ),
+     TABLE( Bop_PFI_toK_Aop_PFI,      TF_FORMAT ),
+     TABLE( Bop_PFI_Kto_Aop_PFI,      TF_FORMAT ),
+     TABLE( Bop_PFI_KtoK_Aop_PFI,     TF_FORMAT ),
+     SINGLE( SCacc_add_to_Dacc,       TF_NONE ),
+     SINGLE( Sacc_add_to_Dacc,        TF_NONE ),
+     SINGLE( Dacc_Skey_extended,      TF_NONE ),
+     SINGLE( Dacc_src_colormatrix,    TF_NONE ),
+     SINGLE( Dacc_src_convolve,       TF_CONVOLVE ),
+     SINGLE( Dacc_src_convolve_keyed, TF_CONVOLVE ),
+     SINGLE( Bop_32_packed_Aop_32,    TF_PACKED ),
+     SINGLE( Bop_a8_packed_Aop_32,    TF_PACKED | TF_A8 )
+};
+
+#define YCBCR(func,bpp)     { #func, &func, bpp, NULL }
+
+static YCbCrFunc ycbcr_funcs[] = {
+     YCBCR( YCbCr_span_to_argb,  4 ),
+     YCBCR( YCbCr_span_to_rgb16, 2 )
+};
+
+/* single plane formats with 1, 2 or 4 bytes per pixel */
+static const DFBSurfacePixelFormat formats[] = {
+     DSPF_A8,       DSPF_RGB16,  DSPF_ARGB1555, DSPF_RGB555, DSPF_BGR555, DSPF_RGBA5551, DSPF_ARGB4444,
+     DSPF_RGB444,   DSPF_RGB32,  DSPF_ARGB,     DSPF_AiRGB,  DSPF_ABGR,   DSPF_AYUV
+};
+
+static GenefxState state[2];
+static SpanBuffers buffers[2];
+
+static bool        skip_pixels = true;  /* mark every eighth pixel of the accumulators as skipped */
+
+/**********************************************************************************************************************/
+
+static unsigned int seed = 1;
+
+static u32
+rnd( void )
+{
+     seed = seed * 1103515245 + 12345;
+
+     return (seed >> 8) & 0xffff;
+}
+
+static u32
+rnd32( void )
+{
+     return (rnd() << 16) | rnd();
+}
+
+static int
+rnd_signed( int limit )
+{
+     return (int) (rnd32() % (2 * limit + 1)) - limit;
+}
+
+static void
+fill_pixels( u8  *pixels,
+             int  bpp,
+             u32  key,
+             u32  mask )
+{
+     int i;
+
+     for (i = 0; i < NUM_PIXELS; i++) {
+          u32 pixel = rnd32();
+
+          /* Every fourth pixel matches the color key. */
+          if (!(rnd() & 3))
+               pixel = key | (pixel & ~mask);
+
+          switch (bpp) {
+               case 1:
+                    pixels[i] = pixel;
+                    break;
+               case 2:
+                    ((u16*) pixels)[i] = pixel;
+                    break;
+               case 4:
+                    ((u32*) pixels)[i] = pixel;
+                    break;
+          }
+     }
+}
+
+static void
+fill_accumulators( GenefxAccumulator *acc,
+                   u16                max )
+{
+     int i;
+
+     for (i = 0; i < NUM_PIXELS; i++) {
+          /* Every eighth pixel is skipped. */
+          acc[i].RGB.a = (rnd() & 7 || !skip_pixels) ? rnd() % max : 0xf000;
+          acc[i].RGB.r = rnd() % max;
+          acc[i].RGB.g = rnd() % max;
+          acc[i].RGB.b = rnd() % max;
+     }
+}
+
+static void
+random_color( DFBColor *color )
+{
+     color->a = rnd();
+     color->r = rnd();
+     color->g = rnd();
+     color->b = rnd();
+}
+
+/*
+ * Set the operands of a random span in the first state and buffers.
+ */
+static void
+random_span( const FuncTable       *table,
+             DFBSurfacePixelFormat  format,
+             int                    run )
+{
+     GenefxState *gfxs   = &state[0];
+     SpanBuffers *buf    = &buffers[0];
+     int          bpp    = format ? DFB_BYTES_PER_PIXEL( format ) : 4;
+     int          bits   = format ? DFB_COLOR_BITS_PER_PIXEL( format ) : 0;
+     u32          mask   = (1u << bits) - 1;
+     u32          pmask  = bpp < 4 ? (1u << (bpp * 8)) - 1 : 0xffffffff;
+     int          offset = rnd() & 3;
+     int          i;
+     s32          matrix[12];
+
+     memset( gfxs, 0, sizeof(GenefxState) );
+
+     gfxs->length = rnd() % MAX_LENGTH + 1;
+     gfxs->Astep  = 1;
+     gfxs->Bstep  = 1;
+     gfxs->Ostep  = 1;
+
+     /* Left to right, right to left within a surface, or horizontally flipped. */
+     if (!(table->flags & (TF_TEX | TF_CONVOLVE))) {
+          switch (run % 3) {
+               case 1:
+                    gfxs->Astep = gfxs->Bstep = gfxs->Ostep = -1;
+                    break;
+               case 2:
+                    gfxs->Astep = -1;
+                    break;
+          }
+     }
+
+     random_color( &gfxs->color );
+
+     gfxs->Cop  = rnd32() & pmask;
+     gfxs->Dkey = rnd32() & mask;
+     gfxs->Skey = rnd32() & mask;
+
+     /* Modulation by the color plus one, as set up for DSBLIT_COLORIZE and DSBLIT_BLEND_COLORALPHA. */
+     gfxs->Cacc.RGB.a = gfxs->color.a + 1;
+     gfxs->Cacc.RGB.r = gfxs->color.r + 1;
+     gfxs->Cacc.RGB.g = gfxs->color.g + 1;
+     gfxs->Cacc.RGB.b = gfxs->color.b + 1;
+
+     gfxs->SCacc.RGB.a = rnd() & 0xff;
+     gfxs->SCacc.RGB.r = rnd() & 0xff;
+     gfxs->SCacc.RGB.g = rnd() & 0xff;
+     gfxs->SCacc.RGB.b = rnd() & 0xff;
+
+     random_color( &gfxs->SkeyExtended.lower );
+
+     gfxs->SkeyExtended.upper.r  = gfxs->SkeyExtended.lower.r + rnd() % (0x100 - gfxs->SkeyExtended.lower.r);
+     gfxs->SkeyExtended.upper.g  = gfxs->SkeyExtended.lower.g + rnd() % (0x100 - gfxs->SkeyExtended.lower.g);
+     gfxs->SkeyExtended.upper.b  = gfxs->SkeyExtended.lower.b + rnd() % (0x100 - gfxs->SkeyExtended.lower.b);
+     gfxs->SkeyExtended.polarity = (rnd() & 1) ? DCKP_OTHER : DCKP_DEFAULT;
+
+     /* Coefficients up to 2.0 and offsets up to 256 in 16.16 fixed point, fitting the SIMD functions. */
+     for (i = 0; i < 12; i++)
+          matrix[i] = rnd_signed( (i & 3) == 3 ? 0x1000000 : 0x20000 );
+
+     src_colormatrix_prepare( gfxs, matrix );
+
+     /* Texture coordinates staying within the texture. */
+     gfxs->s         = rnd32() % (4 << 16);
+     gfxs->t         = rnd32() % (4 << 16);
+     gfxs->SperD     = rnd32() % ((TEX_SIZE - 5) * 0x10000 / MAX_LENGTH);
+     gfxs->TperD     = rnd32() % ((TEX_SIZE - 5) * 0x10000 / MAX_LENGTH);
+     gfxs->src_pitch = TEX_SIZE * bpp;
+
+     /* Three lines of a source at least as wide as the span, with none of the lines kept yet. */
+     if (table->flags & TF_CONVOLVE) {
+          DFBConvolutionFilter filter;
+
+          gfxs->src_format = DSPF_ARGB;
+          gfxs->src_width  = gfxs->length + rnd() % (SRC_WIDTH - gfxs->length + 1);
+          gfxs->src_height = 3;
+          gfxs->src_pitch  = gfxs->src_width * 4;
+          gfxs->src_org[0] = buf->Bop;
+          gfxs->BopX       = rnd() % (gfxs->src_width - gfxs->length + 1);
+          gfxs->BopY       = rnd() % 3;
+          gfxs->Kfuncs[0]  = Sop_PFI_to_Dacc[DFB_PIXELFORMAT_INDEX( DSPF_ARGB )];
+          gfxs->Ksize      = KACC_SIZE;
+          gfxs->Kacc       = buf->Kacc;
+          gfxs->KaccY[0]   = gfxs->KaccY[1] = gfxs->KaccY[2] = -1;
+
+          /* Coefficients up to 4.0 and a bias up to 256 in 16.16 fixed point, fitting the SIMD functions. */
+          for (i = 0; i < 9; i++)
+               filter.kernel[i] = rnd_signed( 0x40000 );
+
+          filter.scale = rnd32() % 0x10001;
+          filter.bias  = rnd_signed( 0x1000000 );
+
+          src_convolution_prepare( gfxs, &filter );
+     }
+
+     /* Any of the blitting flags and blend functions done on packed channels, for an ARGB or RGB32 destination. */
+     if (table->flags & TF_PACKED) {
+          static const DFBSurfaceBlittingFlags packed_flags[] = {
+               DSBLIT_BLEND_ALPHACHANNEL, DSBLIT_BLEND_COLORALPHA, DSBLIT_COLORIZE, DSBLIT_SRC_PREMULTIPLY,
+               DSBLIT_SRC_PREMULTCOLOR
+          };
+
+          CardState               card_state;
+          DFBSurfaceBlittingFlags flags = DSBLIT_NOFX;
+
+          memset( &card_state, 0, sizeof(CardState) );
+
+          while (!flags) {
+               for (i = 0; i < D_ARRAY_SIZE(packed_flags); i++) {
+                    if (rnd() & 1)
+                         flags |= packed_flags[i];
+               }
+          }
+
+          card_state.color     = gfxs->color;
+          card_state.src_blend = (rnd() & 1) ? DSBF_SRCALPHA : DSBF_ONE;
+          card_state.dst_blend = DSBF_INVSRCALPHA;
+
+          gfxs->src_format = (table->flags & TF_A8) ? DSPF_A8 : (rnd() & 1) ? DSPF_ARGB : DSPF_RGB32;
+          gfxs->dst_format = (rnd() & 1) ? DSPF_ARGB : DSPF_RGB32;
+
+          gAcquirePacked( &card_state, gfxs, flags );
+     }
+
+     fill_pixels( buf->Aop, bpp, gfxs->Dkey, mask );
+     fill_pixels( buf->Bop, bpp, gfxs->Skey, mask );
+
+     fill_accumulators( buf->Xacc, 0x100 );
+     fill_accumulators( buf->Yacc, 0x100 );
+     fill_accumulators( buf->Sacc, (table->flags & TF_WIDE) ? 0x200 : 0x100 );
+     fill_accumulators( buf->Dacc, (table->flags & TF_WIDE) ? 0x200 : 0x100 );
+
+     /* Spans start in the middle of the buffers, leaving twice the length in both directions, at any alignment. */
+     gfxs->Aop[0] = buf->Aop + (2 * MAX_LENGTH + offset) * bpp;
+     gfxs->Bop[0] = (table->flags & TF_TEX) ? buf->Bop : buf->Bop + (2 * MAX_LENGTH + offset) * bpp;
+     gfxs->Xacc   = buf->Xacc + offset;
+     gfxs->Yacc   = buf->Yacc + offset;
+     gfxs->Sacc   = ((run & 4) && (table->flags & TF_NO_SACC)) ? NULL : buf->Sacc + offset;
+     gfxs->Dacc   = buf->Dacc + offset;
+}
+
+/*
+ * Copy the first state and buffers to the second ones.
+ */
+static void
+copy_span( void )
+{
+     GenefxState *gfxs = &state[1];
+
+#define REBASE(ptr,field) \
+     ptr = ptr ? (void*) buffers[1].field + ((void*) ptr - (void*) buffers[0].field) : NULL
+
+     *gfxs      = state[0];
+     buffers[1] = buffers[0];
+
+     REBASE( gfxs->Aop[0],     Aop );
+     REBASE( gfxs->Bop[0],     Bop );
+     REBASE( gfxs->Xacc,       Xacc );
+     REBASE( gfxs->Yacc,       Yacc );
+     REBASE( gfxs->Sacc,       Sacc );
+     REBASE( gfxs->Dacc,       Dacc );
+     REBASE( gfxs->src_org[0], Bop );
+     REBASE( gfxs->Kacc,       Kacc );
+
+#undef REBASE
+
+     state[0].Sop = state[0].Bop;
+     state[1].Sop = state[1].Bop;
+}
+
+/*
+ * Run the C function and the patched one on the same random spans, returns the first run with a different result.
+ */
+static int
+test_entry( const FuncTable       *table,
+            DFBSurfacePixelFormat  format,
+            GenefxFunc             ref,
+            GenefxFunc             func )
+{
+     int run;
+
+     for (run = 0; run < NUM_RUNS; run++) {
+          random_span( table, format, run );
+          copy_span();
+
+          ref( &state[0] );
+          func( &state[1] );
+
+          if (memcmp( &buffers[0], &buffers[1], sizeof(SpanBuffers) ))
+               return run;
+     }
+
+     return -1;
+}
+
+/*
+ * Run the C function and the patched one converting the same random samples, returns the first run with a different
+ * result.
+ */
+static int
+test_ycbcr( const YCbCrFunc *entry )
+{
+     static const GenefxYCbCrToRGB *matrices[] = { &ycbcr_to_rgb_bt601, &ycbcr_to_rgb_bt709, &ycbcr_to_rgb_bt2020 };
+
+     int run;
+
+     for (run = 0; run < NUM_RUNS; run++) {
+          int       length     = rnd() % MAX_LENGTH + 1;
+          int       offset     = rnd() & 7;
+          bool      subsampled = run & 1;
+          const u8 *Y          = buffers[0].Bop + offset;
+          const u8 *U          = Y + NUM_PIXELS;
+          const u8 *V          = U + NUM_PIXELS;
+
+          fill_pixels( buffers[0].Aop, 4, 0, 0 );
+          fill_pixels( buffers[0].Bop, 4, 0, 0 );
+
+          buffers[1] = buffers[0];
+
+          entry->ref( Y, U, V, subsampled, buffers[0].Aop + offset * entry->bpp, length, matrices[run % 3] );
+          (*entry->func)( Y, U, V, subsampled, buffers[1].Aop + offset * entry->bpp, length, matrices[run % 3] );
+
+          if (memcmp( &buffers[0], &buffers[1], sizeof(SpanBuffers) ))
+               return run;
+     }
+
+     return -1;
+}
+
+#ifdef USE_SSE2
+/*
+ * Run the C functions of the polyphase scaler and the SSE2 ones with the filter bank of a random scaling, as long as it
+ * has an even number of taps. The columns are scaled from lines scaled horizontally by the C function.
+ */
+static int
+test_scale( void )
+{
+     static s16 rows[MAX_LENGTH][ROW_SIZE] __attribute__((aligned(16)));
+     static int first[MAX_LENGTH];
+     static s16 weights[MAX_LENGTH * MAX_LENGTH];
+
+     int        run, t;
+     int        errors = 0;
+     float      k[MAX_LENGTH];
+     const s16 *L[MAX_LENGTH];
+
+     for (run = 0; run < NUM_RUNS; run++) {
+          int        src_size = rnd() % MAX_LENGTH + 1;
+          int        dst_size = rnd() % MAX_LENGTH + 1;
+          bool       bicubic  = run & 1;
+          int        taps     = scale_taps( src_size, dst_size, bicubic );
+          int        i        = rnd() % dst_size;
+          const u32 *S        = (const u32*) buffers[0].Bop;
+
+          if (taps & 1)
+               continue;
+
+          scale_bank( src_size, dst_size, 0, dst_size, bicubic, taps, first, weights, k );
+
+          fill_pixels( buffers[0].Aop, 4, 0, 0 );
+          fill_pixels( buffers[0].Bop, 4, 0, 0 );
+
+          buffers[1] = buffers[0];
+
+          scale_line( S, (s16*) buffers[0].Xacc, first, weights, taps, dst_size );
+          scale_line_SSE2( S, (s16*) buffers[1].Xacc, first, weights, taps, dst_size );
+
+          if (memcmp( &buffers[0], &buffers[1], sizeof(SpanBuffers) )) {
+               fprintf( stderr, "SSE2: scale_line differs from the C function in run %d (%d -> %d, taps %d)!\n",
+                        run, src_size, dst_size, taps );
+               errors++;
+               break;
+          }
+
+          /* Lines of another source to be scaled vertically with the weights of a random output pixel. */
+          for (t = 0; t < taps; t++) {
+               fill_pixels( buffers[0].Bop, 4, 0, 0 );
+
+               scale_line( S, rows[t], first, weights, taps, dst_size );
+
+               L[t] = rows[t];
+          }
+
+          buffers[1] = buffers[0];
+
+          scale_column( L, weights + i * taps, taps, (u32*) buffers[0].Aop, dst_size );
+          scale_column_SSE2( L, weights + i * taps, taps, (u32*) buffers[1].Aop, dst_size );
+
+          if (memcmp( &buffers[0], &buffers[1], sizeof(SpanBuffers) )) {
+               fprintf( stderr, "SSE2: scale_column differs from the C function in run %d (%d -> %d, taps %d)!\n",
+                        run, src_size, dst_size, taps );
+               errors++;
+               break;
+          }
+     }
+
+     return errors;
+}
+#endif
+
+/*
+ * Compare the entries differing from the C functions after calling the init function.
+ */
+static int
+test_variant( const char *name,
+              void      (*init)( void ) )
+{
+     int i, j, n, run;
+     int errors = 0;
+
+     for (i = 0; i < D_ARRAY_SIZE(tables); i++)
+          memcpy( tables[i].funcs, tables[i].ref, tables[i].num * sizeof(GenefxFunc) );
+
+     for (i = 0; i < D_ARRAY_SIZE(ycbcr_funcs); i++)
+          *ycbcr_funcs[i].func = ycbcr_funcs[i].ref;
+
+     init();
+
+     for (i = 0; i < D_ARRAY_SIZE(tables); i++) {
+          const FuncTable *table = &tables[i];
+
+          for (j = 0; j < table->num; j++) {
+               DFBSurfacePixelFormat format = DSPF_UNKNOWN;
+
+               if (table->funcs[j] == table->ref[j])
+                    continue;
+
+               if (table->flags & TF_FORMAT) {
+                    for (n = 0; n < D_ARRAY_SIZE(formats); n++) {
+                         if (DFB_PIXELFORMAT_INDEX( formats[n] ) == j)
+                              format = formats[n];
+                    }
+
+                    if (!format) {
+                         fprintf( stderr, "%s: %s[%d] is not covered!\n", name, table->name, j );
+                         errors++;
+                         continue;
+                    }
+               }
+
+               if (!table->ref[j]) {
+                    fprintf( stderr, "%s: %s[%d] has no C function!\n", name, table->name, j );
+                    errors++;
+                    continue;
+               }
+
+               run = test_entry( table, format, table->ref[j], table->funcs[j] );
+               if (run >= 0) {
+                    fprintf( stderr, "%s: %s[%d] differs from the C function in run %d (length %d, steps %d/%d)!\n",
+                             name, table->name, j, run, state[0].length, state[0].Astep, state[0].Bstep );
+                    errors++;
+               }
+          }
+     }
+
+     for (i = 0; i < D_ARRAY_SIZE(ycbcr_funcs); i++) {
+          const YCbCrFunc *entry = &ycbcr_funcs[i];
+
+          if (*entry->func == entry->ref)
+               continue;
+
+          run = test_ycbcr( entry );
+          if (run >= 0) {
+               fprintf( stderr, "%s: %s differs from the C function in run %d!\n", name, entry->name, run );
+               errors++;
+          }
+     }
+
+     return errors;
+}
+
+#ifdef USE_SSE2
+static void
+init_AVX2( void )
+{
+     gInit_SSE2();
+     gInit_AVX2();
+}
+#endif
+
+int
+main( int argc, char *argv[] )
+{
+     int i;
+     int errors = 0;
+
+     for (i = 0; i < D_ARRAY_SIZE(tables); i++)
+          memcpy( tables[i].ref, tables[i].funcs, tables[i].num * sizeof(GenefxFunc) );
+
+     for (i = 0; i < D_ARRAY_SIZE(ycbcr_funcs); i++)
+          ycbcr_funcs[i].ref = *ycbcr_funcs[i].func;
+
+#ifdef USE_VECTOR_EXTENSIONS
+     errors += test_variant( "Vector", gInit_Vector );
+#endif
+
+#ifdef USE_MMX
+     /* The MMX blending and adding functions also change skipped pixels, which are never written to the destination. */
+     skip_pixels = false;
+     errors += test_variant( "MMX", gInit_MMX );
+     skip_pixels = true;
+#endif
+
+#ifdef USE_SSE2
+     if (__builtin_cpu_supports( "sse2" )) {
+          errors += test_variant( "SSE2", gInit_SSE2 );
+          errors += test_scale();
+
+          if (__builtin_cpu_supports( "avx2" ))
+               errors += test_variant( "AVX2", init_AVX2 );
+     }
+#endif
+
+     return errors ? 1 : 0;
+}
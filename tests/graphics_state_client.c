@@ -0,0 +1,134 @@
+/*
+   This file is part of DirectFB.
+
+   This library is free software; you can redistribute it and/or
+   modify it under the terms of the GNU Lesser General Public
+   License as published by the Free Software Foundation; either
+   version 2.1 of the License, or (at your option) any later version.
+
+   This library is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public
+   License along with this library; if not, write to the Free Software
+   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+*/
+
+/*
+ * Record more spans than fit in one command of the state client, and check the commands executed and still recorded.
+ */
+
+#include <core/CoreGraphicsStateClient.h>
+#include <core/graphics_state.h>
+#include <directfb.h>
+
+#define SPANS_Y   100
+#define NUM_SPANS 2000
+
+static int spans_done;
+static int commands_done;
+static int errors;
+
+/*
+ * Replaces the call of the remote object, checking the commands instead of executing them.
+ */
+static DFBResult
+check_commands( CoreGraphicsState *obj,
+                const u8          *commands,
+                u32                length )
+{
+     u32 offset = 0;
+
+     while (offset < length) {
+          const CoreGraphicsStateCommand *command = (const CoreGraphicsStateCommand*) (commands + offset);
+          const DFBSpan                  *spans   = (const DFBSpan*) (command + 1);
+          u32                             i;
+
+          if (command->type != CGSC_FILL_SPANS || command->length != command->num * sizeof(DFBSpan)) {
+               fprintf( stderr, "Unexpected command %u with length %u!\n", command->type, command->length );
+               errors++;
+               return DFB_BUG;
+          }
+
+          /* Each command starts at the line of its first span. */
+          if (command->param != SPANS_Y + spans_done) {
+               fprintf( stderr, "Command %d starts at line %d instead of %d!\n",
+                        commands_done, command->param, SPANS_Y + spans_done );
+               errors++;
+          }
+
+          for (i = 0; i < command->num; i++) {
+               if (spans[i].x != spans_done + (int) i) {
+                    fprintf( stderr, "Span %u of command %d is span %d!\n", i, commands_done, spans[i].x );
+                    errors++;
+                    break;
+               }
+          }
+
+          spans_done += command->num;
+          commands_done++;
+
+          offset += sizeof(CoreGraphicsStateCommand) + command->length;
+     }
+
+     return DFB_OK;
+}
+
+int
+main( int argc, char *argv[] )
+{
+     DFBResult                ret;
+     int                      i;
+     DFBSpan                  spans[NUM_SPANS];
+     CardState                state;
+     CoreGraphicsStateClient  client;
+
+     ret = DirectFBInit( &argc, &argv );
+     if (ret) {
+          DirectFBError( "DirectFBInit", ret );
+          return 1;
+     }
+
+     /* Record the commands instead of calling the graphics card directly. */
+     DirectFBSetOption( "always-indirect", NULL );
+
+     memset( &state, 0, sizeof(state) );
+     memset( &client, 0, sizeof(client) );
+
+     D_MAGIC_SET( &state, CardState );
+     D_MAGIC_SET( &client, CoreGraphicsStateClient );
+
+     client.state   = &state;
+     client.Execute = check_commands;
+
+     for (i = 0; i < NUM_SPANS; i++) {
+          spans[i].x = i;
+          spans[i].w = 1;
+     }
+
+     ret = CoreGraphicsStateClient_FillSpans( &client, SPANS_Y, spans, NUM_SPANS );
+     if (ret) {
+          DirectFBError( "CoreGraphicsStateClient_FillSpans", ret );
+          return 1;
+     }
+
+     /* The last commands are executed by the next flush, which needs the remote object. */
+     check_commands( NULL, client.commands, client.length );
+
+     if (spans_done != NUM_SPANS) {
+          fprintf( stderr, "Executed %d spans instead of %d!\n", spans_done, NUM_SPANS );
+          errors++;
+     }
+
+     if (commands_done < 2) {
+          fprintf( stderr, "All spans have been recorded in one command!\n" );
+          errors++;
+     }
+
+     if (client.commands)
+          D_FREE( client.commands );
+
+     return errors ? 1 : 0;
+}